@@ -0,0 +1,91 @@
+#ifndef NATIVE_ADAFRUIT_SSD1306_H
+#define NATIVE_ADAFRUIT_SSD1306_H
+
+#include <string.h>
+#include <Arduino.h>
+#include <Adafruit_GFX.h>
+#include <Wire.h>
+#include "native_hal.h"
+
+#define SSD1306_SWITCHCAPVCC 0x02
+#define SSD1306_EXTERNALVCC 0x01
+#define SSD1306_BLACK 0
+#define SSD1306_WHITE 1
+#define SSD1306_INVERSE 2
+
+// 128x64 panel with a real page-ordered framebuffer. Rectangles and pixels
+// are drawn so the renderer's dirty-region logic sees realistic changes;
+// text only moves the cursor and marks its cell.
+class Adafruit_SSD1306 {
+private:
+    int16_t w;
+    int16_t h;
+    uint8_t buffer[128 * 64 / 8];
+    int16_t cursorX;
+    int16_t cursorY;
+    uint8_t textSize;
+
+    void glyphs(size_t count) {
+        int16_t cellW = 6 * textSize;
+        int16_t cellH = 8 * textSize;
+        for (size_t i = 0; i < count; i++) {
+            fillRect(cursorX, cursorY, cellW - textSize, cellH - textSize, SSD1306_WHITE);
+            cursorX += cellW;
+        }
+    }
+
+public:
+    Adafruit_SSD1306(uint8_t width, uint8_t height, TwoWire*, int8_t)
+        : w(width), h(height), cursorX(0), cursorY(0), textSize(1) {
+        memset(buffer, 0, sizeof(buffer));
+    }
+
+    bool begin(uint8_t, uint8_t) { return true; }
+    int16_t width() const { return w; }
+    int16_t height() const { return h; }
+    uint8_t* getBuffer() { return buffer; }
+
+    void clearDisplay() { memset(buffer, 0, sizeof(buffer)); }
+    void display() { nativeCountDisplayFrame(); }
+
+    void drawPixel(int16_t x, int16_t y, uint16_t color) {
+        if (x < 0 || y < 0 || x >= w || y >= h) return;
+        uint8_t& byte = buffer[x + (y / 8) * w];
+        uint8_t bit = 1 << (y & 7);
+        if (color == SSD1306_WHITE) byte |= bit;
+        else if (color == SSD1306_BLACK) byte &= ~bit;
+        else byte ^= bit;
+    }
+
+    void fillRect(int16_t x, int16_t y, int16_t rw, int16_t rh, uint16_t color) {
+        for (int16_t j = y; j < y + rh; j++) {
+            for (int16_t i = x; i < x + rw; i++) drawPixel(i, j, color);
+        }
+    }
+
+    void drawRect(int16_t x, int16_t y, int16_t rw, int16_t rh, uint16_t color) {
+        fillRect(x, y, rw, 1, color);
+        fillRect(x, y + rh - 1, rw, 1, color);
+        fillRect(x, y, 1, rh, color);
+        fillRect(x + rw - 1, y, 1, rh, color);
+    }
+
+    void setTextSize(uint8_t size) { textSize = size > 0 ? size : 1; }
+    void setTextColor(uint16_t) {}
+    void setTextColor(uint16_t, uint16_t) {}
+    void setCursor(int16_t x, int16_t y) { cursorX = x; cursorY = y; }
+
+    void print(const char* s) { glyphs(strlen(s)); }
+    void print(const String& s) { glyphs(s.length()); }
+    void print(char) { glyphs(1); }
+    template <typename T>
+    void print(T v) { print(String(v)); }
+    template <typename T>
+    void print(T v, int format) { print(String(v, format)); }
+
+    void println() { cursorX = 0; cursorY += 8 * textSize; }
+    template <typename T>
+    void println(T v) { print(v); println(); }
+};
+
+#endif
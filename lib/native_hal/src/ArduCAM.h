@@ -0,0 +1,80 @@
+#ifndef NATIVE_ARDUCAM_H
+#define NATIVE_ARDUCAM_H
+
+#include <stdint.h>
+#include <string.h>
+#include <Arduino.h>
+#include <SPI.h>
+#include "native_hal.h"
+
+// OV2640 ArduCAM stand-in. Registers read back what was written, the sensor
+// reports the OV2640 chip id, captures complete immediately and the FIFO
+// holds the next replayed JPEG (see nativeLoadFrames).
+
+#define OV2640 5
+#define BMP 0
+#define JPEG 1
+#define RAW 2
+
+#define ARDUCHIP_TEST1 0x00
+#define ARDUCHIP_FIFO 0x04
+#define ARDUCHIP_GPIO 0x06
+#define ARDUCHIP_TRIG 0x41
+#define CAP_DONE_MASK 0x08
+#define GPIO_PWDN_MASK 0x02
+#define OV2640_CHIPID_HIGH 0x0A
+#define OV2640_CHIPID_LOW 0x0B
+
+#define OV2640_160x120 0
+#define OV2640_176x144 1
+#define OV2640_320x240 2
+
+#define MAX_FIFO_SIZE 0x5FFFF
+
+class ArduCAM {
+private:
+    uint8_t regs[128];
+    uint8_t sensorBank;
+
+public:
+    ArduCAM(uint8_t, int) : sensorBank(0) { memset(regs, 0, sizeof(regs)); }
+
+    void InitCAM() {}
+    void set_format(uint8_t) {}
+    void OV2640_set_JPEG_size(uint8_t) {}
+
+    void write_reg(uint8_t addr, uint8_t data) { regs[addr & 0x7F] = data; }
+    uint8_t read_reg(uint8_t addr) { return regs[addr & 0x7F]; }
+    void set_bit(uint8_t addr, uint8_t bit) { regs[addr & 0x7F] |= bit; }
+    void clear_bit(uint8_t addr, uint8_t bit) { regs[addr & 0x7F] &= ~bit; }
+    uint8_t get_bit(uint8_t addr, uint8_t bit) {
+        if (addr == ARDUCHIP_TRIG && bit == CAP_DONE_MASK) return nativeCameraCaptureDone() ? bit : 0;
+        return regs[addr & 0x7F] & bit;
+    }
+
+    byte wrSensorReg8_8(int regID, int regDat) {
+        if (regID == 0xFF) sensorBank = regDat;
+        return 1;
+    }
+
+    byte rdSensorReg8_8(uint8_t regID, uint8_t* regDat) {
+        if (regID == OV2640_CHIPID_HIGH) *regDat = 0x26;
+        else if (regID == OV2640_CHIPID_LOW) *regDat = 0x42;
+        else *regDat = 0;
+        return 1;
+    }
+
+    void flush_fifo() {}
+    void clear_fifo_flag() {}
+    void start_capture() { nativeCameraCapture(); }
+    uint32_t read_fifo_length() { return nativeCameraFifoLength(); }
+
+    void CS_LOW() {}
+    void CS_HIGH() { SPI.setBurst(false); }
+    void set_fifo_burst() {
+        nativeCameraBeginBurst();
+        SPI.setBurst(true);
+    }
+};
+
+#endif
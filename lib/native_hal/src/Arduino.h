@@ -0,0 +1,139 @@
+#ifndef NATIVE_ARDUINO_H
+#define NATIVE_ARDUINO_H
+
+// Minimal Arduino core for the native environment: the parts of the API the
+// firmware uses, backed by stdio and the native_hal clock.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+#include <algorithm>
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+
+#define DEC 10
+#define HEX 16
+
+using std::min;
+using std::max;
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+// --- Time (native_hal.cpp; see nativeSetVirtualTime) ---
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+// --- GPIO: recorded, not driven ---
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+
+inline long map(long x, long inMin, long inMax, long outMin, long outMax) {
+    return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+// --- String ---
+
+class String : public std::string {
+public:
+    String(const char* s = "") : std::string(s ? s : "") {}
+    String(const std::string& s) : std::string(s) {}
+    String(char c) : std::string(1, c) {}
+    String(int v, int base = DEC) : std::string(formatInt(v, base)) {}
+    String(unsigned int v, int base = DEC) : std::string(formatInt(v, base)) {}
+    String(long v, int base = DEC) : std::string(formatInt(v, base)) {}
+    String(unsigned long v, int base = DEC) : std::string(formatInt(v, base)) {}
+    String(float v, int decimals = 2) : std::string(formatFloat(v, decimals)) {}
+    String(double v, int decimals = 2) : std::string(formatFloat(v, decimals)) {}
+
+    int toInt() const { return atoi(c_str()); }
+    float toFloat() const { return (float)atof(c_str()); }
+    bool startsWith(const String& prefix) const { return compare(0, prefix.size(), prefix) == 0; }
+    int indexOf(const String& s) const {
+        size_t pos = find(s);
+        return pos == npos ? -1 : (int)pos;
+    }
+    String substring(size_t from, size_t to = npos) const {
+        if (from >= size()) return String();
+        return String(substr(from, to == npos ? npos : to - from));
+    }
+    void trim() {
+        size_t first = find_first_not_of(" \t\r\n");
+        size_t last = find_last_not_of(" \t\r\n");
+        *this = first == npos ? String() : String(substr(first, last - first + 1));
+    }
+
+private:
+    static std::string formatInt(long long v, int base) {
+        char buf[32];
+        snprintf(buf, sizeof(buf), base == HEX ? "%llx" : "%lld", v);
+        return buf;
+    }
+
+    static std::string formatFloat(double v, int decimals) {
+        char buf[48];
+        snprintf(buf, sizeof(buf), "%.*f", decimals, v);
+        return buf;
+    }
+};
+
+struct IPAddress {
+    uint8_t octets[4];
+    IPAddress(uint8_t a = 127, uint8_t b = 0, uint8_t c = 0, uint8_t d = 1) {
+        octets[0] = a; octets[1] = b; octets[2] = c; octets[3] = d;
+    }
+    uint8_t operator[](int i) const { return octets[i]; }
+};
+
+// --- Serial: stdout ---
+
+class HardwareSerial {
+public:
+    void begin(unsigned long) {}
+    void end() {}
+    void flush() { fflush(stdout); }
+    int available() { return 0; }
+    int read() { return -1; }
+    operator bool() const { return true; }
+
+    size_t write(uint8_t c) { return fputc(c, stdout) == EOF ? 0 : 1; }
+    size_t write(const uint8_t* data, size_t len) { return fwrite(data, 1, len, stdout); }
+
+    int printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+    size_t print(const char* s) { return fputs(s, stdout) == EOF ? 0 : strlen(s); }
+    size_t print(const String& s) { return print(s.c_str()); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(int v, int base = DEC) { return print(String(v, base)); }
+    size_t print(unsigned int v, int base = DEC) { return print(String(v, base)); }
+    size_t print(long v, int base = DEC) { return print(String(v, base)); }
+    size_t print(unsigned long v, int base = DEC) { return print(String(v, base)); }
+    size_t print(double v, int decimals = 2) { return print(String(v, decimals)); }
+    size_t print(const IPAddress& ip) {
+        return ::printf("%u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
+    }
+
+    size_t println() { return print("\n"); }
+    template <typename T>
+    size_t println(const T& v) { return print(v) + println(); }
+    template <typename T>
+    size_t println(const T& v, int format) { return print(v, format) + println(); }
+};
+
+extern HardwareSerial Serial;
+
+#endif
@@ -0,0 +1,219 @@
+#ifndef NATIVE_ESP_ASYNC_WEB_SERVER_H
+#define NATIVE_ESP_ASYNC_WEB_SERVER_H
+
+#include <Arduino.h>
+#include <functional>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+// In-process stand-in for the web server: routes registered with on() are
+// served to nativeWebRequest() once begin() has been called, with no sockets.
+// Plain responses are captured whole; chunked and filler responses are
+// drained the way AsyncTCP would, one send buffer at a time, so handlers
+// that stream (CSV export, MJPEG) run exactly as on the device.
+
+enum WebRequestMethod {
+    HTTP_GET = 0b00000001,
+    HTTP_POST = 0b00000010,
+    HTTP_ANY = 0b01111111
+};
+
+#define RESPONSE_TRY_AGAIN 0xFFFFFFFF
+
+typedef std::function<size_t(uint8_t*, size_t, size_t)> AwsResponseFiller;
+
+class AsyncWebParameter {
+private:
+    String val;
+
+public:
+    AsyncWebParameter(const String& value = String()) : val(value) {}
+    const String& value() const { return val; }
+};
+
+class AsyncWebServerResponse {
+public:
+    int status;
+    String contentType;
+    std::string body;
+    AwsResponseFiller filler;      // Empty for a fixed body
+    std::vector<std::pair<String, String> > headers;
+
+    AsyncWebServerResponse(int code, const String& type) : status(code), contentType(type) {}
+    virtual ~AsyncWebServerResponse() {}
+
+    void addHeader(const String& name, const String& value) {
+        headers.push_back(std::make_pair(name, value));
+    }
+};
+
+class AsyncWebServerRequest {
+private:
+    std::map<std::string, AsyncWebParameter> queryParams;
+    std::map<std::string, AsyncWebParameter> postParams;
+    AsyncWebServerResponse* response;
+
+public:
+    AsyncWebServerRequest() : response(nullptr) {}
+    ~AsyncWebServerRequest() { delete response; }
+
+    void setParam(const String& name, const String& value, bool post) {
+        (post ? postParams : queryParams)[name] = AsyncWebParameter(value);
+    }
+
+    bool hasParam(const String& name, bool post = false, bool = false) const {
+        const std::map<std::string, AsyncWebParameter>& params = post ? postParams : queryParams;
+        return params.count(name) > 0;
+    }
+
+    AsyncWebParameter* getParam(const String& name, bool post = false, bool = false) {
+        std::map<std::string, AsyncWebParameter>& params = post ? postParams : queryParams;
+        std::map<std::string, AsyncWebParameter>::iterator it = params.find(name);
+        return it == params.end() ? nullptr : &it->second;
+    }
+
+    // The handler's response; owned by the request
+    AsyncWebServerResponse* sent() const { return response; }
+
+    void send(AsyncWebServerResponse* r) {
+        delete response;
+        response = r;
+    }
+    void send(int code, const String& type = String(), const String& content = String()) {
+        send(beginResponse(code, type, content));
+    }
+
+    AsyncWebServerResponse* beginResponse(int code, const String& type = String(), const String& content = String()) {
+        AsyncWebServerResponse* r = new AsyncWebServerResponse(code, type);
+        r->body = content;
+        return r;
+    }
+    AsyncWebServerResponse* beginResponse_P(int code, const String& type, const uint8_t* data, size_t len) {
+        AsyncWebServerResponse* r = new AsyncWebServerResponse(code, type);
+        r->body.assign((const char*)data, len);
+        return r;
+    }
+    AsyncWebServerResponse* beginResponse(const String& type, size_t, AwsResponseFiller filler) {
+        AsyncWebServerResponse* r = new AsyncWebServerResponse(200, type);
+        r->filler = filler;
+        return r;
+    }
+    AsyncWebServerResponse* beginChunkedResponse(const String& type, AwsResponseFiller filler) {
+        return beginResponse(type, 0, filler);
+    }
+};
+
+typedef std::function<void(AsyncWebServerRequest*)> ArRequestHandlerFunction;
+
+class AsyncWebServer {
+private:
+    struct Route {
+        std::string url;
+        WebRequestMethod method;
+        ArRequestHandlerFunction handler;
+    };
+
+    uint16_t port;
+    std::vector<Route> routes;
+
+    // Never destroyed: global servers may outlive any static map
+    static std::map<uint16_t, AsyncWebServer*>& listening() {
+        static std::map<uint16_t, AsyncWebServer*>* servers = new std::map<uint16_t, AsyncWebServer*>();
+        return *servers;
+    }
+
+public:
+    AsyncWebServer(uint16_t listenPort) : port(listenPort) {}
+    ~AsyncWebServer() {
+        if (onPort(port) == this) listening().erase(port);
+    }
+
+    void on(const char* url, WebRequestMethod method, ArRequestHandlerFunction handler) {
+        Route route = { url, method, handler };
+        routes.push_back(route);
+    }
+
+    void begin() { listening()[port] = this; }
+
+    static AsyncWebServer* onPort(uint16_t listenPort) {
+        std::map<uint16_t, AsyncWebServer*>::iterator it = listening().find(listenPort);
+        return it == listening().end() ? nullptr : it->second;
+    }
+
+    // Run the first matching handler; false if no route matched
+    bool dispatch(WebRequestMethod method, const String& url, AsyncWebServerRequest* request) {
+        for (size_t i = 0; i < routes.size(); i++) {
+            if (routes[i].url == url && (routes[i].method & method)) {
+                routes[i].handler(request);
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+// What a client received for one request
+struct NativeWebResponse {
+    int status;                // 0: nothing listening on the port
+    String contentType;
+    std::string body;
+    int chunks;                // Filler calls that returned data
+    int retries;               // RESPONSE_TRY_AGAIN answers
+    int overruns;              // Filler calls that claimed more than the buffer
+};
+
+// Issue a request to the server listening on port. params are form fields
+// for POST and query parameters otherwise. Streaming responses are drained
+// through a chunkBytes buffer until the filler returns 0, maxBytes have been
+// received, or it has asked to try again maxRetries times in a row (an
+// endless stream such as MJPEG ends on one of the last two).
+inline NativeWebResponse nativeWebRequest(uint16_t port, WebRequestMethod method, const char* url,
+                                          const std::vector<std::pair<String, String> >& params =
+                                              std::vector<std::pair<String, String> >(),
+                                          size_t chunkBytes = 1436, size_t maxBytes = 1 << 20,
+                                          int maxRetries = 100) {
+    NativeWebResponse result = { 0, String(), std::string(), 0, 0, 0 };
+    AsyncWebServer* server = AsyncWebServer::onPort(port);
+    if (!server) return result;
+
+    AsyncWebServerRequest request;
+    for (size_t i = 0; i < params.size(); i++) {
+        request.setParam(params[i].first, params[i].second, method == HTTP_POST);
+    }
+    if (!server->dispatch(method, url, &request)) {
+        result.status = 404;
+        return result;
+    }
+    AsyncWebServerResponse* response = request.sent();
+    if (!response) return result;
+    result.status = response->status;
+    result.contentType = response->contentType;
+    if (!response->filler) {
+        result.body = response->body;
+        return result;
+    }
+
+    std::vector<uint8_t> buffer(chunkBytes);
+    int tries = 0;
+    while (result.body.size() < maxBytes && tries < maxRetries) {
+        size_t n = response->filler(buffer.data(), chunkBytes, result.body.size());
+        if (n == RESPONSE_TRY_AGAIN) {
+            result.retries++;
+            tries++;
+            continue;
+        }
+        if (n == 0) break;
+        if (n > chunkBytes) {
+            result.overruns++;
+            n = chunkBytes;
+        }
+        result.body.append((const char*)buffer.data(), n);
+        result.chunks++;
+        tries = 0;
+    }
+    return result;
+}
+
+#endif
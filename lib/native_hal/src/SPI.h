@@ -0,0 +1,37 @@
+#ifndef NATIVE_SPI_H
+#define NATIVE_SPI_H
+
+#include <stdint.h>
+#include "native_hal.h"
+
+#define MSBFIRST 1
+#define LSBFIRST 0
+#define SPI_MODE0 0
+#define SPI_MODE1 1
+#define SPI_MODE2 2
+#define SPI_MODE3 3
+
+struct SPISettings {
+    SPISettings() {}
+    SPISettings(uint32_t, uint8_t, uint8_t) {}
+};
+
+// Only the camera is on the bus: during an ArduCAM FIFO burst transfer()
+// returns the next byte of the current frame, otherwise 0
+class SPIClass {
+private:
+    bool burst;
+
+public:
+    SPIClass() : burst(false) {}
+    void begin(int8_t = -1, int8_t = -1, int8_t = -1, int8_t = -1) {}
+    void end() {}
+    void beginTransaction(SPISettings) {}
+    void endTransaction() {}
+    void setBurst(bool active) { burst = active; }
+    uint8_t transfer(uint8_t) { return burst ? nativeCameraBurstByte() : 0; }
+};
+
+extern SPIClass SPI;
+
+#endif
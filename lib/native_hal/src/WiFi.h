@@ -0,0 +1,20 @@
+#ifndef NATIVE_WIFI_H
+#define NATIVE_WIFI_H
+
+#include <Arduino.h>
+
+#define WL_IDLE_STATUS 0
+#define WL_CONNECTED 3
+
+// Always "connected" to loopback; there is no network on the native build
+class WiFiClass {
+public:
+    void begin(const char*, const char*) {}
+    int status() { return WL_CONNECTED; }
+    IPAddress localIP() { return IPAddress(); }
+    void setSleep(bool) {}
+};
+
+extern WiFiClass WiFi;
+
+#endif
@@ -0,0 +1,593 @@
+#include "native_hal.h"
+#include <Arduino.h>
+#include <SPI.h>
+#include <Wire.h>
+#include <WiFi.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <dirent.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+HardwareSerial Serial;
+TwoWire Wire;
+SPIClass SPI;
+WiFiClass WiFi;
+
+// --- Clock ---
+
+static const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+static std::atomic<bool> virtualTime(false);
+static std::atomic<uint64_t> skippedUs(0);     // delay() time not actually slept
+static std::atomic<uint64_t> idleUs(0);
+
+uint64_t nativeMonotonicUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - startTime).count();
+}
+
+void nativeSetVirtualTime(bool enabled) { virtualTime = enabled; }
+bool nativeVirtualTime() { return virtualTime.load(); }
+
+// --- Simulated time ---
+
+static std::atomic<bool> simulatedTime(false);
+static std::atomic<uint64_t> simulatedNs(0);
+static NativeCostModel costModel = nativeDefaultCostModel();
+static std::atomic<uint64_t> chargedNs[NATIVE_COST_COUNT];
+static std::atomic<uint32_t> charges[NATIVE_COST_COUNT];
+static uint64_t captureDoneNs = 0;
+static bool capturePending = false;
+
+static const char* const costNames[NATIVE_COST_COUNT] = {
+    "capture", "spi", "i2c", "features", "analyze", "dsp", "inference"
+};
+
+NativeCostModel nativeDefaultCostModel() {
+    NativeCostModel model;
+    model.captureUs = 150000;
+    model.spiByteNs = 1000;                 // 8 MHz SCK plus per-transfer overhead
+    model.i2cByteNs = 22500;                // 9 bit times at 400 kHz
+    model.stageUs[RT_COST_FEATURES] = 400;
+    model.stageUs[RT_COST_ANALYZE] = 150;
+    model.stageUs[RT_COST_DSP] = 50;
+    model.stageUs[RT_COST_INFERENCE] = 2500;
+    return model;
+}
+
+void nativeSetCostModel(const NativeCostModel& model) { costModel = model; }
+
+const char* nativeCostNames() {
+    return "capture_us, spi_byte_ns, i2c_byte_ns, features_us, analyze_us, dsp_us, inference_us";
+}
+
+bool nativeSetCost(const char* assignment) {
+    const char* equals = strchr(assignment, '=');
+    if (!equals) return false;
+    std::string name(assignment, equals - assignment);
+    uint32_t value = (uint32_t)strtoul(equals + 1, nullptr, 10);
+    if (name == "capture_us") costModel.captureUs = value;
+    else if (name == "spi_byte_ns") costModel.spiByteNs = value;
+    else if (name == "i2c_byte_ns") costModel.i2cByteNs = value;
+    else if (name == "features_us") costModel.stageUs[RT_COST_FEATURES] = value;
+    else if (name == "analyze_us") costModel.stageUs[RT_COST_ANALYZE] = value;
+    else if (name == "dsp_us") costModel.stageUs[RT_COST_DSP] = value;
+    else if (name == "inference_us") costModel.stageUs[RT_COST_INFERENCE] = value;
+    else return false;
+    return true;
+}
+
+const char* nativeCostName(int cost) {
+    return cost >= 0 && cost < NATIVE_COST_COUNT ? costNames[cost] : "?";
+}
+
+static void chargeNs(NativeCost cost, uint64_t ns) {
+    if (!simulatedTime.load()) return;
+    simulatedNs += ns;
+    chargedNs[cost] += ns;
+    charges[cost]++;
+}
+
+static uint64_t simulatedNowUs() { return simulatedNs.load() / 1000; }
+
+static void simulatedCharge(RtCostStage stage, uint32_t units) {
+    static const NativeCost costs[RT_COST_STAGE_COUNT] = {
+        NATIVE_COST_FEATURES, NATIVE_COST_ANALYZE, NATIVE_COST_DSP, NATIVE_COST_INFERENCE
+    };
+    chargeNs(costs[stage], (uint64_t)costModel.stageUs[stage] * units * 1000);
+}
+
+// --- Simulated tasks ---
+//
+// One simulated core. Every task is a host thread, but only the current one
+// runs; the rest wait on their own condition variable until the current
+// task sleeps, waits or returns and hands over to the task due earliest.
+// The thread that switched simulated time on is the first task.
+
+static const uint64_t SIM_FOREVER_NS = UINT64_MAX;
+
+struct SimTask {
+    std::thread* thread;        // nullptr for the thread that switched simulated time on
+    const char* name;
+    void (*entry)(void*);
+    void* arg;
+    uint64_t wakeNs;            // Due again at; SIM_FOREVER_NS while waiting without a timeout
+    uint64_t order;             // Equal wake times run in the order they blocked
+    const void* channel;        // What wake() has to name to end the wait early
+    bool woken;
+    bool finished;
+    std::condition_variable turn;
+};
+
+static std::mutex simLock;
+static std::vector<SimTask*> simTasks;
+static SimTask* simCurrent = nullptr;
+static uint64_t simOrder = 0;
+static thread_local SimTask* simSelf = nullptr;
+
+// Makes the task due earliest current, moving the clock up to its wake
+// time; the caller has already blocked or finished
+static void simSwitch() {
+    SimTask* next = nullptr;
+    for (size_t i = 0; i < simTasks.size(); i++) {
+        SimTask* task = simTasks[i];
+        if (task->finished) continue;
+        if (!next || task->wakeNs < next->wakeNs ||
+            (task->wakeNs == next->wakeNs && task->order < next->order)) {
+            next = task;
+        }
+    }
+    if (!next || next->wakeNs == SIM_FOREVER_NS) {
+        fprintf(stderr, "[native] simulated time: every task is waiting with no timeout\n");
+        abort();
+    }
+    uint64_t now = simulatedNs.load();
+    if (next->wakeNs > now) {
+        idleUs += (next->wakeNs - now) / 1000;
+        simulatedNs = next->wakeNs;
+    }
+    simCurrent = next;
+    next->turn.notify_one();
+}
+
+static void simWakeLocked(const void* channel) {
+    for (size_t i = 0; i < simTasks.size(); i++) {
+        SimTask* task = simTasks[i];
+        if (task == simCurrent || task->finished || task->channel != channel) continue;
+        task->channel = nullptr;
+        task->woken = true;
+        task->wakeNs = std::min(task->wakeNs, simulatedNs.load());
+        task->order = ++simOrder;
+    }
+}
+
+// Blocks the calling task until wakeNs or a wake() on channel; true if woken
+static bool simBlock(uint64_t wakeNs, const void* channel) {
+    SimTask* self = simSelf;
+    std::unique_lock<std::mutex> lock(simLock);
+    self->wakeNs = wakeNs;
+    self->order = ++simOrder;
+    self->channel = channel;
+    self->woken = false;
+    simSwitch();
+    self->turn.wait(lock, [self] { return simCurrent == self; });
+    self->channel = nullptr;
+    return self->woken;
+}
+
+static void simTaskMain(SimTask* task) {
+    simSelf = task;
+    {
+        std::unique_lock<std::mutex> lock(simLock);
+        task->turn.wait(lock, [task] { return simCurrent == task; });
+    }
+    task->entry(task->arg);
+    std::lock_guard<std::mutex> lock(simLock);
+    task->finished = true;
+    simWakeLocked(task);
+    simSwitch();
+}
+
+// A thread outside the simulation (none in the firmware) just moves the clock
+static void simulatedSleepUs(uint64_t us) {
+    if (!simSelf) {
+        idleUs += us;
+        simulatedNs += us * 1000;
+        return;
+    }
+    simBlock(simulatedNs.load() + us * 1000, nullptr);
+}
+
+static bool simulatedWait(const void* channel, uint64_t timeoutUs) {
+    if (!simSelf) {
+        if (timeoutUs == RT_SIM_FOREVER) {
+            fprintf(stderr, "[native] simulated time: untimed wait outside a task\n");
+            abort();
+        }
+        simulatedSleepUs(timeoutUs);
+        return false;
+    }
+    uint64_t wakeNs = timeoutUs == RT_SIM_FOREVER ? SIM_FOREVER_NS : simulatedNs.load() + timeoutUs * 1000;
+    return simBlock(wakeNs, channel);
+}
+
+static void simulatedWake(const void* channel) {
+    std::lock_guard<std::mutex> lock(simLock);
+    simWakeLocked(channel);
+}
+
+// The new task is due now and runs once the caller next blocks
+static bool simulatedStartTask(void (*entry)(void*), void* arg, const char* name, RtTaskHandle* handle) {
+    *handle = nullptr;
+    if (!simSelf) {
+        RT_LOG("Simulated time: task '%s' must be started from a simulated task\n", name);
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(simLock);
+    SimTask* task = new SimTask();
+    task->name = name;
+    task->entry = entry;
+    task->arg = arg;
+    task->wakeNs = simulatedNs.load();
+    task->order = ++simOrder;
+    task->channel = nullptr;
+    task->woken = false;
+    task->finished = false;
+    simTasks.push_back(task);
+    task->thread = new std::thread(simTaskMain, task);
+    *handle = task->thread;
+    return true;
+}
+
+static void simulatedJoinTask(RtTaskHandle handle) {
+    SimTask* task = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(simLock);
+        for (size_t i = 0; i < simTasks.size(); i++) {
+            if (simTasks[i]->thread == handle) task = simTasks[i];
+        }
+    }
+    if (!task) return;
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lock(simLock);
+            if (task->finished) break;
+        }
+        simBlock(SIM_FOREVER_NS, task);
+    }
+    // The thread only has to leave simTaskMain now
+    handle->join();
+    delete handle;
+    std::lock_guard<std::mutex> lock(simLock);
+    simTasks.erase(std::find(simTasks.begin(), simTasks.end(), task));
+    delete task;
+}
+
+static RtSimClock simulatedClock = {
+    simulatedNowUs, simulatedSleepUs, simulatedCharge,
+    simulatedWait, simulatedWake, simulatedStartTask, simulatedJoinTask
+};
+
+// The simulated clock continues from the current time so millis() never
+// goes backwards. The calling thread becomes the first simulated task.
+void nativeSetSimulatedTime(bool enabled) {
+    if (enabled == simulatedTime.load()) return;
+    std::lock_guard<std::mutex> lock(simLock);
+    if (enabled) {
+        simulatedNs = (nativeMonotonicUs() + skippedUs.load()) * 1000;
+        SimTask* task = new SimTask();
+        task->thread = nullptr;
+        task->name = "main";
+        task->wakeNs = simulatedNs.load();
+        task->order = ++simOrder;
+        task->channel = nullptr;
+        task->woken = false;
+        task->finished = false;
+        simTasks.push_back(task);
+        simCurrent = task;
+        simSelf = task;
+        simulatedTime = true;
+        rtSimClock() = &simulatedClock;
+    } else {
+        if (simTasks.size() != 1 || simCurrent != simSelf) {
+            fprintf(stderr, "[native] simulated time switched off with tasks still running\n");
+            abort();
+        }
+        rtSimClock() = nullptr;
+        delete simSelf;
+        simTasks.clear();
+        simCurrent = nullptr;
+        simSelf = nullptr;
+        skippedUs = simulatedNs.load() / 1000 - nativeMonotonicUs();
+        simulatedTime = false;
+    }
+}
+
+bool nativeSimulatedTime() { return simulatedTime.load(); }
+
+NativeCostStats nativeCostStats() {
+    NativeCostStats stats;
+    for (int c = 0; c < NATIVE_COST_COUNT; c++) {
+        stats.chargedUs[c] = chargedNs[c].load() / 1000;
+        stats.charges[c] = charges[c].load();
+    }
+    return stats;
+}
+
+unsigned long micros() {
+    if (simulatedTime.load()) return (unsigned long)simulatedNowUs();
+    return (unsigned long)(nativeMonotonicUs() + skippedUs.load());
+}
+unsigned long millis() { return micros() / 1000; }
+
+void delay(unsigned long ms) {
+    if (simulatedTime.load()) {
+        simulatedSleepUs(ms * 1000ULL);
+        return;
+    }
+    idleUs += ms * 1000ULL;
+    if (virtualTime.load()) {
+        skippedUs += ms * 1000ULL;
+        std::this_thread::yield();
+    } else {
+        std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+    }
+}
+
+void delayMicroseconds(unsigned int us) {
+    if (simulatedTime.load()) {
+        simulatedSleepUs(us);
+    } else if (!virtualTime.load()) {
+        std::this_thread::sleep_for(std::chrono::microseconds(us));
+    } else {
+        skippedUs += us;
+    }
+}
+
+void yield() { std::this_thread::yield(); }
+
+// Edge Impulse timing follows the real clock so inference latency is
+// measured even in virtual-time runs (porting/clib leaves these weak); in
+// simulated time it reads the simulated clock like everything else
+uint64_t ei_read_timer_us() { return simulatedTime.load() ? simulatedNowUs() : nativeMonotonicUs(); }
+uint64_t ei_read_timer_ms() { return ei_read_timer_us() / 1000; }
+
+// --- GPIO ---
+
+static uint8_t pinLevels[64];
+
+void pinMode(uint8_t, uint8_t) {}
+void digitalWrite(uint8_t pin, uint8_t value) { pinLevels[pin & 63] = value; }
+int digitalRead(uint8_t pin) { return pinLevels[pin & 63]; }
+
+// --- Serial ---
+
+int HardwareSerial::printf(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    int n = vprintf(format, args);
+    va_end(args);
+    return n;
+}
+
+// --- Camera replay ---
+
+static std::mutex cameraLock;
+static std::vector<std::vector<uint8_t>> frames;
+static size_t frameIndex = 0;
+static const std::vector<uint8_t>* currentFrame = nullptr;
+static size_t burstPos = 0;
+static std::atomic<uint32_t> framesCaptured(0);
+static std::atomic<uint64_t> fifoBytesRead(0);
+
+static bool isJpegName(const std::string& name) {
+    size_t dot = name.rfind('.');
+    if (dot == std::string::npos) return false;
+    std::string ext = name.substr(dot + 1);
+    for (size_t i = 0; i < ext.size(); i++) ext[i] = tolower(ext[i]);
+    return ext == "jpg" || ext == "jpeg";
+}
+
+// Stand-in when no recording is given: a JPEG-framed byte pattern that
+// shifts every capture so consecutive frames differ
+static void buildSyntheticFrames() {
+    for (int f = 0; f < 8; f++) {
+        std::vector<uint8_t> frame(6144);
+        for (size_t i = 0; i < frame.size(); i++) {
+            frame[i] = (uint8_t)((i * 7 + f * 31 + (i >> 6) * 13) & 0xFF);
+        }
+        frame[0] = 0xFF;
+        frame[1] = 0xD8;
+        frame[frame.size() - 2] = 0xFF;
+        frame[frame.size() - 1] = 0xD9;
+        frames.push_back(frame);
+    }
+}
+
+int nativeLoadFrames(const char* directory) {
+    std::lock_guard<std::mutex> guard(cameraLock);
+    frames.clear();
+    frameIndex = 0;
+    currentFrame = nullptr;
+
+    std::vector<std::string> names;
+    DIR* dir = opendir(directory);
+    if (dir) {
+        while (struct dirent* entry = readdir(dir)) {
+            if (isJpegName(entry->d_name)) names.push_back(entry->d_name);
+        }
+        closedir(dir);
+    }
+    std::sort(names.begin(), names.end());
+
+    for (size_t i = 0; i < names.size(); i++) {
+        std::string path = std::string(directory) + "/" + names[i];
+        FILE* f = fopen(path.c_str(), "rb");
+        if (!f) continue;
+        std::vector<uint8_t> data;
+        uint8_t chunk[4096];
+        size_t n;
+        while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) data.insert(data.end(), chunk, chunk + n);
+        fclose(f);
+        if (!data.empty()) frames.push_back(data);
+    }
+    return (int)frames.size();
+}
+
+// extractImageFeatures() skips a 200-byte header, samples every
+// (n / 400 + 1)th of the n bytes after it as pixels (at most 400) and splits
+// them into 20 regions: mean brightness for features 0-6, max - min for 7-13
+// and the share of neighbours more than 30 apart, in percent, for 14-19.
+// Picks the region size the row's edge densities were measured with.
+static int featureRegionSize(const float* features) {
+    for (int region = 20; region >= 5; region--) {
+        bool fits = true;
+        for (int i = 14; i < 20 && fits; i++) {
+            float edges = features[i] * region / 100.0f;
+            int whole = (int)(edges + 0.5f);
+            fits = fabsf(edges - whole) < 0.02f && whole < region;
+        }
+        if (fits) return region;
+    }
+    return 0;
+}
+
+static void buildFeatureFrame(const float* features, int region, std::vector<uint8_t>& frame) {
+    const size_t header = 200;
+    int pixelCount = 20 * region;
+    // 400 pixels only fit one byte apart in 800 bytes
+    int stride = pixelCount < 400 ? 1 : 2;
+    std::vector<uint8_t> pixels(pixelCount, 0);
+    for (int i = 0; i < 20; i++) {
+        uint8_t* p = &pixels[i * region];
+        int value = (int)(features[i] + 0.5f);
+        if (value > 255) value = 255;
+        if (i < 7) {
+            memset(p, value, region);
+        } else if (i < 14) {
+            p[1] = (uint8_t)value;
+        } else {
+            int edges = (int)(features[i] * region / 100.0f + 0.5f);
+            for (int j = 1; j <= edges; j++) p[j] = (j & 1) ? 200 : 0;
+            for (int j = edges + 1; j < region; j++) p[j] = p[edges];
+        }
+    }
+    frame.assign(header + (pixelCount - 1) * stride + 1, 0);
+    frame[0] = 0xFF;
+    frame[1] = 0xD8;
+    for (int k = 0; k < pixelCount; k++) frame[header + k * stride] = pixels[k];
+}
+
+int nativeLoadFeatureFrames(const char* csvPath) {
+    std::lock_guard<std::mutex> guard(cameraLock);
+    frames.clear();
+    frameIndex = 0;
+    currentFrame = nullptr;
+
+    FILE* f = fopen(csvPath, "r");
+    if (!f) return 0;
+    char line[512];
+    while (fgets(line, sizeof(line), f)) {
+        float features[20];
+        char* cursor = strchr(line, ',');    // Skip the label
+        int count = 0;
+        while (cursor && count < 20) {
+            char* end;
+            features[count] = strtof(cursor + 1, &end);
+            if (end == cursor + 1) break;
+            count++;
+            cursor = strchr(end, ',');
+        }
+        int region = count == 20 ? featureRegionSize(features) : 0;
+        if (region == 0) continue;           // Header line or not reproducible
+        std::vector<uint8_t> frame;
+        buildFeatureFrame(features, region, frame);
+        frames.push_back(frame);
+    }
+    fclose(f);
+    return (int)frames.size();
+}
+
+void nativeCameraCapture() {
+    std::lock_guard<std::mutex> guard(cameraLock);
+    if (frames.empty()) buildSyntheticFrames();
+    currentFrame = &frames[frameIndex];
+    frameIndex = (frameIndex + 1) % frames.size();
+    framesCaptured++;
+    if (simulatedTime.load()) {
+        captureDoneNs = simulatedNs.load() + costModel.captureUs * 1000ULL;
+        capturePending = true;
+    }
+}
+
+// Immediate in real time; in simulated time CAP_DONE rises once the
+// exposure has elapsed, so the firmware's own polling delays pay for it
+bool nativeCameraCaptureDone() {
+    if (!simulatedTime.load() || !capturePending) return true;
+    if (simulatedNs.load() < captureDoneNs) return false;
+    // Recorded once, when the firmware sees the capture finish; the clock
+    // itself was moved by the polling delays
+    chargedNs[NATIVE_COST_CAPTURE] += costModel.captureUs * 1000ULL;
+    charges[NATIVE_COST_CAPTURE]++;
+    capturePending = false;
+    return true;
+}
+
+uint32_t nativeCameraFifoLength() {
+    std::lock_guard<std::mutex> guard(cameraLock);
+    return currentFrame ? (uint32_t)currentFrame->size() : 0;
+}
+
+void nativeCameraBeginBurst() {
+    std::lock_guard<std::mutex> guard(cameraLock);
+    burstPos = 0;
+}
+
+// Past the end of the frame the FIFO reads as zeros, like the real one
+uint8_t nativeCameraBurstByte() {
+    fifoBytesRead++;
+    chargeNs(NATIVE_COST_SPI, costModel.spiByteNs);
+    if (!currentFrame || burstPos >= currentFrame->size()) return 0;
+    return (*currentFrame)[burstPos++];
+}
+
+// --- Display / I2C counters ---
+
+static std::atomic<uint32_t> i2cTransactions(0);
+static std::atomic<uint64_t> i2cBytes(0);
+static std::atomic<uint32_t> displayFrames(0);
+
+static std::atomic<bool> busTime(false);
+
+void nativeSetBusTime(bool enabled) { busTime = enabled; }
+
+void nativeCountI2c(size_t bytes) {
+    i2cTransactions++;
+    i2cBytes += bytes;
+    uint64_t ns = (uint64_t)costModel.i2cByteNs * bytes;
+    chargeNs(NATIVE_COST_I2C, ns);
+    if (busTime.load() && !simulatedTime.load()) {
+        std::this_thread::sleep_for(std::chrono::nanoseconds(ns));
+    }
+}
+
+void nativeCountDisplayFrame() { displayFrames++; }
+
+NativeHalStats nativeHalStats() {
+    NativeHalStats stats;
+    stats.framesCaptured = framesCaptured.load();
+    stats.fifoBytesRead = fifoBytesRead.load();
+    stats.i2cTransactions = i2cTransactions.load();
+    stats.i2cBytes = i2cBytes.load();
+    stats.displayFrames = displayFrames.load();
+    stats.idleUs = idleUs.load();
+    return stats;
+}
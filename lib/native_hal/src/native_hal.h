@@ -0,0 +1,102 @@
+#ifndef NATIVE_HAL_H
+#define NATIVE_HAL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "runtime/rt_platform.h"
+
+// Controls and counters for the native environment's hardware stand-ins.
+//
+// Clock: millis()/micros() count from program start. In virtual-time mode
+// delay() advances the clock instead of sleeping, so idle waits cost nothing
+// and a run measures only the work done between them.
+//
+// Simulated time goes further: the clock (including ei_read_timer_us() and
+// rtMicros()) never reads the host's, it only advances by delays and by a
+// cost model of the device - camera exposure, SPI and I2C bytes, and the
+// firmware's compute stages (rtChargeCost). Runs are deterministic and an
+// hour of device behavior takes seconds, tasks included.
+//
+// Camera: each ArduCAM capture serves the next recorded JPEG (cycling), read
+// back through the normal FIFO burst over SPI.
+
+void nativeSetVirtualTime(bool enabled);
+bool nativeVirtualTime();
+uint64_t nativeMonotonicUs();  // Real elapsed time, never virtual
+
+// Device costs charged to the simulated clock. Defaults are estimates for
+// the ESP32 + ArduCAM at 160x120 JPEG; measure and override per board.
+struct NativeCostModel {
+    uint32_t captureUs;                     // start_capture() until CAP_DONE
+    uint32_t spiByteNs;                     // One FIFO burst byte
+    uint32_t i2cByteNs;                     // One OLED byte at 400 kHz
+    uint32_t stageUs[RT_COST_STAGE_COUNT];  // Per rtChargeCost() unit
+};
+
+NativeCostModel nativeDefaultCostModel();
+void nativeSetCostModel(const NativeCostModel& model);
+// "name=value" with a name from nativeCostNames(); false if unknown
+bool nativeSetCost(const char* assignment);
+const char* nativeCostNames();
+
+// Switch on before setup(), from the thread that runs it, and off only once
+// every task started since has been joined. Tasks share one simulated core
+// (RtSimClock in runtime/rt_platform.h).
+void nativeSetSimulatedTime(bool enabled);
+bool nativeSimulatedTime();
+
+// Real-time runs only: each I2C transaction blocks its caller for its
+// modelled bus time (i2cByteNs per byte), so a blocking OLED flush stalls
+// the loop as it would on the device
+void nativeSetBusTime(bool enabled);
+
+// Simulated time charged per cost, for capacity planning
+enum NativeCost {
+    NATIVE_COST_CAPTURE,
+    NATIVE_COST_SPI,
+    NATIVE_COST_I2C,
+    NATIVE_COST_FEATURES,
+    NATIVE_COST_ANALYZE,
+    NATIVE_COST_DSP,
+    NATIVE_COST_INFERENCE,
+    NATIVE_COST_COUNT
+};
+
+struct NativeCostStats {
+    uint64_t chargedUs[NATIVE_COST_COUNT];
+    uint32_t charges[NATIVE_COST_COUNT];
+};
+
+NativeCostStats nativeCostStats();
+const char* nativeCostName(int cost);
+
+// Load every *.jpg / *.jpeg in a directory (sorted); returns the count.
+// Without frames the camera serves a synthetic test image.
+int nativeLoadFrames(const char* directory);
+
+// Load a feature CSV (label, 20 features per line, as in
+// data/finger_detection_data.csv) as frames that extractImageFeatures()
+// reads back as those features; returns the count
+int nativeLoadFeatureFrames(const char* csvPath);
+
+struct NativeHalStats {
+    uint32_t framesCaptured;
+    uint64_t fifoBytesRead;
+    uint32_t i2cTransactions;
+    uint64_t i2cBytes;
+    uint32_t displayFrames;        // Adafruit_SSD1306::display() calls
+    uint64_t idleUs;               // Time spent (or skipped) in delay()
+};
+
+NativeHalStats nativeHalStats();
+
+// Used by the stand-ins themselves
+void nativeCameraCapture();
+bool nativeCameraCaptureDone();
+uint32_t nativeCameraFifoLength();
+void nativeCameraBeginBurst();
+uint8_t nativeCameraBurstByte();
+void nativeCountI2c(size_t bytes);
+void nativeCountDisplayFrame();
+
+#endif
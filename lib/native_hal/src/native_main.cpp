@@ -0,0 +1,165 @@
+// Entry point for the native environment: runs the firmware's setup() and
+// loop() against the stand-ins for a fixed time and reports throughput.
+//
+//   .pio/build/native/program [--frames DIR | --features CSV] [--seconds N] [--bus-time]
+//                             [--virtual-time | --sim-time [--cost NAME=VALUE]...]
+//
+// --frames        replay recorded JPEGs from DIR
+// --features      serve frames that read back as the rows of a feature CSV
+//                 (default: data/finger_detection_data.csv from the working
+//                 directory, so the model sees in-distribution inputs and the
+//                 anomaly gate passes them; synthetic frames if it is missing)
+// --seconds       run length in firmware time (default 30)
+// --virtual-time  delay() advances the clock instead of sleeping. Only the
+//                 Arduino clock is virtual; the task runtime's threads run in
+//                 real time, so use it with USE_TASK_RUNTIME false.
+// --sim-time      deterministic simulated clock: only delays and the device
+//                 cost model (camera, SPI, I2C, compute stages) advance it.
+//                 Tasks take turns on one simulated core.
+//                 The summary adds where the simulated time went and the
+//                 frame rate the pipeline could sustain.
+// --cost          override one cost model entry, e.g. --cost inference_us=8000
+// --bus-time      real time only: I2C transfers take their modelled time, for
+//                 measuring what a blocking OLED flush does to loop jitter
+//
+// Host tools with their own main() (env:replay) define NATIVE_HAL_NO_MAIN;
+// `pio test -e native` (PIO_UNIT_TESTING) links the tests' main() instead.
+
+#if !defined(NATIVE_HAL_NO_MAIN) && !defined(PIO_UNIT_TESTING)
+
+#include <Arduino.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <algorithm>
+#include "native_hal.h"
+
+void setup();
+void loop();
+
+static void usage(const char* program) {
+    printf("usage: %s [--frames DIR | --features CSV] [--seconds N] [--bus-time] [--virtual-time | --sim-time [--cost NAME=VALUE]...]\n", program);
+    printf("costs: %s\n", nativeCostNames());
+}
+
+static uint64_t percentile(std::vector<uint32_t>& values, float p) {
+    if (values.empty()) return 0;
+    size_t index = (size_t)(p * (values.size() - 1));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+int main(int argc, char** argv) {
+    const char* frameDir = nullptr;
+    const char* featureCsv = "data/finger_detection_data.csv";
+    unsigned long seconds = 30;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            frameDir = argv[++i];
+        } else if (strcmp(argv[i], "--features") == 0 && i + 1 < argc) {
+            featureCsv = argv[++i];
+        } else if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            seconds = strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--bus-time") == 0) {
+            nativeSetBusTime(true);
+        } else if (strcmp(argv[i], "--virtual-time") == 0) {
+            nativeSetVirtualTime(true);
+        } else if (strcmp(argv[i], "--sim-time") == 0) {
+            nativeSetSimulatedTime(true);
+        } else if (strcmp(argv[i], "--cost") == 0 && i + 1 < argc) {
+            if (!nativeSetCost(argv[++i])) {
+                usage(argv[0]);
+                return 2;
+            }
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    if (frameDir) {
+        int count = nativeLoadFrames(frameDir);
+        printf("[native] %d frames loaded from %s\n", count, frameDir);
+        if (count == 0) return 1;
+    } else if (int count = nativeLoadFeatureFrames(featureCsv)) {
+        printf("[native] %d frames built from the features in %s\n", count, featureCsv);
+    } else {
+        printf("[native] no frames from %s, using synthetic frames\n", featureCsv);
+    }
+
+    uint64_t realStart = nativeMonotonicUs();
+    setup();
+    uint64_t setupUs = nativeMonotonicUs() - realStart;
+    NativeHalStats atLoop = nativeHalStats();
+
+    // Busy time per loop() call: elapsed time minus what delay() accounted
+    // for (simulated time when simulating, otherwise wall time)
+    bool simulated = nativeSimulatedTime();
+    std::vector<uint32_t> busyUs;
+    unsigned long endMs = millis() + seconds * 1000UL;
+    uint64_t loopStart = nativeMonotonicUs();
+    uint64_t simStart = micros();
+    NativeCostStats costsAtLoop = nativeCostStats();
+    while ((long)(millis() - endMs) < 0) {
+        uint64_t idleBefore = nativeHalStats().idleUs;
+        uint64_t t0 = simulated ? micros() : nativeMonotonicUs();
+        loop();
+        uint64_t elapsed = (simulated ? micros() : nativeMonotonicUs()) - t0;
+        uint64_t idle = nativeHalStats().idleUs - idleBefore;
+        if (nativeVirtualTime()) idle = 0;    // Skipped delays took no wall time
+        busyUs.push_back((uint32_t)(elapsed > idle ? elapsed - idle : 0));
+    }
+    uint64_t realUs = nativeMonotonicUs() - loopStart;
+    uint64_t simUs = micros() - simStart;
+
+    NativeHalStats stats = nativeHalStats();
+    uint32_t frames = stats.framesCaptured - atLoop.framesCaptured;
+    uint64_t totalBusy = 0;
+    for (size_t i = 0; i < busyUs.size(); i++) totalBusy += busyUs[i];
+
+    printf("\n[native] ---- run summary ----\n");
+    printf("[native] setup: %.1f ms wall\n", setupUs / 1000.0);
+    printf("[native] %lu s firmware time in %.2f s wall (%s time)\n",
+           seconds, realUs / 1e6, simulated ? "simulated" : nativeVirtualTime() ? "virtual" : "real");
+    printf("[native] loop(): %lu calls, busy avg %llu us, p50 %llu us, p99 %llu us, max %llu us\n",
+           (unsigned long)busyUs.size(),
+           (unsigned long long)(busyUs.empty() ? 0 : totalBusy / busyUs.size()),
+           (unsigned long long)percentile(busyUs, 0.5f),
+           (unsigned long long)percentile(busyUs, 0.99f),
+           (unsigned long long)percentile(busyUs, 1.0f));
+    printf("[native] camera: %lu frames, %.2f fps firmware time, %llu FIFO bytes read\n",
+           (unsigned long)frames, seconds > 0 ? frames / (double)seconds : 0.0,
+           (unsigned long long)(stats.fifoBytesRead - atLoop.fifoBytesRead));
+    printf("[native] display: %lu frames, %lu I2C transactions, %llu bytes\n",
+           (unsigned long)stats.displayFrames, (unsigned long)stats.i2cTransactions,
+           (unsigned long long)stats.i2cBytes);
+
+    if (simulated) {
+        // Where the simulated time went. Camera exposure is spent polling
+        // CAP_DONE (idle to the CPU) but still bounds the frame rate.
+        NativeCostStats costs = nativeCostStats();
+        uint64_t frameUs = 0;
+        printf("[native] simulated cost breakdown over %.1f s:\n", simUs / 1e6);
+        for (int c = 0; c < NATIVE_COST_COUNT; c++) {
+            uint64_t us = costs.chargedUs[c] - costsAtLoop.chargedUs[c];
+            uint32_t n = costs.charges[c] - costsAtLoop.charges[c];
+            if (c != NATIVE_COST_I2C) frameUs += us;
+            printf("[native]   %-10s %10.3f s %5.1f%%  %8lu charges\n", nativeCostName(c), us / 1e6,
+                   simUs > 0 ? 100.0 * us / simUs : 0.0, (unsigned long)n);
+        }
+        printf("[native] CPU busy %.1f%% of simulated time\n",
+               simUs > 0 ? 100.0 * totalBusy / simUs : 0.0);
+        if (frames > 0 && frameUs > 0) {
+            frameUs /= frames;
+            printf("[native] pipeline %.1f ms per frame: sustains up to %.2f fps (ran at %.2f fps)\n",
+                   frameUs / 1000.0, 1e6 / frameUs, frames * 1e6 / simUs);
+        }
+    }
+    fflush(stdout);
+
+    // Runtime tasks are still running; leave without unwinding them
+    _Exit(0);
+}
+
+#endif // !NATIVE_HAL_NO_MAIN && !PIO_UNIT_TESTING
@@ -0,0 +1,150 @@
+#ifndef ANOMALY_GATE_H
+#define ANOMALY_GATE_H
+
+#include <Arduino.h>
+#include <math.h>
+#include "finger_anomaly_clusters.h"
+
+// Open-set rejection in front of the network. Scores a feature vector the
+// same way as the SDK's K-means anomaly block (standard scaler, then
+// get_min_distance_to_cluster: distance to the nearest centroid minus that
+// cluster's radius) using clusters fitted from data/finger_detection_data.csv.
+// Frames scoring above the threshold are out of distribution and skip the
+// network. The default threshold is the one tools/fit_anomaly_clusters.py
+// chose on rows held out of the fit; the generated header says what fraction
+// of them it passes.
+class AnomalyGate {
+public:
+    static constexpr int AXES = FINGER_ANOMALY_AXES;
+    static constexpr int CLUSTERS = FINGER_ANOMALY_CLUSTER_COUNT;
+
+private:
+    float invScale[AXES];
+    float threshold;
+    bool enabled;
+
+    unsigned long frames;
+    unsigned long rejected;
+    uint64_t totalScoreUs;
+    float lastScore;
+
+    void scaleInput(const float* features, float* out) const {
+        for (int i = 0; i < AXES; i++) {
+            out[i] = (features[i] - finger_anomaly_mean[i]) * invScale[i];
+        }
+    }
+
+    // Squared distance with four independent accumulators so the compiler
+    // can pipeline (or vectorize) the loop; gives up once the partial sum
+    // exceeds bound since the cluster can no longer be the nearest one.
+    static float distance2(const float* x, const float* c, float bound) {
+        float a0 = 0.0f, a1 = 0.0f, a2 = 0.0f, a3 = 0.0f;
+        int i = 0;
+        for (; i + 4 <= AXES; i += 4) {
+            float d0 = x[i] - c[i];
+            float d1 = x[i + 1] - c[i + 1];
+            float d2 = x[i + 2] - c[i + 2];
+            float d3 = x[i + 3] - c[i + 3];
+            a0 += d0 * d0;
+            a1 += d1 * d1;
+            a2 += d2 * d2;
+            a3 += d3 * d3;
+            if ((i & 7) == 4 && (a0 + a1) + (a2 + a3) > bound) {
+                return (a0 + a1) + (a2 + a3);
+            }
+        }
+        for (; i < AXES; i++) {
+            float d = x[i] - c[i];
+            a0 += d * d;
+        }
+        return (a0 + a1) + (a2 + a3);
+    }
+
+public:
+    AnomalyGate(float scoreThreshold = FINGER_ANOMALY_THRESHOLD) {
+        for (int i = 0; i < AXES; i++) {
+            invScale[i] = 1.0f / finger_anomaly_scale[i];
+        }
+        threshold = scoreThreshold;
+        enabled = true;
+        lastScore = 0.0f;
+        resetStats();
+    }
+
+    void setThreshold(float scoreThreshold) { threshold = scoreThreshold; }
+    float getThreshold() const { return threshold; }
+    void setEnabled(bool enable) { enabled = enable; }
+    bool isEnabled() const { return enabled; }
+
+    // Minimum distance to any cluster boundary (<= 0 means inside a cluster)
+    float score(const float* features) const {
+        float x[AXES];
+        scaleInput(features, x);
+
+        float best = INFINITY;
+        for (int c = 0; c < CLUSTERS; c++) {
+            float radius = finger_anomaly_max_error[c];
+            float reach = best + radius;
+            float bound = isinf(best) ? INFINITY : (reach > 0.0f ? reach * reach : 0.0f);
+            float d2 = distance2(x, finger_anomaly_centroids[c], bound);
+            if (d2 > bound) continue;
+            float dist = sqrtf(d2) - radius;
+            if (dist < best) best = dist;
+        }
+        return best;
+    }
+
+    // Straight port of the SDK scoring path, kept for validation and the
+    // anomaly_gate cases in src/bench
+    float scoreReference(const float* features) const {
+        float x[AXES];
+        for (int i = 0; i < AXES; i++) {
+            x[i] = (features[i] - finger_anomaly_mean[i]) / finger_anomaly_scale[i];
+        }
+        float min = 1000.0f;
+        for (int c = 0; c < CLUSTERS; c++) {
+            float dist = 0.0f;
+            for (int i = 0; i < AXES; i++) {
+                dist += pow(x[i] - finger_anomaly_centroids[c][i], 2);
+            }
+            dist = sqrt(dist) - finger_anomaly_max_error[c];
+            if (dist < min) min = dist;
+        }
+        return min;
+    }
+
+    // True when the frame is out of distribution and should not be classified
+    bool reject(const float* features) {
+        if (!enabled) return false;
+
+        unsigned long start = micros();
+        lastScore = score(features);
+        totalScoreUs += micros() - start;
+        frames++;
+
+        if (lastScore > threshold) {
+            rejected++;
+            return true;
+        }
+        return false;
+    }
+
+    void resetStats() {
+        frames = 0;
+        rejected = 0;
+        totalScoreUs = 0;
+    }
+
+    float getLastScore() const { return lastScore; }
+    unsigned long getRejectedCount() const { return rejected; }
+    float getRejectionRate() const { return frames > 0 ? (float)rejected / frames : 0.0f; }
+
+    // Per-frame cost of the gate vs. the SDK-style reference on one input
+    void printStats() {
+        Serial.printf("Anomaly gate: %lu frames, %lu rejected (%.1f%%), avg %.1f us, threshold %.2f\n",
+                     frames, rejected, getRejectionRate() * 100.0f,
+                     frames > 0 ? (float)totalScoreUs / frames : 0.0f, threshold);
+    }
+};
+
+#endif
@@ -0,0 +1,126 @@
+#ifndef DECISION_CACHE_H
+#define DECISION_CACHE_H
+
+#include <Arduino.h>
+#include <math.h>
+
+// Remembers the last classification together with the feature vector it came
+// from. When the next frame's features stay within a per-feature tolerance of
+// it and the entry is younger than maxAgeMs, the cached answer is returned and
+// the network is skipped entirely. A cheap signature of the quantized features
+// is kept too, but only to reject a changed scene early: a bucket hash can
+// match features almost a whole bucket apart, or collide outright, so a
+// signature mismatch is a miss and a match still has to pass the tolerance.
+template <int N>
+class DecisionCache {
+private:
+    float cachedFeatures[N];
+    uint32_t cachedSignature;
+    int cachedResult;
+    unsigned long cachedAtMs;
+    bool valid;
+
+    // Settings
+    unsigned long maxAgeMs;    // 0 disables the cache
+    float bucketSize;          // Quantization step for the signature
+    float tolerance;           // Max per-feature delta for a hit
+
+    // Statistics
+    unsigned long lookups;
+    unsigned long hits;
+    uint32_t lastMissCostUs;   // Cost of the most recent full inference
+    uint64_t savedUs;
+
+    uint32_t signatureOf(const float* features) const {
+        // FNV-1a over the quantized features
+        uint32_t hash = 2166136261u;
+        for (int i = 0; i < N; i++) {
+            int32_t bucket = (int32_t)floorf(features[i] / bucketSize);
+            for (int b = 0; b < 4; b++) {
+                hash ^= (uint8_t)(bucket >> (b * 8));
+                hash *= 16777619u;
+            }
+        }
+        return hash;
+    }
+
+    bool withinTolerance(const float* features) const {
+        for (int i = 0; i < N; i++) {
+            if (fabsf(features[i] - cachedFeatures[i]) > tolerance) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+public:
+    DecisionCache() {
+        maxAgeMs = 3000;
+        bucketSize = 8.0f;
+        tolerance = 4.0f;
+        valid = false;
+        resetStats();
+    }
+
+    void setMaxAge(unsigned long ms) { maxAgeMs = ms; }
+    unsigned long getMaxAge() const { return maxAgeMs; }
+
+    void setTolerance(float quantizationStep, float featureTolerance) {
+        bucketSize = quantizationStep > 0.0f ? quantizationStep : 1.0f;
+        tolerance = featureTolerance;
+        valid = false;
+    }
+
+    void invalidate() { valid = false; }
+
+    // Returns true and fills result when the features match a fresh entry
+    bool lookup(const float* features, unsigned long nowMs, int& result) {
+        if (maxAgeMs == 0) {
+            return false;
+        }
+
+        lookups++;
+        if (!valid || nowMs - cachedAtMs > maxAgeMs) {
+            return false;
+        }
+
+        if (signatureOf(features) != cachedSignature || !withinTolerance(features)) {
+            return false;
+        }
+
+        hits++;
+        savedUs += lastMissCostUs;
+        result = cachedResult;
+        return true;
+    }
+
+    // Record a freshly computed result and what it cost to compute
+    void store(const float* features, int result, unsigned long nowMs, uint32_t costUs) {
+        memcpy(cachedFeatures, features, sizeof(cachedFeatures));
+        cachedSignature = signatureOf(features);
+        cachedResult = result;
+        cachedAtMs = nowMs;
+        lastMissCostUs = costUs;
+        valid = true;
+    }
+
+    void resetStats() {
+        lookups = 0;
+        hits = 0;
+        lastMissCostUs = 0;
+        savedUs = 0;
+    }
+
+    unsigned long getLookups() const { return lookups; }
+    unsigned long getHits() const { return hits; }
+    float getHitRate() const { return lookups > 0 ? (float)hits / lookups : 0.0f; }
+    uint64_t getSavedUs() const { return savedUs; }
+
+    void printStats() {
+        Serial.printf("Decision cache: %lu/%lu hits (%.1f%%), saved %lu ms, max age %lu ms\n",
+                     hits, lookups, getHitRate() * 100.0f,
+                     (unsigned long)(savedUs / 1000), maxAgeMs);
+    }
+};
+
+#endif
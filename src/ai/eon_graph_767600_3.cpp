@@ -0,0 +1,7 @@
+// tflite_learn_767600_3 with its EON graph hooks (eon_graph_hooks.h). The
+// generated graph is compiled here, not from src/tflite-model.
+#include "../tflite-model/tflite_learn_767600_3_compiled.cpp"
+
+#define EON_GRAPH_MODEL tflite_learn_767600_3
+#define EON_GRAPH_OP_NAMES "FULLY_CONNECTED", "SOFTMAX"
+#include "eon_graph_hooks_impl.h"
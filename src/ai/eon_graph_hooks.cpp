@@ -0,0 +1,13 @@
+#include "eon_graph_hooks.h"
+
+static const EonGraphHooks* const graphHooks[] = {
+    &tflite_learn_767600_3_hooks,
+    &tflite_learn_766107_3_hooks,
+};
+
+const EonGraphHooks* findEonGraphHooks(TfLiteStatus (*invoke)()) {
+    for (size_t i = 0; i < sizeof(graphHooks) / sizeof(graphHooks[0]); i++) {
+        if (graphHooks[i]->invoke == invoke) return graphHooks[i];
+    }
+    return nullptr;
+}
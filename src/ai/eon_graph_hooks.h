@@ -0,0 +1,39 @@
+#ifndef EON_GRAPH_HOOKS_H
+#define EON_GRAPH_HOOKS_H
+
+#include <stddef.h>
+#include "edge-impulse-sdk/tensorflow/lite/c/common.h"
+#include "edge-impulse-sdk/tensorflow/lite/micro/micro_profiler_interface.h"
+
+// Profiling and description hooks for the compiled EON graphs. The files in
+// src/tflite-model are kept exactly as Edge Impulse exports them (compare
+// data/ESP32-Finger_Counter_inferencing/src); the hooks live in one wrapper
+// per graph (eon_graph_<model>.cpp) that compiles the generated .cpp in its
+// own translation unit so it can reach the graph's internals. A re-export
+// only has to replace src/tflite-model.
+struct EonGraphHooks {
+    const char* name;
+    // The graph these describe (its model_invoke)
+    TfLiteStatus (*invoke)();
+    // Reports every node of invoke() to profiler, tagged with its op name
+    // (nullptr turns it off). Call it after init: init reinstalls the kernels.
+    void (*setProfiler)(tflite::MicroProfilerInterface* profiler);
+    // Describes node index for offline cost estimates: its op name and the
+    // indices of its input and output tensors. Returns false past the last node.
+    bool (*nodeInfo)(size_t index, const char** opName,
+                     const TfLiteIntArray** inputs, const TfLiteIntArray** outputs);
+    // Returns the tensor with the given index (as used by nodeInfo). Type,
+    // dims and bytes are valid at any time, data only between init and reset.
+    TfLiteStatus (*tensorInfo)(int index, TfLiteTensor* tensor);
+    // Size of the tensor arena init allocates
+    size_t (*arenaSize)();
+};
+
+extern const EonGraphHooks tflite_learn_767600_3_hooks;
+extern const EonGraphHooks tflite_learn_766107_3_hooks;
+
+// Hooks of the graph whose model_invoke is invoke, nullptr for graphs
+// without a wrapper
+const EonGraphHooks* findEonGraphHooks(TfLiteStatus (*invoke)());
+
+#endif
@@ -0,0 +1,91 @@
+// Body of the EON graph hooks (eon_graph_hooks.h), included by each
+// eon_graph_<model>.cpp right after the generated graph with
+//   EON_GRAPH_MODEL     the graph's function prefix, e.g. tflite_learn_767600_3
+//   EON_GRAPH_OP_NAMES  a profiler tag per used_operators_e entry, in order
+// Only the generated graph's internals are used (registrations, used_ops,
+// tflNodes, init_tflite_tensor, ...), so nothing in it has to change.
+
+#include <utility>
+#include "eon_graph_hooks.h"
+
+#define EON_GRAPH_CONCAT_(a, b) a##b
+#define EON_GRAPH_CONCAT(a, b) EON_GRAPH_CONCAT_(a, b)
+#define EON_GRAPH_FN(suffix) EON_GRAPH_CONCAT(EON_GRAPH_MODEL, suffix)
+#define EON_GRAPH_STRING_(a) #a
+#define EON_GRAPH_STRING(a) EON_GRAPH_STRING_(a)
+
+namespace {
+
+typedef TfLiteStatus (*eon_kernel_invoke_t)(TfLiteContext* context, TfLiteNode* node);
+
+const char* const eon_op_names[] = { EON_GRAPH_OP_NAMES };
+static_assert(sizeof(eon_op_names) / sizeof(eon_op_names[0]) == OP_LAST,
+              "EON_GRAPH_OP_NAMES needs one tag per used_operators_e entry");
+
+tflite::MicroProfilerInterface* eon_profiler = nullptr;
+// The kernels' own invoke while a profiled one is installed
+eon_kernel_invoke_t eon_kernel_invoke[OP_LAST];
+
+template <size_t Op>
+TfLiteStatus eon_profiled_invoke(TfLiteContext* context, TfLiteNode* node) {
+    uint32_t event = eon_profiler->BeginEvent(eon_op_names[Op]);
+    TfLiteStatus status = eon_kernel_invoke[Op](context, node);
+    eon_profiler->EndEvent(event);
+    return status;
+}
+
+// Wraps (or unwraps) the registration invoke() calls for every node of op Op
+template <size_t Op>
+int eon_install_op(bool profiled) {
+    TfLiteRegistration& registration = registrations[Op];
+    if (registration.invoke != &eon_profiled_invoke<Op>) {
+        eon_kernel_invoke[Op] = registration.invoke;
+    }
+    registration.invoke = profiled ? &eon_profiled_invoke<Op> : eon_kernel_invoke[Op];
+    return 0;
+}
+
+template <size_t... Op>
+void eon_install(bool profiled, std::index_sequence<Op...>) {
+    int installed[] = { eon_install_op<Op>(profiled)... };
+    (void)installed;
+}
+
+void eon_set_profiler(tflite::MicroProfilerInterface* profiler) {
+    eon_profiler = profiler;
+    eon_install(profiler != nullptr, std::make_index_sequence<OP_LAST>());
+}
+
+bool eon_node_info(size_t index, const char** op_name,
+                   const TfLiteIntArray** inputs, const TfLiteIntArray** outputs) {
+    if (index >= tflNodes_subgraph_index[1]) {
+        return false;
+    }
+    *op_name = eon_op_names[used_ops[index]];
+    *inputs = tflNodes[index].inputs;
+    *outputs = tflNodes[index].outputs;
+    return true;
+}
+
+TfLiteStatus eon_tensor_info(int index, TfLiteTensor* tensor) {
+    if (index < 0 || (size_t)index >= tflTensors_subgraph_index[1]) {
+        return kTfLiteError;
+    }
+    init_tflite_tensor(index, tensor);
+    return kTfLiteOk;
+}
+
+size_t eon_arena_size() {
+    return kTensorArenaSize;
+}
+
+} // namespace
+
+const EonGraphHooks EON_GRAPH_FN(_hooks) = {
+    EON_GRAPH_STRING(EON_GRAPH_MODEL),
+    &EON_GRAPH_FN(_invoke),
+    &eon_set_profiler,
+    &eon_node_info,
+    &eon_tensor_info,
+    &eon_arena_size,
+};
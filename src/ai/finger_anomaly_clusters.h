@@ -0,0 +1,34 @@
+#ifndef FINGER_ANOMALY_CLUSTERS_H
+#define FINGER_ANOMALY_CLUSTERS_H
+
+// Generated by tools/fit_anomaly_clusters.py from data/finger_detection_data.csv - do not edit.
+// K-means clusters over the standard-scaled 20-feature vector, fitted on
+// 192 rows, less 2 outliers dropped with the clusters they formed.
+// Members per cluster: 10, 10, 5, 13, 24, 11, 12, 35, 27, 16, 27.
+// The threshold passes 95.8% of the 48 held-out rows and 97.9% of the
+// fitted ones.
+
+#define FINGER_ANOMALY_CLUSTER_COUNT 11
+#define FINGER_ANOMALY_AXES 20
+#define FINGER_ANOMALY_THRESHOLD -0.064794f
+
+static const float finger_anomaly_mean[FINGER_ANOMALY_AXES] = { 44.067708f, 73.380208f, 106.171875f, 131.833333f, 122.661458f, 124.750000f, 124.604167f, 231.869792f, 232.276042f, 228.526042f, 232.322917f, 230.744792f, 229.385417f, 229.781250f, 72.897500f, 73.513229f, 72.859583f, 72.845521f, 58.713750f, 22.280208f };
+static const float finger_anomaly_scale[FINGER_ANOMALY_AXES] = { 13.843267f, 17.636557f, 9.110813f, 13.750126f, 17.521563f, 18.083429f, 17.655546f, 19.060177f, 18.216918f, 19.428001f, 19.864381f, 19.282507f, 26.980074f, 21.678620f, 10.858629f, 11.247201f, 11.867557f, 12.027828f, 26.161885f, 21.209677f };
+
+static const float finger_anomaly_centroids[FINGER_ANOMALY_CLUSTER_COUNT][FINGER_ANOMALY_AXES] = {
+    { 0.168478f, 0.522766f, -0.040817f, 0.695751f, -0.602769f, -1.036861f, 0.656781f, 0.515746f, 0.275785f, -0.969016f, 0.003880f, 0.288096f, 0.300762f, -0.215939f, -0.961678f, -0.793284f, -0.608093f, 0.589922f, -0.480537f, -0.703179f },
+    { -0.351630f, -0.531862f, -0.370096f, 0.993930f, 0.886824f, -0.517048f, -0.323081f, -0.407645f, 0.171487f, -0.969016f, 0.602943f, 0.272538f, 0.189569f, -1.230763f, 0.255511f, 0.662456f, -0.475126f, 0.059984f, 0.748732f, 0.850687f },
+    { 0.356295f, 0.715547f, 0.837261f, -0.569692f, 1.514622f, -0.207372f, -1.393566f, 0.363596f, 0.028762f, 0.178812f, 0.507294f, 0.189561f, -0.125478f, 0.471375f, -0.897305f, -0.452844f, 0.778965f, -0.017752f, -0.675095f, -0.454991f },
+    { -0.038231f, -0.047727f, 0.251313f, -0.183681f, -0.498722f, 0.975181f, 1.024502f, 0.438662f, -0.154499f, 0.859827f, 0.285792f, 0.332377f, -0.222416f, 0.290409f, 0.072488f, 0.447209f, -0.578919f, 0.574554f, 0.661594f, -0.076934f },
+    { -0.516572f, -0.976015f, -0.192651f, 0.493935f, -0.318358f, -0.414744f, 0.602974f, 0.291019f, 0.289051f, 0.363254f, 0.491353f, 0.177460f, 0.137061f, 0.209980f, 0.025287f, -0.067156f, -0.028053f, -0.665791f, 0.402239f, 1.092632f },
+    { -0.471150f, 0.576374f, -1.495632f, -0.556469f, -0.162273f, -0.162127f, 0.537324f, 0.674573f, -0.194806f, 0.267718f, -0.309151f, -0.736384f, -0.017655f, 0.072993f, 0.189941f, -0.582735f, 0.517489f, 0.142618f, 0.679958f, 2.045112f },
+    { 0.284058f, 0.569071f, 0.118335f, -1.290897f, 0.975286f, -0.400920f, 0.414176f, 0.264786f, 0.309637f, -0.503193f, -0.762986f, -0.159633f, 0.140150f, -0.558826f, -0.048886f, -0.218712f, 0.069412f, -1.243064f, 0.234071f, -0.244042f },
+    { -0.510552f, -1.042165f, -0.128625f, 0.313417f, 0.030736f, -0.287951f, -0.535883f, 0.113261f, 0.044446f, -0.110902f, 0.318874f, 0.096212f, 0.215514f, 0.313220f, 0.363233f, 0.376137f, -0.031937f, 0.407167f, 0.549216f, -0.067055f },
+    { 0.152961f, 0.442545f, 0.033982f, -0.087541f, -0.821970f, 0.972345f, -0.502019f, -0.585833f, 0.480926f, 0.516240f, -0.115074f, 0.334002f, -0.011540f, -0.010411f, -0.007478f, 0.093069f, 0.326790f, 0.057924f, 0.164090f, -0.535841f },
+    { 0.085406f, 0.166262f, 0.365294f, 0.089393f, -0.091257f, 0.459675f, 0.362256f, 0.288833f, -1.377211f, 0.104821f, -0.255378f, 0.366535f, 0.027412f, 0.237850f, 0.163177f, -0.101868f, 0.457532f, 0.042306f, -0.119353f, -0.337091f },
+    { 0.356295f, 0.715547f, 0.074634f, -0.399996f, 0.406146f, -0.233998f, -0.388741f, -0.360426f, 0.224754f, -0.080455f, -0.245589f, -0.474637f, 0.051607f, 0.093805f, 0.036453f, 0.171179f, 0.184353f, 0.280310f, -1.730127f, -0.802474f },
+};
+
+static const float finger_anomaly_max_error[FINGER_ANOMALY_CLUSTER_COUNT] = { 4.275273f, 6.487784f, 3.075714f, 3.905381f, 4.618321f, 3.985221f, 5.396006f, 4.151572f, 4.198062f, 4.435252f, 4.303878f };
+
+#endif
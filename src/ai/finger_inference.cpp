@@ -1,4 +1,7 @@
 #include "finger_inference.h"
+#include "../ESP32-Finger_Counter_inferencing.h"
+#include "../runtime/trace.h"
+#include "../runtime/metrics.h"
 
 // Static member definition
 float FingerInference::staticFeatures[FingerInference::FEATURE_COUNT];
@@ -8,12 +11,7 @@ static int get_signal_data(size_t offset, size_t length, float* out_ptr) {
     return FingerInference::get_signal_data(offset, length, out_ptr);
 }
 
-int FingerInference::runInference() {
-    if (!extractImageFeatures()) {
-        Serial.println("Failed to extract image features");
-        return -1;
-    }
-    
+EI_IMPULSE_ERROR FingerInference::classifyFeatures(ei_impulse_result_t* result) {
     // Copy features to static buffer for callback access
     copyFeaturesToStatic();
     
@@ -22,12 +20,100 @@ int FingerInference::runInference() {
     signal.total_length = FEATURE_COUNT;
     signal.get_data = ::get_signal_data;
     
-    // Run inference
-    ei_impulse_result_t result = { 0 };
-    EI_IMPULSE_ERROR inferenceResult = run_classifier(&signal, &result, false);
+    TRACE_BEGIN(TRACE_CLASSIFY);
+    EI_IMPULSE_ERROR err = run_classifier(&signal, result, false);
+    rtChargeCost(RT_COST_DSP);
+    rtChargeCost(RT_COST_INFERENCE);
+    TRACE_END(TRACE_CLASSIFY);
+    
+    // The SDK's own split of the classify span
+    TRACE_INSTANT(TRACE_EI_DSP, result->timing.dsp_us);
+    TRACE_INSTANT(TRACE_EI_NN, result->timing.classification_us);
+    if (err == EI_IMPULSE_OK) {
+        PipelineMetrics::instance().observe(METRICS_STAGE_DSP, (uint32_t)result->timing.dsp_us);
+    }
+    return err;
+}
+
+bool FingerInference::computeProbabilities(float* probabilities) {
+    if (ensemble) {
+        EnsembleResult result;
+        TRACE_BEGIN(TRACE_CLASSIFY);
+        bool ok = ensemble->classify(features, result);
+        rtChargeCost(RT_COST_INFERENCE, ModelEnsemble::MODEL_COUNT);
+        TRACE_END(TRACE_CLASSIFY);
+        if (!ok) {
+            Serial.println("Ensemble inference failed");
+            return false;
+        }
+        
+        Serial.printf("Ensemble: %d fingers (%.3f) | %s: %d (%.3f, %lu us) | %s: %d (%.3f, %lu us)%s\n",
+                     result.label, result.confidence,
+                     ensemble->getModelName(0), result.modelLabels[0], result.modelConfidence[0],
+                     (unsigned long)result.modelInvokeUs[0],
+                     ensemble->getModelName(1), result.modelLabels[1], result.modelConfidence[1],
+                     (unsigned long)result.modelInvokeUs[1],
+                     result.modelsAgree ? "" : " [disagree]");
+        memcpy(probabilities, result.probabilities, sizeof(result.probabilities));
+        return true;
+    }
     
+    ei_impulse_result_t result = { 0 };
+    EI_IMPULSE_ERROR inferenceResult = classifyFeatures(&result);
     if (inferenceResult != EI_IMPULSE_OK) {
         Serial.printf("Inference failed: %d\n", inferenceResult);
+        return false;
+    }
+    
+    for (int i = 0; i < EI_CLASSIFIER_LABEL_COUNT; i++) {
+        probabilities[i] = result.classification[i].value;
+    }
+    return true;
+}
+
+int FingerInference::runInference() {
+    if (!extractImageFeatures()) {
+        Serial.println("Failed to extract image features");
+        return -1;
+    }
+    
+    return classifyCurrentFeatures();
+}
+
+int FingerInference::classifyFrame(const float* frameFeatures) {
+    memcpy(features, frameFeatures, sizeof(features));
+    return classifyCurrentFeatures();
+}
+
+bool FingerInference::screenCurrentFeatures(int& fingers) {
+    // Unchanged scene: reuse the previous decision
+    if (decisionCache.lookup(features, millis(), fingers)) {
+        Serial.printf("Cached prediction: %d fingers (hit rate %.1f%%)\n",
+                     fingers, decisionCache.getHitRate() * 100.0f);
+        return false;
+    }
+    
+    // Out-of-distribution frames never reach the network
+    if (anomalyGate.reject(features)) {
+        Serial.printf("Anomalous frame rejected (score %.3f > %.3f)\n",
+                     anomalyGate.getLastScore(), anomalyGate.getThreshold());
+        fingers = -1;
+        return false;
+    }
+    return true;
+}
+
+int FingerInference::classifyCurrentFeatures() {
+    int screenedFingers;
+    if (!screenCurrentFeatures(screenedFingers)) {
+        // A rejected frame reads as no fingers
+        return screenedFingers < 0 ? 0 : screenedFingers;
+    }
+    
+    unsigned long startUs = micros();
+    
+    float probabilities[EI_CLASSIFIER_LABEL_COUNT];
+    if (!computeProbabilities(probabilities)) {
         return -1;
     }
     
@@ -37,26 +123,85 @@ int FingerInference::runInference() {
     
     Serial.print("Predictions: ");
     for (int i = 0; i < EI_CLASSIFIER_LABEL_COUNT; i++) {
-        Serial.printf("%s: %.3f ", fingerLabels[i], result.classification[i].value);
+        Serial.printf("%s: %.3f ", fingerLabels[i], probabilities[i]);
         
-        if (result.classification[i].value > maxConfidence) {
-            maxConfidence = result.classification[i].value;
+        if (probabilities[i] > maxConfidence) {
+            maxConfidence = probabilities[i];
             predictedFingers = i;
         }
     }
     Serial.println();
     
-    // Only accept predictions with sufficient confidence
     if (maxConfidence < EI_CLASSIFIER_THRESHOLD) {
         Serial.printf("Low confidence: %.3f (threshold: %.3f)\n", maxConfidence, EI_CLASSIFIER_THRESHOLD);
-        return 0; // Default to no fingers for low confidence
+    } else {
+        Serial.printf("Predicted: %d fingers (confidence: %.3f)\n", predictedFingers, maxConfidence);
+    }
+    
+    // Low-confidence frames still feed the smoother; its confidence floor
+    // keeps them from switching the output on their own
+    TRACE_BEGIN(TRACE_SMOOTHING);
+    const SmoothingState& state = smoother.update(probabilities, millis());
+    TRACE_END(TRACE_SMOOTHING);
+    Serial.printf("Smoothed prediction: %d fingers (score %.3f)\n",
+                 state.stableLabel, ProbabilitySmoother::toProbability(state.stableScore));
+    
+    decisionCache.store(features, state.stableLabel, millis(), micros() - startUs);
+    return state.stableLabel;
+}
+
+int FingerInference::runTemporalInference(TemporalClassifier& temporal) {
+    if (!extractImageFeatures()) {
+        Serial.println("Failed to extract image features");
+        return -1;
+    }
+    
+    return fuseCurrentFeatures(temporal);
+}
+
+int FingerInference::classifyFrameTemporal(const float* frameFeatures, TemporalClassifier& temporal) {
+    memcpy(features, frameFeatures, sizeof(features));
+    return fuseCurrentFeatures(temporal);
+}
+
+int FingerInference::fuseCurrentFeatures(TemporalClassifier& temporal) {
+    int screenedFingers;
+    if (!screenCurrentFeatures(screenedFingers)) {
+        return screenedFingers;
+    }
+    
+    unsigned long startUs = micros();
+    float probabilities[EI_CLASSIFIER_LABEL_COUNT];
+    if (!computeProbabilities(probabilities)) {
+        return -1;
     }
     
-    Serial.printf("Predicted: %d fingers (confidence: %.3f)\n", predictedFingers, maxConfidence);
+    TRACE_BEGIN(TRACE_SMOOTHING);
+    TemporalDecision decision = temporal.addFrame(features, probabilities, millis());
+    TRACE_END(TRACE_SMOOTHING);
     
-    // Add to smoothing buffer
-    addToSmoothingBuffer(predictedFingers);
+    Serial.printf("Temporal: leading %d fingers (posterior %.3f, %d frames)\n",
+                 decision.leadingLabel, decision.posterior, decision.framesUsed);
     
-    // Return smoothed prediction
-    return getSmoothedPrediction();
-}
\ No newline at end of file
+    // Only a latched decision is worth repeating for an unchanged scene
+    if (decision.label >= 0) {
+        decisionCache.store(features, decision.label, millis(), micros() - startUs);
+    }
+    
+    if (!decision.decided) {
+        return -1;
+    }
+    
+    Serial.printf("Temporal decision: %d fingers after %lu ms\n", decision.label, decision.latencyMs);
+    return decision.label;
+}
+
+void FingerInference::printProfile(bool reset) {
+    #if EI_PROFILER_ENABLED
+    Serial.println("=== Inference profile ===");
+    ei_profiler_report();
+    if (reset) ei_profiler_reset();
+    #else
+    Serial.println("Inference profile: build with -DEI_PROFILER_ENABLED=1");
+    #endif
+}
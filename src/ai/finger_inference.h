@@ -2,21 +2,37 @@
 #define FINGER_INFERENCE_H
 
 #include <Arduino.h>
-#include "../ESP32-Finger_Counter_inferencing.h"
+// Model types and constants only: the SDK's model_variables.h defines the
+// impulse itself, so ESP32-Finger_Counter_inferencing.h is included by
+// finger_inference.cpp alone
+#include "../model-parameters/model_metadata.h"
+#include "edge-impulse-sdk/classifier/ei_classifier_types.h"
+#include "edge-impulse-sdk/dsp/returntypes.h"
 #include "../camera/camera_arducam.h"
+#include "model_ensemble.h"
+#include "temporal_classifier.h"
+#include "decision_cache.h"
+#include "probability_smoother.h"
+#include "anomaly_gate.h"
 
 class FingerInference {
 private:
     static constexpr int FEATURE_COUNT = EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE;
-    static constexpr int SMOOTHING_WINDOW = 5;
     
     float features[FEATURE_COUNT];
     ArduCamController* camera;
     
     // Smoothing for stable predictions
-    int recentPredictions[SMOOTHING_WINDOW];
-    int predictionIndex;
-    bool smoothingBufferFull;
+    ProbabilitySmoother smoother;
+    
+    // Skips the network when the scene has not changed
+    DecisionCache<FEATURE_COUNT> decisionCache;
+    
+    // Rejects out-of-distribution frames before the network runs
+    AnomalyGate anomalyGate;
+    
+    // Both compiled graphs instead of run_classifier() when set
+    ModelEnsemble* ensemble;
     
     // Labels for classification results
     const char* fingerLabels[EI_CLASSIFIER_LABEL_COUNT] = {
@@ -27,13 +43,7 @@ private:
 public:
     FingerInference(ArduCamController* cam) {
         camera = cam;
-        predictionIndex = 0;
-        smoothingBufferFull = false;
-        
-        // Initialize smoothing buffer
-        for (int i = 0; i < SMOOTHING_WINDOW; i++) {
-            recentPredictions[i] = 0;
-        }
+        ensemble = nullptr;
         
         Serial.println("Finger Inference initialized");
         Serial.printf("Feature count: %d\n", FEATURE_COUNT);
@@ -52,10 +62,39 @@ public:
     
     int runInference();
     
+    // Same as runInference() for features read by another task (the task
+    // runtime captures on one core and classifies on the other)
+    int classifyFrame(const float* frameFeatures);
+    
+    // Streaming mode: fuse this frame with recent ones and return a finger
+    // count as soon as the evidence is sufficient, or -1 while undecided.
+    // An unchanged scene repeats its cached decision; a rejected frame is
+    // not fused and returns -1.
+    int runTemporalInference(TemporalClassifier& temporal);
+    int classifyFrameTemporal(const float* frameFeatures, TemporalClassifier& temporal);
+    
     int getFingerCount() {
         return runInference();
     }
     
+    // Maximum age of a cached decision in ms (0 disables the cache)
+    void setDecisionCacheMaxAge(unsigned long ms) {
+        decisionCache.setMaxAge(ms);
+    }
+    
+    DecisionCache<FEATURE_COUNT>& getDecisionCache() { return decisionCache; }
+    
+    AnomalyGate& getAnomalyGate() { return anomalyGate; }
+    
+    // Debounced prediction state (stable label, challenger, dwell timing)
+    const SmoothingState& getSmoothingState() const { return smoother.getState(); }
+    ProbabilitySmoother& getSmoother() { return smoother; }
+    
+    // Classify with both compiled graphs (ModelEnsemble) instead of the
+    // deployed impulse; nullptr switches back. Costs a second invoke per frame.
+    void setEnsemble(ModelEnsemble* modelEnsemble) { ensemble = modelEnsemble; }
+    ModelEnsemble* getEnsemble() { return ensemble; }
+    
     void printModelInfo() {
         Serial.println("=== Edge Impulse Model Info ===");
         Serial.printf("Project: %s\n", EI_CLASSIFIER_PROJECT_NAME);
@@ -71,46 +110,28 @@ public:
         }
         Serial.println("===============================");
     }
+    
+    // Per-zone timing of process_impulse, the DSP blocks and TFLM kernels;
+    // needs a build with EI_PROFILER_ENABLED=1
+    void printProfile(bool reset = true);
 
 private:
-    void addToSmoothingBuffer(int prediction) {
-        recentPredictions[predictionIndex] = prediction;
-        predictionIndex = (predictionIndex + 1) % SMOOTHING_WINDOW;
-        
-        if (predictionIndex == 0) {
-            smoothingBufferFull = true;
-        }
-    }
+    EI_IMPULSE_ERROR classifyFeatures(ei_impulse_result_t* result);
     
-    int getSmoothedPrediction() {
-        if (!smoothingBufferFull && predictionIndex < 3) {
-            // Not enough data for smoothing, return latest
-            return recentPredictions[(predictionIndex - 1 + SMOOTHING_WINDOW) % SMOOTHING_WINDOW];
-        }
-        
-        // Count occurrences of each prediction
-        int counts[EI_CLASSIFIER_LABEL_COUNT] = {0};
-        int samplesUsed = smoothingBufferFull ? SMOOTHING_WINDOW : predictionIndex;
-        
-        for (int i = 0; i < samplesUsed; i++) {
-            if (recentPredictions[i] < EI_CLASSIFIER_LABEL_COUNT) {
-                counts[recentPredictions[i]]++;
-            }
-        }
-        
-        // Find most frequent prediction
-        int mostFrequent = 0;
-        int maxCount = counts[0];
-        for (int i = 1; i < EI_CLASSIFIER_LABEL_COUNT; i++) {
-            if (counts[i] > maxCount) {
-                maxCount = counts[i];
-                mostFrequent = i;
-            }
-        }
-        
-        Serial.printf("Smoothed prediction: %d fingers (from %d samples)\n", mostFrequent, samplesUsed);
-        return mostFrequent;
-    }
+    // Decision cache, then anomaly gate, ahead of the network for both
+    // paths below: false with fingers set to the cached decision, or false
+    // with fingers at -1 for a rejected frame; true if the network must run
+    bool screenCurrentFeatures(int& fingers);
+    
+    // Screening, network and smoother over the current features
+    int classifyCurrentFeatures();
+    
+    // Screening, network and temporal fusion over the current features
+    int fuseCurrentFeatures(TemporalClassifier& temporal);
+    
+    // Class probabilities for the current features from run_classifier() or
+    // the ensemble; false if inference failed
+    bool computeProbabilities(float* probabilities);
     
     // Static features buffer for signal callback
     static float staticFeatures[FEATURE_COUNT];
@@ -0,0 +1,151 @@
+#include "model_ensemble.h"
+#include <math.h>
+#include "edge-impulse-sdk/classifier/ei_aligned_malloc.h"
+#include "../tflite-model/tflite_learn_766107_3_compiled.h"
+#include "../tflite-model/tflite_learn_767600_3_compiled.h"
+
+const EnsembleGraph ModelEnsemble::graphs[ModelEnsemble::MODEL_COUNT] = {
+    {
+        "tflite_learn_767600_3",
+        &tflite_learn_767600_3_init,
+        &tflite_learn_767600_3_invoke,
+        &tflite_learn_767600_3_reset,
+        &tflite_learn_767600_3_input,
+        &tflite_learn_767600_3_output,
+        &tflite_learn_767600_3_hooks,
+    },
+    {
+        "tflite_learn_766107_3",
+        &tflite_learn_766107_3_init,
+        &tflite_learn_766107_3_invoke,
+        &tflite_learn_766107_3_reset,
+        &tflite_learn_766107_3_input,
+        &tflite_learn_766107_3_output,
+        &tflite_learn_766107_3_hooks,
+    },
+};
+
+void ModelEnsemble::quantizeInto(const float* features, int8_t* out, float scale, int32_t zeroPoint) {
+    for (int i = 0; i < FEATURE_COUNT; i++) {
+        int32_t q = (int32_t)lroundf(features[i] / scale) + zeroPoint;
+        if (q < -128) q = -128;
+        if (q > 127) q = 127;
+        out[i] = (int8_t)q;
+    }
+}
+
+bool ModelEnsemble::runModel(int index, const float* features, float* probabilities, uint32_t& invokeUs) {
+    const EnsembleGraph& graph = graphs[index];
+    uint64_t passStart = ei_read_timer_us();
+
+    if (graph.init(ei_aligned_calloc) != kTfLiteOk) {
+        Serial.printf("Ensemble: failed to init %s\n", graph.name);
+        return false;
+    }
+
+    TfLiteTensor input;
+    TfLiteTensor output;
+    if (graph.input(0, &input) != kTfLiteOk || graph.output(0, &output) != kTfLiteOk ||
+        input.type != kTfLiteInt8 || output.type != kTfLiteInt8 ||
+        input.bytes != FEATURE_COUNT || output.bytes != LABEL_COUNT) {
+        Serial.printf("Ensemble: unexpected tensor layout in %s\n", graph.name);
+        graph.reset(ei_aligned_free);
+        return false;
+    }
+
+    // Reuse the quantized input when this graph shares the first graph's parameters
+    if (!sharedValid || input.params.scale != sharedScale || input.params.zero_point != sharedZeroPoint) {
+        quantizeInto(features, sharedInput, input.params.scale, input.params.zero_point);
+        sharedScale = input.params.scale;
+        sharedZeroPoint = input.params.zero_point;
+        sharedValid = true;
+    }
+    memcpy(input.data.int8, sharedInput, FEATURE_COUNT);
+
+    if (opProfiling) graph.hooks->setProfiler(&opProfilers[index]);
+    uint64_t invokeStart = ei_read_timer_us();
+    TfLiteStatus status = graph.invoke();
+    invokeUs = (uint32_t)(ei_read_timer_us() - invokeStart);
+    if (opProfiling) graph.hooks->setProfiler(nullptr);
+
+    if (status == kTfLiteOk) {
+        for (int i = 0; i < LABEL_COUNT; i++) {
+            probabilities[i] = (output.data.int8[i] - output.params.zero_point) * output.params.scale;
+        }
+    }
+
+    graph.reset(ei_aligned_free);
+
+    if (status != kTfLiteOk) {
+        Serial.printf("Ensemble: invoke failed for %s\n", graph.name);
+        return false;
+    }
+
+    EnsembleModelStats& s = stats[index];
+    s.totalInvokeUs += invokeUs;
+    s.totalPassUs += ei_read_timer_us() - passStart;
+    if (invokeUs < s.minInvokeUs) s.minInvokeUs = invokeUs;
+    if (invokeUs > s.maxInvokeUs) s.maxInvokeUs = invokeUs;
+    return true;
+}
+
+bool ModelEnsemble::classify(const float* features, EnsembleResult& result) {
+    float modelProbabilities[MODEL_COUNT][LABEL_COUNT];
+    sharedValid = false;
+
+    for (int m = 0; m < MODEL_COUNT; m++) {
+        stats[m].runs++;
+        if (!runModel(m, features, modelProbabilities[m], result.modelInvokeUs[m])) {
+            stats[m].failures++;
+            return false;
+        }
+
+        int best = 0;
+        for (int i = 1; i < LABEL_COUNT; i++) {
+            if (modelProbabilities[m][i] > modelProbabilities[m][best]) best = i;
+        }
+        result.modelLabels[m] = best;
+        result.modelConfidence[m] = modelProbabilities[m][best];
+    }
+
+    for (int i = 0; i < LABEL_COUNT; i++) {
+        float sum = 0.0f;
+        for (int m = 0; m < MODEL_COUNT; m++) {
+            sum += modelProbabilities[m][i];
+        }
+        result.probabilities[i] = sum / MODEL_COUNT;
+    }
+
+    int label = 0;
+    if (mode == ENSEMBLE_VOTE) {
+        int votes[LABEL_COUNT] = {0};
+        for (int m = 0; m < MODEL_COUNT; m++) {
+            votes[result.modelLabels[m]]++;
+        }
+        for (int i = 1; i < LABEL_COUNT; i++) {
+            if (votes[i] > votes[label] ||
+                (votes[i] == votes[label] && result.probabilities[i] > result.probabilities[label])) {
+                label = i;
+            }
+        }
+    } else {
+        for (int i = 1; i < LABEL_COUNT; i++) {
+            if (result.probabilities[i] > result.probabilities[label]) label = i;
+        }
+    }
+    result.label = label;
+    result.confidence = result.probabilities[label];
+
+    result.modelsAgree = true;
+    for (int m = 1; m < MODEL_COUNT; m++) {
+        if (result.modelLabels[m] != result.modelLabels[0]) result.modelsAgree = false;
+    }
+
+    passes++;
+    if (result.modelsAgree) agreements++;
+    for (int m = 0; m < MODEL_COUNT; m++) {
+        if (result.modelLabels[m] == label) stats[m].agreeWithEnsemble++;
+    }
+
+    return true;
+}
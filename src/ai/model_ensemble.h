@@ -0,0 +1,143 @@
+#ifndef MODEL_ENSEMBLE_H
+#define MODEL_ENSEMBLE_H
+
+#include <Arduino.h>
+#include "edge-impulse-sdk/tensorflow/lite/c/common.h"
+#include "../model-parameters/model_metadata.h"
+#include "op_profiler.h"
+#include "eon_graph_hooks.h"
+
+// Runs both compiled finger models (tflite_learn_766107_3 and
+// tflite_learn_767600_3) on the same feature vector. Each EON graph keeps its
+// own tensor arena, so they can be evaluated back to back in a single pass;
+// the input is quantized once and copied into every graph that shares the
+// same input scale/zero point.
+
+enum EnsembleMode {
+    ENSEMBLE_AVERAGE,   // Mean of the per-model probability vectors
+    ENSEMBLE_VOTE       // Majority of per-model argmax, ties go to summed confidence
+};
+
+// Function table for one compiled graph (mirrors ei_config_tflite_eon_graph_t)
+struct EnsembleGraph {
+    const char* name;
+    TfLiteStatus (*init)(void* (*alloc_fnc)(size_t, size_t));
+    TfLiteStatus (*invoke)();
+    TfLiteStatus (*reset)(void (*free_fnc)(void* ptr));
+    TfLiteStatus (*input)(int, TfLiteTensor*);
+    TfLiteStatus (*output)(int, TfLiteTensor*);
+    const EonGraphHooks* hooks;
+};
+
+struct EnsembleModelStats {
+    unsigned long runs;
+    unsigned long failures;
+    uint64_t totalInvokeUs;   // model_invoke only
+    uint64_t totalPassUs;     // init + input + invoke + output + reset
+    uint32_t minInvokeUs;
+    uint32_t maxInvokeUs;
+    unsigned long agreeWithEnsemble;
+};
+
+struct EnsembleResult {
+    float probabilities[EI_CLASSIFIER_LABEL_COUNT];
+    int label;
+    float confidence;
+    int modelLabels[2];
+    float modelConfidence[2];
+    uint32_t modelInvokeUs[2];
+    bool modelsAgree;
+};
+
+class ModelEnsemble {
+public:
+    static constexpr int MODEL_COUNT = 2;
+    static constexpr int FEATURE_COUNT = EI_CLASSIFIER_NN_INPUT_FRAME_SIZE;
+    static constexpr int LABEL_COUNT = EI_CLASSIFIER_LABEL_COUNT;
+
+private:
+    static const EnsembleGraph graphs[MODEL_COUNT];
+
+    EnsembleMode mode;
+    EnsembleModelStats stats[MODEL_COUNT];
+    unsigned long passes;
+    unsigned long agreements;
+
+    // Quantized input shared between graphs with identical input quantization
+    int8_t sharedInput[FEATURE_COUNT];
+    float sharedScale;
+    int32_t sharedZeroPoint;
+    bool sharedValid;
+    
+    // Per-op timing of each graph's invoke, off unless enabled
+    OpProfiler opProfilers[MODEL_COUNT];
+    bool opProfiling;
+
+    bool runModel(int index, const float* features, float* probabilities, uint32_t& invokeUs);
+    void quantizeInto(const float* features, int8_t* out, float scale, int32_t zeroPoint);
+
+public:
+    ModelEnsemble(EnsembleMode ensembleMode = ENSEMBLE_AVERAGE) {
+        mode = ensembleMode;
+        opProfiling = false;
+        resetStats();
+    }
+
+    void setMode(EnsembleMode ensembleMode) { mode = ensembleMode; }
+    EnsembleMode getMode() const { return mode; }
+    
+    void setOpProfiling(bool enabled) { opProfiling = enabled; }
+    const OpProfiler& getOpProfiler(int index) const { return opProfilers[index]; }
+
+    // Classify one feature vector (FEATURE_COUNT raw features) with every model
+    bool classify(const float* features, EnsembleResult& result);
+
+    void resetStats() {
+        passes = 0;
+        agreements = 0;
+        for (int m = 0; m < MODEL_COUNT; m++) {
+            stats[m].runs = 0;
+            stats[m].failures = 0;
+            stats[m].totalInvokeUs = 0;
+            stats[m].totalPassUs = 0;
+            stats[m].minInvokeUs = UINT32_MAX;
+            stats[m].maxInvokeUs = 0;
+            stats[m].agreeWithEnsemble = 0;
+            opProfilers[m].reset();
+        }
+    }
+
+    const EnsembleModelStats& getStats(int index) const { return stats[index]; }
+    const char* getModelName(int index) const { return graphs[index].name; }
+    unsigned long getPassCount() const { return passes; }
+    float getAgreementRate() const {
+        return passes > 0 ? (float)agreements / passes : 0.0f;
+    }
+
+    void printStats() {
+        Serial.println("=== Model Ensemble Stats ===");
+        Serial.printf("Mode: %s, passes: %lu, agreement: %.1f%%\n",
+                     mode == ENSEMBLE_AVERAGE ? "average" : "vote",
+                     passes, getAgreementRate() * 100.0f);
+        for (int m = 0; m < MODEL_COUNT; m++) {
+            const EnsembleModelStats& s = stats[m];
+            unsigned long ok = s.runs - s.failures;
+            Serial.printf("  %s: runs=%lu failures=%lu\n", graphs[m].name, s.runs, s.failures);
+            if (ok > 0) {
+                Serial.printf("    invoke us: avg=%lu min=%lu max=%lu, pass avg=%lu us\n",
+                             (unsigned long)(s.totalInvokeUs / ok),
+                             (unsigned long)s.minInvokeUs,
+                             (unsigned long)s.maxInvokeUs,
+                             (unsigned long)(s.totalPassUs / ok));
+                Serial.printf("    agrees with ensemble: %.1f%%\n",
+                             100.0f * s.agreeWithEnsemble / ok);
+            }
+            if (opProfilers[m].getOpCount() > 0) {
+                opProfilers[m].printReport(graphs[m].name);
+            }
+        }
+        Serial.println("============================");
+    }
+};
+
+#endif
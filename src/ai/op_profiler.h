@@ -0,0 +1,107 @@
+#ifndef OP_PROFILER_H
+#define OP_PROFILER_H
+
+#include <Arduino.h>
+#include <string.h>
+#include "edge-impulse-sdk/tensorflow/lite/micro/micro_profiler_interface.h"
+#include "edge-impulse-sdk/dsp/ei_profiler.h"
+
+#define OP_PROFILER_MAX_OPS 8
+
+// Aggregates the per-node events of a compiled EON graph by op type, e.g.
+// how much of an invoke goes to FULLY_CONNECTED vs SOFTMAX. Attach it with
+// EonGraphHooks::setProfiler(); unlike tflite::MicroProfiler it keeps a few
+// counters per op instead of a 1024-event log, so it can stay attached.
+// Ticks are ei_profiler_ticks() (CPU cycles on the ESP32).
+
+struct OpTiming {
+    const char* tag;
+    unsigned long count;
+    uint64_t totalTicks;
+    uint32_t minTicks;
+    uint32_t maxTicks;
+};
+
+class OpProfiler : public tflite::MicroProfilerInterface {
+private:
+    OpTiming ops[OP_PROFILER_MAX_OPS];
+    uint32_t startTicks[OP_PROFILER_MAX_OPS];
+    int opCount;
+    unsigned long untracked;    // Events for ops past OP_PROFILER_MAX_OPS
+
+    int slotFor(const char* tag) {
+        for (int i = 0; i < opCount; i++) {
+            if (ops[i].tag == tag || strcmp(ops[i].tag, tag) == 0) return i;
+        }
+        if (opCount == OP_PROFILER_MAX_OPS) return -1;
+        OpTiming& op = ops[opCount];
+        op.tag = tag;
+        op.count = 0;
+        op.totalTicks = 0;
+        op.minTicks = UINT32_MAX;
+        op.maxTicks = 0;
+        return opCount++;
+    }
+
+    static unsigned long toUs(uint64_t ticks) {
+        return (unsigned long)(ticks / EI_PROFILER_TICKS_PER_US);
+    }
+
+public:
+    OpProfiler() { reset(); }
+
+    // The event handle is the op's slot; nodes of the same op never overlap
+    uint32_t BeginEvent(const char* tag) override {
+        int slot = slotFor(tag);
+        if (slot < 0) {
+            untracked++;
+            return UINT32_MAX;
+        }
+        startTicks[slot] = ei_profiler_ticks();
+        return (uint32_t)slot;
+    }
+
+    void EndEvent(uint32_t handle) override {
+        if (handle >= (uint32_t)opCount) return;
+        uint32_t ticks = ei_profiler_ticks() - startTicks[handle];
+        OpTiming& op = ops[handle];
+        op.count++;
+        op.totalTicks += ticks;
+        if (ticks < op.minTicks) op.minTicks = ticks;
+        if (ticks > op.maxTicks) op.maxTicks = ticks;
+    }
+
+    void reset() {
+        opCount = 0;
+        untracked = 0;
+    }
+
+    int getOpCount() const { return opCount; }
+    const OpTiming& getOp(int index) const { return ops[index]; }
+
+    uint64_t getTotalTicks() const {
+        uint64_t total = 0;
+        for (int i = 0; i < opCount; i++) total += ops[i].totalTicks;
+        return total;
+    }
+
+    void printReport(const char* title) {
+        uint64_t total = getTotalTicks();
+        Serial.printf("    ops (%s):\n", title);
+        for (int i = 0; i < opCount; i++) {
+            const OpTiming& op = ops[i];
+            if (op.count == 0) continue;
+            Serial.printf("      %-16s n=%lu total=%lu us avg=%lu.%02lu us min=%lu max=%lu us (%.1f%%)\n",
+                         op.tag, op.count, toUs(op.totalTicks),
+                         toUs(op.totalTicks / op.count),
+                         (unsigned long)(op.totalTicks * 100 / op.count / EI_PROFILER_TICKS_PER_US % 100),
+                         toUs(op.minTicks), toUs(op.maxTicks),
+                         total > 0 ? 100.0f * op.totalTicks / total : 0.0f);
+        }
+        if (untracked > 0) {
+            Serial.printf("      (%lu events for ops beyond %d not tracked)\n", untracked, OP_PROFILER_MAX_OPS);
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,140 @@
+#ifndef PROBABILITY_SMOOTHER_H
+#define PROBABILITY_SMOOTHER_H
+
+#include <Arduino.h>
+#include "../model-parameters/model_metadata.h"
+
+// Fixed-point smoothing and debouncing of the model's probability vector.
+// Each update folds the new probabilities into a per-class exponential moving
+// average (Q16 scores, Q8 smoothing factor), so the cost is O(labels) with no
+// history to rescan. The stable label only changes when another class leads
+// it by a hysteresis margin, clears the confidence floor and keeps doing so
+// for a minimum dwell time.
+//
+// The default floor and margin come from the deployed model's outputs on
+// data/finger_detection_data.csv (see the replay env), not from
+// EI_CLASSIFIER_THRESHOLD: its top-1 probability has a median of 0.21 and a
+// 95th percentile of 0.43, so a 0.6 floor on the smoothed scores is never
+// reached. Its weakest correct answer is the near-uniform vector it gives
+// "one finger" (top-1 0.176, leading the runner-up by 0.004 and "no fingers"
+// by 0.016). The floor sits just above chance and below that answer; the
+// margin sits between those two leads, so a run of such frames takes the
+// label from "no fingers" without the runner-up taking it on the way.
+#define SMOOTHING_DEFAULT_MIN_CONFIDENCE 0.17f
+#define SMOOTHING_DEFAULT_HYSTERESIS 0.01f
+
+struct SmoothingState {
+    int stableLabel;              // Debounced output
+    uint16_t stableScore;         // Smoothed probability of stableLabel (Q16)
+    int candidateLabel;           // Class currently challenging stableLabel, -1 if none
+    uint16_t candidateScore;      // Smoothed probability of the candidate (Q16)
+    unsigned long stableSinceMs;  // When stableLabel was last changed
+    unsigned long candidateSinceMs; // When the current candidate started leading
+    unsigned long updates;        // Updates since reset
+    bool changed;                 // stableLabel changed on the last update
+};
+
+class ProbabilitySmoother {
+public:
+    static constexpr int LABEL_COUNT = EI_CLASSIFIER_LABEL_COUNT;
+    static constexpr uint32_t Q16_ONE = 65535;
+
+private:
+    uint16_t scores[LABEL_COUNT];
+    SmoothingState state;
+
+    // Settings
+    uint16_t alphaQ8;             // Weight of a new sample, 1..256
+    uint16_t hysteresisQ16;       // Lead required over the stable class
+    uint16_t minConfidenceQ16;    // Floor a candidate must reach
+    unsigned long minDwellMs;     // How long a candidate must lead before switching
+
+    static uint16_t toQ16(float value) {
+        if (value <= 0.0f) return 0;
+        if (value >= 1.0f) return Q16_ONE;
+        return (uint16_t)(value * Q16_ONE + 0.5f);
+    }
+
+public:
+    ProbabilitySmoother() {
+        configure(0.4f, SMOOTHING_DEFAULT_HYSTERESIS, SMOOTHING_DEFAULT_MIN_CONFIDENCE, 300);
+        reset();
+    }
+
+    // alpha: weight of the newest frame (0..1]; hysteresis and minConfidence
+    // are probabilities; minDwell is in milliseconds
+    void configure(float alpha, float hysteresis, float minConfidence, unsigned long minDwell) {
+        uint32_t a = (uint32_t)(alpha * 256.0f + 0.5f);
+        alphaQ8 = a < 1 ? 1 : (a > 256 ? 256 : a);
+        hysteresisQ16 = toQ16(hysteresis);
+        minConfidenceQ16 = toQ16(minConfidence);
+        minDwellMs = minDwell;
+    }
+
+    void reset(int initialLabel = 0, unsigned long nowMs = 0) {
+        for (int i = 0; i < LABEL_COUNT; i++) {
+            scores[i] = 0;
+        }
+        state.stableLabel = initialLabel;
+        state.stableScore = 0;
+        state.candidateLabel = -1;
+        state.candidateScore = 0;
+        state.stableSinceMs = nowMs;
+        state.candidateSinceMs = nowMs;
+        state.updates = 0;
+        state.changed = false;
+    }
+
+    const SmoothingState& update(const float* probabilities, unsigned long nowMs) {
+        int leader = 0;
+        for (int i = 0; i < LABEL_COUNT; i++) {
+            int32_t sample = toQ16(probabilities[i]);
+            if (state.updates == 0) {
+                scores[i] = (uint16_t)sample;   // Prime with the first frame
+            } else {
+                int32_t delta = sample - (int32_t)scores[i];
+                scores[i] = (uint16_t)((int32_t)scores[i] + delta * (int32_t)alphaQ8 / 256);
+            }
+            if (scores[i] > scores[leader]) leader = i;
+        }
+        state.updates++;
+        state.changed = false;
+
+        int stable = state.stableLabel;
+        bool challenges = leader != stable &&
+                          scores[leader] >= minConfidenceQ16 &&
+                          (uint32_t)scores[leader] >= (uint32_t)scores[stable] + hysteresisQ16;
+
+        if (!challenges) {
+            state.candidateLabel = -1;
+        } else {
+            if (state.candidateLabel != leader) {
+                state.candidateLabel = leader;
+                state.candidateSinceMs = nowMs;
+            }
+            if (nowMs - state.candidateSinceMs >= minDwellMs) {
+                state.stableLabel = leader;
+                state.stableSinceMs = nowMs;
+                state.candidateLabel = -1;
+                state.changed = true;
+            }
+        }
+
+        state.stableScore = scores[state.stableLabel];
+        state.candidateScore = state.candidateLabel >= 0 ? scores[state.candidateLabel] : 0;
+        return state;
+    }
+
+    const SmoothingState& getState() const { return state; }
+    int getStableLabel() const { return state.stableLabel; }
+
+    float getSmoothedProbability(int label) const {
+        return (float)scores[label] / Q16_ONE;
+    }
+
+    static float toProbability(uint16_t q16) {
+        return (float)q16 / Q16_ONE;
+    }
+};
+
+#endif
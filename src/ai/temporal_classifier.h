@@ -0,0 +1,229 @@
+#ifndef TEMPORAL_CLASSIFIER_H
+#define TEMPORAL_CLASSIFIER_H
+
+#include <Arduino.h>
+#include <limits.h>
+#include <math.h>
+#include "../model-parameters/model_metadata.h"
+
+// Streaming classifier that fuses the model's probability vectors as
+// exponentially decayed log-evidence (a naive Bayes accumulation): each frame
+// adds its log-probabilities to the running sum after the sum is scaled by
+// the decay, so a frame k frames old weighs decay^k. There is no fixed
+// window; at the default 0.7 a frame's weight halves in about two frames. A
+// run of confident frames reaches a decision after one or two frames while
+// noisy input needs more. Only the previous frame's features are kept: a
+// large jump from them is treated as a scene change and restarts the
+// accumulation.
+
+struct TemporalDecision {
+    bool decided;          // A new decision was emitted on this frame
+    int label;             // Decided label (valid when decided)
+    float posterior;       // Fused posterior of the leading label
+    int leadingLabel;      // Current leading label, decided or not
+    int framesUsed;        // Frames fused since the last restart
+    unsigned long latencyMs;  // Time from first fused frame to decision
+};
+
+class TemporalClassifier {
+public:
+    static constexpr int FEATURE_COUNT = EI_CLASSIFIER_NN_INPUT_FRAME_SIZE;
+    static constexpr int LABEL_COUNT = EI_CLASSIFIER_LABEL_COUNT;
+
+private:
+    float previousFeatures[FEATURE_COUNT];
+    int frameCount;        // Frames seen since reset(), scene changes included
+
+    float logEvidence[LABEL_COUNT];
+    float posterior[LABEL_COUNT];
+    int framesFused;
+    unsigned long firstFrameMs;
+    int latchedLabel;      // Label already emitted for the current scene, -1 if none
+
+    // Tuning
+    float decay;             // Weight of older evidence per frame (0..1)
+    float decisionThreshold; // Posterior required to emit a decision
+    int minFrames;           // Never decide on fewer frames than this
+    float sceneChangeDistance; // Mean absolute feature delta that resets fusion
+
+    // Latency statistics
+    unsigned long decisions;
+    unsigned long totalLatencyMs;
+    unsigned long minLatencyMs;
+    unsigned long maxLatencyMs;
+
+    static constexpr float MIN_PROBABILITY = 1e-4f;
+
+    float featureDistance(const float* features) const {
+        float sum = 0.0f;
+        for (int i = 0; i < FEATURE_COUNT; i++) {
+            sum += fabsf(features[i] - previousFeatures[i]);
+        }
+        return sum / FEATURE_COUNT;
+    }
+
+    void restartFusion() {
+        for (int i = 0; i < LABEL_COUNT; i++) {
+            logEvidence[i] = 0.0f;
+            posterior[i] = 1.0f / LABEL_COUNT;
+        }
+        framesFused = 0;
+        latchedLabel = -1;
+    }
+
+    void updatePosterior() {
+        float maxLog = logEvidence[0];
+        for (int i = 1; i < LABEL_COUNT; i++) {
+            if (logEvidence[i] > maxLog) maxLog = logEvidence[i];
+        }
+        float sum = 0.0f;
+        for (int i = 0; i < LABEL_COUNT; i++) {
+            posterior[i] = expf(logEvidence[i] - maxLog);
+            sum += posterior[i];
+        }
+        for (int i = 0; i < LABEL_COUNT; i++) {
+            posterior[i] /= sum;
+        }
+    }
+
+public:
+    TemporalClassifier() {
+        decay = 0.7f;
+        decisionThreshold = 0.95f;
+        minFrames = 2;
+        sceneChangeDistance = 25.0f;
+        reset();
+        resetStats();
+    }
+
+    void configure(float evidenceDecay, float threshold, int minimumFrames, float sceneChange) {
+        decay = evidenceDecay;
+        decisionThreshold = threshold;
+        minFrames = minimumFrames < 1 ? 1 : minimumFrames;
+        sceneChangeDistance = sceneChange;
+    }
+
+    void reset() {
+        frameCount = 0;
+        firstFrameMs = 0;
+        restartFusion();
+    }
+
+    void resetStats() {
+        decisions = 0;
+        totalLatencyMs = 0;
+        minLatencyMs = ULONG_MAX;
+        maxLatencyMs = 0;
+    }
+
+    // Feed one frame; returns the fused state and whether a decision fired
+    TemporalDecision addFrame(const float* features, const float* probabilities, unsigned long nowMs) {
+        if (frameCount > 0 && featureDistance(features) > sceneChangeDistance) {
+            restartFusion();
+        }
+        if (framesFused == 0) {
+            firstFrameMs = nowMs;
+        }
+
+        memcpy(previousFeatures, features, sizeof(previousFeatures));
+        frameCount++;
+
+        for (int i = 0; i < LABEL_COUNT; i++) {
+            float p = probabilities[i] < MIN_PROBABILITY ? MIN_PROBABILITY : probabilities[i];
+            logEvidence[i] = decay * logEvidence[i] + logf(p);
+        }
+        framesFused++;
+        updatePosterior();
+
+        TemporalDecision decision;
+        decision.decided = false;
+        decision.leadingLabel = 0;
+        for (int i = 1; i < LABEL_COUNT; i++) {
+            if (posterior[i] > posterior[decision.leadingLabel]) decision.leadingLabel = i;
+        }
+        decision.label = latchedLabel;
+        decision.posterior = posterior[decision.leadingLabel];
+        decision.framesUsed = framesFused;
+        decision.latencyMs = 0;
+
+        if (decision.leadingLabel != latchedLabel &&
+            framesFused >= minFrames &&
+            decision.posterior >= decisionThreshold) {
+            latchedLabel = decision.leadingLabel;
+            decision.decided = true;
+            decision.label = latchedLabel;
+            decision.latencyMs = nowMs - firstFrameMs;
+
+            decisions++;
+            totalLatencyMs += decision.latencyMs;
+            if (decision.latencyMs < minLatencyMs) minLatencyMs = decision.latencyMs;
+            if (decision.latencyMs > maxLatencyMs) maxLatencyMs = decision.latencyMs;
+
+            // Evidence for the next decision starts from this frame
+            firstFrameMs = nowMs;
+        }
+
+        return decision;
+    }
+
+    float getPosterior(int label) const { return posterior[label]; }
+    int getLatchedLabel() const { return latchedLabel; }
+    int getFrameCount() const { return frameCount; }
+
+    // Replay a recorded sequence (one probability and feature vector per frame)
+    // and return the time to the first decision, or -1 if none was reached.
+    long replaySequence(const float (*features)[FEATURE_COUNT],
+                        const float (*probabilities)[LABEL_COUNT],
+                        int count, unsigned long frameIntervalMs, int* decidedLabel = nullptr) {
+        reset();
+        for (int f = 0; f < count; f++) {
+            TemporalDecision d = addFrame(features[f], probabilities[f], f * frameIntervalMs);
+            if (d.decided) {
+                if (decidedLabel) *decidedLabel = d.label;
+                return (long)d.latencyMs;
+            }
+        }
+        return -1;
+    }
+    
+    // Same sequence under the previous policy (N identical confident argmax
+    // readings in a row) for a latency comparison. Time is measured the same
+    // way as replaySequence(): from the first frame to the deciding one.
+    static long replayConsecutiveBaseline(const float (*probabilities)[LABEL_COUNT],
+                                          int count, unsigned long frameIntervalMs,
+                                          int* decidedLabel = nullptr, int required = 3,
+                                          float threshold = EI_CLASSIFIER_THRESHOLD) {
+        int lastLabel = -1;
+        int consecutive = 0;
+        for (int f = 0; f < count; f++) {
+            int best = 0;
+            for (int i = 1; i < LABEL_COUNT; i++) {
+                if (probabilities[f][i] > probabilities[f][best]) best = i;
+            }
+            if (probabilities[f][best] < threshold) {
+                lastLabel = -1;
+                consecutive = 0;
+                continue;
+            }
+            consecutive = (best == lastLabel) ? consecutive + 1 : 1;
+            lastLabel = best;
+            if (consecutive >= required) {
+                if (decidedLabel) *decidedLabel = best;
+                return (long)(f * frameIntervalMs);
+            }
+        }
+        return -1;
+    }
+
+    void printStats() {
+        Serial.println("=== Temporal Classifier Stats ===");
+        Serial.printf("Decisions: %lu\n", decisions);
+        if (decisions > 0) {
+            Serial.printf("Latency to decision: avg=%lu ms min=%lu ms max=%lu ms\n",
+                         totalLatencyMs / decisions, minLatencyMs, maxLatencyMs);
+        }
+        Serial.println("=================================");
+    }
+};
+
+#endif
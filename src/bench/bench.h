@@ -0,0 +1,273 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+// Small Google-Benchmark-style harness for the host micro-benchmarks in this
+// directory (built by the `bench` environment only). A benchmark is a
+// function that sets up its data and then times a loop:
+//
+//     static void benchFoo(BenchState& state) {
+//         ...setup...
+//         state.setWork(macs, "MAC");
+//         while (state.keepRunning()) { foo(); benchClobberMemory(); }
+//     }
+//
+// The runner picks an iteration count that fills --min-time, repeats the
+// measurement --repetitions times and reports the median ns/op, the fastest
+// repetition and the spread, plus work/s when the benchmark declares its
+// work per iteration.
+
+// Keep the compiler from discarding a result or hoisting work out of a loop
+template <class T>
+inline void benchDoNotOptimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+inline void benchClobberMemory() {
+    asm volatile("" : : : "memory");
+}
+
+class BenchState {
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    uint64_t iterations;
+    uint64_t remaining;
+    bool started;
+    Clock::time_point startTime;
+    Clock::time_point endTime;
+    std::vector<long> args;
+    double work;
+    const char* workUnit;
+    std::string error;
+
+public:
+    BenchState(uint64_t iterationCount, const std::vector<long>& benchArgs)
+        : iterations(iterationCount), remaining(iterationCount), started(false),
+          args(benchArgs), work(0), workUnit(nullptr) {}
+
+    // The timer starts on the first call and stops when the iterations run out
+    bool keepRunning() {
+        if (!started) {
+            started = true;
+            startTime = Clock::now();
+        }
+        if (remaining == 0) {
+            endTime = Clock::now();
+            return false;
+        }
+        remaining--;
+        return true;
+    }
+
+    long arg(size_t index) const { return index < args.size() ? args[index] : 0; }
+
+    // Work done by one iteration, e.g. (rows * cols, "MAC")
+    void setWork(double perIteration, const char* unit) {
+        work = perIteration;
+        workUnit = unit;
+    }
+
+    // Abort the benchmark (e.g. a kernel returned an error); reported instead of timings
+    void skipWithError(const char* message) {
+        error = message;
+        remaining = 0;
+    }
+
+    uint64_t getIterations() const { return iterations; }
+    double getWork() const { return work; }
+    const char* getWorkUnit() const { return workUnit; }
+    const std::string& getError() const { return error; }
+
+    double elapsedNs() const {
+        if (!started) return 0;
+        return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count();
+    }
+};
+
+typedef void (*BenchFunction)(BenchState&);
+
+struct BenchCase {
+    std::string name;
+    BenchFunction function;
+    std::vector<long> args;
+};
+
+struct BenchOptions {
+    const char* filter;
+    double minTimeSec;
+    int repetitions;
+    bool csv;
+
+    BenchOptions() : filter(nullptr), minTimeSec(0.1), repetitions(5), csv(false) {}
+};
+
+class BenchRunner {
+private:
+    std::vector<BenchCase> cases;
+    BenchOptions options;
+
+    static const char* scaled(double value, char* buffer, size_t size) {
+        static const char suffixes[] = { ' ', 'k', 'M', 'G', 'T' };
+        int i = 0;
+        while (value >= 1000.0 && i < 4) {
+            value /= 1000.0;
+            i++;
+        }
+        snprintf(buffer, size, "%.2f%c", value, suffixes[i]);
+        return buffer;
+    }
+
+public:
+    struct Result {
+        uint64_t iterations;
+        double medianNs;
+        double minNs;
+        double cvPercent;
+        double work;
+        const char* workUnit;
+        std::string error;
+    };
+
+    // Times one benchmark without printing (run() reports every registered case)
+    Result measure(const BenchCase& bench) {
+        Result result;
+        result.iterations = 0;
+        result.medianNs = result.minNs = result.cvPercent = 0;
+        result.work = 0;
+        result.workUnit = nullptr;
+
+        // Warm-up (page in data, train the branch predictor), then grow the
+        // iteration count until one run fills the minimum time
+        BenchState state(1, bench.args);
+        bench.function(state);
+        if (!state.getError().empty()) {
+            result.error = state.getError();
+            return result;
+        }
+
+        double minNs = options.minTimeSec * 1e9;
+        uint64_t iterations = 1;
+        for (;;) {
+            BenchState trial(iterations, bench.args);
+            bench.function(trial);
+            double ns = trial.elapsedNs();
+            if (ns >= minNs || iterations >= 1000000000ULL) break;
+            double factor = ns > 0 ? minNs * 1.4 / ns : 100.0;
+            factor = std::max(2.0, std::min(100.0, factor));
+            iterations = (uint64_t)(iterations * factor);
+        }
+
+        std::vector<double> perOp;
+        for (int r = 0; r < options.repetitions; r++) {
+            BenchState timed(iterations, bench.args);
+            bench.function(timed);
+            perOp.push_back(timed.elapsedNs() / iterations);
+            result.work = timed.getWork();
+            result.workUnit = timed.getWorkUnit();
+        }
+
+        std::sort(perOp.begin(), perOp.end());
+        double mean = 0;
+        for (size_t i = 0; i < perOp.size(); i++) mean += perOp[i];
+        mean /= perOp.size();
+        double variance = 0;
+        for (size_t i = 0; i < perOp.size(); i++) variance += (perOp[i] - mean) * (perOp[i] - mean);
+        variance /= perOp.size();
+
+        result.iterations = iterations;
+        result.medianNs = perOp[perOp.size() / 2];
+        result.minNs = perOp[0];
+        result.cvPercent = mean > 0 ? 100.0 * sqrt(variance) / mean : 0;
+        return result;
+    }
+
+    void add(const std::string& name, BenchFunction function, const std::vector<long>& args = std::vector<long>()) {
+        BenchCase bench;
+        bench.name = name;
+        bench.function = function;
+        bench.args = args;
+        cases.push_back(bench);
+    }
+
+    void setOptions(const BenchOptions& benchOptions) { options = benchOptions; }
+
+    // Returns the number of benchmarks that failed
+    int run() {
+        int failures = 0;
+        if (options.csv) {
+            printf("name,iterations,ns_per_op,min_ns_per_op,cv_percent,work_per_op,work_unit,work_per_second\n");
+        } else {
+            printf("%-44s %12s %12s %6s %12s %16s\n", "benchmark", "ns/op", "min ns/op", "cv%", "iterations", "throughput");
+        }
+
+        for (size_t i = 0; i < cases.size(); i++) {
+            const BenchCase& bench = cases[i];
+            if (options.filter && strstr(bench.name.c_str(), options.filter) == nullptr) continue;
+
+            Result result = measure(bench);
+            if (!result.error.empty()) {
+                failures++;
+                if (options.csv) {
+                    printf("%s,ERROR,%s\n", bench.name.c_str(), result.error.c_str());
+                } else {
+                    printf("%-44s ERROR: %s\n", bench.name.c_str(), result.error.c_str());
+                }
+                continue;
+            }
+
+            double rate = result.work > 0 && result.medianNs > 0 ? result.work * 1e9 / result.medianNs : 0;
+            if (options.csv) {
+                printf("%s,%llu,%.3f,%.3f,%.2f,%.0f,%s,%.0f\n", bench.name.c_str(),
+                       (unsigned long long)result.iterations, result.medianNs, result.minNs,
+                       result.cvPercent, result.work, result.workUnit ? result.workUnit : "", rate);
+            } else {
+                char throughput[32] = "";
+                if (rate > 0) {
+                    char number[16];
+                    snprintf(throughput, sizeof(throughput), "%s %s/s",
+                             scaled(rate, number, sizeof(number)), result.workUnit);
+                }
+                printf("%-44s %12.1f %12.1f %6.1f %12llu %16s\n", bench.name.c_str(),
+                       result.medianNs, result.minNs, result.cvPercent,
+                       (unsigned long long)result.iterations, throughput);
+            }
+            fflush(stdout);
+        }
+        return failures;
+    }
+};
+
+// Deterministic data so every run (and every machine) benchmarks the same inputs
+class BenchRandom {
+private:
+    uint32_t state;
+
+public:
+    explicit BenchRandom(uint32_t seed) : state(seed ? seed : 1) {}
+
+    uint32_t next() {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    int8_t nextInt8() { return (int8_t)(next() & 0xFF); }
+
+    // Uniform in [low, high)
+    float nextFloat(float low, float high) {
+        return low + (high - low) * ((next() >> 8) / 16777216.0f);
+    }
+};
+
+#endif
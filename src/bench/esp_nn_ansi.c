@@ -0,0 +1,8 @@
+// ESP-NN's portable C kernels, compiled for the host benchmarks. The device
+// build gets them from porting/espressif, which the host environments leave
+// out because the rest of ESP-NN is Xtensa assembly.
+
+#define EI_CLASSIFIER_TFLITE_ENABLE_ESP_NN 1
+
+#include "edge-impulse-sdk/porting/espressif/ESP-NN/src/fully_connected/esp_nn_fully_connected_ansi.c"
+#include "edge-impulse-sdk/porting/espressif/ESP-NN/src/softmax/esp_nn_softmax_ansi.c"
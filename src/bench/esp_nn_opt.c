@@ -0,0 +1,9 @@
+// ESP-NN's generic optimised C kernels, compiled for the host benchmarks.
+// esp_nn_generic_opt.h picks these on the ESP32, so SOFTMAX on the device
+// runs esp_nn_softmax_s8_opt; FULLY_CONNECTED has no _opt variant there and
+// stays on the ANSI kernel (esp_nn_ansi.c). A separate file because the
+// softmax sources share an unguarded header.
+
+#define EI_CLASSIFIER_TFLITE_ENABLE_ESP_NN 1
+
+#include "edge-impulse-sdk/porting/espressif/ESP-NN/src/softmax/esp_nn_softmax_opt.c"
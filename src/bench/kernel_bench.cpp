@@ -0,0 +1,330 @@
+// Host micro-benchmarks for the TFLM kernels our models run: int8
+// FULLY_CONNECTED (TFLM reference, ESP-NN ANSI C and CMSIS-NN C paths),
+// int8 SOFTMAX (the same plus the ESP-NN _opt kernel the ESP32 runs), and
+// the float<->int8 quantize/dequantize around the graph, plus AnomalyGate's
+// scoring against the SDK-style reference it replaces, and the task
+// runtime's cross-thread handoff and stop/start handshake.
+// Shapes are the ones in tflite_learn_*_compiled.cpp (20x20, 10x20 and 6x10
+// dense layers, a 6-way softmax, 20 input features) plus a sweep of larger
+// ones, so a kernel change can be judged without hardware.
+//
+//   pio run -e bench
+//   .pio/build/bench/program [--filter STR] [--min-time SEC] [--repetitions N] [--csv]
+//
+// Inputs come from a fixed seed. Before timing, every FULLY_CONNECTED and
+// SOFTMAX shape is run through every path and the outputs compared
+// against the reference, and AnomalyGate::score() is checked against
+// scoreReference(); a mismatch makes the run exit non-zero.
+
+#include "bench.h"
+#include "kernel_cases.h"
+#include "../ai/anomaly_gate.h"
+#include "../runtime/task_runtime.h"
+
+// (outputs, inputs) of the dense layers
+static const long fcModelShapes[][2] = { { 20, 20 }, { 10, 20 }, { 6, 10 } };
+static const long fcSweepShapes[][2] = { { 32, 64 }, { 64, 128 }, { 128, 256 }, { 256, 512 }, { 512, 1024 } };
+
+// (rows, depth) of the softmax
+static const long softmaxModelShapes[][2] = { { 1, 6 } };
+static const long softmaxSweepShapes[][2] = { { 1, 32 }, { 1, 256 }, { 1, 1024 }, { 16, 256 } };
+
+// Element counts: 20 features in, 6 scores out
+static const long quantizeSizes[] = { 20, 256, 4096 };
+static const long dequantizeSizes[] = { 6, 256, 4096 };
+
+#define COUNT_OF(a) (sizeof(a) / sizeof((a)[0]))
+
+template <KernelPath path>
+static void benchFullyConnected(BenchState& state) {
+    FullyConnectedCase bench((int)state.arg(0), (int)state.arg(1));
+    state.setWork(bench.macs(), "MAC");
+    while (state.keepRunning()) {
+        if (!bench.run(path)) {
+            state.skipWithError("kernel returned an error");
+            break;
+        }
+        benchClobberMemory();
+    }
+}
+
+template <KernelPath path>
+static void benchSoftmax(BenchState& state) {
+    SoftmaxCase bench((int)state.arg(0), (int)state.arg(1));
+    state.setWork(bench.elements(), "elem");
+    while (state.keepRunning()) {
+        bench.run(path);
+        benchClobberMemory();
+    }
+}
+
+static void benchQuantize(BenchState& state) {
+    int size = (int)state.arg(0);
+    std::vector<float> input(size);
+    std::vector<int8_t> output(size);
+    BenchRandom random(BENCH_SEED ^ size);
+    for (int i = 0; i < size; i++) input[i] = random.nextFloat(-4.0f, 4.0f);
+
+    tflite::QuantizationParams params;
+    params.zero_point = -128;
+    params.scale = 8.0 / 255.0;
+    tflite::RuntimeShape shape = shape2d(1, size);
+    state.setWork(size, "elem");
+    while (state.keepRunning()) {
+        tflite::reference_ops::AffineQuantize(params, shape, input.data(), shape, output.data());
+        benchClobberMemory();
+    }
+}
+
+static void benchDequantize(BenchState& state) {
+    int size = (int)state.arg(0);
+    std::vector<int8_t> input(size);
+    std::vector<float> output(size);
+    BenchRandom random(BENCH_SEED ^ size);
+    for (int i = 0; i < size; i++) input[i] = random.nextInt8();
+
+    tflite::DequantizationParams params;
+    params.zero_point = -128;
+    params.scale = 1.0 / 256.0;
+    tflite::RuntimeShape shape = shape2d(1, size);
+    state.setWork(size, "elem");
+    while (state.keepRunning()) {
+        tflite::reference_ops::Dequantize(params, shape, input.data(), shape, output.data());
+        benchClobberMemory();
+    }
+}
+
+// Feature vectors for the anomaly gate: half drawn around the fitted
+// clusters, half uniform over the 0-255 feature range (mostly rejected)
+static const int ANOMALY_INPUTS = 64;
+
+static std::vector<float> anomalyInputs() {
+    std::vector<float> inputs(ANOMALY_INPUTS * AnomalyGate::AXES);
+    BenchRandom random(BENCH_SEED ^ 0xA90);
+    for (int n = 0; n < ANOMALY_INPUTS; n++) {
+        for (int i = 0; i < AnomalyGate::AXES; i++) {
+            inputs[n * AnomalyGate::AXES + i] = n % 2 == 0
+                ? finger_anomaly_mean[i] + random.nextFloat(-1.5f, 1.5f) * finger_anomaly_scale[i]
+                : random.nextFloat(0.0f, 255.0f);
+        }
+    }
+    return inputs;
+}
+
+template <bool reference>
+static void benchAnomalyGate(BenchState& state) {
+    AnomalyGate gate;
+    std::vector<float> inputs = anomalyInputs();
+    volatile float sink = 0.0f;
+    int n = 0;
+    state.setWork(1, "frame");
+    while (state.keepRunning()) {
+        const float* features = &inputs[n * AnomalyGate::AXES];
+        sink = sink + (reference ? gate.scoreReference(features) : gate.score(features));
+        n = (n + 1) % ANOMALY_INPUTS;
+    }
+}
+
+// One wake of another task through RtSignal and one back: the floor under
+// the capture -> inference handoff
+static void benchSignalRoundTrip(BenchState& state) {
+    RtSignal ping;
+    RtSignal pong;
+    std::atomic<bool> done(false);
+    std::thread echo([&] {
+        while (!done.load()) {
+            if (ping.wait(10)) pong.notify();
+        }
+    });
+    state.setWork(1, "round trip");
+    while (state.keepRunning()) {
+        ping.notify();
+        pong.wait(1000);
+    }
+    done = true;
+    echo.join();
+}
+
+static bool benchRuntimeCapture(void*, RuntimeFrame& frame) {
+    frame.featureCount = RUNTIME_FRAME_FEATURES;
+    return true;
+}
+static int benchRuntimeClassify(void*, const RuntimeFrame& frame) { return frame.seq % 6; }
+static void benchRuntimeDetection(void*, const RuntimeDetection&) {}
+
+// TaskRuntime::start() + stop(): three tasks created, running, asked to
+// stop and joined
+static void benchRuntimeRestart(BenchState& state) {
+    TaskRuntime runtime;
+    runtime.getConfig().captureIntervalMs = 0;
+    runtime.getConfig().uiTickMs = 1;
+    RuntimeHooks hooks = { nullptr, benchRuntimeCapture, benchRuntimeClassify, benchRuntimeDetection, nullptr, nullptr };
+    state.setWork(1, "restart");
+    while (state.keepRunning()) {
+        runtime.start(hooks);
+        runtime.stop();
+    }
+}
+
+static std::string shapeName(const char* op, const char* path, long a, long b) {
+    char name[64];
+    snprintf(name, sizeof(name), "%s/%s/%ldx%ld", op, path, a, b);
+    return name;
+}
+
+static std::string sizeName(const char* op, long size) {
+    char name[64];
+    snprintf(name, sizeof(name), "%s/reference/%ld", op, size);
+    return name;
+}
+
+static void addFullyConnected(BenchRunner& runner, const long shape[2]) {
+    std::vector<long> args(shape, shape + 2);
+    runner.add(shapeName("fully_connected", pathNames[PATH_REFERENCE], shape[0], shape[1]), benchFullyConnected<PATH_REFERENCE>, args);
+    runner.add(shapeName("fully_connected", pathNames[PATH_ESP_NN_ANSI], shape[0], shape[1]), benchFullyConnected<PATH_ESP_NN_ANSI>, args);
+    runner.add(shapeName("fully_connected", pathNames[PATH_CMSIS_NN], shape[0], shape[1]), benchFullyConnected<PATH_CMSIS_NN>, args);
+}
+
+static void addSoftmax(BenchRunner& runner, const long shape[2]) {
+    std::vector<long> args(shape, shape + 2);
+    runner.add(shapeName("softmax", pathNames[PATH_REFERENCE], shape[0], shape[1]), benchSoftmax<PATH_REFERENCE>, args);
+    runner.add(shapeName("softmax", pathNames[PATH_ESP_NN_ANSI], shape[0], shape[1]), benchSoftmax<PATH_ESP_NN_ANSI>, args);
+    runner.add(shapeName("softmax", pathNames[PATH_ESP_NN_OPT], shape[0], shape[1]), benchSoftmax<PATH_ESP_NN_OPT>, args);
+    runner.add(shapeName("softmax", pathNames[PATH_CMSIS_NN], shape[0], shape[1]), benchSoftmax<PATH_CMSIS_NN>, args);
+}
+
+static int countMismatches(const std::vector<int8_t>& expected, const std::vector<int8_t>& actual, int* maxDiff) {
+    int mismatches = 0;
+    for (size_t i = 0; i < expected.size(); i++) {
+        int diff = abs(expected[i] - actual[i]);
+        if (diff > 0) mismatches++;
+        if (diff > *maxDiff) *maxDiff = diff;
+    }
+    return mismatches;
+}
+
+// Compare every optimized path against the reference; returns the number of
+// (shape, path) pairs whose output differs
+template <class Case>
+static int verifyShape(const char* op, long a, long b) {
+    Case bench((int)a, (int)b);
+    bench.run(PATH_REFERENCE);
+    std::vector<int8_t> expected = bench.output;
+
+    int failures = 0;
+    for (int path = PATH_REFERENCE + 1; path < PATH_COUNT; path++) {
+        std::fill(bench.output.begin(), bench.output.end(), 0);
+        int maxDiff = 0;
+        int mismatches = bench.run((KernelPath)path) ? countMismatches(expected, bench.output, &maxDiff) : -1;
+        if (mismatches != 0) {
+            failures++;
+            if (mismatches < 0) {
+                fprintf(stderr, "[bench] verify %s %s %ldx%ld: kernel returned an error\n", op, pathNames[path], a, b);
+            } else {
+                fprintf(stderr, "[bench] verify %s %s %ldx%ld: %d/%d outputs differ from reference (max %d)\n",
+                       op, pathNames[path], a, b, mismatches, (int)expected.size(), maxDiff);
+            }
+        }
+    }
+    return failures;
+}
+
+// The pruned score must agree with the reference wherever it matters: the
+// same accept/reject decision and the same score to float rounding
+static int verifyAnomalyGate() {
+    AnomalyGate gate;
+    std::vector<float> inputs = anomalyInputs();
+    int mismatches = 0;
+    float maxDiff = 0.0f;
+    for (int n = 0; n < ANOMALY_INPUTS; n++) {
+        const float* features = &inputs[n * AnomalyGate::AXES];
+        float fast = gate.score(features);
+        float reference = gate.scoreReference(features);
+        float diff = fabsf(fast - reference);
+        if (diff > maxDiff) maxDiff = diff;
+        if (diff > 1e-3f * (1.0f + fabsf(reference))) mismatches++;
+    }
+    if (mismatches) {
+        fprintf(stderr, "[bench] verify anomaly_gate: %d/%d scores differ from reference (max %.6f)\n",
+                mismatches, ANOMALY_INPUTS, maxDiff);
+        return 1;
+    }
+    return 0;
+}
+
+static int verifyAll() {
+    int failures = verifyAnomalyGate(), shapes = 0;
+    for (size_t i = 0; i < COUNT_OF(fcModelShapes); i++, shapes++) {
+        failures += verifyShape<FullyConnectedCase>("fully_connected", fcModelShapes[i][0], fcModelShapes[i][1]);
+    }
+    for (size_t i = 0; i < COUNT_OF(fcSweepShapes); i++, shapes++) {
+        failures += verifyShape<FullyConnectedCase>("fully_connected", fcSweepShapes[i][0], fcSweepShapes[i][1]);
+    }
+    for (size_t i = 0; i < COUNT_OF(softmaxModelShapes); i++, shapes++) {
+        failures += verifyShape<SoftmaxCase>("softmax", softmaxModelShapes[i][0], softmaxModelShapes[i][1]);
+    }
+    for (size_t i = 0; i < COUNT_OF(softmaxSweepShapes); i++, shapes++) {
+        failures += verifyShape<SoftmaxCase>("softmax", softmaxSweepShapes[i][0], softmaxSweepShapes[i][1]);
+    }
+    if (failures == 0) {
+        fprintf(stderr, "[bench] verify: %d shapes, %s, %s and %s match %s; anomaly_gate matches its reference\n",
+               shapes, pathNames[PATH_ESP_NN_ANSI], pathNames[PATH_ESP_NN_OPT], pathNames[PATH_CMSIS_NN],
+               pathNames[PATH_REFERENCE]);
+    }
+    return failures;
+}
+
+static void usage(const char* program) {
+    printf("usage: %s [--filter STR] [--min-time SEC] [--repetitions N] [--csv]\n", program);
+}
+
+int main(int argc, char** argv) {
+    BenchOptions options;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            options.filter = argv[++i];
+        } else if (strcmp(argv[i], "--min-time") == 0 && i + 1 < argc) {
+            options.minTimeSec = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--repetitions") == 0 && i + 1 < argc) {
+            options.repetitions = std::max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--csv") == 0) {
+            options.csv = true;
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    // Context for comparing runs; goes to stderr so --csv output stays clean
+    fprintf(stderr, "[bench] compiler %s, %s, seed 0x%x, min time %.2f s, %d repetitions\n",
+            __VERSION__,
+#ifdef __OPTIMIZE__
+            "optimized",
+#else
+            "NOT optimized",
+#endif
+            BENCH_SEED, options.minTimeSec, options.repetitions);
+
+    int failures = verifyAll();
+
+    BenchRunner runner;
+    runner.setOptions(options);
+    for (size_t i = 0; i < COUNT_OF(fcModelShapes); i++) addFullyConnected(runner, fcModelShapes[i]);
+    for (size_t i = 0; i < COUNT_OF(fcSweepShapes); i++) addFullyConnected(runner, fcSweepShapes[i]);
+    for (size_t i = 0; i < COUNT_OF(softmaxModelShapes); i++) addSoftmax(runner, softmaxModelShapes[i]);
+    for (size_t i = 0; i < COUNT_OF(softmaxSweepShapes); i++) addSoftmax(runner, softmaxSweepShapes[i]);
+    for (size_t i = 0; i < COUNT_OF(quantizeSizes); i++) {
+        runner.add(sizeName("quantize", quantizeSizes[i]), benchQuantize, std::vector<long>(1, quantizeSizes[i]));
+    }
+    for (size_t i = 0; i < COUNT_OF(dequantizeSizes); i++) {
+        runner.add(sizeName("dequantize", dequantizeSizes[i]), benchDequantize, std::vector<long>(1, dequantizeSizes[i]));
+    }
+
+    runner.add("anomaly_gate/score", benchAnomalyGate<false>);
+    runner.add("anomaly_gate/reference", benchAnomalyGate<true>);
+    runner.add("runtime/signal_round_trip", benchSignalRoundTrip);
+    runner.add("runtime/restart", benchRuntimeRestart);
+
+    failures += runner.run();
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,182 @@
+#ifndef KERNEL_CASES_H
+#define KERNEL_CASES_H
+
+// The int8 kernels our models run, set up the way the converter and TFLM
+// prepare them, with deterministic data. Shared by the micro-benchmarks
+// (kernel_bench.cpp) and the cost model's host calibration
+// (costmodel/cost_model.cpp).
+
+#include "bench.h"
+
+#include "edge-impulse-sdk/tensorflow/lite/kernels/internal/quantization_util.h"
+#include "edge-impulse-sdk/tensorflow/lite/kernels/internal/reference/integer_ops/fully_connected.h"
+#include "edge-impulse-sdk/tensorflow/lite/kernels/internal/reference/softmax.h"
+#include "edge-impulse-sdk/tensorflow/lite/kernels/internal/reference/quantize.h"
+#include "edge-impulse-sdk/tensorflow/lite/kernels/internal/reference/dequantize.h"
+#include "edge-impulse-sdk/CMSIS/NN/Include/arm_nnfunctions.h"
+
+extern "C" {
+#include "edge-impulse-sdk/porting/espressif/ESP-NN/include/esp_nn_ansi_headers.h"
+}
+
+#define BENCH_SEED 0x5eed
+
+// TFLM's RuntimeShape has no initializer-list constructor
+static tflite::RuntimeShape shape2d(int32_t rows, int32_t cols) {
+    const int32_t dims[2] = { rows, cols };
+    return tflite::RuntimeShape(2, dims);
+}
+
+// PATH_ESP_NN_OPT is what ESP-NN's generic build (esp_nn_generic_opt.h)
+// runs on the ESP32: the _opt softmax, and for FULLY_CONNECTED, which has
+// no _opt variant there, the ANSI kernel again
+enum KernelPath {
+    PATH_REFERENCE,
+    PATH_ESP_NN_ANSI,
+    PATH_ESP_NN_OPT,
+    PATH_CMSIS_NN,
+    PATH_COUNT
+};
+
+static const char* const pathNames[PATH_COUNT] = { "reference", "esp_nn_ansi", "esp_nn_opt", "cmsis_nn" };
+
+// One int8 dense layer with per-tensor quantization, as the converter emits
+// it for our models: symmetric weights, int32 bias, asymmetric activations
+class FullyConnectedCase {
+private:
+    int outputs;
+    int inputs;
+    std::vector<int8_t> input;
+    std::vector<int8_t> filter;
+    std::vector<int32_t> bias;
+    int32_t inputOffset;
+    int32_t outputOffset;
+    int32_t multiplier;
+    int shift;
+
+public:
+    std::vector<int8_t> output;
+
+    FullyConnectedCase(int outputCount, int inputCount)
+        : outputs(outputCount), inputs(inputCount), input(inputCount),
+          filter(outputCount * inputCount), bias(outputCount), output(outputCount) {
+        BenchRandom random(BENCH_SEED ^ (outputCount << 16) ^ inputCount);
+        for (size_t i = 0; i < input.size(); i++) input[i] = random.nextInt8();
+        for (size_t i = 0; i < filter.size(); i++) filter[i] = (int8_t)(random.nextInt8() | 1);
+        for (size_t i = 0; i < bias.size(); i++) bias[i] = (int32_t)(random.next() % 4096) - 2048;
+
+        const double inputScale = 0.05, filterScale = 0.02;
+        const double outputScale = inputScale * filterScale * 64.0 * sqrt((double)inputs);
+        inputOffset = 128;      // Input zero point -128
+        outputOffset = -10;
+        tflite::QuantizeMultiplier(inputScale * filterScale / outputScale, &multiplier, &shift);
+    }
+
+    double macs() const { return (double)outputs * inputs; }
+
+    bool run(KernelPath path) {
+        switch (path) {
+        case PATH_REFERENCE: {
+            tflite::FullyConnectedParams params = {};
+            params.input_offset = inputOffset;
+            params.weights_offset = 0;
+            params.output_offset = outputOffset;
+            params.output_multiplier = multiplier;
+            params.output_shift = shift;
+            params.quantized_activation_min = -128;
+            params.quantized_activation_max = 127;
+            const int32_t biasSize = outputs;
+            tflite::reference_integer_ops::FullyConnected(
+                params, shape2d(1, inputs), input.data(),
+                shape2d(outputs, inputs), filter.data(),
+                tflite::RuntimeShape(1, &biasSize), bias.data(),
+                shape2d(1, outputs), output.data());
+            return true;
+        }
+        case PATH_ESP_NN_ANSI:
+        case PATH_ESP_NN_OPT:
+            esp_nn_fully_connected_s8_ansi(input.data(), inputOffset, (uint16_t)inputs,
+                                           filter.data(), 0, bias.data(), output.data(),
+                                           (uint16_t)outputs, outputOffset, shift, multiplier,
+                                           -128, 127);
+            return true;
+        case PATH_CMSIS_NN: {
+            // Same dims/params as the CMSIS branch of fully_connected.cpp
+            cmsis_nn_context context = { nullptr, 0 };
+            cmsis_nn_fc_params fcParams;
+            fcParams.input_offset = inputOffset;
+            fcParams.filter_offset = 0;
+            fcParams.output_offset = outputOffset;
+            fcParams.activation.min = -128;
+            fcParams.activation.max = 127;
+            cmsis_nn_per_tensor_quant_params quantParams = { multiplier, shift };
+            cmsis_nn_dims inputDims = { 1, 1, 1, inputs };
+            cmsis_nn_dims filterDims = { inputs, 1, 1, outputs };
+            cmsis_nn_dims biasDims = { 1, 1, 1, outputs };
+            cmsis_nn_dims outputDims = { 1, 1, 1, outputs };
+            return arm_fully_connected_s8(&context, &fcParams, &quantParams, &inputDims, input.data(),
+                                          &filterDims, filter.data(), &biasDims, bias.data(),
+                                          &outputDims, output.data()) == ARM_CMSIS_NN_SUCCESS;
+        }
+        default:
+            return false;
+        }
+    }
+};
+
+// int8 -> int8 softmax with beta 1, prepared like softmax_common.cpp does
+class SoftmaxCase {
+private:
+    int rows;
+    int depth;
+    std::vector<int8_t> input;
+    tflite::SoftmaxParams params;
+    std::vector<int32_t> scratch;   // One row of exp() values for the _opt kernel
+
+public:
+    std::vector<int8_t> output;
+
+    SoftmaxCase(int rowCount, int depthCount)
+        : rows(rowCount), depth(depthCount), input(rowCount * depthCount), params(),
+          scratch(esp_nn_get_softmax_scratch_size_opt(depthCount, rowCount) / sizeof(int32_t)),
+          output(rowCount * depthCount) {
+        BenchRandom random(BENCH_SEED ^ (rowCount << 16) ^ depthCount);
+        for (size_t i = 0; i < input.size(); i++) input[i] = random.nextInt8();
+
+        static const int kScaledDiffIntegerBits = 5;
+        int inputLeftShift;
+        tflite::PreprocessSoftmaxScaling(1.0, 0.1, kScaledDiffIntegerBits,
+                                         &params.input_multiplier, &inputLeftShift);
+        params.input_left_shift = inputLeftShift;
+        params.diff_min = -1 * tflite::CalculateInputRadius(kScaledDiffIntegerBits, inputLeftShift);
+    }
+
+    double elements() const { return (double)rows * depth; }
+
+    bool run(KernelPath path) {
+        switch (path) {
+        case PATH_REFERENCE:
+            tflite::reference_ops::Softmax(params, shape2d(rows, depth), input.data(),
+                                           shape2d(rows, depth), output.data());
+            return true;
+        case PATH_ESP_NN_ANSI:
+            esp_nn_softmax_s8_ansi(input.data(), rows, depth, params.input_multiplier,
+                                   params.input_left_shift, params.diff_min, output.data());
+            return true;
+        case PATH_ESP_NN_OPT:
+            // Set on every call, as TFLM's softmax.cpp does
+            esp_nn_set_softmax_scratch_buf_opt(scratch.data());
+            esp_nn_softmax_s8_opt(input.data(), rows, depth, params.input_multiplier,
+                                  params.input_left_shift, params.diff_min, output.data());
+            return true;
+        case PATH_CMSIS_NN:
+            arm_softmax_s8(input.data(), rows, depth, params.input_multiplier,
+                           params.input_left_shift, params.diff_min, output.data());
+            return true;
+        default:
+            return false;
+        }
+    }
+};
+
+#endif
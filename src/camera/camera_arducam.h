@@ -6,6 +6,9 @@
 #include <SPI.h>
 #include "../config_pins.h"
 #include "downscale.h"
+#include "../runtime/trace.h"
+#include "../runtime/metrics.h"
+#include "../runtime/i2c_bus.h"
 
 // Define MAX_FIFO_SIZE if not already defined by ArduCAM library
 #ifndef MAX_FIFO_SIZE
@@ -18,6 +21,9 @@ private:
     bool isInitialized;
     uint8_t* imageBuffer;
     size_t bufferSize;
+    bool inStandby;
+    
+    static const int CAMERA_WAKE_MS = 5;   // Sensor settle time after power-down
     
     bool testSPI() {
         // Test SPI by writing and reading back a test pattern
@@ -91,12 +97,18 @@ private:
         return false;
     }
     
-    bool testI2C() {
-        // Test I2C by reading camera ID
-        uint8_t vid, pid;
+    // Sensor ID over SCCB; the OLED flush task shares the bus
+    void readSensorId(uint8_t& vid, uint8_t& pid) {
+        I2cBusLock bus;
         myCAM->wrSensorReg8_8(0xff, 0x01);  // Select register bank
         myCAM->rdSensorReg8_8(OV2640_CHIPID_HIGH, &vid);
         myCAM->rdSensorReg8_8(OV2640_CHIPID_LOW, &pid);
+    }
+    
+    bool testI2C() {
+        // Test I2C by reading camera ID
+        uint8_t vid, pid;
+        readSensorId(vid, pid);
         
         Serial.printf("Camera ID detected: 0x%02X 0x%02X\n", vid, pid);
         
@@ -123,6 +135,7 @@ public:
     ArduCamController() {
         myCAM = nullptr;
         isInitialized = false;
+        inStandby = false;
         imageBuffer = nullptr;
         bufferSize = CAM_WIDTH * CAM_HEIGHT; // Grayscale
     }
@@ -171,12 +184,15 @@ public:
         myCAM->write_reg(0x07, 0x00);  // Normal mode
         delay(200);
         
-        // Set to JPEG mode
-        myCAM->set_format(JPEG);
-        myCAM->InitCAM();
-        
-        // For PSRAM boards, try lower resolution first
-        myCAM->OV2640_set_JPEG_size(OV2640_160x120);
+        // Set to JPEG mode; sensor registers go over SCCB on the shared bus
+        {
+            I2cBusLock bus;
+            myCAM->set_format(JPEG);
+            myCAM->InitCAM();
+            
+            // For PSRAM boards, try lower resolution first
+            myCAM->OV2640_set_JPEG_size(OV2640_160x120);
+        }
         
         // Additional delay for PSRAM initialization
         delay(1000);
@@ -191,12 +207,35 @@ public:
         return true;
     }
     
-    bool captureImage() {
+    // Put the sensor into power-down through the ArduChip GPIO (low power
+    // mode on the Mini 2MP Plus). The register state is kept, so waking only
+    // needs the sensor to settle.
+    void setStandby(bool standby) {
+        if (!isInitialized || standby == inStandby) return;
+        if (standby) {
+            myCAM->set_bit(ARDUCHIP_GPIO, GPIO_PWDN_MASK);
+        } else {
+            myCAM->clear_bit(ARDUCHIP_GPIO, GPIO_PWDN_MASK);
+            delay(CAMERA_WAKE_MS);
+        }
+        inStandby = standby;
+    }
+    
+    bool isStandby() const { return inStandby; }
+    
+    bool captureImage(bool verbose = true) {
         if (!isInitialized) {
             Serial.println("Camera not initialized");
             return false;
         }
         
+        if (inStandby) {
+            setStandby(false);
+        }
+        
+        TRACE_SCOPE(TRACE_CAPTURE);
+        MetricsStageTimer captureTimer(METRICS_STAGE_CAPTURE);
+        
         // Start capture
         myCAM->flush_fifo();
         myCAM->clear_fifo_flag();
@@ -207,11 +246,18 @@ public:
             delay(1);
         }
         
-        Serial.println("Image captured");
+        PipelineMetrics::instance().countFrameCaptured();
+        if (verbose) {
+            Serial.println("Image captured");
+        }
         return true;
     }
     
-    bool processImageForFingers(int& fingerCount) {
+    // Capture a frame and read a sparse grid of FIFO bytes into samples.
+    // Split out of processImageForFingers so the capture and analysis steps
+    // can run on different tasks.
+    bool captureFingerSamples(uint8_t* samples, int maxSamples, int& count) {
+        count = 0;
         if (!captureImage()) {
             return false;
         }
@@ -230,6 +276,8 @@ public:
         Serial.printf("Using FIFO length: %d bytes\n", length);
         
         // Enhanced finger detection algorithm
+        TRACE_BEGIN(TRACE_FIFO_READ);
+        uint32_t transferStartUs = rtMicros();
         myCAM->CS_LOW();
         myCAM->set_fifo_burst();
         
@@ -240,18 +288,25 @@ public:
         
         // Sample image data in a grid pattern to detect finger-like regions
         uint32_t sampleCount = (3000 < length) ? 3000 : length;
-        uint8_t samples[100]; // Store sample points
-        int sampleIndex = 0;
         
         // Take samples across the image
-        for (int i = 0; i < sampleCount && sampleIndex < 100; i += 30) {
-            uint8_t pixel = SPI.transfer(0x00);
-            if (sampleIndex < 100) {
-                samples[sampleIndex++] = pixel;
-            }
+        for (int i = 0; i < sampleCount && count < maxSamples; i += 30) {
+            samples[count++] = SPI.transfer(0x00);
         }
         
         myCAM->CS_HIGH();
+        TRACE_END_ARG(TRACE_FIFO_READ, sampleCount);
+        PipelineMetrics::instance().observe(METRICS_STAGE_TRANSFER, rtMicros() - transferStartUs);
+        PipelineMetrics::instance().addTransferBytes((length < 200 ? length : 200) + count);
+        return true;
+    }
+    
+    bool processImageForFingers(int& fingerCount) {
+        uint8_t samples[100]; // Store sample points
+        int sampleIndex = 0;
+        if (!captureFingerSamples(samples, 100, sampleIndex)) {
+            return false;
+        }
         
         // Analyze samples for finger detection
         fingerCount = analyzeImageSamples(samples, sampleIndex);
@@ -259,14 +314,17 @@ public:
         Serial.printf("Analyzed %d samples, detected finger count: %d\n", sampleIndex, fingerCount);
         return true;
     }
-     bool extractImageFeatures(float* features, int feature_count) {
-        if (!captureImage()) {
+     bool extractImageFeatures(float* features, int feature_count, bool verbose = true) {
+        TRACE_SCOPE(TRACE_FEATURES);
+        if (!captureImage(verbose)) {
             return false;
         }
         
         uint32_t length = myCAM->read_fifo_length();
         if (length > 100000) length = 8192; // Handle PSRAM quirk
         
+        TRACE_BEGIN(TRACE_FIFO_READ);
+        uint32_t transferStartUs = rtMicros();
         myCAM->CS_LOW();
         myCAM->set_fifo_burst();
         
@@ -289,6 +347,11 @@ public:
         }
         
         myCAM->CS_HIGH();
+        TRACE_END_ARG(TRACE_FIFO_READ, length);
+        PipelineMetrics::instance().observe(METRICS_STAGE_TRANSFER, rtMicros() - transferStartUs);
+        PipelineMetrics::instance().addTransferBytes(length);
+        
+        rtChargeCost(RT_COST_FEATURES);
         
         if (pixel_count < 100) {
             // Not enough data, return default features
@@ -354,6 +417,8 @@ public:
     }
     
     int analyzeImageSamples(uint8_t* samples, int count) {
+        TRACE_SCOPE(TRACE_ANALYZE);
+        rtChargeCost(RT_COST_ANALYZE);
         if (count < 10) return 0; // Not enough data
         
         // Calculate image statistics
@@ -426,9 +491,7 @@ public:
         }
         
         uint8_t vid, pid;
-        myCAM->wrSensorReg8_8(0xff, 0x01);
-        myCAM->rdSensorReg8_8(OV2640_CHIPID_HIGH, &vid);
-        myCAM->rdSensorReg8_8(OV2640_CHIPID_LOW, &pid);
+        readSensorId(vid, pid);
         
         Serial.printf("Camera ID: 0x%02X 0x%02X\n", vid, pid);
     }
@@ -437,20 +500,23 @@ public:
         return testSPI() && testI2C();
     }
     
-    bool captureJPEG(uint8_t** jpegData, size_t* jpegSize) {
+    // verbose=false keeps streaming (several frames a second) off the log
+    bool captureJPEG(uint8_t** jpegData, size_t* jpegSize, bool verbose = true) {
         if (!isInitialized) {
             Serial.println("Camera not initialized");
             return false;
         }
         
         // Capture image
-        if (!captureImage()) {
+        if (!captureImage(verbose)) {
             return false;
         }
         
         // Read FIFO length
         uint32_t length = myCAM->read_fifo_length();
-        Serial.printf("FIFO length: %d bytes\n", length);
+        if (verbose) {
+            Serial.printf("FIFO length: %d bytes\n", length);
+        }
         
         // Handle PSRAM board quirks
         if (length >= MAX_FIFO_SIZE || length == 0 || length > 100000) {
@@ -468,6 +534,8 @@ public:
         *jpegSize = length;
         
         // Read JPEG data from FIFO
+        TRACE_BEGIN(TRACE_FIFO_READ);
+        uint32_t transferStartUs = rtMicros();
         myCAM->CS_LOW();
         myCAM->set_fifo_burst();
         
@@ -476,8 +544,13 @@ public:
         }
         
         myCAM->CS_HIGH();
+        TRACE_END_ARG(TRACE_FIFO_READ, length);
+        PipelineMetrics::instance().observe(METRICS_STAGE_TRANSFER, rtMicros() - transferStartUs);
+        PipelineMetrics::instance().addTransferBytes(length);
         
-        Serial.printf("JPEG captured: %d bytes\n", *jpegSize);
+        if (verbose) {
+            Serial.printf("JPEG captured: %u bytes\n", (unsigned)*jpegSize);
+        }
         return true;
     }
 };
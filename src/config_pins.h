@@ -18,6 +18,7 @@
 
 // Buzzer Pin
 #define BUZZER_PIN      4
+// #define BUZZER_LEDC_CHANNEL 0   // Uncomment for a passive buzzer driven by LEDC
 
 // Camera Settings
 #define CAM_WIDTH       160
@@ -27,5 +28,14 @@
 // Timer Settings
 #define MAX_TIMER_MINUTES 10
 #define MIN_TIMER_SECONDS 5
+#define MAX_CONCURRENT_TIMERS 4
+
+// Diagnostics
+#ifndef ENABLE_TRACE
+#define ENABLE_TRACE 0          // Stage tracing (runtime/trace.h); the native env turns it on
+#endif
+#ifndef ENABLE_HEAP_TELEMETRY
+#define ENABLE_HEAP_TELEMETRY 0 // Wrap ei_malloc and new/delete (runtime/heap_telemetry.h); +16 B per block, 4 KB table
+#endif
 
 #endif
\ No newline at end of file
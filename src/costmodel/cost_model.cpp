@@ -0,0 +1,559 @@
+// Static cost report for the impulse: walks ei_default_impulse (DSP,
+// learning and postprocessing blocks) and the EON graph description of each
+// compiled learning block, and prints per block and per node the MACs, bytes
+// read and written, tensor arena, and estimated CPU cycles on the ESP32 and
+// the ESP32-S3. Nothing is run; the report only depends on the model, so a
+// DSP/NN configuration can be compared before it is flashed.
+//
+//   pio run -e costmodel
+//   .pio/build/costmodel/program [--csv] [--ensemble] [--calibrate] [--tolerance PCT]
+//                                [--repetitions N]
+//
+// --ensemble   also report the second compiled graph ModelEnsemble runs
+// --calibrate  time the host build of the ESP-NN C kernels at the model
+//              shapes and a sweep of larger ones, and compare the measured
+//              cost ratios with the ones the esp32 profile predicts (it runs
+//              the same C code, esp_nn_softmax_s8_opt included); exits
+//              non-zero if a ratio is off by more than --tolerance percent
+//              (default 15). Each shape is the median of --repetitions runs
+//              (default 15).
+//
+// Cycle figures come from the per-op cost profiles below, not from a
+// simulator: they are meant for ranking configurations and spotting the
+// block that dominates. Constant tensors are costed as if the flash cache
+// is warm, which it is from the second inference on.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "edge-impulse-sdk/classifier/ei_run_classifier.h"
+#include "ai/eon_graph_hooks.h"
+#include "../bench/kernel_cases.h"
+
+// Per-target costs in CPU cycles. FULLY_CONNECTED walks each output's row
+// in steps of macLanes MACs plus a scalar tail, then requantizes the output.
+// SOFTMAX pays a per-element cost in each of its three passes over a row and
+// a per-row cost for the reciprocal of the sum of exps.
+struct TargetProfile {
+    const char* name;
+    const char* kernels;            // ESP-NN path the firmware gets on this target
+    double clockMhz;
+    int macLanes;                   // MACs per inner-loop step (1 = scalar C)
+    double cyclesPerMacStep;
+    double cyclesPerTailMac;        // depth % macLanes leftovers
+    double cyclesPerOutput;         // Bias, requantize, clamp
+    double cyclesPerKernelCall;     // Prologue and parameter setup
+    double cyclesPerSoftmaxElement; // Max, fixed-point exp, rescale
+    double cyclesPerSoftmaxRow;     // Leading zeros and 1 / (1 + x)
+    double cyclesPerOp;             // TFLM dispatch, ResetTensors, tensor lookups
+    double cyclesPerFlashByte;      // Constant data through the flash cache
+    double cyclesPerQuantizedValue; // float <-> int8 around the graph
+    double cyclesPerDspValue;       // Raw feature copy and axis scaling
+};
+
+enum TargetId {
+    TARGET_ESP32,
+    TARGET_ESP32S3,
+    TARGET_COUNT
+};
+
+// The kernel costs are instruction counts at one instruction per cycle, the
+// rate the schedule comments in esp_nn_fully_connected_s8_esp32s3.S assume
+// (its 10-instruction loops are annotated II=10). The C kernels are counted
+// per helper from ESP-NN's common_functions.h and softmax_common.h:
+//
+//   SAT_HIGH_MUL  overflow test 4, sign-picked 64-bit nudge 5, mull + mulsh 2,
+//                 nudge add with carry 4, saturating pick of the high word
+//                 (srai, and, add with carry, ssai + src) 8, result select 1
+//   with one operand constant the overflow test folds and the nudge sign is
+//   the other operand's: 19
+//   DIV_POW2      and with the mask, ssr + sra, sign and threshold, compare
+//                 and round; mask and threshold hoisted when the exponent is
+//                 loop-invariant: 7, or 6 with an immediate exponent
+static const double SAT_HIGH_MUL_CYCLES = 24;
+static const double SAT_HIGH_MUL_CONST_CYCLES = 19;
+static const double DIV_POW2_CYCLES = 7;
+static const double DIV_POW2_CONST_CYCLES = 6;
+
+// esp_nn_fully_connected_s8_ansi, per output: loop and row pointers 7, bias
+// 4, left shift 2, SAT_HIGH_MUL, DIV_POW2, offset, clamp and store 4, and 4
+// reloads of the parameters passed on the stack. Its inner loop is the
+// 10-instruction "remaining c loop" of the S3 kernel.
+static const double ANSI_FC_OUTPUT_CYCLES = 7 + 4 + 2 + SAT_HIGH_MUL_CYCLES + DIV_POW2_CYCLES + 4 + 4;
+
+// esp_nn_softmax_s8_opt, per element of a row:
+//   max pass      load, sign-extend, max, pointer: 4
+//   exp pass      load and diff 3, diff_min test 1, rescale 1 + SAT_HIGH_MUL;
+//                 esp_nn_exp_on_negative_values: argument 5, x^2 x^3 x^4 as
+//                 3 SAT_HIGH_MUL, the polynomial as 2 SAT_HIGH_MUL by a
+//                 constant, 2 DIV_POW2 by a constant and 4 adds, 7 barrel
+//                 steps of a SAT_HIGH_MUL by a constant and a 5-instruction
+//                 select, zero select 2; store 2, DIV_POW2 by ACCUM_BITS
+//                 and add 7, pointer 1
+//   output pass   load and diff 3, test 1, scratch load 1, SAT_HIGH_MUL,
+//                 DIV_POW2, offset, clamps and store 3, pointers 3
+// and per row: loop setup and init 10, nsau and shift 4, the 64-bit halving
+// 10, then esp_nn_one_over_one_plus_x_for_x_in_0_1's SAT_HIGH_MUL by a
+// constant and 3 Newton-Raphson steps of 2 SAT_HIGH_MUL, a 7-instruction
+// mul_power_of_2 and 2 adds, a final mul_power_of_2, and pointers 6
+static const double OPT_SOFTMAX_ELEMENT_CYCLES =
+    4 +
+    (5 + SAT_HIGH_MUL_CYCLES) + 5 + 3 * SAT_HIGH_MUL_CYCLES + 2 * SAT_HIGH_MUL_CONST_CYCLES +
+        2 * DIV_POW2_CONST_CYCLES + 4 + 7 * (SAT_HIGH_MUL_CONST_CYCLES + 5) + 2 + 2 + (DIV_POW2_CONST_CYCLES + 1) + 1 +
+    (5 + SAT_HIGH_MUL_CYCLES + DIV_POW2_CYCLES + 3 + 3);
+static const double OPT_SOFTMAX_ROW_CYCLES =
+    10 + 4 + 10 + (SAT_HIGH_MUL_CONST_CYCLES + 1) + 3 * (2 * SAT_HIGH_MUL_CYCLES + 7 + 2) + 7 + 6;
+
+// esp_nn_fully_connected_s8_esp32s3 as scheduled in its .S: a 10-instruction
+// loop per 8 MACs, the 10-instruction scalar loop for the tail, and 60 per
+// output (17 around the vector loop, 4 bias, 17 requantize, 10 shift, 12
+// offset, clamp and store); setting the tail loop up adds 7 that aren't
+// modelled. Kernel call: argument marshalling in the TFLM kernel and the
+// prologue and invariant setup of the ESP-NN function.
+static const TargetProfile profiles[TARGET_COUNT] = {
+    // LX6 without ESP-NN assembly for these ops: esp_nn_fully_connected_s8_ansi
+    // and esp_nn_softmax_s8_opt
+    { "esp32", "ESP-NN ANSI C", 240, 1, 10, 10, ANSI_FC_OUTPUT_CYCLES, 40,
+      OPT_SOFTMAX_ELEMENT_CYCLES, OPT_SOFTMAX_ROW_CYCLES, 400, 0.5, 30, 12 },
+    // LX7 with PIE: esp_nn_fully_connected_s8_esp32s3 does 8 int16 MACs per
+    // EE.VMULAS step; softmax is the same C code as on the ESP32
+    { "esp32s3", "ESP-NN S3 SIMD", 240, 8, 10, 10, 60, 40,
+      OPT_SOFTMAX_ELEMENT_CYCLES, OPT_SOFTMAX_ROW_CYCLES, 350, 0.25, 24, 10 },
+};
+
+// ---- Cost formulas -----------------------------------------------------------
+// Shared by the report and the calibration so both test the same model
+
+static double fullyConnectedCycles(const TargetProfile& profile, double batch, double outputs, double depth) {
+    double steps = floor(depth / profile.macLanes);
+    double tail = depth - steps * profile.macLanes;
+    double perOutput = steps * profile.cyclesPerMacStep + tail * profile.cyclesPerTailMac + profile.cyclesPerOutput;
+    return profile.cyclesPerKernelCall + batch * outputs * perOutput;
+}
+
+static double softmaxCycles(const TargetProfile& profile, double rows, double depth) {
+    return profile.cyclesPerKernelCall + rows * (profile.cyclesPerSoftmaxRow + depth * profile.cyclesPerSoftmaxElement);
+}
+
+// ---- Report rows -------------------------------------------------------------
+
+struct CostRow {
+    std::string scope;      // "block" or "node"
+    std::string block;
+    std::string node;
+    std::string op;
+    double macs;
+    double bytesRead;
+    double bytesWritten;
+    double arenaBytes;      // Graph arena for a block, arena tensors touched for a node
+    double cycles[TARGET_COUNT];
+    bool modelled;
+
+    CostRow() : macs(0), bytesRead(0), bytesWritten(0), arenaBytes(0), modelled(true) {
+        for (int t = 0; t < TARGET_COUNT; t++) cycles[t] = 0;
+    }
+
+    void add(const CostRow& other) {
+        macs += other.macs;
+        bytesRead += other.bytesRead;
+        bytesWritten += other.bytesWritten;
+        for (int t = 0; t < TARGET_COUNT; t++) cycles[t] += other.cycles[t];
+        modelled = modelled && other.modelled;
+    }
+};
+
+static size_t elementCount(const TfLiteIntArray* dims) {
+    size_t count = 1;
+    for (int i = 0; i < dims->size; i++) count *= dims->data[i];
+    return count;
+}
+
+// One EON node from its op name and tensor metadata
+static CostRow costNode(const EonGraphHooks* hooks, size_t index, const char* opName,
+                        const TfLiteIntArray* inputs, const TfLiteIntArray* outputs) {
+    CostRow row;
+    row.scope = "node";
+    row.node = std::to_string(index);
+    row.op = opName;
+
+    std::vector<TfLiteTensor> in, out;
+    double flashBytes = 0;
+    std::vector<int> arenaTensors;
+    for (int pass = 0; pass < 2; pass++) {
+        const TfLiteIntArray* indices = pass == 0 ? inputs : outputs;
+        for (int i = 0; i < indices->size; i++) {
+            TfLiteTensor tensor;
+            memset(&tensor, 0, sizeof(tensor));
+            int tensorIndex = indices->data[i];
+            if (tensorIndex < 0 || hooks->tensorInfo(tensorIndex, &tensor) != kTfLiteOk) continue;
+            (pass == 0 ? in : out).push_back(tensor);
+            if (pass == 0) row.bytesRead += tensor.bytes;
+            else row.bytesWritten += tensor.bytes;
+            if (tensor.allocation_type == kTfLiteArenaRw) {
+                if (std::find(arenaTensors.begin(), arenaTensors.end(), tensorIndex) == arenaTensors.end()) {
+                    arenaTensors.push_back(tensorIndex);
+                    row.arenaBytes += tensor.bytes;
+                }
+            } else if (pass == 0) {
+                flashBytes += tensor.bytes;
+            }
+        }
+    }
+
+    bool fullyConnected = strcmp(opName, "FULLY_CONNECTED") == 0 && in.size() >= 2 && in[1].dims->size == 2;
+    bool softmax = strcmp(opName, "SOFTMAX") == 0 && !out.empty();
+    double units = 0, depth = 0, batch = 0, rows = 0;
+    if (fullyConnected) {
+        units = in[1].dims->data[0];
+        depth = in[1].dims->data[1];
+        batch = depth > 0 ? elementCount(in[0].dims) / depth : 0;
+        row.macs = batch * units * depth;
+    } else if (softmax) {
+        // ESP-NN runs softmax over the last axis, row by row
+        const TfLiteIntArray* dims = out[0].dims;
+        depth = dims->size > 0 ? dims->data[dims->size - 1] : 1;
+        rows = depth > 0 ? elementCount(dims) / depth : 0;
+    }
+    row.modelled = fullyConnected || softmax;
+
+    for (int t = 0; t < TARGET_COUNT; t++) {
+        const TargetProfile& profile = profiles[t];
+        double cycles = profile.cyclesPerOp + flashBytes * profile.cyclesPerFlashByte;
+        if (fullyConnected) cycles += fullyConnectedCycles(profile, batch, units, depth);
+        if (softmax) cycles += softmaxCycles(profile, rows, depth);
+        row.cycles[t] = cycles;
+    }
+    return row;
+}
+
+// float <-> int8 conversion run_nn_inference and the postprocessing do around the graph
+static CostRow costConversion(const char* op, double values, double bytesIn, double bytesOut) {
+    CostRow row;
+    row.scope = "node";
+    row.node = "-";
+    row.op = op;
+    row.bytesRead = values * bytesIn;
+    row.bytesWritten = values * bytesOut;
+    for (int t = 0; t < TARGET_COUNT; t++) {
+        row.cycles[t] = profiles[t].cyclesPerKernelCall + values * profiles[t].cyclesPerQuantizedValue;
+    }
+    return row;
+}
+
+// Appends the block row followed by its node rows
+static void costGraph(const std::string& blockName, const EonGraphHooks* hooks,
+                      bool quantizedInput, double inputValues, std::vector<CostRow>& rows) {
+    CostRow block;
+    block.scope = "block";
+    block.block = blockName;
+    block.op = "tflite_eon";
+
+    std::vector<CostRow> nodes;
+    if (quantizedInput) nodes.push_back(costConversion("QUANTIZE (input)", inputValues, sizeof(float), 1));
+
+    if (!hooks) {
+        block.op = "tflite_eon (no graph description)";
+        block.modelled = false;
+    } else {
+        const char* opName;
+        const TfLiteIntArray* inputs;
+        const TfLiteIntArray* outputs;
+        for (size_t i = 0; hooks->nodeInfo(i, &opName, &inputs, &outputs); i++) {
+            nodes.push_back(costNode(hooks, i, opName, inputs, outputs));
+        }
+        block.arenaBytes = hooks->arenaSize();
+    }
+
+    for (size_t i = 0; i < nodes.size(); i++) {
+        nodes[i].block = blockName;
+        block.add(nodes[i]);
+    }
+    rows.push_back(block);
+    rows.insert(rows.end(), nodes.begin(), nodes.end());
+}
+
+static void costDspBlock(const ei_model_dsp_t& dsp, std::vector<CostRow>& rows) {
+    CostRow row;
+    row.scope = "block";
+    row.block = "dsp " + std::to_string(dsp.blockId);
+    double values = dsp.n_output_features;
+
+    if (dsp.extract_fn == &extract_raw_features) {
+        row.op = "raw";
+        row.bytesRead = values * sizeof(float);
+        row.bytesWritten = values * sizeof(float);
+        for (int t = 0; t < TARGET_COUNT; t++) {
+            row.cycles[t] = profiles[t].cyclesPerKernelCall + values * profiles[t].cyclesPerDspValue;
+        }
+    } else {
+        row.op = "unmodelled extractor";
+        row.bytesWritten = values * sizeof(float);
+        row.modelled = false;
+    }
+    rows.push_back(row);
+}
+
+static void costLearningBlock(const ei_learning_block_t& learn, const ei_impulse_t* impulse,
+                              std::vector<CostRow>& rows) {
+    std::string name = "learn " + std::to_string(learn.blockId);
+    const ei_learning_block_config_tflite_graph_t* config =
+        (const ei_learning_block_config_tflite_graph_t*)learn.config;
+
+    if (learn.infer_fn != &run_nn_inference || !config->compiled) {
+        CostRow row;
+        row.scope = "block";
+        row.block = name;
+        row.op = "unmodelled (not an EON graph)";
+        row.modelled = false;
+        rows.push_back(row);
+        return;
+    }
+
+    size_t first = rows.size();
+    const ei_config_tflite_eon_graph_t* graph = (const ei_config_tflite_eon_graph_t*)config->graph_config;
+    costGraph(name, findEonGraphHooks(graph->model_invoke), config->quantized, impulse->nn_input_frame_size, rows);
+    if (config->quantized && config->dequantize_output) {
+        CostRow dequantize = costConversion("DEQUANTIZE (output)", impulse->label_count, 1, sizeof(float));
+        dequantize.block = name;
+        rows[first].add(dequantize);
+        rows.push_back(dequantize);
+    }
+}
+
+static void costPostprocessingBlock(const ei_postprocessing_block_t& post, const ei_impulse_t* impulse,
+                                    std::vector<CostRow>& rows) {
+    // Each result entry is a label pointer and a float on the 32-bit targets
+    const double resultBytes = 8;
+    double labels = impulse->label_count;
+    CostRow row;
+    if (post.postprocess_fn == &process_classification_i8) {
+        row = costConversion("classification_i8", labels, 1, resultBytes);
+    } else if (post.postprocess_fn == &process_classification_f32) {
+        row = costConversion("classification_f32", labels, sizeof(float), resultBytes);
+    } else {
+        row.op = "unmodelled postprocessing";
+        row.modelled = false;
+    }
+    row.scope = "block";
+    row.block = "post " + std::to_string(post.block_id);
+    row.node = "";
+    rows.push_back(row);
+}
+
+// ---- Output ------------------------------------------------------------------
+
+static double toUs(double cycles, const TargetProfile& profile) {
+    return cycles / profile.clockMhz;
+}
+
+static void printCsv(const std::vector<CostRow>& rows) {
+    printf("scope,block,node,op,macs,bytes_read,bytes_written,arena_bytes");
+    for (int t = 0; t < TARGET_COUNT; t++) printf(",%s_cycles,%s_us", profiles[t].name, profiles[t].name);
+    printf(",modelled\n");
+    for (size_t i = 0; i < rows.size(); i++) {
+        const CostRow& row = rows[i];
+        printf("%s,%s,%s,%s,%.0f,%.0f,%.0f,%.0f", row.scope.c_str(), row.block.c_str(), row.node.c_str(),
+               row.op.c_str(), row.macs, row.bytesRead, row.bytesWritten, row.arenaBytes);
+        for (int t = 0; t < TARGET_COUNT; t++) {
+            printf(",%.0f,%.2f", row.cycles[t], toUs(row.cycles[t], profiles[t]));
+        }
+        printf(",%d\n", row.modelled ? 1 : 0);
+    }
+}
+
+static void printTable(const std::vector<CostRow>& rows) {
+    printf("%-24s %-20s %8s %8s %8s %8s", "block / node", "op", "MACs", "read B", "write B", "arena B");
+    for (int t = 0; t < TARGET_COUNT; t++) {
+        std::string cycles = std::string(profiles[t].name) + " cyc";
+        std::string us = std::string(profiles[t].name) + " us";
+        printf(" %12s %11s", cycles.c_str(), us.c_str());
+    }
+    printf("\n");
+
+    for (size_t i = 0; i < rows.size(); i++) {
+        const CostRow& row = rows[i];
+        std::string label = row.scope == "node" ? "  node " + row.node : row.block;
+        std::string op = row.op + (row.modelled ? "" : " ?");
+        printf("%-24s %-20s %8.0f %8.0f %8.0f %8.0f", label.c_str(), op.c_str(),
+               row.macs, row.bytesRead, row.bytesWritten, row.arenaBytes);
+        for (int t = 0; t < TARGET_COUNT; t++) {
+            printf(" %12.0f %11.2f", row.cycles[t], toUs(row.cycles[t], profiles[t]));
+        }
+        printf("\n");
+    }
+}
+
+// ---- Calibration ---------------------------------------------------------------
+// The host runs the same ESP-NN C kernels the ESP32 does, so each kernel's
+// cost across shapes should be in the proportions the esp32 profile
+// predicts. Absolute times don't transfer, and neither does the ratio
+// between kernels: the host overlaps the independent instructions of the
+// MAC loop but not softmax's chains of dependent SAT_HIGH_MULs, which the
+// LX6 runs at one instruction per cycle either way. So one host-ns-per-cycle
+// scale is fitted per kernel (geometric mean) and each shape is checked
+// against its kernel's scale. Shapes stay small because the host compiler
+// vectorizes the C loops, which flatters large layers in a way the LX6 can't.
+// Each shape is timed as the median of --repetitions runs, which a stray
+// slow or fast run on a busy machine doesn't move.
+
+static void calibrateFullyConnected(BenchState& state) {
+    FullyConnectedCase bench((int)state.arg(0), (int)state.arg(1));
+    while (state.keepRunning()) {
+        bench.run(PATH_ESP_NN_OPT);
+        benchClobberMemory();
+    }
+}
+
+static void calibrateSoftmax(BenchState& state) {
+    SoftmaxCase bench((int)state.arg(0), (int)state.arg(1));
+    while (state.keepRunning()) {
+        bench.run(PATH_ESP_NN_OPT);
+        benchClobberMemory();
+    }
+}
+
+struct CalibrationShape {
+    bool softmax;
+    long a;     // outputs, or rows
+    long b;     // depth
+};
+
+static const CalibrationShape calibrationShapes[] = {
+    { false, 20, 20 }, { false, 10, 20 }, { false, 6, 10 },
+    { false, 32, 64 }, { false, 64, 128 },
+    { true, 1, 6 }, { true, 1, 32 }, { true, 1, 256 },
+};
+
+#define CALIBRATION_SHAPES (sizeof(calibrationShapes) / sizeof(calibrationShapes[0]))
+
+static int calibrate(double tolerancePercent, int repetitions) {
+    const TargetProfile& profile = profiles[TARGET_ESP32];
+    BenchOptions options;
+    options.minTimeSec = 0.05;
+    options.repetitions = repetitions;
+    BenchRunner runner;
+    runner.setOptions(options);
+
+    // Indexed by CalibrationShape::softmax
+    static const char* const kernelNames[2] = { "fully_connected", "softmax" };
+    double hostNs[CALIBRATION_SHAPES];
+    double cycles[CALIBRATION_SHAPES];
+    double logScale[2] = { 0, 0 };
+    int shapes[2] = { 0, 0 };
+    for (size_t i = 0; i < CALIBRATION_SHAPES; i++) {
+        const CalibrationShape& shape = calibrationShapes[i];
+        BenchCase bench;
+        bench.function = shape.softmax ? calibrateSoftmax : calibrateFullyConnected;
+        bench.args.push_back(shape.a);
+        bench.args.push_back(shape.b);
+        hostNs[i] = runner.measure(bench).medianNs;
+        cycles[i] = shape.softmax
+            ? softmaxCycles(profile, shape.a, shape.b)
+            : fullyConnectedCycles(profile, 1, shape.a, shape.b);
+        logScale[shape.softmax] += log(hostNs[i] / cycles[i]);
+        shapes[shape.softmax]++;
+    }
+    double scale[2];
+    for (int k = 0; k < 2; k++) scale[k] = exp(logScale[k] / shapes[k]);
+
+    printf("\n%-24s %12s %12s %14s %8s\n", "calibration shape", "host ns", "esp32 cyc", "predicted ns", "error");
+    int failures = 0;
+    for (size_t i = 0; i < CALIBRATION_SHAPES; i++) {
+        const CalibrationShape& shape = calibrationShapes[i];
+        double predicted = cycles[i] * scale[shape.softmax];
+        double error = 100.0 * (predicted - hostNs[i]) / hostNs[i];
+        bool fail = fabs(error) > tolerancePercent;
+        if (fail) failures++;
+
+        char name[48];
+        snprintf(name, sizeof(name), "%s %ldx%ld", kernelNames[shape.softmax], shape.a, shape.b);
+        printf("%-24s %12.1f %12.0f %14.1f %7.1f%%%s\n", name, hostNs[i], cycles[i], predicted, error,
+               fail ? "  OUT OF TOLERANCE" : "");
+    }
+
+    fflush(stdout);
+    for (int k = 0; k < 2; k++) {
+        fprintf(stderr, "[costmodel] calibration: %s host %.4f ns per esp32 cycle\n", kernelNames[k], scale[k]);
+    }
+    fprintf(stderr, "[costmodel] calibration: %d of %d shapes within %.0f%%, median of %d runs each\n",
+            (int)CALIBRATION_SHAPES - failures, (int)CALIBRATION_SHAPES, tolerancePercent, repetitions);
+    fprintf(stderr, "[costmodel] the esp32s3 FULLY_CONNECTED kernel is Xtensa PIE assembly and has no host counterpart\n");
+    return failures;
+}
+
+static void usage(const char* program) {
+    printf("usage: %s [--csv] [--ensemble] [--calibrate] [--tolerance PCT] [--repetitions N]\n", program);
+}
+
+int main(int argc, char** argv) {
+    bool csv = false, ensemble = false, calibration = false;
+    double tolerancePercent = 15;
+    int repetitions = 15;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--csv") == 0) {
+            csv = true;
+        } else if (strcmp(argv[i], "--ensemble") == 0) {
+            ensemble = true;
+        } else if (strcmp(argv[i], "--calibrate") == 0) {
+            calibration = true;
+        } else if (strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc) {
+            tolerancePercent = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--repetitions") == 0 && i + 1 < argc) {
+            repetitions = std::max(1, atoi(argv[++i]));
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    const ei_impulse_t* impulse = ei_default_impulse.impulse;
+    std::vector<CostRow> rows;
+    for (size_t i = 0; i < impulse->dsp_blocks_size; i++) {
+        costDspBlock(impulse->dsp_blocks[i], rows);
+    }
+    for (size_t i = 0; i < impulse->learning_blocks_size; i++) {
+        costLearningBlock(impulse->learning_blocks[i], impulse, rows);
+    }
+    for (size_t i = 0; i < impulse->postprocessing_blocks_size; i++) {
+        costPostprocessingBlock(impulse->postprocessing_blocks[i], impulse, rows);
+    }
+
+    CostRow total;
+    total.scope = "total";
+    total.block = "total";
+    for (size_t i = 0; i < rows.size(); i++) {
+        if (rows[i].scope != "block") continue;
+        total.add(rows[i]);
+        total.arenaBytes = std::max(total.arenaBytes, rows[i].arenaBytes);
+    }
+    rows.push_back(total);
+
+    if (ensemble) {
+        // ModelEnsemble runs this graph on the same features after the impulse's own
+        costGraph("ensemble 766107_3", &tflite_learn_766107_3_hooks, true, impulse->nn_input_frame_size, rows);
+    }
+
+    // Context goes to stderr so --csv output stays clean
+    fprintf(stderr, "[costmodel] impulse %d \"%s\" (%s): %u DSP, %u learning, %u postprocessing blocks, %u labels\n",
+            (int)impulse->project_id, impulse->project_name, impulse->impulse_name,
+            (unsigned)impulse->dsp_blocks_size, (unsigned)impulse->learning_blocks_size,
+            (unsigned)impulse->postprocessing_blocks_size, (unsigned)impulse->label_count);
+    for (int t = 0; t < TARGET_COUNT; t++) {
+        fprintf(stderr, "[costmodel] %s: %.0f MHz, %s\n", profiles[t].name, profiles[t].clockMhz, profiles[t].kernels);
+    }
+    fprintf(stderr, "[costmodel] EON arenas are what init allocates; the TFLM interpreter would need %d B\n",
+            EI_CLASSIFIER_TFLITE_LARGEST_ARENA_SIZE);
+
+    if (csv) {
+        printCsv(rows);
+    } else {
+        printTable(rows);
+    }
+
+    int failures = calibration ? calibrate(tolerancePercent, repetitions) : 0;
+    return failures == 0 ? 0 : 1;
+}
@@ -40,6 +40,7 @@
 #include "edge-impulse-sdk/dsp/speechpy/speechpy.hpp"
 #include "edge-impulse-sdk/classifier/ei_signal_with_range.h"
 #include "edge-impulse-sdk/dsp/ei_flatten.h"
+#include "edge-impulse-sdk/dsp/ei_profiler.h"
 #include "model-parameters/model_metadata.h"
 
 #if EI_CLASSIFIER_HR_ENABLED
@@ -100,6 +101,7 @@ __attribute__((unused)) int extract_spectral_analysis_features(
     void *config_ptr,
     const float frequency)
 {
+    EI_PROFILE_ZONE("dsp_spectral");
     ei_dsp_config_spectral_analysis_t *config = (ei_dsp_config_spectral_analysis_t *)config_ptr;
 
     // input matrix from the raw signal
@@ -160,6 +162,7 @@ __attribute__((unused)) int extract_spectral_analysis_features(
 }
 
 __attribute__((unused)) int extract_raw_features(signal_t *signal, matrix_t *output_matrix, void *config_ptr, const float frequency) {
+    EI_PROFILE_ZONE("dsp_raw");
     ei_dsp_config_raw_t config = *((ei_dsp_config_raw_t*)config_ptr);
 
     // Because of rounding errors during re-sampling the output size of the block might be
@@ -183,6 +186,7 @@ __attribute__((unused)) int extract_raw_features(signal_t *signal, matrix_t *out
 }
 
 __attribute__((unused)) int extract_flatten_features(signal_t *signal, matrix_t *output_matrix, void *config_ptr, const float frequency) {
+    EI_PROFILE_ZONE("dsp_flatten");
     auto handle = flatten_class::create(config_ptr, frequency);
     auto ret = handle->extract(signal, output_matrix, config_ptr, frequency, nullptr);
     delete handle;
@@ -195,6 +199,7 @@ static int preemphasized_audio_signal_get_data(size_t offset, size_t length, flo
 }
 
 __attribute__((unused)) int extract_mfcc_features(signal_t *signal, matrix_t *output_matrix, void *config_ptr, const float sampling_frequency) {
+    EI_PROFILE_ZONE("dsp_mfcc");
     ei_dsp_config_mfcc_t config = *((ei_dsp_config_mfcc_t*)config_ptr);
 
     if (config.axes != 1) {
@@ -468,6 +473,7 @@ __attribute__((unused)) int extract_mfcc_per_slice_features(signal_t *signal, ma
 }
 
 __attribute__((unused)) int extract_spectrogram_features(signal_t *signal, matrix_t *output_matrix, void *config_ptr, const float sampling_frequency) {
+    EI_PROFILE_ZONE("dsp_spectrogram");
     ei_dsp_config_spectrogram_t config = *((ei_dsp_config_spectrogram_t*)config_ptr);
 
     if (config.axes != 1) {
@@ -737,6 +743,7 @@ __attribute__((unused)) int extract_spectrogram_per_slice_features(signal_t *sig
 
 
 __attribute__((unused)) int extract_mfe_features(signal_t *signal, matrix_t *output_matrix, void *config_ptr, const float sampling_frequency) {
+    EI_PROFILE_ZONE("dsp_mfe");
     ei_dsp_config_mfe_t config = *((ei_dsp_config_mfe_t*)config_ptr);
 
     if (config.axes != 1) {
@@ -1113,6 +1120,7 @@ __attribute__((unused)) int extract_mfe_per_slice_features(signal_t *signal, mat
 }
 
 __attribute__((unused)) int extract_image_features(signal_t *signal, matrix_t *output_matrix, void *config_ptr, const float frequency) {
+    EI_PROFILE_ZONE("dsp_image");
     ei_dsp_config_image_t config = *((ei_dsp_config_image_t*)config_ptr);
 
     int16_t channel_count = strcmp(config.channels, "Grayscale") == 0 ? 1 : 3;
@@ -1235,6 +1243,7 @@ __attribute__((unused)) int extract_drpai_features_quantized(signal_t *signal, m
 
 __attribute__((unused)) int extract_image_features_quantized(signal_t *signal, matrix_i8_t *output_matrix, void *config_ptr, float scale, float zero_point, const float frequency,
                                                              int image_scaling) {
+    EI_PROFILE_ZONE("dsp_image_quantized");
     ei_dsp_config_image_t config = *((ei_dsp_config_image_t*)config_ptr);
 
     int16_t channel_count = strcmp(config.channels, "Grayscale") == 0 ? 1 : 3;
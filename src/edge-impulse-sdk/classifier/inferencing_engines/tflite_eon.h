@@ -43,6 +43,10 @@
 #include "edge-impulse-sdk/classifier/ei_model_types.h"
 #include "edge-impulse-sdk/classifier/inferencing_engines/tflite_helper.h"
 #include "edge-impulse-sdk/classifier/ei_run_dsp.h"
+#include "edge-impulse-sdk/dsp/ei_profiler.h"
+#if EI_PROFILER_ENABLED
+#include "ai/eon_graph_hooks.h"
+#endif
 
 /**
  * Setup the TFLite runtime
@@ -111,7 +115,24 @@ static EI_IMPULSE_ERROR inference_tflite_run(
 
     ei_config_tflite_eon_graph_t *graph_config = (ei_config_tflite_eon_graph_t*)block_config->graph_config;
 
-    if (graph_config->model_invoke() != kTfLiteOk) {
+#if EI_PROFILER_ENABLED
+    // Per-op zones (FULLY_CONNECTED, SOFTMAX, ...) under "inference"
+    static ei::profiler::tag_profiler op_profiler;
+    const EonGraphHooks *hooks = findEonGraphHooks(graph_config->model_invoke);
+    if (hooks) {
+        hooks->setProfiler(&op_profiler);
+    }
+#endif
+
+    TfLiteStatus invoke_status = graph_config->model_invoke();
+
+#if EI_PROFILER_ENABLED
+    if (hooks) {
+        hooks->setProfiler(nullptr);
+    }
+#endif
+
+    if (invoke_status != kTfLiteOk) {
         return EI_IMPULSE_TFLITE_ERROR;
     }
 
@@ -31,8 +31,422 @@
 #ifndef __EIPROFILER__H__
 #define __EIPROFILER__H__
 
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
 #include "edge-impulse-sdk/porting/ei_classifier_porting.h"
+#include "edge-impulse-sdk/tensorflow/lite/micro/micro_profiler_interface.h"
 
+/**
+ * Scoped-zone profiler.
+ *
+ * Place EI_PROFILE_ZONE("name") at the top of a block; the time until the
+ * block exits is charged to that zone. Zones opened while another zone is
+ * active become its children, so a report shows where the time inside
+ * process_impulse went (DSP block, extractor, inference, kernels) with both
+ * total and self time per zone. Statistics are kept per (parent, zone) pair:
+ * a zone entered from two call paths (a kernel under two models' invokes)
+ * appears once under each, with its own figures.
+ *
+ * Each node keeps count, min, max, total and a log-linear histogram (four
+ * sub-buckets per power of two, so percentiles are within ~12%) from which
+ * p99 is read. Timestamps come from the CPU cycle counter on Xtensa, the
+ * monotonic clock (ns) on Linux/macOS hosts and ei_read_timer_us() elsewhere.
+ * Ticks are 32 bits, so a single zone entry must stay below 2^32 ticks
+ * (~17 s at 240 MHz, ~4 s on hosts).
+ *
+ * Build with EI_PROFILER_ENABLED=1 to turn it on. Otherwise the macros
+ * expand to nothing and instrumented code is unchanged.
+ *
+ * Statistics are not locked: a zone is expected to be entered from one task
+ * at a time (inference runs on a single task). A report or reset from
+ * another task can see a node mid-update, which only skews that report.
+ */
+
+#ifndef EI_PROFILER_ENABLED
+#define EI_PROFILER_ENABLED 0
+#endif
+
+// Nodes, i.e. distinct (parent, zone) pairs
+#ifndef EI_PROFILER_MAX_ZONES
+#define EI_PROFILER_MAX_ZONES 32
+#endif
+
+#ifndef EI_PROFILER_MAX_TAGGED_ZONES
+#define EI_PROFILER_MAX_TAGGED_ZONES 8
+#endif
+
+#define EI_PROFILER_MAX_DEPTH 8
+#define EI_PROFILER_BUCKETS 128
+
+#ifndef EI_PROFILER_THREAD_LOCAL
+#define EI_PROFILER_THREAD_LOCAL thread_local
+#endif
+
+#if defined(__XTENSA__)
+#ifdef F_CPU
+#define EI_PROFILER_TICKS_PER_US (F_CPU / 1000000)
+#else
+#define EI_PROFILER_TICKS_PER_US 240
+#endif
+static inline uint32_t ei_profiler_ticks()
+{
+    uint32_t ccount;
+    __asm__ __volatile__("rsr %0, ccount" : "=a"(ccount));
+    return ccount;
+}
+#elif defined(__linux__) || defined(__APPLE__)
+#include <time.h>
+#define EI_PROFILER_TICKS_PER_US 1000
+static inline uint32_t ei_profiler_ticks()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec);
+}
+#else
+#define EI_PROFILER_TICKS_PER_US 1
+static inline uint32_t ei_profiler_ticks()
+{
+    return (uint32_t)ei_read_timer_us();
+}
+#endif
+
+typedef struct ei_profile_node ei_profile_node_t;
+
+// One instrumented site: a static per EI_PROFILE_ZONE, one per distinct tag
+typedef struct ei_profile_zone {
+    const char *name;
+    ei_profile_node_t *last;            // Node of the latest entry, tried first
+} ei_profile_zone_t;
+
+// Statistics of one zone under one parent node
+struct ei_profile_node {
+    const ei_profile_zone_t *zone;
+    ei_profile_node_t *parent;
+    int depth;
+    uint32_t count;
+    uint32_t min_ticks;
+    uint32_t max_ticks;
+    uint64_t total_ticks;
+    uint64_t child_ticks;               // Spent in nested zones
+    uint32_t histogram[EI_PROFILER_BUCKETS];
+};
+
+namespace ei {
+namespace profiler {
+
+struct registry_t {
+    ei_profile_node_t nodes[EI_PROFILER_MAX_ZONES];
+    int count;
+    uint32_t dropped;                   // Entries whose node did not fit
+};
+
+// inline, not static: one registry shared by every translation unit
+inline registry_t &registry()
+{
+    static registry_t instance;
+    return instance;
+}
+
+class scope;
+
+inline scope *&current_scope()
+{
+    static EI_PROFILER_THREAD_LOCAL scope *current = nullptr;
+    return current;
+}
+
+// Log-linear bucket: exact below 4 ticks, then 4 buckets per power of two
+static inline int bucket_of(uint32_t ticks)
+{
+    if (ticks < 4) {
+        return (int)ticks;
+    }
+    int msb = 31 - __builtin_clz(ticks);
+    int sub = (int)((ticks >> (msb - 2)) & 3);
+    return msb * 4 + sub - 4;
+}
+
+static inline uint32_t bucket_upper(int bucket)
+{
+    if (bucket < 4) {
+        return (uint32_t)bucket;
+    }
+    int msb = (bucket + 4) / 4;
+    int sub = (bucket + 4) % 4;
+    uint64_t upper = ((uint64_t)(5 + sub) << (msb - 2)) - 1;
+    return upper > 0xFFFFFFFFu ? 0xFFFFFFFFu : (uint32_t)upper;
+}
+
+// The node for zone under parent, created on its first entry there (so
+// parents always precede their children). Null once the registry is full.
+static inline ei_profile_node_t *node_for(ei_profile_zone_t *zone, ei_profile_node_t *parent)
+{
+    if (zone->last && zone->last->parent == parent) {
+        return zone->last;
+    }
+    registry_t &reg = registry();
+    ei_profile_node_t *node = nullptr;
+    for (int i = 0; i < reg.count && !node; i++) {
+        if (reg.nodes[i].zone == zone && reg.nodes[i].parent == parent) {
+            node = &reg.nodes[i];
+        }
+    }
+    if (!node) {
+        if (reg.count == EI_PROFILER_MAX_ZONES) {
+            reg.dropped++;
+            return nullptr;
+        }
+        node = &reg.nodes[reg.count++];
+        node->zone = zone;
+        node->parent = parent;
+        node->depth = parent ? parent->depth + 1 : 0;
+        node->min_ticks = 0xFFFFFFFFu;
+    }
+    zone->last = node;
+    return node;
+}
+
+static inline void record(ei_profile_node_t *node, uint32_t ticks, uint32_t child_ticks)
+{
+    node->count++;
+    if (ticks < node->min_ticks) node->min_ticks = ticks;
+    if (ticks > node->max_ticks) node->max_ticks = ticks;
+    node->total_ticks += ticks;
+    node->child_ticks += child_ticks;
+    node->histogram[bucket_of(ticks)]++;
+}
+
+class scope {
+public:
+    scope() : node(nullptr), parent(nullptr), start(0), child_ticks(0) { }
+
+    explicit scope(ei_profile_zone_t *zone) : scope()
+    {
+        begin(zone);
+    }
+
+    ~scope()
+    {
+        end();
+    }
+
+    // begin()/end() are for spans that cannot be a C++ block (e.g.
+    // MicroProfilerInterface events); spans must still nest
+    void begin(ei_profile_zone_t *zone)
+    {
+        scope *outer = current_scope();
+        node = node_for(zone, outer ? outer->node : nullptr);
+        if (!node) {
+            return;                     // Not recorded; children attach to outer
+        }
+        parent = outer;
+        child_ticks = 0;
+        current_scope() = this;
+        start = ei_profiler_ticks();
+    }
+
+    void end()
+    {
+        if (!node) {
+            return;
+        }
+        uint32_t ticks = ei_profiler_ticks() - start;
+        current_scope() = parent;
+        record(node, ticks, child_ticks);
+        if (parent) {
+            parent->child_ticks += ticks;
+        }
+        node = nullptr;
+    }
+
+private:
+    ei_profile_node_t *node;
+    scope *parent;
+    uint32_t start;
+    uint32_t child_ticks;
+};
+
+// Zones named at run time, one per distinct tag
+inline ei_profile_zone_t *tagged_zone(const char *tag)
+{
+    static ei_profile_zone_t zones[EI_PROFILER_MAX_TAGGED_ZONES];
+    static int count = 0;
+    for (int i = 0; i < count; i++) {
+        if (zones[i].name == tag || strcmp(zones[i].name, tag) == 0) {
+            return &zones[i];
+        }
+    }
+    if (count == EI_PROFILER_MAX_TAGGED_ZONES) {
+        return nullptr;
+    }
+    zones[count].name = tag;
+    return &zones[count++];
+}
+
+/**
+ * Feeds MicroProfilerInterface events (TFLM interpreter, EON invoke loop)
+ * into the zone tree: each tag becomes a zone, nested under whatever zone
+ * is open at the event.
+ */
+class tag_profiler : public tflite::MicroProfilerInterface {
+public:
+    tag_profiler() : depth(0) { }
+
+    uint32_t BeginEvent(const char *tag) override
+    {
+        ei_profile_zone_t *zone = tagged_zone(tag);
+        if (!zone || depth == EI_PROFILER_MAX_DEPTH) {
+            return EI_PROFILER_MAX_DEPTH;
+        }
+        scopes[depth].begin(zone);
+        return (uint32_t)depth++;
+    }
+
+    void EndEvent(uint32_t event_handle) override
+    {
+        if (event_handle >= (uint32_t)depth) {
+            return;
+        }
+        // Close anything left open above this event as well
+        while (depth > (int)event_handle) {
+            scopes[--depth].end();
+        }
+    }
+
+private:
+    scope scopes[EI_PROFILER_MAX_DEPTH];
+    int depth;
+};
+
+} // namespace profiler
+} // namespace ei
+
+/**
+ * @brief      Smallest recorded duration that at least `percent` of a node's
+ *             samples do not exceed, in ticks (bucket upper bound, clamped to
+ *             the node's max). Divide by EI_PROFILER_TICKS_PER_US for us.
+ */
+static inline uint32_t ei_profiler_percentile_ticks(const ei_profile_node_t *node, float percent)
+{
+    if (node->count == 0) {
+        return 0;
+    }
+    uint64_t target = (uint64_t)(node->count * (percent / 100.0f) + 0.5f);
+    if (target < 1) target = 1;
+    uint64_t seen = 0;
+    for (int b = 0; b < EI_PROFILER_BUCKETS; b++) {
+        seen += node->histogram[b];
+        if (seen >= target) {
+            uint32_t upper = ei::profiler::bucket_upper(b);
+            return upper > node->max_ticks ? node->max_ticks : upper;
+        }
+    }
+    return node->max_ticks;
+}
+
+static inline int ei_profiler_node_count()
+{
+    return ei::profiler::registry().count;
+}
+
+static inline const ei_profile_node_t *ei_profiler_node_at(int index)
+{
+    return index >= 0 && index < ei_profiler_node_count() ? &ei::profiler::registry().nodes[index] : nullptr;
+}
+
+// First node of the zone named name under parent (nullptr: top level)
+static inline const ei_profile_node_t *ei_profiler_find(const char *name, const ei_profile_node_t *parent)
+{
+    for (int i = 0; i < ei_profiler_node_count(); i++) {
+        const ei_profile_node_t *node = ei_profiler_node_at(i);
+        if (node->parent == parent && strcmp(node->zone->name, name) == 0) {
+            return node;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * @brief      Clear the statistics of every node (the tree is kept)
+ */
+static inline void ei_profiler_reset()
+{
+    for (int i = 0; i < ei_profiler_node_count(); i++) {
+        ei_profile_node_t *node = &ei::profiler::registry().nodes[i];
+        node->count = 0;
+        node->min_ticks = 0xFFFFFFFFu;
+        node->max_ticks = 0;
+        node->total_ticks = 0;
+        node->child_ticks = 0;
+        memset(node->histogram, 0, sizeof(node->histogram));
+    }
+    ei::profiler::registry().dropped = 0;
+}
+
+// Ticks as microseconds with one decimal, e.g. "12.5"
+static inline const char *ei_profiler_format_us(uint64_t ticks, char *buf, size_t size)
+{
+    uint64_t tenths = ticks * 10 / EI_PROFILER_TICKS_PER_US;
+    snprintf(buf, size, "%lu.%lu", (unsigned long)(tenths / 10), (unsigned long)(tenths % 10));
+    return buf;
+}
+
+static inline void ei_profiler_print_children(const ei_profile_node_t *parent)
+{
+    char mean[24], self_us[24], min_us[24], p99[24], max_us[24];
+
+    for (int i = 0; i < ei_profiler_node_count(); i++) {
+        const ei_profile_node_t *node = ei_profiler_node_at(i);
+        if (node->parent != parent) {
+            continue;
+        }
+        if (node->count > 0) {
+            uint64_t self = node->total_ticks > node->child_ticks ? node->total_ticks - node->child_ticks : 0;
+            ei_printf("%*s%-*s %7lu %9s %9s %9s %9s %9s\r\n",
+                node->depth * 2, "", 32 - node->depth * 2, node->zone->name,
+                (unsigned long)node->count,
+                ei_profiler_format_us(node->total_ticks / node->count, mean, sizeof(mean)),
+                ei_profiler_format_us(self / node->count, self_us, sizeof(self_us)),
+                ei_profiler_format_us(node->min_ticks, min_us, sizeof(min_us)),
+                ei_profiler_format_us(ei_profiler_percentile_ticks(node, 99.0f), p99, sizeof(p99)),
+                ei_profiler_format_us(node->max_ticks, max_us, sizeof(max_us)));
+        }
+        ei_profiler_print_children(node);
+    }
+}
+
+/**
+ * @brief      Print the zone tree with per-node statistics in microseconds
+ *             (mean = total per call, self = excluding child zones)
+ */
+static inline void ei_profiler_report()
+{
+    ei_printf("%-32s %7s %9s %9s %9s %9s %9s\r\n", "zone", "count", "mean us", "self us", "min us", "p99 us", "max us");
+    ei_profiler_print_children(nullptr);
+    if (ei::profiler::registry().dropped > 0) {
+        ei_printf("(%lu zone entries over EI_PROFILER_MAX_ZONES not recorded)\r\n",
+            (unsigned long)ei::profiler::registry().dropped);
+    }
+}
+
+#define EI_PROFILER_CONCAT_(a, b) a##b
+#define EI_PROFILER_CONCAT(a, b) EI_PROFILER_CONCAT_(a, b)
+
+#if EI_PROFILER_ENABLED
+#define EI_PROFILE_ZONE(zone_name) \
+    static ei_profile_zone_t EI_PROFILER_CONCAT(_ei_zone_, __LINE__) = { zone_name }; \
+    ei::profiler::scope EI_PROFILER_CONCAT(_ei_scope_, __LINE__)(&EI_PROFILER_CONCAT(_ei_zone_, __LINE__))
+#else
+#define EI_PROFILE_ZONE(zone_name)
+#endif
+
+/**
+ * Interval timer kept for existing callers: report() prints the time since
+ * the last reset() or report(). Now microsecond based.
+ */
 class EiProfiler {
 public:
     EiProfiler()
@@ -41,12 +455,14 @@ public:
     }
     void reset()
     {
-        timestamp = ei_read_timer_ms();
+        timestamp = ei_read_timer_us();
     }
     void report(const char *message)
     {
-        ei_printf("%s took %llu\r\n", message, ei_read_timer_ms() - timestamp);
-        timestamp = ei_read_timer_ms(); //read again to not count printf time
+        uint64_t elapsed = ei_read_timer_us() - timestamp;
+        ei_printf("%s took %llu.%03llu ms\r\n", message,
+            (unsigned long long)(elapsed / 1000), (unsigned long long)(elapsed % 1000));
+        timestamp = ei_read_timer_us(); //read again to not count printf time
     }
 
 private:
@@ -48,11 +48,11 @@ __attribute__((weak)) EI_IMPULSE_ERROR ei_sleep(int32_t time_ms) {
     return EI_IMPULSE_OK;
 }
 
-uint64_t ei_read_timer_ms() {
+__attribute__((weak)) uint64_t ei_read_timer_ms() {
     return ei_read_timer_us() / 1000;
 }
 
-uint64_t ei_read_timer_us() {
+__attribute__((weak)) uint64_t ei_read_timer_us() {
     return 0;
 }
 
@@ -2,6 +2,10 @@
 #define STATE_MACHINE_H
 
 #include <Arduino.h>
+#include "timer_wheel.h"
+#include "timer_manager.h"
+#include "../config_pins.h"
+#include "../runtime/trace.h"
 
 enum TimerState {
     STATE_WAITING,      // Waiting for finger input
@@ -11,31 +15,77 @@ enum TimerState {
     STATE_FINISHED      // Timer completed
 };
 
+// Scheduled events; each has at most one pending deadline
+enum TimerEvent {
+    EVENT_READY_MESSAGE,    // Periodic "Ready!" prompt while waiting
+    EVENT_STATE_TIMEOUT,    // Leave the current state
+    EVENT_REDRAW,           // Countdown digits change
+    EVENT_TIMER_EXPIRED,    // Countdown reached zero
+    EVENT_ALARM_REPEAT,     // Re-sound the alarm while finished
+    EVENT_DETECT_WINDOW,    // Open/close gesture detection while running
+    EVENT_COUNT
+};
+
 // Forward declarations
 class OLEDDisplay;
 class BuzzerControl;
 class ArduCamController;
 
+// Every state transition, redraw and alarm is a deadline on a timer wheel.
+// update() only dispatches events that are due, and msUntilNextEvent() tells
+// the caller how long it may sleep. Time comes from an injectable clock so
+// the machine can be stepped deterministically off-target. Times are
+// uint32_t milliseconds throughout, as in TimerWheel and TimerManager, so
+// they wrap at the same point (49 days) as the deadlines built from them.
+//
+// STATE_RUNNING covers any number of concurrent countdowns (TimerManager);
+// the display follows the soonest one and the state only finishes when the
+// last one expires.
 class TimerStateMachine {
 private:
     TimerState currentState;
-    unsigned long stateStartTime;
-    unsigned long timerStartTime;
-    unsigned long timerDuration;    // in milliseconds
+    uint32_t stateStartTime;
+    uint32_t timerStartTime;
+    uint32_t timerDuration;    // in milliseconds
     int detectedFingers;
     int confirmationCount;
-    
+
     // References to hardware components
     OLEDDisplay* display;
     BuzzerControl* buzzer;
     ArduCamController* camera;
-    
+
+    TimerWheel<64, EVENT_COUNT> events;
+    TimerManager<MAX_CONCURRENT_TIMERS> timers;
+    uint32_t (*clock)();
+    bool acceptWhileRunning;
+    bool detectWindowOpen;
+    uint32_t detectWindowSeq;
+
     // State timeouts
-    static const unsigned long DETECTION_TIMEOUT = 3000;   // 3 seconds
-    static const unsigned long SETTING_TIMEOUT = 2000;     // 2 seconds
-    static const unsigned long CONFIRMATION_REQUIRED = 3;   // Need 3 consistent readings
-    
+    static void dispatch(void* context, int eventId) {
+        static_cast<TimerStateMachine*>(context)->handleEvent((TimerEvent)eventId);
+    }
+
+    static uint32_t millisClock() { return (uint32_t)millis(); }
+
 public:
+    static const uint32_t DETECTION_TIMEOUT = 3000;   // 3 seconds
+    static const uint32_t SETTING_TIMEOUT = 2000;     // 2 seconds
+    static const uint32_t CONFIRMATION_REQUIRED = 3;  // Need 3 consistent readings
+    static const uint32_t READY_MESSAGE_INTERVAL = 5000;
+    static const uint32_t ALARM_INTERVAL = 2000;
+    static const uint32_t FINISHED_TIMEOUT = 10000;
+    static const uint32_t TIMER_SET_HOLD = 2000;      // Keep "Timer Set!" visible
+    // Readings are taken at most this often while a gesture is looked for
+    static const uint32_t DETECT_READING_INTERVAL = 1000;
+    // While running, gestures are looked for in short windows so the camera
+    // can stay powered down in between: room for the confirming readings plus
+    // 1 s for the camera to wake and the last inference to finish, out of
+    // every 30 s
+    static const uint32_t DETECT_WINDOW = CONFIRMATION_REQUIRED * DETECT_READING_INTERVAL + 1000;
+    static const uint32_t DETECT_PERIOD = 30000;
+
     TimerStateMachine() {
         currentState = STATE_WAITING;
         stateStartTime = 0;
@@ -46,62 +96,130 @@ public:
         display = nullptr;
         buzzer = nullptr;
         camera = nullptr;
+        clock = millisClock;
+        acceptWhileRunning = true;
+        detectWindowOpen = false;
+        detectWindowSeq = 0;
     }
-    
+
     void init(OLEDDisplay* disp, BuzzerControl* buzz, ArduCamController* cam) {
         display = disp;
         buzzer = buzz;
         camera = cam;
+        events.reset(now());
         setState(STATE_WAITING);
     }
-    
+
+    // Replace millis() as the time source (host runs with a fake clock)
+    void setClock(uint32_t (*clockFn)()) {
+        clock = clockFn;
+        events.reset(now());
+    }
+
+    uint32_t now() const { return clock(); }
+
+    // Dispatch all events that are due; cheap when nothing is
     void update() {
-        switch (currentState) {
-            case STATE_WAITING:
-                handleWaitingState();
-                break;
-            case STATE_DETECTING:
-                handleDetectingState();
-                break;
-            case STATE_SETTING:
-                handleSettingState();
-                break;
-            case STATE_RUNNING:
-                handleRunningState();
-                break;
-            case STATE_FINISHED:
-                handleFinishedState();
-                break;
-        }
+        events.advance(now(), &TimerStateMachine::dispatch, this);
+    }
+
+    // Milliseconds until update() next has work (TimerWheel::NO_EVENT if none)
+    uint32_t msUntilNextEvent() const {
+        return events.msUntilNext(now());
     }
-    
+
     // State management
     void setState(TimerState newState) {
+        uint32_t t = now();
         currentState = newState;
-        stateStartTime = millis();
+        stateStartTime = t;
         Serial.printf("State changed to: %d\n", newState);
+
+        // Deadlines belong to the state that scheduled them
+        events.cancelAll();
+        if (newState != STATE_RUNNING) {
+            timers.clear();
+        }
+        detectWindowOpen = false;
+        detectWindowSeq++;
+        enterState(newState, t);
     }
-    
+
     TimerState getState() const { return currentState; }
-    
+
     // Timer functions
     void setTimer(int minutes, int seconds = 0) {
         timerDuration = (minutes * 60 + seconds) * 1000; // Convert to milliseconds
         Serial.printf("Timer set for %d minutes %d seconds\n", minutes, seconds);
     }
-    
-    unsigned long getRemainingTime() {
-        if (currentState != STATE_RUNNING) return 0;
-        unsigned long elapsed = millis() - timerStartTime;
-        if (elapsed >= timerDuration) return 0;
-        return (timerDuration - elapsed) / 1000; // Return seconds
+
+    // Start another countdown. From STATE_WAITING this enters STATE_RUNNING;
+    // while running it joins the timers already counting down.
+    bool addTimer(int minutes, int seconds = 0) {
+        uint32_t t = now();
+        uint32_t duration = (minutes * 60 + seconds) * 1000;
+        int id = timers.add(duration, t);
+        if (id < 0) {
+            Serial.println("All timer slots in use");
+            return false;
+        }
+        Serial.printf("Timer %d set for %d minutes %d seconds (%d running)\n",
+                     id, minutes, seconds, timers.size());
+
+        if (currentState != STATE_RUNNING) {
+            timerDuration = duration;
+            setState(STATE_RUNNING);
+        } else {
+            scheduleExpiry(t);
+            // The gesture was just used: next chance in a full period
+            closeDetectWindow(t);
+        }
+        // Let the caller's confirmation message stay up before the countdown redraws
+        events.schedule(EVENT_REDRAW, TIMER_SET_HOLD, t);
+        return true;
+    }
+
+    bool cancelTimer(int id) {
+        if (!timers.cancel(id)) return false;
+        if (timers.empty() && currentState == STATE_RUNNING) {
+            setState(STATE_WAITING);
+        } else {
+            scheduleExpiry(now());
+            events.schedule(EVENT_REDRAW, 0, now());
+        }
+        return true;
+    }
+
+    int getActiveTimers() const { return timers.size(); }
+
+    // On: a countdown opens a DETECT_WINDOW every DETECT_PERIOD in which a
+    // gesture adds another timer. Off: gestures are ignored until the timer
+    // ends. Either way the camera is only needed while acceptsNewTimers().
+    void setAcceptWhileRunning(bool accept) { acceptWhileRunning = accept; }
+
+    // Whether a detected gesture may start a (further) timer right now
+    bool acceptsNewTimers() const {
+        return currentState == STATE_WAITING ||
+               (acceptWhileRunning && currentState == STATE_RUNNING &&
+                detectWindowOpen && !timers.full());
+    }
+
+    // Bumped whenever a detection window closes (or the state changes), so a
+    // caller debouncing readings can start over instead of carrying a
+    // partial count into the next window
+    uint32_t getDetectWindowSeq() const { return detectWindowSeq; }
+
+    // Seconds left on the soonest countdown
+    uint32_t getRemainingTime() {
+        if (currentState != STATE_RUNNING || timers.empty()) return 0;
+        return timers.remainingMs(*timers.peek(), now()) / 1000; // Return seconds
     }
-    
+
     bool isTimerExpired() {
         if (currentState != STATE_RUNNING) return false;
-        return (millis() - timerStartTime) >= timerDuration;
+        return timers.empty() || timers.msUntilNext(now()) == 0;
     }
-    
+
     // Finger detection
     void processFingerCount(int count) {
         if (count == detectedFingers) {
@@ -111,106 +229,195 @@ public:
             confirmationCount = 1;
         }
     }
-    
+
     int getDetectedFingers() const { return detectedFingers; }
-    
+
 private:
-    void handleWaitingState() {
-        // ML detection is now handled in main loop
-        // This state just waits for external trigger
-        static unsigned long lastMessage = 0;
-        if (millis() - lastMessage > 5000) {
-            if (display) {
-                display->showMessage("Ready!", "Show fingers to set timer");
-            }
-            lastMessage = millis();
+    void enterState(TimerState state, uint32_t t) {
+        switch (state) {
+            case STATE_WAITING:
+                // ML detection is handled in main loop; this state just
+                // re-prompts periodically until an external trigger
+                events.schedule(EVENT_READY_MESSAGE, READY_MESSAGE_INTERVAL, t);
+                break;
+            case STATE_DETECTING:
+                // Mostly bypassed now; fall back to waiting on the next update
+                events.schedule(EVENT_STATE_TIMEOUT, 0, t);
+                break;
+            case STATE_SETTING:
+                if (display) {
+                    display->showTimer(detectedFingers, 0);
+                }
+                events.schedule(EVENT_STATE_TIMEOUT, SETTING_TIMEOUT, t);
+                break;
+            case STATE_RUNNING:
+                // Entering RUNNING without addTimer() (setTimer() + setState())
+                // starts a countdown from timerDuration
+                timerStartTime = t;
+                if (timers.empty()) {
+                    timers.add(timerDuration, t);
+                }
+                scheduleExpiry(t);
+                events.schedule(EVENT_REDRAW, 0, t);
+                closeDetectWindow(t);
+                break;
+            case STATE_FINISHED:
+                if (display) {
+                    display->showFinished();
+                }
+                events.schedule(EVENT_ALARM_REPEAT, ALARM_INTERVAL, t);
+                events.schedule(EVENT_STATE_TIMEOUT, FINISHED_TIMEOUT, t);
+                break;
         }
     }
-    
-    void handleDetectingState() {
-        // ML detection is now handled in main loop
-        // This state is mostly bypassed now
-        setState(STATE_WAITING);
+
+    void handleEvent(TimerEvent event) {
+        TRACE_SCOPE_ARG(TRACE_STATE_EVENT, event);
+        uint32_t t = now();
+        switch (event) {
+            case EVENT_READY_MESSAGE:
+                if (display) {
+                    display->showMessage("Ready!", "Show fingers to set timer");
+                }
+                events.schedule(EVENT_READY_MESSAGE, READY_MESSAGE_INTERVAL, t);
+                break;
+
+            case EVENT_STATE_TIMEOUT:
+                handleStateTimeout();
+                break;
+
+            case EVENT_REDRAW:
+                redrawCountdown(t);
+                break;
+
+            case EVENT_TIMER_EXPIRED:
+                handleTimersExpired(t);
+                break;
+
+            case EVENT_ALARM_REPEAT:
+                // Re-sound once the previous pattern has played out
+                if (buzzer && !buzzer->isBusy()) {
+                    buzzer->alarmPattern();
+                }
+                events.schedule(EVENT_ALARM_REPEAT, ALARM_INTERVAL, t);
+                break;
+
+            case EVENT_DETECT_WINDOW:
+                if (detectWindowOpen) {
+                    closeDetectWindow(t);
+                } else {
+                    detectWindowOpen = true;
+                    events.schedule(EVENT_DETECT_WINDOW, DETECT_WINDOW, t);
+                }
+                break;
+
+            default:
+                break;
+        }
     }
-    
-    void handleSettingState() {
-        // Timer is being set, show countdown before starting
-        static unsigned long lastUpdate = 0;
-        if (millis() - lastUpdate > 500) {
-            int remaining = SETTING_TIMEOUT - (millis() - stateStartTime);
-            remaining /= 1000;
-            
-            if (display) {
-                display->showTimer(detectedFingers, 0);
-            }
-            
-            lastUpdate = millis();
+
+    void handleStateTimeout() {
+        switch (currentState) {
+            case STATE_DETECTING:
+                setState(STATE_WAITING);
+                break;
+            case STATE_SETTING:
+                setTimer(detectedFingers, 0);
+                setState(STATE_RUNNING);
+                startTimer();
+                break;
+            case STATE_FINISHED:
+                // Reset after 10 seconds
+                setState(STATE_WAITING);
+                if (display) {
+                    display->showMessage("Ready!", "Show fingers to set timer");
+                }
+                break;
+            default:
+                break;
         }
-        
-        if (millis() - stateStartTime > SETTING_TIMEOUT) {
-            setTimer(detectedFingers, 0);
-            setState(STATE_RUNNING);
-            startTimer();
+    }
+
+    void scheduleExpiry(uint32_t t) {
+        if (timers.empty()) {
+            events.cancel(EVENT_TIMER_EXPIRED);
+        } else {
+            events.schedule(EVENT_TIMER_EXPIRED, timers.msUntilNext(t), t);
         }
     }
-    
-    void handleRunningState() {
-        unsigned long remaining = getRemainingTime();
-        
-        if (display) {
-            display->showCountdown(timerDuration / 1000, remaining);
+
+    void closeDetectWindow(uint32_t t) {
+        detectWindowOpen = false;
+        detectWindowSeq++;
+        if (acceptWhileRunning) {
+            events.schedule(EVENT_DETECT_WINDOW, DETECT_PERIOD - DETECT_WINDOW, t);
         }
-        
-        if (isTimerExpired()) {
+    }
+
+    void handleTimersExpired(uint32_t t) {
+        TimerManager<MAX_CONCURRENT_TIMERS>::Timer expired;
+        int finished = 0;
+        while (timers.popExpired(t, expired)) {
+            Serial.printf("Timer %d finished\n", expired.id);
+            finished++;
+        }
+
+        if (timers.empty()) {
             setState(STATE_FINISHED);
             finishTimer();
+            return;
         }
-    }
-    
-    void handleFinishedState() {
-        static unsigned long lastBeep = 0;
-        
-        if (display) {
-            display->showFinished();
-        }
-        
-        // Beep every 2 seconds
-        if (millis() - lastBeep > 2000) {
+
+        // Others are still counting down: short alert, then back to them
+        if (finished > 0) {
+            if (display) {
+                String others = String(timers.size()) + " still running";
+                display->showMessage("Timer done!", others.c_str());
+            }
             if (buzzer) {
-                buzzer->alarmPattern();
+                buzzer->beepPattern(3, 150, 100);
             }
-            lastBeep = millis();
+            events.schedule(EVENT_REDRAW, TIMER_SET_HOLD, t);
         }
-        
-        // Reset after 10 seconds
-        if (millis() - stateStartTime > 10000) {
-            setState(STATE_WAITING);
-            if (display) {
-                display->showMessage("Ready!", "Show fingers to set timer");
-            }
+        scheduleExpiry(t);
+    }
+
+    // Draw the soonest countdown and schedule the next redraw for the moment
+    // its displayed seconds value next changes. The title shows whether a
+    // detection window is open; it follows the window edges within a second.
+    void redrawCountdown(uint32_t t) {
+        const TimerManager<MAX_CONCURRENT_TIMERS>::Timer* soonest = timers.peek();
+        if (!soonest) return;
+        uint32_t remainingMs = timers.remainingMs(*soonest, t);
+        if (remainingMs == 0) return;   // EVENT_TIMER_EXPIRED takes over
+
+        if (display) {
+            display->showCountdown(soonest->durationMs / 1000, remainingMs / 1000, timers.size() - 1,
+                                   acceptsNewTimers());
         }
+
+        events.schedule(EVENT_REDRAW, remainingMs % 1000 + 1, t);
     }
-    
+
     void startDetection() {
         Serial.println("Starting finger detection");
         confirmationCount = 0;
     }
-    
+
     void confirmFingerCount(int count) {
         Serial.printf("Finger count confirmed: %d\n", count);
         if (buzzer) {
             buzzer->beep(200);
         }
     }
-    
+
     void startTimer() {
-        timerStartTime = millis();
         Serial.println("Timer started");
         if (buzzer) {
             buzzer->beepPattern(2, 100, 100);
         }
     }
-    
+
     void finishTimer() {
         Serial.println("Timer finished!");
         if (buzzer) {
@@ -219,4 +426,4 @@ private:
     }
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,162 @@
+#ifndef TIMER_MANAGER_H
+#define TIMER_MANAGER_H
+
+#include <stdint.h>
+
+// Concurrent countdowns kept in a binary min-heap ordered by deadline.
+// add() and cancel() are O(log n), the soonest deadline is the heap root
+// (O(1)). Timers live in fixed slots; the heap holds slot indices and
+// heapPos maps a slot back to its heap position so cancel() does not search.
+// Deadlines are millis() values compared as signed differences, which stays
+// correct across the 49-day wraparound as long as timers are < 24 days.
+template <int CAPACITY>
+class TimerManager {
+public:
+    struct Timer {
+        uint8_t id;            // Stable handle shown to the user (1-based)
+        uint32_t startMs;
+        uint32_t durationMs;
+        uint32_t deadlineMs;
+    };
+
+private:
+    Timer slots[CAPACITY];
+    bool used[CAPACITY];
+    int8_t heap[CAPACITY];     // Slot indices, soonest deadline first
+    int8_t heapPos[CAPACITY];  // Slot -> heap index, -1 if free
+    int count;
+    uint8_t nextId;
+
+    static bool before(uint32_t a, uint32_t b) {
+        return (int32_t)(a - b) < 0;
+    }
+
+    bool less(int i, int j) const {
+        return before(slots[heap[i]].deadlineMs, slots[heap[j]].deadlineMs);
+    }
+
+    void swapNodes(int i, int j) {
+        int8_t t = heap[i];
+        heap[i] = heap[j];
+        heap[j] = t;
+        heapPos[heap[i]] = i;
+        heapPos[heap[j]] = j;
+    }
+
+    void siftUp(int i) {
+        while (i > 0) {
+            int parent = (i - 1) / 2;
+            if (!less(i, parent)) break;
+            swapNodes(i, parent);
+            i = parent;
+        }
+    }
+
+    void siftDown(int i) {
+        while (true) {
+            int left = 2 * i + 1;
+            int right = left + 1;
+            int smallest = i;
+            if (left < count && less(left, smallest)) smallest = left;
+            if (right < count && less(right, smallest)) smallest = right;
+            if (smallest == i) break;
+            swapNodes(i, smallest);
+            i = smallest;
+        }
+    }
+
+    void removeAt(int i) {
+        int slot = heap[i];
+        count--;
+        if (i != count) {
+            heap[i] = heap[count];
+            heapPos[heap[i]] = i;
+            // The moved node may belong above or below its new position
+            siftDown(i);
+            siftUp(i);
+        }
+        used[slot] = false;
+        heapPos[slot] = -1;
+    }
+
+    int findSlot(int id) const {
+        for (int s = 0; s < CAPACITY; s++) {
+            if (used[s] && slots[s].id == id) return s;
+        }
+        return -1;
+    }
+
+public:
+    TimerManager() {
+        clear();
+    }
+
+    void clear() {
+        for (int s = 0; s < CAPACITY; s++) {
+            used[s] = false;
+            heapPos[s] = -1;
+        }
+        count = 0;
+        nextId = 1;
+    }
+
+    // Start a countdown; returns its id, or -1 when all slots are busy
+    int add(uint32_t durationMs, uint32_t nowMs) {
+        if (count >= CAPACITY) return -1;
+        int slot = 0;
+        while (used[slot]) slot++;
+
+        Timer& timer = slots[slot];
+        timer.id = nextId;
+        nextId = nextId >= 99 ? 1 : nextId + 1;
+        timer.startMs = nowMs;
+        timer.durationMs = durationMs;
+        timer.deadlineMs = nowMs + durationMs;
+        used[slot] = true;
+
+        heap[count] = slot;
+        heapPos[slot] = count;
+        count++;
+        siftUp(count - 1);
+        return timer.id;
+    }
+
+    // The slot scan is over CAPACITY entries; the heap update is O(log n)
+    bool cancel(int id) {
+        int slot = findSlot(id);
+        if (slot < 0) return false;
+        removeAt(heapPos[slot]);
+        return true;
+    }
+
+    int size() const { return count; }
+    bool empty() const { return count == 0; }
+    bool full() const { return count >= CAPACITY; }
+
+    // Soonest timer, or nullptr when none are running
+    const Timer* peek() const {
+        return count > 0 ? &slots[heap[0]] : nullptr;
+    }
+
+    // Milliseconds until the soonest deadline (0 if already due)
+    uint32_t msUntilNext(uint32_t nowMs) const {
+        if (count == 0) return 0xFFFFFFFF;
+        int32_t wait = (int32_t)(slots[heap[0]].deadlineMs - nowMs);
+        return wait > 0 ? (uint32_t)wait : 0;
+    }
+
+    // Remove one timer that has expired by nowMs; false when none is due
+    bool popExpired(uint32_t nowMs, Timer& expired) {
+        if (count == 0 || before(nowMs, slots[heap[0]].deadlineMs)) return false;
+        expired = slots[heap[0]];
+        removeAt(0);
+        return true;
+    }
+
+    uint32_t remainingMs(const Timer& timer, uint32_t nowMs) const {
+        int32_t left = (int32_t)(timer.deadlineMs - nowMs);
+        return left > 0 ? (uint32_t)left : 0;
+    }
+};
+
+#endif
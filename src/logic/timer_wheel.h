@@ -0,0 +1,137 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <stdint.h>
+
+// Hashed timer wheel for a small, fixed set of event ids. Each id has at most
+// one pending deadline; scheduling it again replaces the old one. Deadlines
+// are absolute millis() values compared wrap-safely, and each lives in the
+// slot for its 8 ms tick, so advance() only visits the slots that elapsed
+// since the last call instead of polling every timer.
+template <int SLOTS, int EVENTS>
+class TimerWheel {
+    static_assert(SLOTS >= 2 && (SLOTS & (SLOTS - 1)) == 0, "TimerWheel slots must be a power of two");
+    static_assert(EVENTS < 127, "TimerWheel event ids must fit in int8_t");
+
+public:
+    static constexpr uint32_t TICK_SHIFT = 3;          // 8 ms per slot
+    static constexpr uint32_t NO_EVENT = 0xFFFFFFFF;
+
+    typedef void (*Handler)(void* context, int eventId);
+
+private:
+    int8_t slotHead[SLOTS];
+    int8_t next[EVENTS];
+    uint32_t deadline[EVENTS];
+    bool scheduled[EVENTS];
+    uint32_t lastMs;
+
+    static int slotFor(uint32_t ms) {
+        return (int)((ms >> TICK_SHIFT) & (SLOTS - 1));
+    }
+
+    static bool due(uint32_t deadlineMs, uint32_t nowMs) {
+        return (int32_t)(deadlineMs - nowMs) <= 0;
+    }
+
+    void unlink(int id) {
+        int slot = slotFor(deadline[id]);
+        int8_t* link = &slotHead[slot];
+        while (*link >= 0) {
+            if (*link == id) {
+                *link = next[id];
+                break;
+            }
+            link = &next[*link];
+        }
+        next[id] = -1;
+        scheduled[id] = false;
+    }
+
+    // Fire everything due in one slot. Handlers may schedule or cancel
+    // events, so the list is rescanned after every callback.
+    int fireSlot(int slot, uint32_t nowMs, Handler handler, void* context) {
+        int fired = 0;
+        bool again = true;
+        while (again) {
+            again = false;
+            for (int id = slotHead[slot]; id >= 0; id = next[id]) {
+                if (due(deadline[id], nowMs)) {
+                    unlink(id);
+                    handler(context, id);
+                    fired++;
+                    again = true;
+                    break;
+                }
+            }
+        }
+        return fired;
+    }
+
+public:
+    TimerWheel() {
+        for (int i = 0; i < SLOTS; i++) slotHead[i] = -1;
+        for (int i = 0; i < EVENTS; i++) {
+            next[i] = -1;
+            deadline[i] = 0;
+            scheduled[i] = false;
+        }
+        lastMs = 0;
+    }
+
+    // Start from nowMs; call once before scheduling against a real clock
+    void reset(uint32_t nowMs) {
+        cancelAll();
+        lastMs = nowMs;
+    }
+
+    void schedule(int id, uint32_t delayMs, uint32_t nowMs) {
+        if (id < 0 || id >= EVENTS) return;
+        if (scheduled[id]) unlink(id);
+        deadline[id] = nowMs + delayMs;
+        int slot = slotFor(deadline[id]);
+        next[id] = slotHead[slot];
+        slotHead[slot] = (int8_t)id;
+        scheduled[id] = true;
+    }
+
+    void cancel(int id) {
+        if (id >= 0 && id < EVENTS && scheduled[id]) unlink(id);
+    }
+
+    void cancelAll() {
+        for (int id = 0; id < EVENTS; id++) cancel(id);
+    }
+
+    bool isScheduled(int id) const { return id >= 0 && id < EVENTS && scheduled[id]; }
+
+    // Dispatch every event due at nowMs; returns how many fired
+    int advance(uint32_t nowMs, Handler handler, void* context) {
+        uint32_t ticks = (nowMs >> TICK_SHIFT) - (lastMs >> TICK_SHIFT);
+        if (ticks >= (uint32_t)SLOTS) ticks = SLOTS - 1;   // Long gap: visit every slot once
+
+        int fired = 0;
+        int slot = slotFor(lastMs);
+        for (uint32_t i = 0; i <= ticks; i++) {
+            fired += fireSlot(slot, nowMs, handler, context);
+            slot = (slot + 1) & (SLOTS - 1);
+        }
+        lastMs = nowMs;
+        return fired;
+    }
+
+    // Milliseconds until the earliest pending event (0 if overdue), or
+    // NO_EVENT when nothing is scheduled; lets the caller sleep until then
+    uint32_t msUntilNext(uint32_t nowMs) const {
+        uint32_t best = NO_EVENT;
+        for (int id = 0; id < EVENTS; id++) {
+            if (!scheduled[id]) continue;
+            int32_t wait = (int32_t)(deadline[id] - nowMs);
+            uint32_t w = wait > 0 ? (uint32_t)wait : 0;
+            if (w < best) best = w;
+        }
+        return best;
+    }
+};
+
+#endif
@@ -22,13 +22,47 @@
 #endif
 
 #include "web/data_collection_server.h"
+#include "ai/finger_inference.h"
+#include "runtime/task_runtime.h"
+#include "runtime/loop_jitter.h"
+#include "runtime/i2c_bus.h"
+#include "runtime/power_manager.h"
+#include "runtime/trace.h"
+#include "runtime/heap_telemetry.h"
 
 // Data collection mode - set to false for timer mode
 #define DATA_COLLECTION_MODE false
 #define USE_PRETRAINED_WEIGHTS true
+// Run capture, inference and UI as separate FreeRTOS tasks instead of loop()
+#define USE_TASK_RUNTIME true
+// Send OLED frames from a background task instead of blocking in update()
+#define USE_ASYNC_OLED_FLUSH true
+// Light-sleep between scheduled events and power down the camera when unused
+#define USE_LIGHT_SLEEP true
+// Let a gesture add another timer while one is counting down; the camera
+// is only powered for the state machine's short detection windows
+#define ACCEPT_TIMERS_WHILE_RUNNING true
+// Count fingers with the Edge Impulse model; false falls back to the
+// brightness/transition heuristic in ArduCamController. Off on the device
+// until the model and the anomaly gate are calibrated (on the recorded
+// dataset the model is right 28% of the time, too unsure to ever start a
+// timer); the native env turns it on to exercise the inference pipeline.
+#ifndef USE_ML_MODEL
+#define USE_ML_MODEL false
+#endif
+// Average both compiled graphs (ModelEnsemble) instead of the deployed
+// impulse: a second invoke per frame for the A/B agreement figures
+#define USE_MODEL_ENSEMBLE false
+// Fuse the model's output over recent frames (TemporalClassifier) and start
+// a timer on its decision, instead of waiting for 3 identical readings
+#define USE_TEMPORAL_CLASSIFIER false
+// Join Wi-Fi in timer mode too and serve /api/metrics, /api/heap and
+// /api/memory; keeps the CPU out of light sleep. Without it the timer's
+// metrics are only on the serial "metrics" command.
+#define SERVE_METRICS_IN_TIMER_MODE false
 
-// Forward declarations
-class FingerInference;
+static_assert(RUNTIME_FRAME_FEATURES == EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE,
+              "RuntimeFrame must carry one model input");
 
 // Global objects
 OLEDDisplay display;
@@ -36,11 +70,29 @@ BuzzerControl buzzer;
 ArduCamController camera;
 TimerStateMachine stateMachine;
 DataCollectionServer webServer;
-FingerInference* fingerAI;
+FingerInference* fingerAI = nullptr;
+ModelEnsemble ensemble;
+TemporalClassifier temporal;
+TaskRuntime runtime;
+LoopJitterMeter loopJitter("UI");
+#ifdef ARDUINO
+Esp32PowerBackend powerBackend;
+#else
+HostPowerBackend powerBackend;    // native environment
+#endif
+PowerManager power(&powerBackend);
+
+// Function declarations
+void startTaskRuntime();
+void printRuntimeStats();
+void pollSerialCommands();
+void setCameraPower(bool needed);
+void idleUntilNextEvent(uint32_t maxBudgetMs);
 
 void setup() {
     Serial.begin(115200);
     delay(2000);
+    TRACE_NAME_TASK("loop");
     
     Serial.println("=================================");
     Serial.println("   ML-POWERED FINGER TIMER       ");
@@ -61,6 +113,11 @@ void setup() {
         success = false;
     } else {
         Serial.println("✓ OLED initialized successfully");
+        #if USE_ASYNC_OLED_FLUSH
+        if (display.startAsyncFlush()) {
+            Serial.println("✓ OLED background flush started");
+        }
+        #endif
     }
     
     Serial.println("Initializing buzzer...");
@@ -75,15 +132,22 @@ void setup() {
         Serial.println("✓ Camera initialized successfully");
     }
     
+    #if USE_ML_MODEL
     // Initialize ML inference
     Serial.println("Initializing ML inference...");
-    // fingerAI = new FingerInference(&camera);
-    // fingerAI->printModelInfo();
-    Serial.println("✓ ML inference initialized (placeholder)");
+    fingerAI = new FingerInference(&camera);
+    fingerAI->printModelInfo();
+    #if USE_MODEL_ENSEMBLE
+    fingerAI->setEnsemble(&ensemble);
+    Serial.println("✓ Model ensemble enabled");
+    #endif
+    Serial.println("✓ ML inference initialized");
+    #endif
     
     // Initialize state machine
     Serial.println("Initializing state machine...");
     stateMachine.init(&display, &buzzer, &camera);
+    stateMachine.setAcceptWhileRunning(ACCEPT_TIMERS_WHILE_RUNNING);
     Serial.println("✓ State machine initialized");
     
     #if DATA_COLLECTION_MODE
@@ -101,6 +165,16 @@ void setup() {
         display.showMessage("WiFi Error", "Check credentials");
     }
     #else
+    #if SERVE_METRICS_IN_TIMER_MODE
+    if (webServer.initMonitoring()) {
+        Serial.print("Metrics at http://");
+        Serial.print(webServer.getIPAddress());
+        Serial.println("/api/metrics");
+    } else {
+        Serial.println("✗ WiFi failed - metrics on the serial console only");
+    }
+    #endif
+    
     // Normal ML timer operation
     if (success) {
         Serial.println();
@@ -122,6 +196,13 @@ void setup() {
     Serial.println("3. Timer starts automatically");
     Serial.println("4. Buzzer sounds when time's up");
     Serial.println();
+    
+    power.setSleepEnabled(USE_LIGHT_SLEEP);
+    power.reset();
+    
+    #if USE_TASK_RUNTIME
+    startTaskRuntime();
+    #endif
     #endif
 }
 
@@ -130,6 +211,8 @@ void setup() {
 // Function declarations
 void runMLTimerMode();
 void collectTrainingDataWeb();
+void handleFingerDetection(int detectedFingers);
+void handleFingerDecision(int fingers);
 
 void collectTrainingDataWeb() {
     if (!webServer.shouldTriggerCollection()) {
@@ -159,7 +242,7 @@ void collectTrainingDataWeb() {
         }
         
         // Add to web server data collection
-        webServer.addDataSample(csvLine);
+        webServer.addSample(webServer.currentFingers, features, 20);
         
         // Also print to serial for backup
         Serial.println("TRAINING_DATA," + csvLine);
@@ -176,6 +259,9 @@ void collectTrainingDataWeb() {
         webServer.onSampleCollected();
         
         Serial.printf("✓ Sample collected! Total samples: %d\n", webServer.totalSamples);
+        if (webServer.totalSamples % 50 == 0) {
+            webServer.printMemoryReport();
+        }
         
         // Visual feedback
         String sampleMsg = "Sample " + String(webServer.totalSamples);
@@ -190,74 +276,311 @@ void collectTrainingDataWeb() {
 }
 
 void loop() {
+    pollSerialCommands();
+    
     if (DATA_COLLECTION_MODE) {
         collectTrainingDataWeb();
+        webServer.serviceCameraStream();
+        // Keep the live view at its frame rate while streaming
+        if (webServer.stream.getClients() > 0) {
+            delay(10);
+            return;
+        }
+    } else if (runtime.isRunning()) {
+        // Capture, inference and UI are handled by the runtime tasks
+        delay(1000);
+        return;
     } else {
         // ML Timer Mode - Update state machine with ML inference
         runMLTimerMode();
+        
+        // Detection runs once a second while waiting; otherwise sleep until
+        // the state machine's next deadline
+        idleUntilNextEvent(stateMachine.acceptsNewTimers() ? 100 : 1000);
+        return;
     }
     
     delay(100);
 }
 
-void runMLTimerMode() {
-    static unsigned long lastDetection = 0;
+// Camera is only needed while a gesture can start a timer
+void setCameraPower(bool needed) {
+    if (camera.isStandby() == !needed) return;
+    camera.setStandby(!needed);
+    power.noteCameraStandby(!needed);
+}
+
+// Light sleep stops the CPU and the peripheral clocks: nothing may need
+// esp_timer callbacks or be mid-transfer on I2C/SPI, and the Wi-Fi
+// association would be lost
+bool canLightSleep() {
+    if (DATA_COLLECTION_MODE || webServer.isWifiActive()) return false;
+    if (buzzer.isBusy() || display.getFlusher().isBusy()) return false;
+    // The capture and inference tasks run on their own; in loop() mode
+    // everything happens on the caller and is done by now
+    return !runtime.isRunning() || runtime.isIdle();
+}
+
+void idleUntilNextEvent(uint32_t maxBudgetMs) {
+    uint32_t budget = stateMachine.msUntilNextEvent();
+    if (budget > maxBudgetMs) budget = maxBudgetMs;
+    // Keep the loop responsive while a tone is playing
+    if (buzzer.isBusy() && budget > 20) budget = 20;
+    power.idle(budget, canLightSleep());
+}
+
+// Shared by the loop() path and the runtime's UI task: debounce per-frame
+// counts and start the timer after 3 consecutive matching detections. The
+// count starts over with every detection window, so readings from one
+// window never complete a gesture in the next.
+void handleFingerDetection(int detectedFingers) {
     static int consecutiveDetections = 0;
     static int lastDetectedCount = 0;
+    static bool awaitClear = false;    // Hand must leave before the next timer
+    static uint32_t window = 0;
+    
+    uint32_t currentWindow = stateMachine.getDetectWindowSeq();
+    if (currentWindow != window) {
+        window = currentWindow;
+        consecutiveDetections = 0;
+        lastDetectedCount = 0;
+        awaitClear = false;
+    }
+    
+    if (awaitClear) {
+        if (detectedFingers <= 0 || detectedFingers > 5) {
+            awaitClear = false;
+        }
+        return;
+    }
+    
+    // Enhance the basic detection with some post-processing
+    if (detectedFingers > 0 && detectedFingers <= 5) {
+        if (detectedFingers == lastDetectedCount) {
+            consecutiveDetections++;
+        } else {
+            lastDetectedCount = detectedFingers;
+            consecutiveDetections = 1;
+        }
+        
+        Serial.printf("Detected: %d fingers (consecutive: %d)\n", detectedFingers, consecutiveDetections);
+        
+        // Show current detection
+        display.showFingerCount(detectedFingers);
+        
+        // If we have 3 consecutive stable detections
+        if (consecutiveDetections >= 3) {
+            Serial.printf("Stable detection confirmed: %d fingers\n", detectedFingers);
+            handleFingerDecision(detectedFingers);
+            
+            // Reset detection state
+            consecutiveDetections = 0;
+            lastDetectedCount = 0;
+            awaitClear = true;
+        }
+    } else {
+        // Reset if we detect 0 or invalid finger count
+        consecutiveDetections = 0;
+        lastDetectedCount = 0;
+    }
+}
+
+// A confirmed finger count: start a timer; joins any already running. The
+// state machine keeps the confirmation up for a moment before redrawing.
+// The temporal classifier calls this directly; it only decides again once
+// the scene has changed.
+void handleFingerDecision(int fingers) {
+    if (fingers <= 0 || fingers > 5) return;
+    display.showMessage("Timer Set!", String(String(fingers) + " minutes").c_str());
+    if (stateMachine.addTimer(fingers, 0)) {
+        buzzer.beepPattern(2, 150, 100);
+    } else {
+        buzzer.beepPattern(3, 100, 100);
+    }
+}
+
+void runMLTimerMode() {
+    static unsigned long lastDetection = 0;
     
-    // Run detection every 1000ms when in waiting state
-    TimerState currentState = stateMachine.getState();
+    // Run detection once a second while a gesture can start a timer,
+    // counted from the start of the last reading so a detection window
+    // fits the readings it was sized for
+    bool detecting = stateMachine.acceptsNewTimers();
+    setCameraPower(detecting);
     
-    if (currentState == STATE_WAITING && (millis() - lastDetection > 1000)) {
+    if (detecting && (millis() - lastDetection >= TimerStateMachine::DETECT_READING_INTERVAL)) {
+        lastDetection = millis();
         
         Serial.println("Running finger detection...");
         int detectedFingers = 0;
         
-        // Use camera's basic finger detection for now
+        #if USE_ML_MODEL && USE_TEMPORAL_CLASSIFIER
+        detectedFingers = fingerAI->runTemporalInference(temporal);
+        if (detectedFingers >= 0) {
+            handleFingerDecision(detectedFingers);
+        }
+        #elif USE_ML_MODEL
+        detectedFingers = fingerAI->runInference();
+        if (detectedFingers >= 0) {
+            handleFingerDetection(detectedFingers);
+        }
+        #else
         if (camera.processImageForFingers(detectedFingers)) {
-            
-            // Enhance the basic detection with some post-processing
-            if (detectedFingers > 0 && detectedFingers <= 5) {
-                if (detectedFingers == lastDetectedCount) {
-                    consecutiveDetections++;
-                } else {
-                    lastDetectedCount = detectedFingers;
-                    consecutiveDetections = 1;
-                }
-                
-                Serial.printf("Detected: %d fingers (consecutive: %d)\n", detectedFingers, consecutiveDetections);
-                
-                // Show current detection
-                display.showFingerCount(detectedFingers);
-                
-                // If we have 3 consecutive stable detections
-                if (consecutiveDetections >= 3) {
-                    Serial.printf("Stable detection confirmed: %d fingers\n", detectedFingers);
-                    
-                    // Set and start timer
-                    stateMachine.setTimer(detectedFingers, 0);
-                    display.showMessage("Timer Set!", 
-                                      String(String(detectedFingers) + " minutes").c_str());
-                    buzzer.beepPattern(2, 150, 100);
-                    
-                    // Brief delay then start timer
-                    delay(2000);
-                    stateMachine.setState(STATE_RUNNING);
-                    
-                    // Reset detection state
-                    consecutiveDetections = 0;
-                    lastDetectedCount = 0;
-                }
-            } else {
-                // Reset if we detect 0 or invalid finger count
-                consecutiveDetections = 0;
-                lastDetectedCount = 0;
-            }
+            handleFingerDetection(detectedFingers);
         }
-        
-        lastDetection = millis();
+        #endif
     }
     
     // Always update the state machine for timer countdown and UI updates
     stateMachine.update();
-}
\ No newline at end of file
+    buzzer.update();
+    loopJitter.tick();
+    printRuntimeStats();
+}
+
+// Task runtime hooks: the capture task owns the camera/SPI bus, the
+// inference task only touches the frame it was handed, and the UI task owns
+// the state machine, OLED and buzzer
+
+bool runtimeCapture(void*, RuntimeFrame& frame) {
+    #if USE_ML_MODEL
+    // Features come straight off the FIFO; only the model runs on the other core
+    if (!camera.extractImageFeatures(frame.features, RUNTIME_FRAME_FEATURES, false)) {
+        return false;
+    }
+    frame.featureCount = RUNTIME_FRAME_FEATURES;
+    return true;
+    #else
+    return camera.captureFingerSamples(frame.samples, RUNTIME_FRAME_SAMPLES, frame.sampleCount);
+    #endif
+}
+
+int runtimeClassify(void*, const RuntimeFrame& frame) {
+    if (frame.featureCount > 0) {
+        #if USE_TEMPORAL_CLASSIFIER
+        return fingerAI->classifyFrameTemporal(frame.features, temporal);
+        #else
+        return fingerAI->classifyFrame(frame.features);
+        #endif
+    }
+    if (frame.sampleCount == 0) return -1;
+    return camera.analyzeImageSamples(const_cast<uint8_t*>(frame.samples), frame.sampleCount);
+}
+
+void runtimeOnDetection(void*, const RuntimeDetection& detection) {
+    // Detections captured before the last timer filled the slots are stale
+    if (!stateMachine.acceptsNewTimers()) return;
+    #if USE_ML_MODEL && USE_TEMPORAL_CLASSIFIER
+    handleFingerDecision(detection.fingers);
+    #else
+    handleFingerDetection(detection.fingers);
+    #endif
+}
+
+void runtimeCaptureIdle(void*, bool idle) {
+    setCameraPower(!idle);
+}
+
+void runtimeUiTick(void*) {
+    stateMachine.update();
+    buzzer.update();
+    bool waiting = stateMachine.acceptsNewTimers();
+    runtime.setCaptureEnabled(waiting);
+    loopJitter.tick();
+    printRuntimeStats();
+    
+    // Capture is paused while no new timer can be taken, so nothing else is
+    // in flight and the whole chip can sleep until the next deadline
+    if (!waiting && runtime.isIdle()) {
+        idleUntilNextEvent(1000);
+    }
+}
+
+// Once a minute: pipeline, display traffic, UI loop regularity, the
+// inference zone profile (EI_PROFILER_ENABLED builds) and the stage trace of
+// the last few hundred events
+void printRuntimeStats() {
+    static unsigned long lastStats = 0;
+    if (millis() - lastStats > 60000) {
+        if (runtime.isRunning()) {
+            runtime.printStats();
+        }
+        display.getRenderer().printStats();
+        display.getFlusher().printStats();
+        I2cBus::printStats();
+        I2cBus::resetStats();
+        loopJitter.printStats();
+        loopJitter.reset();
+        power.printStats();
+        if (fingerAI && fingerAI->getEnsemble()) {
+            fingerAI->getEnsemble()->printStats();
+        }
+        #if EI_PROFILER_ENABLED
+        if (fingerAI) {
+            fingerAI->printProfile();
+        }
+        #endif
+        #if USE_ML_MODEL && USE_TEMPORAL_CLASSIFIER
+        temporal.printStats();
+        #endif
+        TRACE_DUMP();
+        lastStats = millis();
+    }
+}
+
+// Line commands on the serial console: "heap" prints the allocation report,
+// "heap reset" restarts the peak figures, "metrics" prints what /api/metrics
+// would serve, "profile" prints the inference zone profile since the last one
+void pollSerialCommands() {
+    static char line[32];
+    static int length = 0;
+    while (Serial.available() > 0) {
+        char c = (char)Serial.read();
+        if (c != '\n' && c != '\r') {
+            if (length < (int)sizeof(line) - 1) line[length++] = c;
+            continue;
+        }
+        if (length == 0) continue;
+        line[length] = '\0';
+        length = 0;
+        
+        if (strcmp(line, "heap") == 0) {
+            HeapTelemetry::instance().printReport();
+        } else if (strcmp(line, "heap reset") == 0) {
+            HeapTelemetry::instance().resetPeak();
+            Serial.println("Heap peaks reset");
+        } else if (strcmp(line, "metrics") == 0) {
+            char* text = (char*)malloc(METRICS_RESPONSE_BYTES);
+            if (text) {
+                MetricsWriter writer(text, METRICS_RESPONSE_BYTES);
+                webServer.fillMetrics(writer);
+                Serial.print(text);
+                free(text);
+            }
+        } else if (strcmp(line, "profile") == 0) {
+            if (fingerAI) {
+                fingerAI->printProfile();
+            }
+        } else {
+            Serial.printf("Unknown command '%s' (try: heap, heap reset, metrics, profile)\n", line);
+        }
+    }
+}
+
+void startTaskRuntime() {
+    RuntimeHooks hooks;
+    hooks.context = nullptr;
+    hooks.capture = runtimeCapture;
+    hooks.classify = runtimeClassify;
+    hooks.onDetection = runtimeOnDetection;
+    hooks.uiTick = runtimeUiTick;
+    hooks.captureIdle = runtimeCaptureIdle;
+    // Same reading cadence the detection windows are sized for
+    runtime.getConfig().captureIntervalMs = TimerStateMachine::DETECT_READING_INTERVAL;
+    
+    if (runtime.start(hooks)) {
+        Serial.println("✓ Task runtime started (capture / inference / UI)");
+    } else {
+        Serial.println("✗ Task runtime failed to start, using loop()");
+    }
+}
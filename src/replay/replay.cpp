@@ -0,0 +1,624 @@
+// Replays labelled feature rows (and optionally recorded JPEG frames) through
+// run_classifier() on the host and reports accuracy, the confusion matrix,
+// per-row latency percentiles and allocations. Against a stored baseline it
+// exits non-zero when accuracy drops, allocations grow, or latency grows past
+// the tolerance.
+//
+//   pio run -e replay
+//   .pio/build/replay/program [--csv FILE] [--frames DIR] [--passes N]
+//                             [--baseline FILE] [--write-baseline FILE]
+//                             [--latency-tolerance PCT] [--accuracy-tolerance PCT]
+//                             [--ensemble] [--temporal [--sequence-frames N]]
+//
+// --csv       rows of `label,f0,...,f19` (default data/finger_detection_data.csv)
+// --frames    DIR/<label>/*.jpg, fed through the mock ArduCAM and
+//             ArduCamController::extractImageFeatures() like the firmware
+// --passes    times the whole set is replayed for the latency figures
+//             (default 5); accuracy comes from the first pass
+// --baseline  compare with a file written by --write-baseline; p50 latency
+//             relative to the calibration loop may grow by
+//             --latency-tolerance percent (default 25), accuracy may drop by
+//             --accuracy-tolerance points (default 1), allocations per row
+//             may not grow
+// --ensemble  also classify every row with ModelEnsemble (both compiled
+//             graphs, averaged and voted) and compare accuracy and latency
+//             with the single deployed model; not part of the baseline
+// --temporal  latency-to-decision benchmark: runs of --sequence-frames
+//             (default 8) consecutive rows of one label are fed 1 s apart,
+//             like the firmware's captures, to TemporalClassifier and to the
+//             3-identical-readings rule; reports decisions, correctness and
+//             the time to decide
+//
+// Latency is host wall time around run_classifier(). The baseline stores
+// each pass's p50 divided by the time of a fixed calibration loop (int8 dot
+// products the shape of the model's dense layers) timed just before that
+// pass, median over passes, so one baseline holds across machines, clock
+// scaling and load; p99 is reported but not checked. Accuracy and
+// allocation counts are deterministic.
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "native_hal.h"
+#include "../ESP32-Finger_Counter_inferencing.h"
+#include "../camera/camera_arducam.h"
+#include "../ai/model_ensemble.h"
+#include "../ai/temporal_classifier.h"
+
+#define FEATURE_COUNT EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE
+#define LABEL_COUNT EI_CLASSIFIER_LABEL_COUNT
+
+// ---- Allocation counting ---------------------------------------------------
+// Strong definitions of the SDK's weak ei_malloc/ei_calloc/ei_free; only
+// calls made while run_classifier() is running are counted
+
+static bool countingAllocations = false;
+static unsigned long allocationCount = 0;
+static uint64_t allocationBytes = 0;
+
+static void noteAllocation(size_t size) {
+    if (!countingAllocations) return;
+    allocationCount++;
+    allocationBytes += size;
+}
+
+void* ei_malloc(size_t size) {
+    noteAllocation(size);
+    return malloc(size);
+}
+
+void* ei_calloc(size_t nitems, size_t size) {
+    noteAllocation(nitems * size);
+    return calloc(nitems, size);
+}
+
+void ei_free(void* ptr) {
+    free(ptr);
+}
+
+// ---- Latency calibration ---------------------------------------------------
+// Plain int8 dot products over the dense layers' shapes (20x20, 20x10,
+// 10x6): the same kind of work as the graph, without the SDK
+
+static const int CALIBRATION_LAYERS[][2] = { { 20, 20 }, { 20, 10 }, { 10, 6 } };
+static const int CALIBRATION_TRIALS = 15;
+static const int CALIBRATION_LOOPS_PER_TRIAL = 2000;
+
+static volatile int32_t calibrationSink;
+
+static int32_t calibrationLoop(const int8_t* weights, int8_t* activations) {
+    int32_t checksum = 0;
+    const int8_t* w = weights;
+    for (size_t l = 0; l < sizeof(CALIBRATION_LAYERS) / sizeof(CALIBRATION_LAYERS[0]); l++) {
+        int inputs = CALIBRATION_LAYERS[l][0];
+        int outputs = CALIBRATION_LAYERS[l][1];
+        for (int o = 0; o < outputs; o++) {
+            int32_t acc = 0;
+            for (int i = 0; i < inputs; i++) acc += (int32_t)w[i] * activations[i];
+            w += inputs;
+            checksum += acc;
+            activations[o] = (int8_t)(acc >> 8);
+        }
+    }
+    return checksum;
+}
+
+// Median time of one calibration loop in microseconds
+static double calibrationUs() {
+    static int8_t weights[20 * 20 + 20 * 10 + 10 * 6];
+    int8_t activations[20];
+    for (size_t i = 0; i < sizeof(weights); i++) weights[i] = (int8_t)((i * 37) % 255 - 127);
+
+    std::vector<double> trials;
+    for (int t = 0; t < CALIBRATION_TRIALS; t++) {
+        for (int i = 0; i < 20; i++) activations[i] = (int8_t)(i * 11 - 100);
+        auto start = std::chrono::steady_clock::now();
+        int32_t checksum = 0;
+        for (int n = 0; n < CALIBRATION_LOOPS_PER_TRIAL; n++) {
+            checksum += calibrationLoop(weights, activations);
+        }
+        auto end = std::chrono::steady_clock::now();
+        calibrationSink = checksum;
+        trials.push_back(std::chrono::duration<double, std::micro>(end - start).count() /
+                         CALIBRATION_LOOPS_PER_TRIAL);
+    }
+    std::nth_element(trials.begin(), trials.begin() + trials.size() / 2, trials.end());
+    return trials[trials.size() / 2];
+}
+
+// ---- Replay ----------------------------------------------------------------
+
+struct ReplayRow {
+    int label;
+    float features[FEATURE_COUNT];
+};
+
+struct ReplayStats {
+    int rows;
+    int correct;
+    int errors;
+    int confusion[LABEL_COUNT][LABEL_COUNT];   // [expected][predicted]
+    std::vector<double> latencyUs;
+    std::vector<double> calibrationUs;  // Per pass
+    std::vector<double> passP50;        // Per pass, in calibration loops
+    uint64_t dspUs;
+    uint64_t classificationUs;
+    unsigned long allocations;
+    uint64_t allocatedBytes;
+};
+
+struct ReplayBaseline {
+    double accuracy;
+    double calibrationUs;     // One calibration loop, for reference
+    double latencyP50;        // In calibration loops
+    double latencyP99;
+    double allocationsPerRow;
+};
+
+static bool loadCsv(const char* path, std::vector<ReplayRow>& rows) {
+    FILE* f = fopen(path, "r");
+    if (!f) return false;
+
+    char line[512];
+    int lineNumber = 0;
+    while (fgets(line, sizeof(line), f)) {
+        lineNumber++;
+        ReplayRow row;
+        char* cursor = line;
+        char* end;
+        row.label = (int)strtol(cursor, &end, 10);
+        if (end == cursor) continue;    // Blank line or header
+        int count = 0;
+        while (*end == ',' && count < FEATURE_COUNT) {
+            cursor = end + 1;
+            row.features[count] = strtof(cursor, &end);
+            if (end == cursor) break;
+            count++;
+        }
+        if (count != FEATURE_COUNT || row.label < 0 || row.label >= LABEL_COUNT) {
+            printf("[replay] %s:%d: expected a label 0-%d and %d features, skipped\n",
+                   path, lineNumber, LABEL_COUNT - 1, FEATURE_COUNT);
+            continue;
+        }
+        rows.push_back(row);
+    }
+    fclose(f);
+    return true;
+}
+
+// Frames for label N live in DIR/N/; each one goes through the same FIFO
+// sampling as the firmware's capture path
+static int loadFrames(const char* directory, std::vector<ReplayRow>& rows) {
+    ArduCamController camera;
+    if (!camera.init()) {
+        printf("[replay] camera stand-in failed to initialise\n");
+        return 0;
+    }
+
+    int loaded = 0;
+    for (int label = 0; label < LABEL_COUNT; label++) {
+        std::string path = std::string(directory) + "/" + ei_classifier_inferencing_categories[label];
+        int frames = nativeLoadFrames(path.c_str());
+        for (int i = 0; i < frames; i++) {
+            ReplayRow row;
+            row.label = label;
+            if (camera.extractImageFeatures(row.features, FEATURE_COUNT, false)) {
+                rows.push_back(row);
+                loaded++;
+            }
+        }
+    }
+    return loaded;
+}
+
+static int classify(const ReplayRow& row, ReplayStats& stats) {
+    signal_t signal;
+    numpy::signal_from_buffer(row.features, FEATURE_COUNT, &signal);
+    ei_impulse_result_t result;
+    memset(&result, 0, sizeof(result));
+
+    unsigned long allocationsBefore = allocationCount;
+    uint64_t bytesBefore = allocationBytes;
+    countingAllocations = true;
+    auto start = std::chrono::steady_clock::now();
+    EI_IMPULSE_ERROR err = run_classifier(&signal, &result, false);
+    auto end = std::chrono::steady_clock::now();
+    countingAllocations = false;
+
+    stats.latencyUs.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+    stats.allocations += allocationCount - allocationsBefore;
+    stats.allocatedBytes += allocationBytes - bytesBefore;
+    stats.dspUs += result.timing.dsp_us;
+    stats.classificationUs += result.timing.classification_us;
+
+    if (err != EI_IMPULSE_OK) {
+        stats.errors++;
+        return -1;
+    }
+
+    int best = 0;
+    for (int i = 1; i < LABEL_COUNT; i++) {
+        if (result.classification[i].value > result.classification[best].value) best = i;
+    }
+    return best;
+}
+
+static double percentile(std::vector<double> values, double p) {
+    if (values.empty()) return 0;
+    size_t index = (size_t)(p * (values.size() - 1));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+static ReplayStats replay(const std::vector<ReplayRow>& rows, int passes) {
+    ReplayStats stats;
+    memset(&stats.confusion, 0, sizeof(stats.confusion));
+    stats.rows = (int)rows.size();
+    stats.correct = stats.errors = 0;
+    stats.dspUs = stats.classificationUs = 0;
+    stats.allocations = 0;
+    stats.allocatedBytes = 0;
+
+    for (int pass = 0; pass < passes; pass++) {
+        // Calibrated next to the pass it normalizes, so clock changes
+        // between passes cancel out
+        double calibration = calibrationUs();
+        size_t first = stats.latencyUs.size();
+        for (size_t i = 0; i < rows.size(); i++) {
+            int predicted = classify(rows[i], stats);
+            if (pass > 0) continue;
+            if (predicted >= 0) stats.confusion[rows[i].label][predicted]++;
+            if (predicted == rows[i].label) stats.correct++;
+        }
+        std::vector<double> passUs(stats.latencyUs.begin() + first, stats.latencyUs.end());
+        stats.calibrationUs.push_back(calibration);
+        stats.passP50.push_back(percentile(passUs, 0.5) / calibration);
+    }
+    return stats;
+}
+
+// Same rows through both compiled graphs; accuracy of each model and of the
+// combined label, and the cost of the second invoke
+static void replayEnsemble(const std::vector<ReplayRow>& rows, int passes, EnsembleMode mode) {
+    ModelEnsemble ensemble(mode);
+    int correct = 0;
+    int errors = 0;
+    int modelCorrect[ModelEnsemble::MODEL_COUNT] = { 0 };
+    std::vector<double> latencyUs;
+
+    for (int pass = 0; pass < passes; pass++) {
+        for (size_t i = 0; i < rows.size(); i++) {
+            EnsembleResult result;
+            auto start = std::chrono::steady_clock::now();
+            bool ok = ensemble.classify(rows[i].features, result);
+            auto end = std::chrono::steady_clock::now();
+            latencyUs.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+            if (pass > 0) continue;
+            if (!ok) {
+                errors++;
+                continue;
+            }
+            if (result.label == rows[i].label) correct++;
+            for (int m = 0; m < ModelEnsemble::MODEL_COUNT; m++) {
+                if (result.modelLabels[m] == rows[i].label) modelCorrect[m]++;
+            }
+        }
+    }
+
+    int total = (int)rows.size();
+    printf("\n[replay] ---- ensemble (%s) ----\n", mode == ENSEMBLE_AVERAGE ? "average" : "vote");
+    printf("[replay] accuracy: %.2f%% (%d/%d), models agree on %.1f%% of rows\n",
+           100.0 * correct / total, correct, total, ensemble.getAgreementRate() * 100.0f);
+    if (errors) printf("[replay] ensemble errors: %d\n", errors);
+    for (int m = 0; m < ModelEnsemble::MODEL_COUNT; m++) {
+        const EnsembleModelStats& stats = ensemble.getStats(m);
+        unsigned long ok = stats.runs - stats.failures;
+        printf("[replay]   %-24s accuracy %6.2f%%, invoke avg %.2f us, pass avg %.2f us\n",
+               ensemble.getModelName(m), 100.0 * modelCorrect[m] / total,
+               ok ? (double)stats.totalInvokeUs / ok : 0.0, ok ? (double)stats.totalPassUs / ok : 0.0);
+    }
+    printf("[replay] latency over %lu runs: p50 %.2f us, p99 %.2f us, max %.2f us\n",
+           (unsigned long)latencyUs.size(), percentile(latencyUs, 0.5),
+           percentile(latencyUs, 0.99), percentile(latencyUs, 1.0));
+}
+
+static void printReport(const ReplayStats& stats) {
+    double accuracy = stats.rows > 0 ? (double)stats.correct / stats.rows : 0;
+    size_t runs = stats.latencyUs.size();
+
+    printf("\n[replay] ---- %d rows ----\n", stats.rows);
+    printf("[replay] accuracy: %.2f%% (%d/%d)\n", accuracy * 100.0, stats.correct, stats.rows);
+    if (stats.errors) printf("[replay] run_classifier errors: %d\n", stats.errors);
+
+    printf("[replay] confusion (rows expected, columns predicted):\n");
+    printf("[replay] %8s", "");
+    for (int p = 0; p < LABEL_COUNT; p++) printf(" %6s", ei_classifier_inferencing_categories[p]);
+    printf(" %8s\n", "recall");
+    for (int e = 0; e < LABEL_COUNT; e++) {
+        int total = 0;
+        printf("[replay] %8s", ei_classifier_inferencing_categories[e]);
+        for (int p = 0; p < LABEL_COUNT; p++) {
+            printf(" %6d", stats.confusion[e][p]);
+            total += stats.confusion[e][p];
+        }
+        printf(" %7.1f%%\n", total > 0 ? 100.0 * stats.confusion[e][e] / total : 0.0);
+    }
+
+    printf("[replay] latency over %lu runs: p50 %.2f us, p90 %.2f us, p99 %.2f us, max %.2f us\n",
+           (unsigned long)runs, percentile(stats.latencyUs, 0.5), percentile(stats.latencyUs, 0.9),
+           percentile(stats.latencyUs, 0.99), percentile(stats.latencyUs, 1.0));
+    printf("[replay] calibration loop %.4f us: p50 %.2f loops (median of %lu passes)\n",
+           percentile(stats.calibrationUs, 0.5), percentile(stats.passP50, 0.5),
+           (unsigned long)stats.passP50.size());
+    printf("[replay] SDK timing: dsp %.2f us, classification %.2f us per run\n",
+           runs ? (double)stats.dspUs / runs : 0.0, runs ? (double)stats.classificationUs / runs : 0.0);
+    printf("[replay] allocations: %.2f per run, %.0f bytes per run\n",
+           runs ? (double)stats.allocations / runs : 0.0, runs ? (double)stats.allocatedBytes / runs : 0.0);
+}
+
+static ReplayBaseline toBaseline(const ReplayStats& stats) {
+    ReplayBaseline baseline;
+    size_t runs = stats.latencyUs.size();
+    double calibration = percentile(stats.calibrationUs, 0.5);
+    baseline.accuracy = stats.rows > 0 ? (double)stats.correct / stats.rows : 0;
+    baseline.calibrationUs = calibration;
+    baseline.latencyP50 = percentile(stats.passP50, 0.5);
+    baseline.latencyP99 = percentile(stats.latencyUs, 0.99) / calibration;
+    baseline.allocationsPerRow = runs ? (double)stats.allocations / runs : 0;
+    return baseline;
+}
+
+static bool writeBaseline(const char* path, const ReplayBaseline& baseline, int rows) {
+    FILE* f = fopen(path, "w");
+    if (!f) return false;
+    fprintf(f, "# replay baseline (%d rows); regenerate with --write-baseline\n", rows);
+    fprintf(f, "accuracy %.6f\n", baseline.accuracy);
+    fprintf(f, "calibration_us %.4f\n", baseline.calibrationUs);
+    fprintf(f, "latency_p50_loops %.3f\n", baseline.latencyP50);
+    fprintf(f, "latency_p99_loops %.3f\n", baseline.latencyP99);
+    fprintf(f, "allocations_per_row %.3f\n", baseline.allocationsPerRow);
+    fclose(f);
+    return true;
+}
+
+static bool readBaseline(const char* path, ReplayBaseline& baseline) {
+    FILE* f = fopen(path, "r");
+    if (!f) return false;
+    baseline.accuracy = baseline.calibrationUs = baseline.latencyP50 = baseline.latencyP99 = -1;
+    baseline.allocationsPerRow = -1;
+
+    char line[128];
+    char key[64];
+    double value;
+    while (fgets(line, sizeof(line), f)) {
+        if (line[0] == '#' || sscanf(line, "%63s %lf", key, &value) != 2) continue;
+        if (strcmp(key, "accuracy") == 0) baseline.accuracy = value;
+        else if (strcmp(key, "calibration_us") == 0) baseline.calibrationUs = value;
+        else if (strcmp(key, "latency_p50_loops") == 0) baseline.latencyP50 = value;
+        else if (strcmp(key, "latency_p99_loops") == 0) baseline.latencyP99 = value;
+        else if (strcmp(key, "allocations_per_row") == 0) baseline.allocationsPerRow = value;
+    }
+    fclose(f);
+    // Baselines with absolute latencies (latency_p50_us) are not comparable
+    return baseline.accuracy >= 0 && baseline.latencyP50 >= 0 &&
+           baseline.latencyP99 >= 0 && baseline.allocationsPerRow >= 0;
+}
+
+// Returns the number of regressed metrics
+static int compareBaseline(const ReplayBaseline& baseline, const ReplayBaseline& current,
+                           double latencyTolerancePct, double accuracyTolerancePct) {
+    int regressions = 0;
+    double latencyLimit = 1.0 + latencyTolerancePct / 100.0;
+
+    printf("\n[replay] ---- baseline ----\n");
+    printf("[replay] %-20s %12s %12s %12s\n", "metric", "baseline", "current", "limit");
+
+    double accuracyLimit = baseline.accuracy - accuracyTolerancePct / 100.0;
+    bool accuracyOk = current.accuracy >= accuracyLimit;
+    printf("[replay] %-20s %11.2f%% %11.2f%% %11.2f%%%s\n", "accuracy", baseline.accuracy * 100.0,
+           current.accuracy * 100.0, accuracyLimit * 100.0, accuracyOk ? "" : "  REGRESSED");
+    if (!accuracyOk) regressions++;
+
+    double latencyP50Limit = baseline.latencyP50 * latencyLimit;
+    bool latencyOk = current.latencyP50 <= latencyP50Limit;
+    printf("[replay] %-20s %12.2f %12.2f %12.2f%s\n", "p50 (loops)", baseline.latencyP50,
+           current.latencyP50, latencyP50Limit, latencyOk ? "" : "  REGRESSED");
+    if (!latencyOk) regressions++;
+    // Scheduler noise dominates the tail of a few-microsecond call
+    printf("[replay] %-20s %12.2f %12.2f %12s\n", "p99 (loops)", baseline.latencyP99,
+           current.latencyP99, "-");
+    printf("[replay] %-20s %12.4f %12.4f %12s\n", "calibration us", baseline.calibrationUs,
+           current.calibrationUs, "-");
+
+    bool allocationsOk = current.allocationsPerRow <= baseline.allocationsPerRow;
+    printf("[replay] %-20s %12.2f %12.2f %12.2f%s\n", "allocations/row", baseline.allocationsPerRow,
+           current.allocationsPerRow, baseline.allocationsPerRow, allocationsOk ? "" : "  REGRESSED");
+    if (!allocationsOk) regressions++;
+
+    return regressions;
+}
+
+// Probabilities for one row, without touching the replay statistics
+static bool classifyProbabilities(const ReplayRow& row, float* probabilities) {
+    signal_t signal;
+    numpy::signal_from_buffer(row.features, FEATURE_COUNT, &signal);
+    ei_impulse_result_t result;
+    memset(&result, 0, sizeof(result));
+    if (run_classifier(&signal, &result, false) != EI_IMPULSE_OK) return false;
+    for (int i = 0; i < LABEL_COUNT; i++) probabilities[i] = result.classification[i].value;
+    return true;
+}
+
+struct DecisionStats {
+    int decided;
+    int correct;
+    std::vector<double> latencyMs;
+};
+
+static void noteDecision(DecisionStats& stats, long latencyMs, int label, int expected) {
+    if (latencyMs < 0) return;
+    stats.decided++;
+    if (label == expected) stats.correct++;
+    stats.latencyMs.push_back((double)latencyMs);
+}
+
+// Consecutive rows of a label were recorded back to back by the data
+// collection server, so a run of them stands in for a hand held in front of
+// the camera
+static void replayTemporal(const std::vector<ReplayRow>& rows, int sequenceFrames) {
+    static const int MAX_SEQUENCE = 64;
+    const unsigned long intervalMs = 1000;    // TaskRuntime capture interval
+    sequenceFrames = std::min(std::max(sequenceFrames, 1), MAX_SEQUENCE);
+
+    static float features[MAX_SEQUENCE][FEATURE_COUNT];
+    static float probabilities[MAX_SEQUENCE][LABEL_COUNT];
+    TemporalClassifier temporal;
+    DecisionStats fused = { 0, 0, {} };
+    DecisionStats confident = { 0, 0, {} };
+    DecisionStats consecutive = { 0, 0, {} };
+    int sequences = 0;
+    double topProbability = 0;
+
+    for (size_t start = 0; start + sequenceFrames <= rows.size(); start += sequenceFrames) {
+        int label = rows[start].label;
+        bool usable = true;
+        for (int f = 0; f < sequenceFrames && usable; f++) {
+            const ReplayRow& row = rows[start + f];
+            usable = row.label == label && classifyProbabilities(row, probabilities[f]);
+            memcpy(features[f], row.features, sizeof(features[f]));
+        }
+        if (!usable) continue;
+        sequences++;
+        for (int f = 0; f < sequenceFrames; f++) {
+            topProbability += *std::max_element(probabilities[f], probabilities[f] + LABEL_COUNT);
+        }
+
+        int decided = -1;
+        long latency = temporal.replaySequence(features, probabilities, sequenceFrames, intervalMs, &decided);
+        noteDecision(fused, latency, decided, label);
+        latency = TemporalClassifier::replayConsecutiveBaseline(probabilities, sequenceFrames, intervalMs, &decided);
+        noteDecision(confident, latency, decided, label);
+        // handleFingerDetection() itself takes any argmax, confident or not
+        latency = TemporalClassifier::replayConsecutiveBaseline(probabilities, sequenceFrames, intervalMs,
+                                                                &decided, 3, 0.0f);
+        noteDecision(consecutive, latency, decided, label);
+    }
+
+    printf("\n[replay] ---- latency to decision: %d sequences of %d frames, %lu ms apart ----\n",
+           sequences, sequenceFrames, intervalMs);
+    printf("[replay] mean top-1 probability %.3f (decision threshold %.2f)\n",
+           sequences ? topProbability / (sequences * sequenceFrames) : 0.0, (double)EI_CLASSIFIER_THRESHOLD);
+    printf("[replay] %-12s %8s %8s %10s %10s %10s\n", "policy", "decided", "correct", "mean ms", "p50 ms", "max ms");
+    const struct {
+        const char* name;
+        const DecisionStats* stats;
+    } policies[] = {
+        { "temporal", &fused },
+        { "3 confident", &confident },
+        { "3 in a row", &consecutive },
+    };
+    for (size_t i = 0; i < sizeof(policies) / sizeof(policies[0]); i++) {
+        const DecisionStats& stats = *policies[i].stats;
+        double mean = 0;
+        for (size_t j = 0; j < stats.latencyMs.size(); j++) mean += stats.latencyMs[j];
+        if (!stats.latencyMs.empty()) mean /= stats.latencyMs.size();
+        printf("[replay] %-12s %8d %8d %10.0f %10.0f %10.0f\n", policies[i].name, stats.decided,
+               stats.correct, mean, percentile(stats.latencyMs, 0.5), percentile(stats.latencyMs, 1.0));
+    }
+}
+
+static void usage(const char* program) {
+    printf("usage: %s [--csv FILE] [--frames DIR] [--passes N] [--baseline FILE]\n"
+           "       [--write-baseline FILE] [--latency-tolerance PCT] [--accuracy-tolerance PCT]\n"
+           "       [--ensemble] [--temporal [--sequence-frames N]]\n", program);
+}
+
+int main(int argc, char** argv) {
+    const char* csvPath = "data/finger_detection_data.csv";
+    const char* frameDir = nullptr;
+    const char* baselinePath = nullptr;
+    const char* writePath = nullptr;
+    int passes = 5;
+    double latencyTolerancePct = 25.0;
+    double accuracyTolerancePct = 1.0;
+    bool ensemble = false;
+    bool temporal = false;
+    int sequenceFrames = 8;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--csv") == 0 && i + 1 < argc) {
+            csvPath = argv[++i];
+        } else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            frameDir = argv[++i];
+        } else if (strcmp(argv[i], "--passes") == 0 && i + 1 < argc) {
+            passes = std::max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+            baselinePath = argv[++i];
+        } else if (strcmp(argv[i], "--write-baseline") == 0 && i + 1 < argc) {
+            writePath = argv[++i];
+        } else if (strcmp(argv[i], "--latency-tolerance") == 0 && i + 1 < argc) {
+            latencyTolerancePct = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--accuracy-tolerance") == 0 && i + 1 < argc) {
+            accuracyTolerancePct = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--ensemble") == 0) {
+            ensemble = true;
+        } else if (strcmp(argv[i], "--temporal") == 0) {
+            temporal = true;
+        } else if (strcmp(argv[i], "--sequence-frames") == 0 && i + 1 < argc) {
+            sequenceFrames = atoi(argv[++i]);
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    std::vector<ReplayRow> rows;
+    if (!loadCsv(csvPath, rows)) {
+        printf("[replay] cannot read %s\n", csvPath);
+        return 1;
+    }
+    printf("[replay] %lu rows from %s\n", (unsigned long)rows.size(), csvPath);
+    if (frameDir) {
+        printf("[replay] %d frames from %s\n", loadFrames(frameDir, rows), frameDir);
+    }
+    if (rows.empty()) return 1;
+
+    ReplayStats stats = replay(rows, passes);
+    printReport(stats);
+    ReplayBaseline current = toBaseline(stats);
+
+    if (ensemble) {
+        replayEnsemble(rows, passes, ENSEMBLE_AVERAGE);
+        replayEnsemble(rows, passes, ENSEMBLE_VOTE);
+    }
+    if (temporal) {
+        replayTemporal(rows, sequenceFrames);
+    }
+
+    int regressions = stats.errors > 0 ? 1 : 0;
+    if (baselinePath) {
+        ReplayBaseline baseline;
+        if (!readBaseline(baselinePath, baseline)) {
+            printf("[replay] cannot read baseline %s\n", baselinePath);
+            return 1;
+        }
+        regressions += compareBaseline(baseline, current, latencyTolerancePct, accuracyTolerancePct);
+        printf("[replay] %s\n", regressions ? "FAILED: regressed against baseline" : "OK: within baseline");
+    }
+
+    if (writePath) {
+        if (!writeBaseline(writePath, current, stats.rows)) {
+            printf("[replay] cannot write %s\n", writePath);
+            return 1;
+        }
+        printf("[replay] baseline written to %s\n", writePath);
+    }
+
+    fflush(stdout);
+    return regressions ? 1 : 0;
+}
@@ -0,0 +1,62 @@
+// Allocation hooks for runtime/heap_telemetry.h. Only built into the image
+// when ENABLE_HEAP_TELEMETRY is set; otherwise the SDK's weak ei_malloc family
+// and the toolchain's new/delete stay in place.
+
+#include "heap_telemetry.h"
+
+#if ENABLE_HEAP_TELEMETRY
+
+#include <new>
+#include "../edge-impulse-sdk/porting/ei_classifier_porting.h"
+
+// The SDK's ESP32-S3 port returns 16-byte aligned blocks for ESP-NN's SIMD
+// kernels; the header keeps malloc's alignment, which is enough on the ESP32
+
+__attribute__((noinline)) void* ei_malloc(size_t size) {
+    return HeapTelemetry::instance().allocate(size, HEAP_SOURCE_EI, HEAP_TELEMETRY_CALLER(), false);
+}
+
+__attribute__((noinline)) void* ei_calloc(size_t nitems, size_t size) {
+    return HeapTelemetry::instance().allocateArray(nitems, size, HEAP_SOURCE_EI, HEAP_TELEMETRY_CALLER());
+}
+
+void ei_free(void* ptr) {
+    HeapTelemetry::instance().release(ptr);
+}
+
+static void* allocateNew(size_t size, uintptr_t caller) {
+    void* ptr = HeapTelemetry::instance().allocate(size, HEAP_SOURCE_NEW, caller, false);
+    if (!ptr) {
+#if __cpp_exceptions
+        throw std::bad_alloc();
+#else
+        abort();
+#endif
+    }
+    return ptr;
+}
+
+__attribute__((noinline)) void* operator new(size_t size) {
+    return allocateNew(size, HEAP_TELEMETRY_CALLER());
+}
+
+__attribute__((noinline)) void* operator new[](size_t size) {
+    return allocateNew(size, HEAP_TELEMETRY_CALLER());
+}
+
+__attribute__((noinline)) void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return HeapTelemetry::instance().allocate(size, HEAP_SOURCE_NEW, HEAP_TELEMETRY_CALLER(), false);
+}
+
+__attribute__((noinline)) void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return HeapTelemetry::instance().allocate(size, HEAP_SOURCE_NEW, HEAP_TELEMETRY_CALLER(), false);
+}
+
+void operator delete(void* ptr) noexcept { HeapTelemetry::instance().release(ptr); }
+void operator delete[](void* ptr) noexcept { HeapTelemetry::instance().release(ptr); }
+void operator delete(void* ptr, size_t) noexcept { HeapTelemetry::instance().release(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { HeapTelemetry::instance().release(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { HeapTelemetry::instance().release(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { HeapTelemetry::instance().release(ptr); }
+
+#endif // ENABLE_HEAP_TELEMETRY
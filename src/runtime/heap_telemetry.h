@@ -0,0 +1,377 @@
+#ifndef HEAP_TELEMETRY_H
+#define HEAP_TELEMETRY_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include "rt_platform.h"
+#include "../config_pins.h"
+#include "../model-parameters/model_metadata.h"
+
+// Heap accounting for the allocations the model's static arena figure
+// (EI_CLASSIFIER_TFLITE_LARGEST_ARENA_SIZE) does not cover: per-call
+// ei_malloc/ei_calloc in process_impulse and run_nn_inference, and every
+// C++ new (camera driver, web server, std containers). With
+// ENABLE_HEAP_TELEMETRY, heap_telemetry.cpp replaces the SDK's weak
+// ei_malloc/ei_calloc/ei_free and the global new/delete with versions that
+// prefix each block with a 16-byte header and record live bytes, peak,
+// counts, a size histogram and the top call sites (by return address;
+// resolve them with xtensa-esp32-elf-addr2line -e firmware.elf).
+//
+// Every block handed out with a header is also entered in a table of live
+// blocks, and release() only reads a header for pointers found there: a
+// block from plain malloc passed to ei_free or delete is freed as is and
+// counted, never taken apart. When the table is full, allocations get no
+// header and are counted as untracked.
+//
+// Plain malloc (Arduino String, camera frame buffers) is not wrapped; the
+// system heap figures next to the report cover it.
+
+#define HEAP_TELEMETRY_MAX_SITES 32
+#define HEAP_TELEMETRY_SIZE_BUCKETS 12     // <=16, <=32, ... <=16K, larger
+#define HEAP_TELEMETRY_MAX_BLOCKS 1024      // Live-block table slots (power of two), 4 B each on the ESP32
+
+enum HeapSource {
+    HEAP_SOURCE_EI,         // ei_malloc / ei_calloc
+    HEAP_SOURCE_NEW,        // operator new / new[]
+    HEAP_SOURCE_COUNT
+};
+
+struct HeapSite {
+    uintptr_t address;      // Return address of the allocating call
+    uint8_t source;
+    uint32_t allocations;
+    uint32_t frees;
+    uint64_t totalBytes;
+    uint32_t liveBytes;
+    uint32_t largest;
+};
+
+struct HeapCounters {
+    uint32_t liveBytes;
+    uint32_t peakBytes;
+    uint32_t liveBlocks;
+    uint32_t allocations;
+    uint32_t frees;
+    uint32_t failures;
+};
+
+struct HeapTotals {
+    HeapCounters sources[HEAP_SOURCE_COUNT];
+    uint32_t liveBytes;
+    uint32_t peakBytes;
+    uint32_t sizeBuckets[HEAP_TELEMETRY_SIZE_BUCKETS];
+    uint32_t untrackedSites;    // Allocations from sites past HEAP_TELEMETRY_MAX_SITES
+    uint32_t untrackedBlocks;   // Allocations made without a header (live-block table full)
+    uint32_t foreignFrees;      // Frees of blocks not in the live-block table
+};
+
+class HeapTelemetry {
+private:
+    // Keeps the 16-byte alignment the SDK asks for
+    struct BlockHeader {
+        uint32_t size;
+        uint16_t site;
+        uint8_t source;
+        uint8_t reserved0;
+        uint32_t reserved[2];
+    };
+    static const uint16_t NO_SITE = 0xFFFF;
+    static const size_t BLOCK_MASK = HEAP_TELEMETRY_MAX_BLOCKS - 1;
+    // Inserts stop at 3/4 full so probe runs stay short
+    static const size_t MAX_LIVE_BLOCKS = HEAP_TELEMETRY_MAX_BLOCKS / 4 * 3;
+
+    RtSpinLock lock;
+    HeapSite sites[HEAP_TELEMETRY_MAX_SITES];
+    int siteCount;
+    HeapTotals totals;
+    // Open addressing with linear probing over the pointers handed out; 0 is
+    // an empty slot
+    uintptr_t blocks[HEAP_TELEMETRY_MAX_BLOCKS];
+    size_t blockCount;
+
+    static size_t blockSlot(uintptr_t ptr) {
+        return (size_t)(((ptr >> 3) * 2654435761u) & BLOCK_MASK);
+    }
+
+    // Called with the lock held; false when the table is full
+    bool insertBlock(uintptr_t ptr) {
+        if (blockCount >= MAX_LIVE_BLOCKS) return false;
+        size_t slot = blockSlot(ptr);
+        while (blocks[slot]) slot = (slot + 1) & BLOCK_MASK;
+        blocks[slot] = ptr;
+        blockCount++;
+        return true;
+    }
+
+    // Called with the lock held; false for pointers that were never inserted.
+    // Later entries of the probe run move back into the hole, so lookups
+    // never need tombstones.
+    bool removeBlock(uintptr_t ptr) {
+        size_t slot = blockSlot(ptr);
+        while (blocks[slot] != ptr) {
+            if (!blocks[slot]) return false;
+            slot = (slot + 1) & BLOCK_MASK;
+        }
+        size_t hole = slot;
+        for (size_t next = (hole + 1) & BLOCK_MASK; blocks[next]; next = (next + 1) & BLOCK_MASK) {
+            size_t home = blockSlot(blocks[next]);
+            // Move the entry unless its home lies cyclically in (hole, next]
+            bool stays = hole <= next ? (hole < home && home <= next) : (hole < home || home <= next);
+            if (!stays) {
+                blocks[hole] = blocks[next];
+                hole = next;
+            }
+        }
+        blocks[hole] = 0;
+        blockCount--;
+        return true;
+    }
+
+    static int sizeBucket(size_t size) {
+        int bucket = 0;
+        size_t limit = 16;
+        while (size > limit && bucket < HEAP_TELEMETRY_SIZE_BUCKETS - 1) {
+            limit <<= 1;
+            bucket++;
+        }
+        return bucket;
+    }
+
+    // Called with the lock held
+    uint16_t siteFor(uintptr_t address, HeapSource source) {
+        for (int i = 0; i < siteCount; i++) {
+            if (sites[i].address == address && sites[i].source == source) return (uint16_t)i;
+        }
+        if (siteCount == HEAP_TELEMETRY_MAX_SITES) return NO_SITE;
+        HeapSite& site = sites[siteCount];
+        memset(&site, 0, sizeof(site));
+        site.address = address;
+        site.source = (uint8_t)source;
+        return (uint16_t)siteCount++;
+    }
+
+public:
+    constexpr HeapTelemetry() : lock(), sites(), siteCount(0), totals(), blocks(), blockCount(0) {}
+
+    static HeapTelemetry& instance() {
+        static HeapTelemetry telemetry;     // Constant-initialised: usable from the first new
+        return telemetry;
+    }
+
+    static constexpr bool isEnabled() { return ENABLE_HEAP_TELEMETRY != 0; }
+
+    void* allocate(size_t size, HeapSource source, uintptr_t caller, bool zero) {
+        // The header records 32-bit sizes
+        BlockHeader* header = nullptr;
+        if (size <= UINT32_MAX - sizeof(BlockHeader)) {
+            header = (BlockHeader*)(zero ? calloc(1, sizeof(BlockHeader) + size)
+                                         : malloc(sizeof(BlockHeader) + size));
+        }
+        lock.lock();
+        if (!header) {
+            totals.sources[source].failures++;
+            lock.unlock();
+            return nullptr;
+        }
+        if (!insertBlock((uintptr_t)(header + 1))) {
+            totals.untrackedBlocks++;
+            lock.unlock();
+            free(header);
+            void* ptr = zero ? calloc(1, size) : malloc(size);
+            if (!ptr) {
+                lock.lock();
+                totals.sources[source].failures++;
+                lock.unlock();
+            }
+            return ptr;
+        }
+        HeapCounters& counters = totals.sources[source];
+        counters.allocations++;
+        counters.liveBlocks++;
+        counters.liveBytes += size;
+        if (counters.liveBytes > counters.peakBytes) counters.peakBytes = counters.liveBytes;
+        totals.liveBytes += size;
+        if (totals.liveBytes > totals.peakBytes) totals.peakBytes = totals.liveBytes;
+        totals.sizeBuckets[sizeBucket(size)]++;
+
+        uint16_t index = siteFor(caller, source);
+        if (index == NO_SITE) {
+            totals.untrackedSites++;
+        } else {
+            HeapSite& site = sites[index];
+            site.allocations++;
+            site.totalBytes += size;
+            site.liveBytes += size;
+            if (size > site.largest) site.largest = size;
+        }
+        lock.unlock();
+
+        header->size = (uint32_t)size;
+        header->site = index;
+        header->source = (uint8_t)source;
+        return header + 1;
+    }
+
+    // calloc semantics: nullptr (and a failure) when count * size overflows
+    void* allocateArray(size_t count, size_t size, HeapSource source, uintptr_t caller) {
+        if (size && count > SIZE_MAX / size) {
+            lock.lock();
+            totals.sources[source].failures++;
+            lock.unlock();
+            return nullptr;
+        }
+        return allocate(count * size, source, caller, true);
+    }
+
+    void release(void* ptr) {
+        if (!ptr) return;
+        lock.lock();
+        if (!removeBlock((uintptr_t)ptr)) {
+            // Not ours (or handed out untracked): its header would be someone
+            // else's memory
+            totals.foreignFrees++;
+            lock.unlock();
+            free(ptr);
+            return;
+        }
+
+        BlockHeader* header = (BlockHeader*)ptr - 1;
+        HeapCounters& counters = totals.sources[header->source];
+        counters.frees++;
+        counters.liveBlocks--;
+        counters.liveBytes -= header->size;
+        totals.liveBytes -= header->size;
+        if (header->site < siteCount) {
+            sites[header->site].frees++;
+            sites[header->site].liveBytes -= header->size;
+        }
+        lock.unlock();
+
+        free(header);
+    }
+
+    // Blocks currently in the live-block table
+    size_t getTrackedBlocks() {
+        lock.lock();
+        size_t count = blockCount;
+        lock.unlock();
+        return count;
+    }
+
+    HeapTotals getTotals() {
+        lock.lock();
+        HeapTotals copy = totals;
+        lock.unlock();
+        return copy;
+    }
+
+    // Copies up to maxSites sites, largest live bytes first (then total bytes)
+    int getTopSites(HeapSite* out, int maxSites) {
+        HeapSite snapshot[HEAP_TELEMETRY_MAX_SITES];
+        lock.lock();
+        int count = siteCount;
+        memcpy(snapshot, sites, sizeof(HeapSite) * count);
+        lock.unlock();
+
+        int copied = 0;
+        bool taken[HEAP_TELEMETRY_MAX_SITES] = { false };
+        while (copied < maxSites && copied < count) {
+            int best = -1;
+            for (int i = 0; i < count; i++) {
+                if (taken[i]) continue;
+                if (best < 0 || snapshot[i].liveBytes > snapshot[best].liveBytes ||
+                    (snapshot[i].liveBytes == snapshot[best].liveBytes &&
+                     snapshot[i].totalBytes > snapshot[best].totalBytes)) {
+                    best = i;
+                }
+            }
+            taken[best] = true;
+            out[copied++] = snapshot[best];
+        }
+        return copied;
+    }
+
+    // Peaks restart from the current live figures; counts and sites are kept
+    void resetPeak() {
+        lock.lock();
+        totals.peakBytes = totals.liveBytes;
+        for (int s = 0; s < HEAP_SOURCE_COUNT; s++) {
+            totals.sources[s].peakBytes = totals.sources[s].liveBytes;
+        }
+        lock.unlock();
+    }
+
+    static const char* sourceName(int source) {
+        return source == HEAP_SOURCE_EI ? "ei_malloc" : "new";
+    }
+
+    static uint32_t sizeBucketLimit(int bucket) {
+        return bucket < HEAP_TELEMETRY_SIZE_BUCKETS - 1 ? 16u << bucket : 0;   // 0 = unbounded
+    }
+
+    void printReport(int topSites = 8) {
+        RT_LOG("=== Heap telemetry ===\n");
+        if (!isEnabled()) {
+            RT_LOG("  disabled (build with ENABLE_HEAP_TELEMETRY=1)\n");
+            return;
+        }
+        HeapTotals snapshot = getTotals();
+        RT_LOG("  tracked: %lu B live, %lu B peak (model arena %d B static)\n",
+               (unsigned long)snapshot.liveBytes, (unsigned long)snapshot.peakBytes,
+               EI_CLASSIFIER_TFLITE_LARGEST_ARENA_SIZE);
+        for (int s = 0; s < HEAP_SOURCE_COUNT; s++) {
+            const HeapCounters& c = snapshot.sources[s];
+            RT_LOG("  %-9s %lu B live in %lu blocks, peak %lu B, %lu allocs, %lu frees, %lu failed\n",
+                   sourceName(s), (unsigned long)c.liveBytes, (unsigned long)c.liveBlocks,
+                   (unsigned long)c.peakBytes, (unsigned long)c.allocations,
+                   (unsigned long)c.frees, (unsigned long)c.failures);
+        }
+
+        RT_LOG("  sizes:");
+        for (int b = 0; b < HEAP_TELEMETRY_SIZE_BUCKETS; b++) {
+            if (snapshot.sizeBuckets[b] == 0) continue;
+            if (sizeBucketLimit(b)) {
+                RT_LOG(" <=%lu:%lu", (unsigned long)sizeBucketLimit(b), (unsigned long)snapshot.sizeBuckets[b]);
+            } else {
+                RT_LOG(" >%lu:%lu", (unsigned long)sizeBucketLimit(b - 1), (unsigned long)snapshot.sizeBuckets[b]);
+            }
+        }
+        RT_LOG("\n");
+
+        HeapSite top[HEAP_TELEMETRY_MAX_SITES];
+        int count = getTopSites(top, topSites < HEAP_TELEMETRY_MAX_SITES ? topSites : HEAP_TELEMETRY_MAX_SITES);
+        RT_LOG("  top sites (live first):\n");
+        for (int i = 0; i < count; i++) {
+            RT_LOG("    0x%08lx %-9s %6lu allocs %8lu B total %6lu B live  largest %lu B\n",
+                   (unsigned long)top[i].address, sourceName(top[i].source),
+                   (unsigned long)top[i].allocations, (unsigned long)top[i].totalBytes,
+                   (unsigned long)top[i].liveBytes, (unsigned long)top[i].largest);
+        }
+        if (snapshot.untrackedSites || snapshot.foreignFrees) {
+            RT_LOG("  %lu allocs from sites past %d not attributed, %lu foreign frees\n",
+                   (unsigned long)snapshot.untrackedSites, HEAP_TELEMETRY_MAX_SITES,
+                   (unsigned long)snapshot.foreignFrees);
+        }
+        if (snapshot.untrackedBlocks) {
+            RT_LOG("  %lu allocs not tracked: more than %lu blocks live\n",
+                   (unsigned long)snapshot.untrackedBlocks, (unsigned long)MAX_LIVE_BLOCKS);
+        }
+#ifdef ARDUINO
+        RT_LOG("  system heap: %lu B free, %lu B min free, %lu B largest block\n",
+               (unsigned long)ESP.getFreeHeap(), (unsigned long)ESP.getMinFreeHeap(),
+               (unsigned long)ESP.getMaxAllocHeap());
+#endif
+    }
+};
+
+// Return address of the current function, usable as a call-site key. On
+// Xtensa the top two bits hold the caller's window size, not address bits.
+#if defined(__XTENSA__)
+#define HEAP_TELEMETRY_CALLER() ((((uintptr_t)__builtin_return_address(0)) & 0x3FFFFFFF) | 0x40000000)
+#else
+#define HEAP_TELEMETRY_CALLER() ((uintptr_t)__builtin_return_address(0))
+#endif
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef I2C_BUS_H
+#define I2C_BUS_H
+
+#include <atomic>
+#include "rt_platform.h"
+
+// The OLED and the camera's SCCB port share one I2C bus, and the OLED flush
+// switches its clock to 400 kHz while it pushes pixels. With the flush on
+// its own task (core 0) and camera register access on core 1, every user of
+// Wire holds this lock for a whole exchange, clock changes included. The
+// lock also records how long callers waited for the bus.
+class I2cBus {
+private:
+    static RtMutex& mutex() {
+        static RtMutex busMutex;
+        return busMutex;
+    }
+
+    struct Stats {
+        std::atomic<unsigned long> acquisitions;
+        std::atomic<unsigned long> contended;      // Waited more than 100 us
+        std::atomic<uint32_t> maxWaitUs;
+        std::atomic<uint64_t> totalWaitUs;
+    };
+
+    static Stats& stats() {
+        static Stats busStats;
+        return busStats;
+    }
+
+public:
+    static void lock() {
+        uint32_t start = rtMicros();
+        mutex().lock();
+        uint32_t waited = rtMicros() - start;
+
+        Stats& s = stats();
+        s.acquisitions++;
+        s.totalWaitUs += waited;
+        if (waited > 100) s.contended++;
+        if (waited > s.maxWaitUs.load()) s.maxWaitUs = waited;
+    }
+
+    static void unlock() { mutex().unlock(); }
+
+    static void resetStats() {
+        Stats& s = stats();
+        s.acquisitions = 0;
+        s.contended = 0;
+        s.maxWaitUs = 0;
+        s.totalWaitUs = 0;
+    }
+
+    static void printStats() {
+        Stats& s = stats();
+        unsigned long count = s.acquisitions.load();
+        RT_LOG("I2C bus: %lu acquisitions, %lu waited >100 us, wait avg %lu / max %lu us\n",
+               count, s.contended.load(),
+               count > 0 ? (unsigned long)(s.totalWaitUs.load() / count) : 0UL,
+               (unsigned long)s.maxWaitUs.load());
+    }
+};
+
+// Holds the bus for the enclosing scope
+class I2cBusLock {
+public:
+    I2cBusLock() { I2cBus::lock(); }
+    ~I2cBusLock() { I2cBus::unlock(); }
+
+private:
+    I2cBusLock(const I2cBusLock&);
+    I2cBusLock& operator=(const I2cBusLock&);
+};
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef LOOP_JITTER_H
+#define LOOP_JITTER_H
+
+#include <math.h>
+#include "rt_platform.h"
+
+// Measures how regular a periodic loop is: call tick() once per iteration
+// and it tracks the spread of the intervals between calls (Welford running
+// mean/variance) plus the worst iteration. Used to compare blocking vs.
+// background display flushes.
+class LoopJitterMeter {
+private:
+    const char* name;
+    uint32_t lastUs;
+    bool primed;
+
+    unsigned long samples;
+    double meanUs;
+    double m2;
+    uint32_t minUs;
+    uint32_t maxUs;
+
+public:
+    LoopJitterMeter(const char* label) : name(label) {
+        reset();
+    }
+
+    void reset() {
+        primed = false;
+        lastUs = 0;
+        samples = 0;
+        meanUs = 0.0;
+        m2 = 0.0;
+        minUs = UINT32_MAX;
+        maxUs = 0;
+    }
+
+    void tick(uint32_t nowUs) {
+        if (primed) {
+            uint32_t interval = nowUs - lastUs;
+            samples++;
+            double delta = interval - meanUs;
+            meanUs += delta / samples;
+            m2 += delta * (interval - meanUs);
+            if (interval < minUs) minUs = interval;
+            if (interval > maxUs) maxUs = interval;
+        }
+        lastUs = nowUs;
+        primed = true;
+    }
+
+    void tick() { tick(rtMicros()); }
+
+    unsigned long getSamples() const { return samples; }
+    float getMeanUs() const { return (float)meanUs; }
+    float getStdDevUs() const { return samples > 1 ? (float)sqrt(m2 / (samples - 1)) : 0.0f; }
+    uint32_t getMaxUs() const { return maxUs; }
+
+    void printStats() {
+        if (samples == 0) return;
+        RT_LOG("%s loop: %lu iterations, period avg %.0f us, jitter (stddev) %.0f us, min %lu / max %lu us\n",
+               name, samples, meanUs, getStdDevUs(), (unsigned long)minUs, (unsigned long)maxUs);
+    }
+};
+
+#endif
@@ -0,0 +1,234 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <atomic>
+#include "rt_platform.h"
+
+// Always-on pipeline counters and latency histograms, scraped as Prometheus
+// text from /api/metrics (web/data_collection_server.h) or printed with the
+// "metrics" serial command. Every update is a handful of 32-bit atomic adds
+// (lock-free on the ESP32's S32C1I), so the hot path never takes a lock
+// and never allocates. Histogram buckets are fixed; the cumulative "le" view
+// Prometheus wants is only built at scrape time.
+
+#define METRICS_PREFIX "finger_timer_"
+#define METRICS_LATENCY_BUCKETS 12      // 11 bounds + overflow
+
+enum MetricsStage {
+    METRICS_STAGE_CAPTURE,      // Sensor exposure until CAP_DONE
+    METRICS_STAGE_TRANSFER,     // SPI burst out of the ArduCAM FIFO
+    METRICS_STAGE_DSP,          // SDK-reported DSP time of run_classifier(); none with the ensemble
+    METRICS_STAGE_INFERENCE,    // Runtime classify hook (heuristic or network)
+    METRICS_STAGE_COUNT
+};
+
+// Upper bounds in microseconds; observations above the last bound land in
+// the overflow bucket (+Inf)
+static const uint32_t METRICS_BUCKET_BOUNDS_US[METRICS_LATENCY_BUCKETS - 1] = {
+    500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 500000, 1000000
+};
+
+// Fixed-bucket histogram. Any task may observe(); a scrape reads each
+// bucket independently, so a scrape racing an update can be one sample
+// behind in some buckets, never torn. The 64-bit sum is read untorn.
+class LatencyHistogram {
+private:
+    // Spins before a reader sleeps: a writer preempted mid-update by a
+    // higher-priority reader on the same core only finishes if it yields
+    static const int SUM_READ_SPINS = 64;
+
+    std::atomic<uint32_t> buckets[METRICS_LATENCY_BUCKETS];
+    // Sum in microseconds as two words: 64-bit atomics are not lock-free on
+    // the ESP32, so the low word's carry is added to the high word instead.
+    // Writers stay lock-free; a reader only takes a sum no update overlapped
+    // (sumWriters was zero throughout and sumEpoch did not move), which
+    // rules out catching a carry between its two adds
+    std::atomic<uint32_t> sumLow;
+    std::atomic<uint32_t> sumHigh;
+    std::atomic<uint32_t> sumWriters;
+    std::atomic<uint32_t> sumEpoch;
+
+public:
+    LatencyHistogram() : sumLow(0), sumHigh(0), sumWriters(0), sumEpoch(0) {
+        for (int b = 0; b < METRICS_LATENCY_BUCKETS; b++) buckets[b] = 0;
+    }
+
+    void observe(uint32_t us) {
+        int b = 0;
+        while (b < METRICS_LATENCY_BUCKETS - 1 && us > METRICS_BUCKET_BOUNDS_US[b]) b++;
+        buckets[b].fetch_add(1, std::memory_order_relaxed);
+        sumWriters.fetch_add(1);
+        uint32_t before = sumLow.fetch_add(us);
+        if ((uint32_t)(before + us) < before) {
+            sumHigh.fetch_add(1);
+        }
+        sumEpoch.fetch_add(1);
+        sumWriters.fetch_sub(1);
+    }
+
+    uint32_t getBucket(int bucket) const { return buckets[bucket].load(std::memory_order_relaxed); }
+
+    uint32_t getCount() const {
+        uint32_t count = 0;
+        for (int b = 0; b < METRICS_LATENCY_BUCKETS; b++) count += getBucket(b);
+        return count;
+    }
+
+    uint64_t getSumUs() const {
+        for (int attempt = 1; ; attempt++) {
+            uint32_t epoch = sumEpoch.load();
+            if (sumWriters.load() == 0) {
+                uint32_t high = sumHigh.load();
+                uint32_t low = sumLow.load();
+                if (sumWriters.load() == 0 && sumEpoch.load() == epoch) {
+                    return ((uint64_t)high << 32) | low;
+                }
+            }
+            if (attempt % SUM_READ_SPINS == 0) rtSleepMs(1);
+        }
+    }
+};
+
+// Appends Prometheus text exposition format to a fixed buffer; output past
+// the end is dropped and reported by overflowed()
+class MetricsWriter {
+private:
+    char* buffer;
+    size_t capacity;
+    size_t length;
+    bool overflow;
+
+public:
+    MetricsWriter(char* out, size_t size) : buffer(out), capacity(size), length(0), overflow(false) {
+        if (capacity > 0) buffer[0] = '\0';
+    }
+
+    void append(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+        if (length >= capacity) {
+            overflow = true;
+            return;
+        }
+        va_list args;
+        va_start(args, format);
+        int written = vsnprintf(buffer + length, capacity - length, format, args);
+        va_end(args);
+        if (written < 0 || (size_t)written >= capacity - length) {
+            overflow = true;
+            length = capacity;
+            buffer[capacity - 1] = '\0';
+            return;
+        }
+        length += written;
+    }
+
+    void header(const char* name, const char* type, const char* help) {
+        append("# HELP " METRICS_PREFIX "%s %s\n# TYPE " METRICS_PREFIX "%s %s\n", name, help, name, type);
+    }
+
+    void counter(const char* name, const char* help, unsigned long value) {
+        header(name, "counter", help);
+        append(METRICS_PREFIX "%s %lu\n", name, value);
+    }
+
+    void gauge(const char* name, const char* help, double value) {
+        header(name, "gauge", help);
+        append(METRICS_PREFIX "%s %.6g\n", name, value);
+    }
+
+    // One series of a histogram family; header() once before the first
+    void histogram(const char* name, const char* label, const char* labelValue,
+                   const LatencyHistogram& histogram) {
+        uint32_t cumulative = 0;
+        for (int b = 0; b < METRICS_LATENCY_BUCKETS - 1; b++) {
+            cumulative += histogram.getBucket(b);
+            append(METRICS_PREFIX "%s_bucket{%s=\"%s\",le=\"%g\"} %lu\n", name, label, labelValue,
+                   METRICS_BUCKET_BOUNDS_US[b] / 1e6, (unsigned long)cumulative);
+        }
+        cumulative += histogram.getBucket(METRICS_LATENCY_BUCKETS - 1);
+        append(METRICS_PREFIX "%s_bucket{%s=\"%s\",le=\"+Inf\"} %lu\n", name, label, labelValue,
+               (unsigned long)cumulative);
+        append(METRICS_PREFIX "%s_sum{%s=\"%s\"} %.6f\n", name, label, labelValue,
+               histogram.getSumUs() / 1e6);
+        append(METRICS_PREFIX "%s_count{%s=\"%s\"} %lu\n", name, label, labelValue,
+               (unsigned long)cumulative);
+    }
+
+    const char* c_str() const { return buffer; }
+    size_t size() const { return length; }
+    bool overflowed() const { return overflow; }
+};
+
+class PipelineMetrics {
+private:
+    LatencyHistogram stages[METRICS_STAGE_COUNT];
+    std::atomic<uint32_t> framesCaptured;
+    std::atomic<uint32_t> captureFailures;
+    std::atomic<uint32_t> inferences;
+    std::atomic<uint32_t> droppedFrames;
+    std::atomic<uint32_t> transferBytes;
+    std::atomic<uint32_t> wifiSentBytes;
+
+public:
+    PipelineMetrics() : framesCaptured(0), captureFailures(0), inferences(0),
+                        droppedFrames(0), transferBytes(0), wifiSentBytes(0) {}
+
+    static PipelineMetrics& instance() {
+        static PipelineMetrics metrics;
+        return metrics;
+    }
+
+    static const char* stageName(int stage) {
+        static const char* const names[METRICS_STAGE_COUNT] = {
+            "capture", "transfer", "dsp", "inference"
+        };
+        return stage >= 0 && stage < METRICS_STAGE_COUNT ? names[stage] : "?";
+    }
+
+    void observe(MetricsStage stage, uint32_t us) { stages[stage].observe(us); }
+
+    void countFrameCaptured() { framesCaptured.fetch_add(1, std::memory_order_relaxed); }
+    void countCaptureFailure() { captureFailures.fetch_add(1, std::memory_order_relaxed); }
+    void countInference() { inferences.fetch_add(1, std::memory_order_relaxed); }
+    void countDroppedFrame() { droppedFrames.fetch_add(1, std::memory_order_relaxed); }
+    void addTransferBytes(uint32_t bytes) { transferBytes.fetch_add(bytes, std::memory_order_relaxed); }
+    void addWifiSentBytes(uint32_t bytes) { wifiSentBytes.fetch_add(bytes, std::memory_order_relaxed); }
+
+    const LatencyHistogram& getStage(int stage) const { return stages[stage]; }
+    uint32_t getFramesCaptured() const { return framesCaptured.load(); }
+    uint32_t getInferences() const { return inferences.load(); }
+    uint32_t getDroppedFrames() const { return droppedFrames.load(); }
+
+    // Pipeline counters and stage histograms; the web server appends heap
+    // and Wi-Fi figures it owns
+    void write(MetricsWriter& out) const {
+        out.counter("frames_captured_total", "Camera frames captured.", framesCaptured.load());
+        out.counter("capture_failures_total", "Runtime captures that failed.", captureFailures.load());
+        out.counter("inferences_total", "Frames classified by the inference task.", inferences.load());
+        out.counter("frames_dropped_total", "Frames dropped because inference was behind.", droppedFrames.load());
+        out.counter("camera_transfer_bytes_total", "Bytes read from the camera FIFO.", transferBytes.load());
+        out.counter("wifi_sent_bytes_total", "HTTP response bytes handed to the Wi-Fi stack.", wifiSentBytes.load());
+
+        out.header("stage_latency_seconds", "histogram", "Pipeline stage latency.");
+        for (int s = 0; s < METRICS_STAGE_COUNT; s++) {
+            out.histogram("stage_latency_seconds", "stage", stageName(s), stages[s]);
+        }
+    }
+};
+
+// Observes the enclosing scope's duration into a stage histogram
+class MetricsStageTimer {
+private:
+    MetricsStage stage;
+    uint32_t startUs;
+
+public:
+    explicit MetricsStageTimer(MetricsStage timedStage) : stage(timedStage), startUs(rtMicros()) {}
+    ~MetricsStageTimer() {
+        PipelineMetrics::instance().observe(stage, rtMicros() - startUs);
+    }
+};
+
+#endif
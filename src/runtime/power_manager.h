@@ -0,0 +1,239 @@
+#ifndef POWER_MANAGER_H
+#define POWER_MANAGER_H
+
+#include <atomic>
+#include "rt_platform.h"
+
+#ifdef ARDUINO
+#include <esp_sleep.h>
+#endif
+
+// Decides how to spend idle time between scheduled events. Short gaps are
+// plain delays; gaps long enough to pay for the wake-up go into light sleep
+// with a timer wake-up just ahead of the next deadline. It also keeps an
+// energy/latency account: time awake vs. asleep, camera on vs. standby, and
+// how late each wake-up was, priced with a simple current model.
+
+struct PowerModel {
+    float activeMa;          // ESP32 awake, radio off
+    float lightSleepMa;      // ESP32 in light sleep
+    float cameraActiveMa;    // ArduCAM streaming/idle powered
+    float cameraStandbyMa;   // Sensor in power-down
+    uint32_t sleepWakeMs;    // Margin for the light-sleep wake-up path
+    uint32_t minSleepMs;     // Shorter gaps are not worth sleeping
+};
+
+// Platform hooks; the simulated backend advances a fake clock instead
+class PowerBackend {
+public:
+    virtual ~PowerBackend() {}
+    virtual uint32_t nowMs() = 0;
+    virtual void idleDelay(uint32_t ms) = 0;
+    virtual void lightSleep(uint32_t ms) = 0;
+};
+
+#ifdef ARDUINO
+class Esp32PowerBackend : public PowerBackend {
+public:
+    uint32_t nowMs() override { return millis(); }
+
+    void idleDelay(uint32_t ms) override { delay(ms); }
+
+    // millis() keeps counting across light sleep (esp_timer is compensated)
+    void lightSleep(uint32_t ms) override {
+        Serial.flush();
+        esp_sleep_enable_timer_wakeup((uint64_t)ms * 1000ULL);
+        esp_light_sleep_start();
+    }
+};
+#else
+// Native build: the Arduino stand-in's clock, no real sleep state
+class HostPowerBackend : public PowerBackend {
+public:
+    uint32_t nowMs() override { return millis(); }
+    void idleDelay(uint32_t ms) override { delay(ms); }
+    void lightSleep(uint32_t ms) override { delay(ms); }
+};
+#endif
+
+// Host simulation: time only moves when the firmware idles, and a light
+// sleep costs wakeLatencyMs on top of the requested duration
+class SimulatedPowerBackend : public PowerBackend {
+private:
+    uint32_t clockMs;
+    uint32_t wakeLatencyMs;
+
+public:
+    SimulatedPowerBackend(uint32_t startMs = 0, uint32_t wakeLatency = 1)
+        : clockMs(startMs), wakeLatencyMs(wakeLatency) {}
+
+    uint32_t nowMs() override { return clockMs; }
+    void idleDelay(uint32_t ms) override { clockMs += ms; }
+    void lightSleep(uint32_t ms) override { clockMs += ms + wakeLatencyMs; }
+
+    // Simulated work between idle periods
+    void advance(uint32_t ms) { clockMs += ms; }
+};
+
+class PowerManager {
+private:
+    PowerBackend* backend;
+    PowerModel model;
+    bool sleepEnabled;
+
+    uint32_t startMs;
+    uint32_t lastMarkMs;          // End of the last idle period
+    uint64_t awakeMs;
+    uint64_t asleepMs;
+    uint64_t idleAwakeMs;         // Idle spent in delay() rather than sleep
+    unsigned long sleeps;
+    unsigned long skippedSleeps;  // Sleep was allowed but the gap was too short
+    uint32_t maxWakeLateMs;
+    uint64_t totalWakeLateMs;
+
+    // Camera accounting, written by whichever task owns the camera
+    std::atomic<bool> cameraStandby;
+    std::atomic<uint32_t> cameraSinceMs;
+    std::atomic<uint32_t> cameraOnMs;
+    std::atomic<uint32_t> cameraStandbyMs;
+    std::atomic<unsigned long> cameraWakes;
+
+    void markAwake(uint32_t now) {
+        awakeMs += now - lastMarkMs;
+    }
+
+public:
+    PowerManager(PowerBackend* platform) : backend(platform) {
+        model.activeMa = 45.0f;
+        model.lightSleepMa = 0.8f;
+        model.cameraActiveMa = 70.0f;
+        model.cameraStandbyMa = 1.5f;
+        model.sleepWakeMs = 2;
+        model.minSleepMs = 20;
+        sleepEnabled = true;
+        cameraStandby = false;
+        reset();
+    }
+
+    PowerModel& getModel() { return model; }
+    void setSleepEnabled(bool enabled) { sleepEnabled = enabled; }
+
+    void reset() {
+        uint32_t now = backend->nowMs();
+        startMs = now;
+        lastMarkMs = now;
+        awakeMs = 0;
+        asleepMs = 0;
+        idleAwakeMs = 0;
+        sleeps = 0;
+        skippedSleeps = 0;
+        maxWakeLateMs = 0;
+        totalWakeLateMs = 0;
+        cameraSinceMs = now;
+        cameraOnMs = 0;
+        cameraStandbyMs = 0;
+        cameraWakes = 0;
+    }
+
+    // Spend budgetMs until the next deadline. allowSleep is false while
+    // something needs the CPU or timers to keep running (buzzer playing,
+    // frames in flight, Wi-Fi up). Returns the time actually spent idle.
+    uint32_t idle(uint32_t budgetMs, bool allowSleep) {
+        uint32_t start = backend->nowMs();
+        markAwake(start);
+        if (budgetMs == 0) {
+            lastMarkMs = start;
+            return 0;
+        }
+
+        bool sleep = sleepEnabled && allowSleep;
+        if (sleep && budgetMs < model.minSleepMs + model.sleepWakeMs) {
+            skippedSleeps++;
+            sleep = false;
+        }
+
+        if (sleep) {
+            uint32_t target = budgetMs - model.sleepWakeMs;
+            backend->lightSleep(target);
+            uint32_t slept = backend->nowMs() - start;
+            asleepMs += slept;
+            sleeps++;
+            // How far past the deadline we woke (early wake-ups count as 0)
+            uint32_t late = slept > budgetMs ? slept - budgetMs : 0;
+            totalWakeLateMs += late;
+            if (late > maxWakeLateMs) maxWakeLateMs = late;
+        } else {
+            backend->idleDelay(budgetMs);
+            uint32_t waited = backend->nowMs() - start;
+            awakeMs += waited;
+            idleAwakeMs += waited;
+        }
+
+        lastMarkMs = backend->nowMs();
+        return lastMarkMs - start;
+    }
+
+    // Record a camera power transition (call from the task that owns it)
+    void noteCameraStandby(bool standby) {
+        if (standby == cameraStandby.load()) return;
+        uint32_t now = backend->nowMs();
+        uint32_t span = now - cameraSinceMs.load();
+        if (cameraStandby.load()) {
+            cameraStandbyMs += span;
+            cameraWakes++;
+        } else {
+            cameraOnMs += span;
+        }
+        cameraSinceMs = now;
+        cameraStandby = standby;
+    }
+
+    bool isCameraStandby() const { return cameraStandby.load(); }
+
+    uint64_t getAwakeMs() const { return awakeMs; }
+    uint64_t getAsleepMs() const { return asleepMs; }
+    unsigned long getSleepCount() const { return sleeps; }
+    unsigned long getSkippedSleeps() const { return skippedSleeps; }
+    uint64_t getIdleAwakeMs() const { return idleAwakeMs; }
+    uint32_t getMaxWakeLateMs() const { return maxWakeLateMs; }
+
+    // Average current over the accounted period using the model above
+    float getAverageCurrentMa() {
+        uint32_t now = backend->nowMs();
+        float awake = (float)(awakeMs + (now - lastMarkMs));
+        float asleep = (float)asleepMs;
+        float camOn = (float)cameraOnMs.load();
+        float camStandby = (float)cameraStandbyMs.load();
+        if (cameraStandby.load()) {
+            camStandby += now - cameraSinceMs.load();
+        } else {
+            camOn += now - cameraSinceMs.load();
+        }
+
+        float total = awake + asleep;
+        if (total <= 0.0f) return 0.0f;
+        float cpu = model.activeMa * awake + model.lightSleepMa * asleep;
+        float cam = model.cameraActiveMa * camOn + model.cameraStandbyMa * camStandby;
+        return (cpu + cam) / total;
+    }
+
+    void printStats() {
+        uint32_t now = backend->nowMs();
+        uint64_t awake = awakeMs + (now - lastMarkMs);
+        uint64_t total = awake + asleepMs;
+        float avgMa = getAverageCurrentMa();
+        RT_LOG("=== Power ===\n");
+        RT_LOG("Awake %lu ms (idle-awake %lu), asleep %lu ms (%.1f%%), %lu sleeps, %lu too short\n",
+               (unsigned long)awake, (unsigned long)idleAwakeMs, (unsigned long)asleepMs,
+               total > 0 ? 100.0f * asleepMs / total : 0.0f, sleeps, skippedSleeps);
+        RT_LOG("Wake latency: avg %.2f ms, max %lu ms past deadline\n",
+               sleeps > 0 ? (float)totalWakeLateMs / sleeps : 0.0f, (unsigned long)maxWakeLateMs);
+        RT_LOG("Camera: on %lu ms, standby %lu ms, %lu wake-ups\n",
+               (unsigned long)cameraOnMs.load(), (unsigned long)cameraStandbyMs.load(), cameraWakes.load());
+        RT_LOG("Model: avg %.1f mA, %.2f mAh over %lu s\n",
+               avgMa, avgMa * (now - startMs) / 3600000.0f, (unsigned long)((now - startMs) / 1000));
+        RT_LOG("=============\n");
+    }
+};
+
+#endif
@@ -0,0 +1,290 @@
+#ifndef RT_PLATFORM_H
+#define RT_PLATFORM_H
+
+#include <stdint.h>
+
+// Minimal task/clock abstraction for the task runtime. On the ESP32 tasks are
+// FreeRTOS tasks pinned to a core; on a host build (no ARDUINO define) they
+// are std::threads so the scheduling and queue behavior can be exercised and
+// benchmarked on Linux. Either way a task is an entry function that returns
+// when it is done, and rtJoinTask() waits for that.
+
+// Compute stages whose cost a simulated clock has to model, because on the
+// host they take (much shorter) real time that the simulation ignores
+enum RtCostStage {
+    RT_COST_FEATURES,       // Feature extraction from FIFO bytes
+    RT_COST_ANALYZE,        // Heuristic finger count
+    RT_COST_DSP,            // run_classifier() DSP block
+    RT_COST_INFERENCE,      // run_classifier() network
+    RT_COST_STAGE_COUNT
+};
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#include <freertos/event_groups.h>
+
+#define RT_LOG(...) Serial.printf(__VA_ARGS__)
+
+// A started task: FreeRTOS tasks cannot be joined, so every task runs through
+// rtTaskTrampoline, which raises RT_TASK_EXITED once the entry function has
+// returned and then deletes itself
+struct RtTask {
+    void (*entry)(void*);
+    void* arg;
+    EventGroupHandle_t events;
+};
+
+typedef RtTask* RtTaskHandle;
+
+#define RT_TASK_EXITED  (1 << 0)
+
+inline uint32_t rtMicros() { return (uint32_t)micros(); }
+inline uint32_t rtMillis() { return (uint32_t)millis(); }
+inline void rtSleepMs(uint32_t ms) { vTaskDelay(ms / portTICK_PERIOD_MS > 0 ? ms / portTICK_PERIOD_MS : 1); }
+
+inline void rtTaskTrampoline(void* param) {
+    RtTask* task = static_cast<RtTask*>(param);
+    task->entry(task->arg);
+    // Nothing of the RtTask may be touched after this: the joiner frees it
+    // as soon as the bit is set
+    xEventGroupSetBits(task->events, RT_TASK_EXITED);
+    vTaskDelete(NULL);
+}
+
+inline bool rtStartTask(void (*entry)(void*), void* arg, const char* name,
+                        uint32_t stackBytes, int priority, int core, RtTaskHandle* handle) {
+    *handle = nullptr;
+    RtTask* task = new RtTask;
+    task->entry = entry;
+    task->arg = arg;
+    task->events = xEventGroupCreate();
+    if (!task->events) {
+        delete task;
+        return false;
+    }
+    if (xTaskCreatePinnedToCore(rtTaskTrampoline, name, stackBytes, task, priority, NULL, core) != pdPASS) {
+        vEventGroupDelete(task->events);
+        delete task;
+        return false;
+    }
+    *handle = task;
+    return true;
+}
+
+// Blocks until the task's entry function has returned, so a following
+// rtStartTask can never overlap the old task. Must not be called from the
+// task itself.
+inline void rtJoinTask(RtTaskHandle& handle) {
+    if (!handle) return;
+    xEventGroupWaitBits(handle->events, RT_TASK_EXITED, pdFALSE, pdTRUE, portMAX_DELAY);
+    vEventGroupDelete(handle->events);
+    delete handle;
+    handle = nullptr;
+}
+
+// Opaque id of the calling task (for tracing)
+inline uint32_t rtCurrentTaskId() { return (uint32_t)(uintptr_t)xTaskGetCurrentTaskHandle(); }
+
+// The device pays compute costs in real time
+inline void rtChargeCost(RtCostStage, uint32_t = 1) {}
+
+// Wakes a waiting task; notifications coalesce like a binary semaphore
+class RtSignal {
+private:
+    SemaphoreHandle_t semaphore;
+
+public:
+    RtSignal() { semaphore = xSemaphoreCreateBinary(); }
+    ~RtSignal() { vSemaphoreDelete(semaphore); }
+
+    void notify() { xSemaphoreGive(semaphore); }
+
+    // Returns false on timeout
+    bool wait(uint32_t timeoutMs) {
+        return xSemaphoreTake(semaphore, pdMS_TO_TICKS(timeoutMs)) == pdTRUE;
+    }
+};
+
+// Short critical sections between tasks (priority-inheriting mutex)
+class RtMutex {
+private:
+    SemaphoreHandle_t mutex;
+
+public:
+    RtMutex() { mutex = xSemaphoreCreateMutex(); }
+    ~RtMutex() { vSemaphoreDelete(mutex); }
+
+    void lock() { xSemaphoreTake(mutex, portMAX_DELAY); }
+    void unlock() { xSemaphoreGive(mutex); }
+};
+
+// A few instructions of bookkeeping from any task or before the scheduler
+// starts (e.g. inside operator new). Constant-initialised, never allocates;
+// masks interrupts on this core while held.
+class RtSpinLock {
+private:
+    portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+
+public:
+    constexpr RtSpinLock() {}
+
+    void lock() { portENTER_CRITICAL(&mux); }
+    void unlock() { portEXIT_CRITICAL(&mux); }
+};
+
+#else
+#include <stdio.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#define RT_LOG(...) printf(__VA_ARGS__)
+
+typedef std::thread* RtTaskHandle;
+
+// Simulated time (lib/native_hal, --sim-time): while installed, the clock
+// only moves when the firmware sleeps or is charged a modelled cost, so a
+// run is deterministic and hours of device time pass in seconds. Tasks share
+// one simulated core: the running task keeps it until it sleeps or waits,
+// then the task due earliest runs (ties in the order they blocked) and the
+// clock jumps to its wake time if nothing is due yet.
+#define RT_SIM_FOREVER UINT64_MAX
+
+struct RtSimClock {
+    uint64_t (*nowUs)();
+    void (*sleepUs)(uint64_t us);
+    void (*charge)(RtCostStage stage, uint32_t units);
+    // Blocks the calling task until wake(channel) or timeoutUs has passed
+    // (RT_SIM_FOREVER for no timeout); true if it was woken
+    bool (*wait)(const void* channel, uint64_t timeoutUs);
+    void (*wake)(const void* channel);
+    bool (*startTask)(void (*entry)(void*), void* arg, const char* name, RtTaskHandle* handle);
+    void (*joinTask)(RtTaskHandle handle);
+};
+
+inline RtSimClock*& rtSimClock() {
+    static RtSimClock* clock = nullptr;
+    return clock;
+}
+
+inline uint32_t rtMicros() {
+    using namespace std::chrono;
+    static const steady_clock::time_point start = steady_clock::now();
+    if (rtSimClock()) return (uint32_t)rtSimClock()->nowUs();
+    return (uint32_t)duration_cast<microseconds>(steady_clock::now() - start).count();
+}
+inline uint32_t rtMillis() { return rtMicros() / 1000; }
+inline void rtSleepMs(uint32_t ms) {
+    if (rtSimClock()) {
+        rtSimClock()->sleepUs(ms * 1000ULL);
+        return;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+// Advance a simulated clock by the modelled cost of units of a stage
+inline void rtChargeCost(RtCostStage stage, uint32_t units = 1) {
+    if (rtSimClock()) rtSimClock()->charge(stage, units);
+}
+
+// Core and priority are ignored on the host; the OS scheduler decides, or
+// the simulated clock's in simulated time
+inline bool rtStartTask(void (*entry)(void*), void* arg, const char* name,
+                        uint32_t, int, int, RtTaskHandle* handle) {
+    if (rtSimClock()) return rtSimClock()->startTask(entry, arg, name, handle);
+    *handle = new std::thread(entry, arg);
+    return true;
+}
+
+inline void rtJoinTask(RtTaskHandle& handle) {
+    if (handle) {
+        if (rtSimClock()) {
+            rtSimClock()->joinTask(handle);
+        } else {
+            handle->join();
+            delete handle;
+        }
+        handle = nullptr;
+    }
+}
+
+inline uint32_t rtCurrentTaskId() {
+    return (uint32_t)std::hash<std::thread::id>()(std::this_thread::get_id());
+}
+
+class RtSignal {
+private:
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool pending;
+
+public:
+    RtSignal() : pending(false) {}
+
+    void notify() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending = true;
+        }
+        condition.notify_one();
+        if (rtSimClock()) rtSimClock()->wake(this);
+    }
+
+    bool wait(uint32_t timeoutMs) {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (!rtSimClock()) {
+            condition.wait_for(lock, std::chrono::milliseconds(timeoutMs), [this] { return pending; });
+        } else if (!pending) {
+            lock.unlock();
+            rtSimClock()->wait(this, timeoutMs * 1000ULL);
+            lock.lock();
+        }
+        bool woke = pending;
+        pending = false;
+        return woke;
+    }
+};
+
+class RtMutex {
+private:
+    std::mutex mutex;
+
+public:
+    // In simulated time the owner may be blocked in a sleep, so a contender
+    // waits for the simulated core instead of the host mutex
+    void lock() {
+        if (rtSimClock()) {
+            while (!mutex.try_lock()) rtSimClock()->wait(this, RT_SIM_FOREVER);
+            return;
+        }
+        mutex.lock();
+    }
+    void unlock() {
+        mutex.unlock();
+        if (rtSimClock()) rtSimClock()->wake(this);
+    }
+};
+
+class RtSpinLock {
+private:
+    std::atomic_flag flag = ATOMIC_FLAG_INIT;
+
+public:
+    constexpr RtSpinLock() {}
+
+    void lock() {
+        while (flag.test_and_set(std::memory_order_acquire)) {
+            std::this_thread::yield();
+        }
+    }
+    void unlock() { flag.clear(std::memory_order_release); }
+};
+#endif
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <stddef.h>
+#include <atomic>
+
+// Lock-free single-producer/single-consumer ring buffer. One task may call
+// push() and one (other) task may call pop(); neither ever blocks. Capacity
+// must be a power of two; one slot is not sacrificed because head and tail
+// are free-running counters.
+template <typename T, size_t CAPACITY>
+class SpscQueue {
+    static_assert(CAPACITY >= 2 && (CAPACITY & (CAPACITY - 1)) == 0,
+                  "SpscQueue capacity must be a power of two");
+
+private:
+    T slots[CAPACITY];
+    std::atomic<size_t> head;     // Next slot to read (consumer owned)
+    std::atomic<size_t> tail;     // Next slot to write (producer owned)
+    std::atomic<unsigned long> dropped;
+
+public:
+    SpscQueue() : head(0), tail(0), dropped(0) {}
+
+    // Producer side: returns false (and counts a drop) when full
+    bool push(const T& item) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) >= CAPACITY) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        slots[t & (CAPACITY - 1)] = item;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side: returns false when empty
+    bool pop(T& item) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = slots[h & (CAPACITY - 1)];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t size() const {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+
+    bool empty() const { return size() == 0; }
+    size_t capacity() const { return CAPACITY; }
+    unsigned long getDropped() const { return dropped.load(std::memory_order_relaxed); }
+};
+
+#endif
@@ -0,0 +1,328 @@
+#ifndef TASK_RUNTIME_H
+#define TASK_RUNTIME_H
+
+#include <atomic>
+#include "rt_platform.h"
+#include "spsc_queue.h"
+#include "trace.h"
+#include "metrics.h"
+
+// Three-task pipeline replacing the single Arduino loop():
+//
+//   capture task ──frames──▶ inference task ──detections──▶ UI task
+//   (camera/SPI)             (other core)                   (state machine,
+//                                                             OLED, buzzer)
+//
+// Stages talk only through lock-free SPSC queues, so each piece of hardware
+// is owned by exactly one task. What a stage actually does is supplied via
+// RuntimeHooks, which keeps this header free of camera/model dependencies and
+// lets the same runtime run on the host with stand-in hooks.
+
+#define RUNTIME_FRAME_SAMPLES   100
+#define RUNTIME_FRAME_FEATURES  20
+
+struct RuntimeFrame {
+    uint32_t seq;
+    uint32_t captureStartUs;
+    uint32_t captureEndUs;
+    uint8_t samples[RUNTIME_FRAME_SAMPLES];
+    int sampleCount;
+    float features[RUNTIME_FRAME_FEATURES];
+    int featureCount;
+};
+
+struct RuntimeDetection {
+    uint32_t seq;
+    int fingers;
+    uint32_t captureStartUs;
+    uint32_t inferenceStartUs;
+    uint32_t inferenceEndUs;
+};
+
+struct RuntimeHooks {
+    void* context;
+    // Capture task: fill frame.samples and/or frame.features
+    bool (*capture)(void* context, RuntimeFrame& frame);
+    // Inference task: return a finger count, or -1 if the frame is unusable
+    int (*classify)(void* context, const RuntimeFrame& frame);
+    // UI task: consume one detection
+    void (*onDetection)(void* context, const RuntimeDetection& detection);
+    // UI task: periodic tick (state machine update, display refresh)
+    void (*uiTick)(void* context);
+    // Capture task: capture paused (true) or resumed (false); optional, lets
+    // the task that owns the camera power it down
+    void (*captureIdle)(void* context, bool idle);
+};
+
+struct RuntimeConfig {
+    uint32_t captureIntervalMs;
+    uint32_t uiTickMs;
+    int captureCore;
+    int inferenceCore;
+    int uiCore;
+    int captureStack;
+    int inferenceStack;
+    int uiStack;
+};
+
+class TaskRuntime {
+public:
+    static constexpr size_t FRAME_QUEUE_DEPTH = 2;
+    static constexpr size_t DETECTION_QUEUE_DEPTH = 4;
+
+private:
+    RuntimeHooks hooks;
+    RuntimeConfig config;
+
+    SpscQueue<RuntimeFrame, FRAME_QUEUE_DEPTH> frameQueue;
+    SpscQueue<RuntimeDetection, DETECTION_QUEUE_DEPTH> detectionQueue;
+    RtSignal frameReady;
+
+    RtTaskHandle captureHandle;
+    RtTaskHandle inferenceHandle;
+    RtTaskHandle uiHandle;
+
+    std::atomic<bool> running;
+    std::atomic<bool> captureEnabled;
+    std::atomic<int> activeTasks;
+    // Raised while a task is touching its hardware or holding a frame
+    std::atomic<bool> capturing;
+    std::atomic<bool> inferring;
+
+    // Counters (each written by a single task)
+    std::atomic<unsigned long> framesCaptured;
+    std::atomic<unsigned long> captureFailures;
+    std::atomic<unsigned long> framesInferred;
+    std::atomic<unsigned long> detectionsHandled;
+    std::atomic<uint32_t> maxCaptureUs;
+    std::atomic<uint32_t> maxInferenceUs;
+    std::atomic<uint32_t> maxEndToEndUs;
+    std::atomic<uint64_t> totalEndToEndUs;
+
+    static void updateMax(std::atomic<uint32_t>& slot, uint32_t value) {
+        if (value > slot.load(std::memory_order_relaxed)) {
+            slot.store(value, std::memory_order_relaxed);
+        }
+    }
+
+    void captureLoop() {
+        uint32_t seq = 0;
+        uint32_t nextCaptureMs = rtMillis();
+        bool idle = false;
+        TRACE_NAME_TASK("capture");
+
+        while (running.load()) {
+            // Raised before captureEnabled is read, so a UI task that pauses
+            // capture and then finds isIdle() true cannot miss a capture
+            // that was just starting
+            capturing = true;
+            bool enabled = captureEnabled.load();
+            if (enabled == idle && hooks.captureIdle) {
+                idle = !enabled;
+                hooks.captureIdle(hooks.context, idle);
+            }
+
+            uint32_t now = rtMillis();
+            if (!enabled || (int32_t)(now - nextCaptureMs) < 0) {
+                capturing = false;
+                rtSleepMs(10);
+                continue;
+            }
+            nextCaptureMs = now + config.captureIntervalMs;
+
+            RuntimeFrame frame;
+            frame.seq = seq++;
+            frame.sampleCount = 0;
+            frame.featureCount = 0;
+            frame.captureStartUs = rtMicros();
+            if (!hooks.capture(hooks.context, frame)) {
+                captureFailures++;
+                PipelineMetrics::instance().countCaptureFailure();
+                capturing = false;
+                continue;
+            }
+            frame.captureEndUs = rtMicros();
+            updateMax(maxCaptureUs, frame.captureEndUs - frame.captureStartUs);
+            framesCaptured++;
+
+            // A full queue means inference is behind; the frame is dropped
+            // (and counted) rather than queued behind stale ones
+            if (frameQueue.push(frame)) {
+                frameReady.notify();
+            } else {
+                TRACE_INSTANT(TRACE_FRAME_DROPPED, frame.seq);
+                PipelineMetrics::instance().countDroppedFrame();
+            }
+            capturing = false;
+        }
+        capturing = false;
+    }
+
+    void inferenceLoop() {
+        RuntimeFrame frame;
+        TRACE_NAME_TASK("inference");
+        while (running.load()) {
+            if (frameQueue.empty()) {
+                frameReady.wait(50);
+                continue;
+            }
+            // Raised before the pop so the frame is never invisible to
+            // isIdle() between the queue and this task
+            inferring = true;
+            frameQueue.pop(frame);
+
+            RuntimeDetection detection;
+            detection.seq = frame.seq;
+            detection.captureStartUs = frame.captureStartUs;
+            detection.inferenceStartUs = rtMicros();
+            detection.fingers = hooks.classify(hooks.context, frame);
+            detection.inferenceEndUs = rtMicros();
+            updateMax(maxInferenceUs, detection.inferenceEndUs - detection.inferenceStartUs);
+            framesInferred++;
+            PipelineMetrics::instance().observe(METRICS_STAGE_INFERENCE,
+                                                detection.inferenceEndUs - detection.inferenceStartUs);
+            PipelineMetrics::instance().countInference();
+
+            if (detection.fingers >= 0) {
+                detectionQueue.push(detection);
+            }
+            inferring = false;
+        }
+    }
+
+    void uiLoop() {
+        RuntimeDetection detection;
+        TRACE_NAME_TASK("ui");
+        while (running.load()) {
+            while (detectionQueue.pop(detection)) {
+                TRACE_BEGIN(TRACE_DETECTION);
+                hooks.onDetection(hooks.context, detection);
+                TRACE_END_ARG(TRACE_DETECTION, detection.seq);
+                uint32_t endToEnd = rtMicros() - detection.captureStartUs;
+                updateMax(maxEndToEndUs, endToEnd);
+                totalEndToEndUs += endToEnd;
+                detectionsHandled++;
+            }
+            if (hooks.uiTick) {
+                hooks.uiTick(hooks.context);
+            }
+            rtSleepMs(config.uiTickMs);
+        }
+    }
+
+    static void captureEntry(void* arg) {
+        TaskRuntime* self = static_cast<TaskRuntime*>(arg);
+        self->captureLoop();
+        self->activeTasks--;
+    }
+
+    static void inferenceEntry(void* arg) {
+        TaskRuntime* self = static_cast<TaskRuntime*>(arg);
+        self->inferenceLoop();
+        self->activeTasks--;
+    }
+
+    static void uiEntry(void* arg) {
+        TaskRuntime* self = static_cast<TaskRuntime*>(arg);
+        self->uiLoop();
+        self->activeTasks--;
+    }
+
+public:
+    TaskRuntime() : captureHandle(nullptr), inferenceHandle(nullptr), uiHandle(nullptr),
+                    running(false), captureEnabled(true), activeTasks(0),
+                    capturing(false), inferring(false) {
+        config.captureIntervalMs = 1000;
+        config.uiTickMs = 20;
+        // Arduino loop() and the Wi-Fi stack live on core 1/core 0 respectively;
+        // inference gets core 0 to itself between radio bursts
+        config.captureCore = 1;
+        config.inferenceCore = 0;
+        config.uiCore = 1;
+        config.captureStack = 4096;
+        config.inferenceStack = 8192;
+        config.uiStack = 4096;
+        resetStats();
+    }
+
+    RuntimeConfig& getConfig() { return config; }
+
+    bool start(const RuntimeHooks& runtimeHooks) {
+        if (running.load()) return false;
+        hooks = runtimeHooks;
+        running = true;
+        activeTasks = 3;
+
+        bool ok = rtStartTask(&TaskRuntime::captureEntry, this, "capture",
+                              config.captureStack, 2, config.captureCore, &captureHandle);
+        ok = ok && rtStartTask(&TaskRuntime::inferenceEntry, this, "inference",
+                               config.inferenceStack, 2, config.inferenceCore, &inferenceHandle);
+        ok = ok && rtStartTask(&TaskRuntime::uiEntry, this, "ui",
+                               config.uiStack, 1, config.uiCore, &uiHandle);
+        if (!ok) {
+            RT_LOG("Task runtime: failed to start tasks\n");
+            stop();
+        }
+        return ok;
+    }
+
+    // Ask all tasks to finish and wait until they have; afterwards start()
+    // can run a fresh task set without overlapping the old one
+    void stop() {
+        running = false;
+        frameReady.notify();
+        rtJoinTask(captureHandle);
+        rtJoinTask(inferenceHandle);
+        rtJoinTask(uiHandle);
+    }
+
+    bool isRunning() const { return running.load(); }
+    int getActiveTasks() const { return activeTasks.load(); }
+
+    // Called from the UI side to pause capture outside STATE_WAITING
+    void setCaptureEnabled(bool enabled) { captureEnabled = enabled; }
+
+    // No capture or SPI transfer in progress, no frame queued or being
+    // classified and no detection waiting for the UI: nothing would be cut
+    // off by light sleep. Read in pipeline order, so a frame moving from one
+    // stage to the next is always seen in one of them.
+    bool isIdle() const {
+        return !capturing.load() && frameQueue.empty() && !inferring.load() && detectionQueue.empty();
+    }
+
+    void resetStats() {
+        framesCaptured = 0;
+        captureFailures = 0;
+        framesInferred = 0;
+        detectionsHandled = 0;
+        maxCaptureUs = 0;
+        maxInferenceUs = 0;
+        maxEndToEndUs = 0;
+        totalEndToEndUs = 0;
+    }
+
+    unsigned long getFramesCaptured() const { return framesCaptured.load(); }
+    unsigned long getFramesInferred() const { return framesInferred.load(); }
+    unsigned long getDetectionsHandled() const { return detectionsHandled.load(); }
+    unsigned long getDroppedFrames() const { return frameQueue.getDropped(); }
+    unsigned long getDroppedDetections() const { return detectionQueue.getDropped(); }
+
+    void printStats() {
+        unsigned long handled = detectionsHandled.load();
+        RT_LOG("=== Task Runtime Stats ===\n");
+        RT_LOG("Frames: captured=%lu failed=%lu inferred=%lu dropped=%lu\n",
+               framesCaptured.load(), captureFailures.load(), framesInferred.load(),
+               frameQueue.getDropped());
+        RT_LOG("Detections: handled=%lu dropped=%lu\n", handled, detectionQueue.getDropped());
+        RT_LOG("Max capture %lu us, max inference %lu us\n",
+               (unsigned long)maxCaptureUs.load(), (unsigned long)maxInferenceUs.load());
+        if (handled > 0) {
+            RT_LOG("End-to-end: avg %lu us, max %lu us\n",
+                   (unsigned long)(totalEndToEndUs.load() / handled),
+                   (unsigned long)maxEndToEndUs.load());
+        }
+        RT_LOG("==========================\n");
+    }
+};
+
+#endif
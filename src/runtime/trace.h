@@ -0,0 +1,170 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include <atomic>
+#include "rt_platform.h"
+#include "../config_pins.h"
+
+// Per-stage tracing for end-to-end latency. Instrumented code records begin/
+// end/instant events into a fixed ring (newest TRACE_CAPACITY events win);
+// recording is one atomic increment and a 12-byte store, with timestamps
+// from the Edge Impulse porting clock so they line up with the SDK's own
+// timing. dump() prints the ring as TRACE lines on the serial log, and
+// tools/trace_to_chrome.py turns a captured log into Chrome trace JSON
+// (chrome://tracing, Perfetto).
+//
+// With ENABLE_TRACE 0 (config_pins.h) every TRACE_* macro compiles to nothing.
+
+#define TRACE_CAPACITY 512      // Power of two
+#define TRACE_MAX_TASKS 8
+
+// Provided by the Edge Impulse porting layer (micros() on the device)
+uint64_t ei_read_timer_us();
+
+enum TraceStage {
+    TRACE_CAPTURE,          // Sensor exposure until CAP_DONE
+    TRACE_FIFO_READ,        // SPI burst out of the ArduCAM FIFO
+    TRACE_FEATURES,         // 20-feature extraction
+    TRACE_ANALYZE,          // Heuristic finger count from FIFO samples
+    TRACE_CLASSIFY,         // run_classifier()
+    TRACE_EI_DSP,           // Instant: SDK-reported DSP time (arg = us)
+    TRACE_EI_NN,            // Instant: SDK-reported network time (arg = us)
+    TRACE_SMOOTHING,        // Probability smoother / temporal fusion
+    TRACE_FRAME_DROPPED,    // Instant: runtime queue full (arg = seq)
+    TRACE_DETECTION,        // UI task handling a detection (arg = seq)
+    TRACE_STATE_EVENT,      // State machine event (arg = TimerEvent)
+    TRACE_DISPLAY_SUBMIT,   // Framebuffer handed to the flusher / renderer
+    TRACE_DISPLAY_FLUSH,    // Dirty-region I2C transfer (end arg = bytes)
+    TRACE_STAGE_COUNT
+};
+
+struct TraceEvent {
+    uint32_t timestampUs;
+    uint16_t task;          // Folded rtCurrentTaskId()
+    uint8_t stage;
+    char phase;             // 'B', 'E' or 'I'
+    int32_t arg;
+};
+
+class TraceBuffer {
+private:
+    TraceEvent events[TRACE_CAPACITY];
+    std::atomic<uint32_t> head;         // Total events ever recorded
+    std::atomic<bool> enabled;
+
+    struct TaskName {
+        uint16_t task;
+        const char* name;
+    };
+    TaskName taskNames[TRACE_MAX_TASKS];
+    std::atomic<int> taskCount;
+
+    static uint16_t foldTask(uint32_t id) {
+        return (uint16_t)(id ^ (id >> 16));
+    }
+
+public:
+    TraceBuffer() : head(0), enabled(true), taskCount(0) {}
+
+    static TraceBuffer& instance() {
+        static TraceBuffer buffer;
+        return buffer;
+    }
+
+    static const char* stageName(int stage) {
+        static const char* const names[TRACE_STAGE_COUNT] = {
+            "capture", "fifo_read", "features", "analyze", "classify",
+            "ei_dsp", "ei_nn", "smoothing", "frame_dropped", "detection",
+            "state_event", "display_submit", "display_flush"
+        };
+        return stage >= 0 && stage < TRACE_STAGE_COUNT ? names[stage] : "?";
+    }
+
+    void record(TraceStage stage, char phase, int32_t arg = 0) {
+        if (!enabled.load(std::memory_order_relaxed)) return;
+        uint32_t index = head.fetch_add(1, std::memory_order_relaxed);
+        TraceEvent& event = events[index & (TRACE_CAPACITY - 1)];
+        event.timestampUs = (uint32_t)ei_read_timer_us();
+        event.task = foldTask(rtCurrentTaskId());
+        event.stage = (uint8_t)stage;
+        event.phase = phase;
+        event.arg = arg;
+    }
+
+    // Label the calling task in dumps; name must outlive the buffer
+    void nameCurrentTask(const char* name) {
+        int slot = taskCount.fetch_add(1);
+        if (slot >= TRACE_MAX_TASKS) return;
+        taskNames[slot].task = foldTask(rtCurrentTaskId());
+        taskNames[slot].name = name;
+    }
+
+    void setEnabled(bool on) { enabled = on; }
+
+    uint32_t getRecorded() const { return head.load(); }
+
+    // Print the ring oldest-first. Recording is paused meanwhile so the
+    // snapshot is consistent; events from other tasks during the dump are lost.
+    void dump() {
+        bool wasEnabled = enabled.exchange(false);
+        uint32_t end = head.load();
+        uint32_t count = end < TRACE_CAPACITY ? end : TRACE_CAPACITY;
+
+        RT_LOG("TRACE_DUMP,%lu,%lu\n", (unsigned long)count, (unsigned long)(end - count));
+        for (int s = 0; s < TRACE_STAGE_COUNT; s++) {
+            RT_LOG("TRACE_STAGE,%d,%s\n", s, stageName(s));
+        }
+        int tasks = taskCount.load() < TRACE_MAX_TASKS ? taskCount.load() : TRACE_MAX_TASKS;
+        for (int t = 0; t < tasks; t++) {
+            RT_LOG("TRACE_TASK,%u,%s\n", taskNames[t].task, taskNames[t].name);
+        }
+        for (uint32_t i = end - count; i != end; i++) {
+            const TraceEvent& event = events[i & (TRACE_CAPACITY - 1)];
+            RT_LOG("TRACE,%lu,%c,%u,%u,%ld\n", (unsigned long)event.timestampUs, event.phase,
+                   event.stage, event.task, (long)event.arg);
+        }
+        RT_LOG("TRACE_DUMP_END\n");
+
+        enabled = wasEnabled;
+    }
+};
+
+// Begin on construction, end on scope exit
+class TraceScope {
+private:
+    TraceStage stage;
+
+public:
+    TraceScope(TraceStage traceStage, int32_t arg = 0) : stage(traceStage) {
+        TraceBuffer::instance().record(stage, 'B', arg);
+    }
+    ~TraceScope() {
+        TraceBuffer::instance().record(stage, 'E');
+    }
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+
+#if ENABLE_TRACE
+#define TRACE_BEGIN(stage)              TraceBuffer::instance().record(stage, 'B')
+#define TRACE_END(stage)                TraceBuffer::instance().record(stage, 'E')
+#define TRACE_END_ARG(stage, arg)       TraceBuffer::instance().record(stage, 'E', (int32_t)(arg))
+#define TRACE_INSTANT(stage, arg)       TraceBuffer::instance().record(stage, 'I', (int32_t)(arg))
+#define TRACE_SCOPE(stage)              TraceScope TRACE_CONCAT(traceScope_, __LINE__)(stage)
+#define TRACE_SCOPE_ARG(stage, arg)     TraceScope TRACE_CONCAT(traceScope_, __LINE__)(stage, (int32_t)(arg))
+#define TRACE_NAME_TASK(name)           TraceBuffer::instance().nameCurrentTask(name)
+#define TRACE_DUMP()                    TraceBuffer::instance().dump()
+#else
+#define TRACE_BEGIN(stage)              do {} while (0)
+#define TRACE_END(stage)                do {} while (0)
+#define TRACE_END_ARG(stage, arg)       do {} while (0)
+#define TRACE_INSTANT(stage, arg)       do {} while (0)
+#define TRACE_SCOPE(stage)              do {} while (0)
+#define TRACE_SCOPE_ARG(stage, arg)     do {} while (0)
+#define TRACE_NAME_TASK(name)           do {} while (0)
+#define TRACE_DUMP()                    do {} while (0)
+#endif
+
+#endif
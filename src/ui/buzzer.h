@@ -2,62 +2,232 @@
 #define BUZZER_H
 
 #include <Arduino.h>
+#include <atomic>
 #include "../config_pins.h"
+#include "../runtime/spsc_queue.h"
+
+#ifdef ARDUINO
+#include <esp_timer.h>
+#endif
+
+// Tone patterns are queued as note/duration steps and played back by
+// advance(), so beep()/beepPattern()/alarmPattern() return immediately. On
+// the ESP32 a periodic esp_timer calls advance() every BUZZER_TICK_MS while
+// there is something to play and is stopped once the queue drains; on a host
+// build update(nowMs) is driven by hand with a fake clock. The queue is SPSC:
+// the caller's task produces steps, the tick consumes them. Busy state is
+// derived from the queue and the consumer's active step, so each piece of
+// state has exactly one writer.
+
+#define BUZZER_TICK_MS  5
+#define BUZZER_TONE_HZ  2700
+
+struct ToneStep {
+    uint16_t frequency;    // 0 = silence
+    uint16_t durationMs;
+};
 
 class BuzzerControl {
+public:
+    static constexpr size_t QUEUE_DEPTH = 32;
+
 private:
-    unsigned long lastBeepTime;
-    int beepCount;
-    bool isBeeping;
-    
+    SpscQueue<ToneStep, QUEUE_DEPTH> steps;
+    std::atomic<bool> flushRequested;
+    // Set by whoever starts the tick timer, cleared by the tick that stops it
+    std::atomic<bool> ticking;
+
+    // Consumer-side playback state
+    ToneStep current;
+    unsigned long stepEndMs;
+    std::atomic<bool> stepActive;     // Read by isBusy() on the producer side
+    uint16_t outputFrequency;
+
+    bool timerDriven;
+#ifdef ARDUINO
+    esp_timer_handle_t tickTimer;
+
+    static void onTick(void* arg) {
+        static_cast<BuzzerControl*>(arg)->advance(millis());
+    }
+#endif
+
+    void startTicking() {
+        if (ticking.exchange(true)) return;
+#ifdef ARDUINO
+        if (timerDriven) {
+            esp_timer_start_periodic(tickTimer, BUZZER_TICK_MS * 1000);
+        }
+#endif
+    }
+
+    // Consumer side, once nothing is left to play. The timer is stopped
+    // before the flag drops, so a producer that sees the flag down can start
+    // it again safely; a step queued just before the flag dropped is caught
+    // by the re-check.
+    void stopTicking() {
+#ifdef ARDUINO
+        if (timerDriven) {
+            esp_timer_stop(tickTimer);
+        }
+#endif
+        ticking = false;
+        if (!steps.empty()) {
+            startTicking();
+        }
+    }
+
+    void setOutput(uint16_t frequency) {
+        if (frequency == outputFrequency) return;
+        outputFrequency = frequency;
+#if defined(ARDUINO) && defined(BUZZER_LEDC_CHANNEL)
+        ledcWriteTone(BUZZER_LEDC_CHANNEL, frequency);
+#else
+        digitalWrite(BUZZER_PIN, frequency > 0 ? HIGH : LOW);
+#endif
+    }
+
+    // Play out every step that has ended by nowMs. Steps are chained from the
+    // previous step's end time rather than from nowMs, so a late tick does not
+    // stretch the pattern.
+    void advance(unsigned long nowMs) {
+        if (flushRequested.exchange(false)) {
+            ToneStep discard;
+            while (steps.pop(discard)) {}
+            stepActive = false;
+        }
+
+        while (true) {
+            bool active = stepActive.load();
+            if (active && (long)(nowMs - stepEndMs) < 0) {
+                break;
+            }
+            unsigned long start = active ? stepEndMs : nowMs;
+            if (steps.empty()) {
+                stepActive = false;
+                break;
+            }
+            // Marked active before the pop, so isBusy() never sees an empty
+            // queue and no active step while a step is being taken
+            stepActive = true;
+            steps.pop(current);
+            stepEndMs = start + current.durationMs;
+        }
+
+        setOutput(stepActive.load() ? current.frequency : 0);
+        if (!stepActive.load()) {
+            stopTicking();
+        }
+    }
+
+    void queueTone(uint16_t frequency, uint16_t durationMs) {
+        if (durationMs == 0) return;
+        ToneStep step = { frequency, durationMs };
+        if (steps.push(step)) {
+            startTicking();
+        }
+    }
+
 public:
-    BuzzerControl() {
-        lastBeepTime = 0;
-        beepCount = 0;
-        isBeeping = false;
+    BuzzerControl() : flushRequested(false), ticking(false), stepActive(false) {
+        current.frequency = 0;
+        current.durationMs = 0;
+        stepEndMs = 0;
+        outputFrequency = 0;
+        timerDriven = false;
+#ifdef ARDUINO
+        tickTimer = nullptr;
+#endif
     }
-    
+
     void init() {
+#if defined(ARDUINO) && defined(BUZZER_LEDC_CHANNEL)
+        ledcSetup(BUZZER_LEDC_CHANNEL, BUZZER_TONE_HZ, 8);
+        ledcAttachPin(BUZZER_PIN, BUZZER_LEDC_CHANNEL);
+        ledcWriteTone(BUZZER_LEDC_CHANNEL, 0);
+#else
         pinMode(BUZZER_PIN, OUTPUT);
         digitalWrite(BUZZER_PIN, LOW);
+#endif
+
+#ifdef ARDUINO
+        esp_timer_create_args_t args = {};
+        args.callback = &BuzzerControl::onTick;
+        args.arg = this;
+        args.name = "buzzer";
+        // Started by the first queued step, not here: an idle buzzer costs no
+        // wake-ups
+        if (esp_timer_create(&args, &tickTimer) == ESP_OK) {
+            timerDriven = true;
+        } else {
+            Serial.println("Buzzer timer unavailable, falling back to update()");
+        }
+#endif
         Serial.println("Buzzer initialized");
     }
-    
+
+    void tone(uint16_t frequency, uint16_t durationMs) {
+        queueTone(frequency, durationMs);
+    }
+
+    void rest(uint16_t durationMs) {
+        queueTone(0, durationMs);
+    }
+
     void beep(int duration = 100) {
-        digitalWrite(BUZZER_PIN, HIGH);
-        delay(duration);
-        digitalWrite(BUZZER_PIN, LOW);
+        tone(BUZZER_TONE_HZ, duration);
     }
-    
+
     void beepPattern(int count, int duration = 100, int interval = 150) {
         for (int i = 0; i < count; i++) {
-            digitalWrite(BUZZER_PIN, HIGH);
-            delay(duration);
-            digitalWrite(BUZZER_PIN, LOW);
+            tone(BUZZER_TONE_HZ, duration);
             if (i < count - 1) {
-                delay(interval);
+                rest(interval);
             }
         }
     }
-    
+
     void alarmPattern() {
         // Alarm pattern: 3 long beeps
         for (int i = 0; i < 3; i++) {
-            digitalWrite(BUZZER_PIN, HIGH);
-            delay(500);
-            digitalWrite(BUZZER_PIN, LOW);
-            delay(200);
+            tone(BUZZER_TONE_HZ, 500);
+            rest(200);
         }
     }
-    
+
+    // Advance playback from the main loop / UI task. A no-op while the
+    // hardware timer drives the sequencer (it is the only consumer then).
     void update() {
-        // For future non-blocking beep implementations
+        if (!timerDriven) {
+            advance(millis());
+        }
+    }
+
+    // Explicit-clock variant for host runs against a fake clock
+    void update(unsigned long nowMs) {
+        if (!timerDriven) {
+            advance(nowMs);
+        }
     }
-    
+
+    // True while a pattern is queued or sounding
+    bool isBusy() const { return stepActive.load() || !steps.empty(); }
+
+    // True while the tick timer runs (on the host: while update() has work)
+    bool isTicking() const { return ticking.load(); }
+
+    unsigned long getDroppedSteps() const { return steps.getDropped(); }
+
+    // Silence and discard anything queued; takes effect on the next tick
     void stop() {
-        digitalWrite(BUZZER_PIN, LOW);
-        isBeeping = false;
+        flushRequested = true;
+        if (timerDriven) {
+            // The flush needs a tick even if the timer had already stopped
+            startTicking();
+        } else {
+            advance(millis());
+        }
     }
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -4,16 +4,38 @@
 #include <Adafruit_GFX.h>
 #include <Adafruit_SSD1306.h>
 #include "../config_pins.h"
+#include "oled_renderer.h"
+#include "oled_async_flush.h"
 
 class OLEDDisplay {
 private:
     Adafruit_SSD1306 display;
+    SSD1306I2CBackend panel;
+    OledRenderer renderer;
+    AsyncOledFlusher flusher;
+    
+    // Last countdown drawn, so an unchanged frame is not re-rendered
+    int lastCountdownTotal;
+    int lastCountdownRemaining;
+    int lastCountdownOthers;
+    bool lastCountdownDetecting;
     
 public:
-    OLEDDisplay() : display(OLED_WIDTH, OLED_HEIGHT, &Wire, -1) {}
+    OLEDDisplay() : display(OLED_WIDTH, OLED_HEIGHT, &Wire, -1), panel(&Wire, OLED_ADDRESS), renderer(&panel), flusher(&renderer) {
+        lastCountdownTotal = -1;
+        lastCountdownRemaining = -1;
+        lastCountdownOthers = 0;
+        lastCountdownDetecting = false;
+    }
     
     bool init() {
-        if(!display.begin(SSD1306_SWITCHCAPVCC, OLED_ADDRESS)) {
+        bool started;
+        {
+            // begin() sends the init sequence and pushes a frame itself
+            I2cBusLock bus;
+            started = display.begin(SSD1306_SWITCHCAPVCC, OLED_ADDRESS);
+        }
+        if(!started) {
             Serial.println("SSD1306 allocation failed");
             return false;
         }
@@ -23,7 +45,8 @@ public:
         display.setTextColor(SSD1306_WHITE);
         display.setCursor(0, 0);
         display.println("Initializing...");
-        display.display();
+        renderer.invalidate();
+        update();
         
         Serial.println("OLED initialized");
         return true;
@@ -31,6 +54,7 @@ public:
     
     void clear() {
         display.clearDisplay();
+        lastCountdownRemaining = -1;
     }
     
     void showMessage(const char* title, const char* message = "") {
@@ -113,15 +137,31 @@ public:
         update();
     }
     
-    void showCountdown(int totalSeconds, int remaining) {
+    // otherTimers: further countdowns running behind the one shown;
+    // detecting: a gesture may add another timer right now
+    void showCountdown(int totalSeconds, int remaining, int otherTimers = 0,
+                       bool detecting = false) {
+        if (totalSeconds == lastCountdownTotal && remaining == lastCountdownRemaining &&
+            otherTimers == lastCountdownOthers && detecting == lastCountdownDetecting) {
+            return;   // Called every update(); nothing changed since last frame
+        }
         clear();
+        lastCountdownTotal = totalSeconds;
+        lastCountdownRemaining = remaining;
+        lastCountdownOthers = otherTimers;
+        lastCountdownDetecting = detecting;
         
         int minutes = remaining / 60;
         int seconds = remaining % 60;
         
         display.setTextSize(1);
         display.setCursor(0, 0);
-        display.println("Timer Running");
+        display.println(detecting ? "Show fingers now" : "Timer Running");
+        if (otherTimers > 0) {
+            display.setCursor(OLED_WIDTH - 18, 0);
+            display.print("+");
+            display.print(otherTimers);
+        }
         
         display.setTextSize(3);
         display.setCursor(10, 20);
@@ -151,9 +191,30 @@ public:
         update();
     }
     
+    // Move I2C transfers to a background task; update() then only copies the
+    // framebuffer. Call after init().
+    bool startAsyncFlush(int core = 0) {
+        return flusher.start(core);
+    }
+    
+    // Push only what changed since the last frame to the panel
     void update() {
-        display.display();
+        TRACE_SCOPE(TRACE_DISPLAY_SUBMIT);
+        if (flusher.isRunning()) {
+            flusher.submit(display.getBuffer());
+        } else {
+            renderer.flush(display.getBuffer(), millis());
+        }
     }
+    
+    // Resend the whole frame, e.g. after the panel was power-cycled
+    void refresh() {
+        renderer.invalidate();
+        update();
+    }
+    
+    OledRenderer& getRenderer() { return renderer; }
+    AsyncOledFlusher& getFlusher() { return flusher; }
 };
 
 #endif
\ No newline at end of file
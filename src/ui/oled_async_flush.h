@@ -0,0 +1,142 @@
+#ifndef OLED_ASYNC_FLUSH_H
+#define OLED_ASYNC_FLUSH_H
+
+#include <string.h>
+#include <atomic>
+#include "oled_renderer.h"
+#include "../runtime/rt_platform.h"
+#include "../runtime/trace.h"
+
+// Moves the I2C transfer off the caller. submit() copies the freshly drawn
+// framebuffer into the pending slot and returns; a background task swaps the
+// pending and sending slots and runs the dirty-region flush from the sending
+// one. Frames submitted faster than the bus can take them coalesce: only the
+// newest pending frame is ever sent.
+class AsyncOledFlusher {
+private:
+    OledRenderer* renderer;
+
+    uint8_t slots[2][OLED_FRAME_BYTES];
+    uint8_t* pending;          // Last submitted frame (producer writes)
+    uint8_t* sending;          // Frame the flush task is transmitting
+    bool pendingDirty;         // Guarded by lock
+    RtMutex lock;
+    RtSignal frameReady;
+
+    RtTaskHandle task;
+    std::atomic<bool> running;
+    std::atomic<bool> flushing;
+
+    // Stats
+    std::atomic<unsigned long> submitted;
+    std::atomic<unsigned long> coalesced;
+    std::atomic<unsigned long> flushed;
+    std::atomic<uint32_t> maxSubmitUs;
+    std::atomic<uint32_t> maxFlushUs;
+    std::atomic<uint64_t> totalFlushUs;
+
+    void flushLoop() {
+        TRACE_NAME_TASK("oled");
+        while (running.load()) {
+            frameReady.wait(100);
+
+            lock.lock();
+            bool haveFrame = pendingDirty;
+            if (haveFrame) {
+                uint8_t* swap = sending;
+                sending = pending;
+                pending = swap;
+                pendingDirty = false;
+                flushing = true;
+            }
+            lock.unlock();
+            if (!haveFrame) continue;
+
+            uint32_t start = rtMicros();
+            renderer->flush(sending, rtMillis());
+            uint32_t elapsed = rtMicros() - start;
+            if (elapsed > maxFlushUs.load()) maxFlushUs = elapsed;
+            totalFlushUs += elapsed;
+            flushed++;
+            flushing = false;
+        }
+    }
+
+    static void taskEntry(void* arg) {
+        static_cast<AsyncOledFlusher*>(arg)->flushLoop();
+    }
+
+public:
+    AsyncOledFlusher(OledRenderer* target) : renderer(target), task(nullptr), running(false), flushing(false) {
+        memset(slots, 0, sizeof(slots));
+        pending = slots[0];
+        sending = slots[1];
+        pendingDirty = false;
+        resetStats();
+    }
+
+    bool start(int core = 0, int priority = 1) {
+        if (running.load()) return true;
+        running = true;
+        if (!rtStartTask(&AsyncOledFlusher::taskEntry, this, "oled_flush", 3072, priority, core, &task)) {
+            running = false;
+            return false;
+        }
+        return true;
+    }
+
+    void stop() {
+        running = false;
+        frameReady.notify();
+        rtJoinTask(task);
+    }
+
+    bool isRunning() const { return running.load(); }
+
+    // True while a frame is waiting or on the bus
+    bool isBusy() {
+        lock.lock();
+        bool busy = pendingDirty || flushing.load();
+        lock.unlock();
+        return busy;
+    }
+
+    // Hand a frame to the flush task; only the memcpy happens on the caller
+    void submit(const uint8_t* framebuffer) {
+        uint32_t start = rtMicros();
+
+        lock.lock();
+        memcpy(pending, framebuffer, OLED_FRAME_BYTES);
+        if (pendingDirty) coalesced++;
+        pendingDirty = true;
+        lock.unlock();
+        frameReady.notify();
+
+        submitted++;
+        uint32_t elapsed = rtMicros() - start;
+        if (elapsed > maxSubmitUs.load()) maxSubmitUs = elapsed;
+    }
+
+    void resetStats() {
+        submitted = 0;
+        coalesced = 0;
+        flushed = 0;
+        maxSubmitUs = 0;
+        maxFlushUs = 0;
+        totalFlushUs = 0;
+    }
+
+    unsigned long getSubmitted() const { return submitted.load(); }
+    unsigned long getCoalesced() const { return coalesced.load(); }
+    unsigned long getFlushed() const { return flushed.load(); }
+
+    void printStats() {
+        unsigned long count = flushed.load();
+        RT_LOG("OLED async: %lu submitted, %lu coalesced, %lu flushed, max submit %lu us, flush avg %lu / max %lu us\n",
+               submitted.load(), coalesced.load(), count, (unsigned long)maxSubmitUs.load(),
+               count > 0 ? (unsigned long)(totalFlushUs.load() / count) : 0UL,
+               (unsigned long)maxFlushUs.load());
+    }
+};
+
+#endif
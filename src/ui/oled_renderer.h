@@ -0,0 +1,214 @@
+#ifndef OLED_RENDERER_H
+#define OLED_RENDERER_H
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <string.h>
+#include <atomic>
+#include "../config_pins.h"
+#include "../runtime/trace.h"
+#include "../runtime/i2c_bus.h"
+
+// Dirty-region flushing for the SSD1306. Adafruit_SSD1306::display() pushes
+// the whole 1 KB framebuffer on every call; the renderer instead keeps a copy
+// of what the panel currently shows, diffs the new framebuffer against it page
+// by page and only transmits the changed column span of each page.
+
+#define OLED_PAGES       (OLED_HEIGHT / 8)
+#define OLED_FRAME_BYTES (OLED_WIDTH * OLED_PAGES)
+
+// Where flushed regions go: the panel over I2C, or a framebuffer on the host
+class OledBackend {
+public:
+    virtual ~OledBackend() {}
+    virtual void beginFlush() {}
+    virtual void endFlush() {}
+    // Write columns [colStart, colEnd] of one page; returns bytes put on the bus
+    virtual size_t writeRegion(int page, int colStart, int colEnd, const uint8_t* data) = 0;
+};
+
+// SSD1306 over I2C using page/column addressing (horizontal mode, as set up
+// by Adafruit_SSD1306::begin)
+class SSD1306I2CBackend : public OledBackend {
+public:
+    static constexpr int CHUNK = 31;   // Wire buffer is 32 bytes incl. control byte
+
+private:
+    TwoWire* wire;
+    uint8_t address;
+
+    size_t sendCommands(const uint8_t* commands, int count) {
+        wire->beginTransmission(address);
+        wire->write((uint8_t)0x00);    // Co = 0, D/C = 0: command stream
+        for (int i = 0; i < count; i++) {
+            wire->write(commands[i]);
+        }
+        wire->endTransmission();
+        return count + 2;
+    }
+
+public:
+    SSD1306I2CBackend(TwoWire* bus = &Wire, uint8_t i2cAddress = OLED_ADDRESS)
+        : wire(bus), address(i2cAddress) {}
+
+    // Same clocking as Adafruit_SSD1306: fast mode while pushing pixels, then
+    // back to 100 kHz for the camera's SCCB on the shared bus. The bus is held
+    // from the first clock change to the last, so the camera never sees 400 kHz.
+    void beginFlush() override {
+        I2cBus::lock();
+        wire->setClock(400000);
+    }
+    void endFlush() override {
+        wire->setClock(100000);
+        I2cBus::unlock();
+    }
+
+    size_t writeRegion(int page, int colStart, int colEnd, const uint8_t* data) override {
+        const uint8_t window[] = {
+            0x22, (uint8_t)page, (uint8_t)page,          // Page address
+            0x21, (uint8_t)colStart, (uint8_t)colEnd     // Column address
+        };
+        size_t bytes = sendCommands(window, sizeof(window));
+
+        int count = colEnd - colStart + 1;
+        for (int offset = 0; offset < count; offset += CHUNK) {
+            int len = count - offset < CHUNK ? count - offset : CHUNK;
+            wire->beginTransmission(address);
+            wire->write((uint8_t)0x40);    // D/C = 1: data stream
+            wire->write(data + offset, len);
+            wire->endTransmission();
+            bytes += len + 2;
+        }
+        return bytes;
+    }
+};
+
+// Host-side stand-in: applies regions to an in-memory copy of the panel and
+// counts bytes as the I2C backend would
+class FramebufferOledBackend : public OledBackend {
+private:
+    uint8_t frame[OLED_FRAME_BYTES];
+    unsigned long regionsWritten;
+
+public:
+    FramebufferOledBackend() : regionsWritten(0) {
+        memset(frame, 0, sizeof(frame));
+    }
+
+    size_t writeRegion(int page, int colStart, int colEnd, const uint8_t* data) override {
+        int count = colEnd - colStart + 1;
+        memcpy(frame + page * OLED_WIDTH + colStart, data, count);
+        regionsWritten++;
+        int chunks = (count + SSD1306I2CBackend::CHUNK - 1) / SSD1306I2CBackend::CHUNK;
+        return 8 + count + chunks * 2;
+    }
+
+    const uint8_t* getFrame() const { return frame; }
+    unsigned long getRegionsWritten() const { return regionsWritten; }
+
+    bool getPixel(int x, int y) const {
+        return (frame[(y / 8) * OLED_WIDTH + x] >> (y & 7)) & 1;
+    }
+};
+
+class OledRenderer {
+private:
+    OledBackend* backend;
+    uint8_t shown[OLED_FRAME_BYTES];   // What the panel currently displays
+    // Set from any task by invalidate(), consumed by the flushing one
+    std::atomic<bool> fullRefresh;
+
+    // Stats
+    unsigned long flushes;
+    unsigned long skippedFlushes;
+    unsigned long totalBytes;
+    unsigned long windowStartMs;
+    unsigned long windowBytes;
+    unsigned long bytesPerSecond;
+
+    void countBytes(size_t bytes, unsigned long nowMs) {
+        totalBytes += bytes;
+        if (nowMs - windowStartMs >= 1000) {
+            // Rate over the window that just closed (0 if it was idle)
+            bytesPerSecond = windowBytes * 1000 / (nowMs - windowStartMs);
+            windowStartMs = nowMs;
+            windowBytes = 0;
+        }
+        windowBytes += bytes;
+    }
+
+public:
+    OledRenderer(OledBackend* output = nullptr) : backend(output) {
+        memset(shown, 0, sizeof(shown));
+        fullRefresh = true;
+        resetStats();
+    }
+
+    void setBackend(OledBackend* output) {
+        backend = output;
+        invalidate();
+    }
+
+    // Force the next flush to resend everything (panel contents unknown)
+    void invalidate() { fullRefresh = true; }
+
+    // Send the parts of framebuffer that differ from what is on the panel.
+    // Returns the number of bytes transmitted.
+    size_t flush(const uint8_t* framebuffer, unsigned long nowMs) {
+        if (!backend || !framebuffer) return 0;
+        TRACE_BEGIN(TRACE_DISPLAY_FLUSH);
+
+        // Taken once up front: an invalidate() during this flush applies to
+        // the next one instead of being cleared unseen
+        bool full = fullRefresh.exchange(false);
+        size_t bytes = 0;
+        bool started = false;
+        for (int page = 0; page < OLED_PAGES; page++) {
+            const uint8_t* next = framebuffer + page * OLED_WIDTH;
+            uint8_t* current = shown + page * OLED_WIDTH;
+
+            int first = 0;
+            int last = OLED_WIDTH - 1;
+            if (!full) {
+                while (first < OLED_WIDTH && next[first] == current[first]) first++;
+                if (first == OLED_WIDTH) continue;   // Page unchanged
+                while (next[last] == current[last]) last--;
+            }
+
+            if (!started) {
+                backend->beginFlush();
+                started = true;
+            }
+            bytes += backend->writeRegion(page, first, last, next + first);
+            memcpy(current + first, next + first, last - first + 1);
+        }
+        if (started) backend->endFlush();
+
+        flushes++;
+        if (bytes == 0) skippedFlushes++;
+        countBytes(bytes, nowMs);
+        TRACE_END_ARG(TRACE_DISPLAY_FLUSH, bytes);
+        return bytes;
+    }
+
+    void resetStats() {
+        flushes = 0;
+        skippedFlushes = 0;
+        totalBytes = 0;
+        windowStartMs = millis();
+        windowBytes = 0;
+        bytesPerSecond = 0;
+    }
+
+    unsigned long getBytesPerSecond() const { return bytesPerSecond; }
+    unsigned long getTotalBytes() const { return totalBytes; }
+    unsigned long getFlushes() const { return flushes; }
+    unsigned long getSkippedFlushes() const { return skippedFlushes; }
+
+    void printStats() {
+        Serial.printf("OLED: %lu flushes (%lu unchanged), %lu bytes total, %lu B/s (full frame %d B)\n",
+                     flushes, skippedFlushes, totalBytes, bytesPerSecond, OLED_FRAME_BYTES);
+    }
+};
+
+#endif
@@ -4,7 +4,13 @@
 #include <WiFi.h>
 #include <ESPAsyncWebServer.h>
 #include <ArduinoJson.h>
+#include <memory>
 #include "web_pages.h"
+#include "sample_store.h"
+#include "sample_log.h"
+#include "mjpeg_stream.h"
+#include "../runtime/heap_telemetry.h"
+#include "../runtime/metrics.h"
 
 // Forward declaration to avoid circular includes
 class ArduCamController;
@@ -13,10 +19,18 @@ class ArduCamController;
 #define WIFI_SSID "BENTEWIFI"        // <-- Change this to your WiFi name
 #define WIFI_PASSWORD "bighouse831" // <-- Change this to your WiFi password
 
+// Prometheus text for /api/metrics; the full exposition is ~6 KB
+#define METRICS_RESPONSE_BYTES 8192
+
+// RAM fallback when the flash log is unavailable:
+// 16 segments x 32 samples = 512 samples (~14 KB) before the oldest are overwritten
+typedef SampleStore<32, 16> DataSampleStore;
+
 class DataCollectionServer {
 private:
     AsyncWebServer server;
     bool serverStarted;
+    bool wifiStarted;       // Radio on, even if the connection failed
     ArduCamController* cameraPtr;
     
 public:
@@ -30,9 +44,11 @@ public:
     bool autoMode;
     int collectionDelay; // ms between samples
     unsigned long lastCollectionTime;
-    String collectedData;
+    DataSampleStore samples;
+    SampleLog sampleLog;       // Persistent copy of the session on flash
+    MjpegStreamHub stream;     // Live view for /api/camera/stream
     
-    DataCollectionServer() : server(80), serverStarted(false) {
+    DataCollectionServer() : server(80), serverStarted(false), wifiStarted(false) {
         isCollecting = false;
         shouldCollect = false;
         currentFingers = 0;
@@ -42,15 +58,53 @@ public:
         autoMode = false;
         collectionDelay = 3000;
         lastCollectionTime = 0;
-        collectedData = "";
         cameraPtr = nullptr;
     }
     
-    bool init(ArduCamController* camera = nullptr) {
+    bool init(ArduCamController* camera = nullptr, const char* logPath = SAMPLE_LOG_PATH) {
         cameraPtr = camera;
+        
+        // Samples from before a reset are still on flash
+        if (sampleLog.begin(logPath)) {
+            totalSamples = sampleLog.size();
+            Serial.printf("Sample log: %lu samples restored (session %d)\n",
+                         (unsigned long)totalSamples, sampleLog.getSession());
+        } else {
+            Serial.println("Sample log unavailable - samples kept in RAM only");
+        }
+        
+        if (!connectWifi()) {
+            return false;
+        }
+        
+        setupRoutes();
+        server.begin();
+        serverStarted = true;
+        
+        return true;
+    }
+    
+    // Timer mode: only the read-only monitoring routes (/api/metrics,
+    // /api/heap, /api/memory). The collection and camera routes stay off,
+    // since the capture task owns the camera. Wi-Fi keeps the CPU out of
+    // light sleep while it is on.
+    bool initMonitoring() {
+        if (!connectWifi()) {
+            return false;
+        }
+        
+        setupMonitoringRoutes();
+        server.begin();
+        serverStarted = true;
+        
+        return true;
+    }
+    
+    bool connectWifi() {
         // Connect to WiFi
         Serial.print("Connecting to WiFi");
         WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+        wifiStarted = true;
         
         int attempts = 0;
         while (WiFi.status() != WL_CONNECTED && attempts < 20) {
@@ -69,13 +123,43 @@ public:
         Serial.print("IP address: ");
         Serial.println(WiFi.localIP());
         
-        setupRoutes();
-        server.begin();
-        serverStarted = true;
-        
         return true;
     }
     
+    void setupMonitoringRoutes() {
+        server.on("/api/memory", HTTP_GET, [this](AsyncWebServerRequest *request){
+            DynamicJsonDocument doc(512);
+            fillMemoryReport(doc);
+            String response;
+            serializeJson(doc, response);
+            request->send(200, "application/json", response);
+        });
+        
+        server.on("/api/heap", HTTP_GET, [this](AsyncWebServerRequest *request){
+            DynamicJsonDocument doc(3072);
+            fillHeapReport(doc);
+            String response;
+            serializeJson(doc, response);
+            request->send(200, "application/json", response);
+        });
+        
+        // Prometheus scrape target
+        server.on("/api/metrics", HTTP_GET, [this](AsyncWebServerRequest *request){
+            char* text = (char*)malloc(METRICS_RESPONSE_BYTES);
+            if (!text) {
+                request->send(503, "text/plain", "Out of memory");
+                return;
+            }
+            MetricsWriter writer(text, METRICS_RESPONSE_BYTES);
+            fillMetrics(writer);
+            if (writer.overflowed()) {
+                Serial.println("Metrics: response truncated, raise METRICS_RESPONSE_BYTES");
+            }
+            request->send(200, "text/plain; version=0.0.4", String(text));
+            free(text);
+        });
+    }
+    
     void setupRoutes() {
         // Serve main page
         server.on("/", HTTP_GET, [this](AsyncWebServerRequest *request){
@@ -92,6 +176,7 @@ public:
             doc["samplesPerFingerCount"] = samplesPerFingerCount;
             doc["autoMode"] = autoMode;
             doc["collectionDelay"] = collectionDelay;
+            doc["storedSamples"] = storedSamples();
             
             String response;
             serializeJson(doc, response);
@@ -102,8 +187,8 @@ public:
             isCollecting = true;
             shouldCollect = true;
             currentSample = 0;
-            totalSamples = 0;
-            collectedData = "";
+            // Stored samples are kept so a session interrupted by a reset can
+            // be resumed; "Clear Data" starts over
             Serial.println("Data collection started via web interface");
             request->send(200, "text/plain", "Collection started");
         });
@@ -139,16 +224,42 @@ public:
             request->send(200, "text/plain", "Settings updated");
         });
         
+        // CSV is generated a chunk at a time from the flash log (or the RAM
+        // store without one), so the response never needs the whole file in RAM
         server.on("/api/data", HTTP_GET, [this](AsyncWebServerRequest *request){
-            request->send(200, "text/plain", collectedData);
+            AsyncWebServerResponse *response;
+            if (sampleLog.isOpen()) {
+                std::shared_ptr<CsvStreamer<SampleLog>> streamer(new CsvStreamer<SampleLog>(&sampleLog));
+                response = request->beginChunkedResponse("text/plain",
+                    [streamer](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+                        size_t written = streamer->fill(buffer, maxLen);
+                        PipelineMetrics::instance().addWifiSentBytes(written);
+                        return written;
+                    });
+            } else {
+                std::shared_ptr<CsvStreamer<DataSampleStore>> streamer(new CsvStreamer<DataSampleStore>(&samples));
+                response = request->beginChunkedResponse("text/plain",
+                    [streamer](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+                        size_t written = streamer->fill(buffer, maxLen);
+                        PipelineMetrics::instance().addWifiSentBytes(written);
+                        return written;
+                    });
+            }
+            response->addHeader("Cache-Control", "no-cache");
+            request->send(response);
         });
         
         server.on("/api/cleardata", HTTP_POST, [this](AsyncWebServerRequest *request){
-            collectedData = "";
+            samples.clear();
+            if (sampleLog.isOpen()) {
+                sampleLog.clear();
+            }
             totalSamples = 0;
             request->send(200, "text/plain", "Data cleared");
         });
         
+        setupMonitoringRoutes();
+        
         // Camera streaming endpoints
         server.on("/api/camera/capture", HTTP_GET, [this](AsyncWebServerRequest *request){
             if (!cameraPtr) {
@@ -176,6 +287,56 @@ public:
                 request->send(500, "text/plain", "Failed to get JPEG data");
             }
         });
+        
+        // Live view: one long response, frames pushed by serviceCameraStream()
+        server.on("/api/camera/stream", HTTP_GET, [this](AsyncWebServerRequest *request){
+            if (!cameraPtr) {
+                request->send(500, "text/plain", "Camera not initialized");
+                return;
+            }
+            if (request->hasParam("fps")) {
+                stream.setTargetFps(request->getParam("fps")->value().toInt());
+            }
+            
+            std::shared_ptr<MjpegClient> client(new MjpegClient(&stream));
+            AsyncWebServerResponse *response = request->beginChunkedResponse(
+                "multipart/x-mixed-replace; boundary=" MJPEG_BOUNDARY,
+                [client](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+                    return client->fill(buffer, maxLen);
+                });
+            response->addHeader("Cache-Control", "no-cache, no-store, must-revalidate");
+            response->addHeader("Access-Control-Allow-Origin", "*");
+            request->send(response);
+        });
+        
+        server.on("/api/camera/stats", HTTP_GET, [this](AsyncWebServerRequest *request){
+            MjpegStats stats = stream.getStats();
+            DynamicJsonDocument doc(256);
+            doc["clients"] = stats.clients;
+            doc["targetFps"] = stats.targetFps;
+            doc["captureFps"] = stats.captureFps;
+            doc["sendFps"] = stats.sendFps;
+            doc["framesCaptured"] = stats.published;
+            doc["framesSent"] = stats.sent;
+            doc["framesDropped"] = stats.dropped;
+            
+            String response;
+            serializeJson(doc, response);
+            request->send(200, "application/json", response);
+        });
+    }
+    
+    // Capture for the live view when a client is connected and the next
+    // frame is due. Runs from loop(), so it never races sample collection
+    // for the camera.
+    void serviceCameraStream() {
+        if (!cameraPtr || !stream.wantsFrame(millis())) return;
+        
+        uint8_t* jpegData = nullptr;
+        size_t jpegSize = 0;
+        if (cameraPtr->captureJPEG(&jpegData, &jpegSize, false)) {
+            stream.publish(jpegData, jpegSize, millis());
+        }
     }
     
     bool getCameraJPEG(uint8_t** jpegData, size_t* jpegSize) {
@@ -191,14 +352,155 @@ public:
     
     
     bool isServerStarted() { return serverStarted; }
+    bool isWifiActive() { return wifiStarted; }
     String getIPAddress() { 
         IPAddress ip = WiFi.localIP();
         return String(ip[0]) + "." + String(ip[1]) + "." + String(ip[2]) + "." + String(ip[3]);
     }
     
-    void addDataSample(const String& sample) {
-        collectedData += sample + "\n";
+    bool addSample(int label, const float* features, int count) {
+        SampleRecord record;
+        encodeSample(record, label, features, count, millis(), sampleLog.getSession());
+        
+        if (sampleLog.isOpen()) {
+            if (!sampleLog.append(record)) {
+                Serial.println("Sample log: write failed or flash full");
+                return false;
+            }
+        } else if (!samples.add(record)) {
+            Serial.println("Sample store: segment allocation failed");
+            return false;
+        }
         totalSamples++;
+        return true;
+    }
+    
+    uint32_t storedSamples() const {
+        return sampleLog.isOpen() ? sampleLog.size() : samples.size();
+    }
+    
+    // Sample store usage and heap high-water marks
+    void fillMemoryReport(DynamicJsonDocument& doc) {
+        SampleStoreStats stats = samples.getStats();
+        doc["storedSamples"] = storedSamples();
+        doc["ramSamples"] = stats.stored;
+        doc["capacity"] = stats.capacity;
+        doc["overwritten"] = stats.overwritten;
+        doc["segments"] = stats.segments;
+        doc["peakSegments"] = stats.peakSegments;
+        doc["storeBytes"] = stats.bytesAllocated;
+        doc["storePeakBytes"] = stats.peakBytes;
+        doc["allocationFailed"] = samples.hadAllocationFailure();
+        SampleLogStats log = sampleLog.getStats();
+        doc["flashLog"] = log.open;
+        doc["flashSamples"] = log.records;
+        doc["flashCapacity"] = log.maxRecords;
+        doc["flashBytes"] = log.fileBytes;
+        doc["tornRecords"] = log.tornRecords;
+        doc["session"] = log.session;
+#ifdef ARDUINO
+        doc["freeHeap"] = ESP.getFreeHeap();
+        doc["minFreeHeap"] = ESP.getMinFreeHeap();
+        doc["largestFreeBlock"] = ESP.getMaxAllocHeap();
+#endif
+    }
+    
+    // Tracked ei_malloc/new allocations (runtime/heap_telemetry.h)
+    void fillHeapReport(DynamicJsonDocument& doc) {
+        HeapTelemetry& telemetry = HeapTelemetry::instance();
+        doc["enabled"] = HeapTelemetry::isEnabled();
+        doc["arenaBytes"] = EI_CLASSIFIER_TFLITE_LARGEST_ARENA_SIZE;
+#ifdef ARDUINO
+        doc["freeHeap"] = ESP.getFreeHeap();
+        doc["minFreeHeap"] = ESP.getMinFreeHeap();
+        doc["largestFreeBlock"] = ESP.getMaxAllocHeap();
+#endif
+        if (!HeapTelemetry::isEnabled()) return;
+        
+        HeapTotals totals = telemetry.getTotals();
+        doc["liveBytes"] = totals.liveBytes;
+        doc["peakBytes"] = totals.peakBytes;
+        doc["untrackedSites"] = totals.untrackedSites;
+        doc["foreignFrees"] = totals.foreignFrees;
+        
+        JsonObject sources = doc.createNestedObject("sources");
+        for (int s = 0; s < HEAP_SOURCE_COUNT; s++) {
+            const HeapCounters& c = totals.sources[s];
+            JsonObject source = sources.createNestedObject(HeapTelemetry::sourceName(s));
+            source["liveBytes"] = c.liveBytes;
+            source["peakBytes"] = c.peakBytes;
+            source["liveBlocks"] = c.liveBlocks;
+            source["allocations"] = c.allocations;
+            source["frees"] = c.frees;
+            source["failures"] = c.failures;
+        }
+        
+        JsonArray sizes = doc.createNestedArray("sizeHistogram");
+        for (int b = 0; b < HEAP_TELEMETRY_SIZE_BUCKETS; b++) {
+            JsonObject bucket = sizes.createNestedObject();
+            bucket["maxBytes"] = HeapTelemetry::sizeBucketLimit(b);    // 0 = larger
+            bucket["count"] = totals.sizeBuckets[b];
+        }
+        
+        HeapSite top[8];
+        int count = telemetry.getTopSites(top, 8);
+        JsonArray sites = doc.createNestedArray("sites");
+        for (int i = 0; i < count; i++) {
+            JsonObject site = sites.createNestedObject();
+            char address[12];
+            snprintf(address, sizeof(address), "0x%08lx", (unsigned long)top[i].address);
+            site["address"] = address;
+            site["source"] = HeapTelemetry::sourceName(top[i].source);
+            site["allocations"] = top[i].allocations;
+            site["frees"] = top[i].frees;
+            site["totalBytes"] = top[i].totalBytes;
+            site["liveBytes"] = top[i].liveBytes;
+            site["largest"] = top[i].largest;
+        }
+    }
+    
+    // Pipeline counters and stage histograms plus the heap and Wi-Fi
+    // figures this server can see
+    void fillMetrics(MetricsWriter& out) {
+        PipelineMetrics::instance().write(out);
+        
+        MjpegStats streamStats = stream.getStats();
+        out.gauge("stream_clients", "Connected live view clients.", streamStats.clients);
+        out.counter("stream_frames_sent_total", "Live view frames sent, summed over clients.", streamStats.sent);
+        out.counter("stream_frames_dropped_total", "Live view frames skipped by slow clients.", streamStats.dropped);
+        out.gauge("stream_send_fps", "Live view frames sent per second over the last window.", streamStats.sendFps);
+        out.gauge("stored_samples", "Training samples stored.", storedSamples());
+#ifdef ARDUINO
+        out.gauge("wifi_rssi_dbm", "Received signal strength.", WiFi.RSSI());
+        out.gauge("heap_free_bytes", "Free heap.", ESP.getFreeHeap());
+        out.gauge("heap_min_free_bytes", "Lowest free heap since boot.", ESP.getMinFreeHeap());
+        out.gauge("heap_largest_free_block_bytes", "Largest allocatable heap block.", ESP.getMaxAllocHeap());
+#endif
+        if (HeapTelemetry::isEnabled()) {
+            HeapTotals totals = HeapTelemetry::instance().getTotals();
+            out.gauge("heap_tracked_live_bytes", "Bytes live in ei_malloc and new blocks.", totals.liveBytes);
+            out.gauge("heap_tracked_peak_bytes", "Peak of the tracked live bytes.", totals.peakBytes);
+        }
+    }
+    
+    void printMemoryReport() {
+        SampleStoreStats stats = samples.getStats();
+        Serial.printf("Samples: %lu/%lu stored, %lu overwritten, %lu segments (peak %lu, %lu bytes)\n",
+                     (unsigned long)stats.stored, (unsigned long)stats.capacity,
+                     (unsigned long)stats.overwritten, (unsigned long)stats.segments,
+                     (unsigned long)stats.peakSegments, (unsigned long)stats.peakBytes);
+        SampleLogStats log = sampleLog.getStats();
+        if (log.open) {
+            Serial.printf("Sample log: %lu/%lu records, %lu bytes on flash, %lu torn, %lu failed writes\n",
+                         (unsigned long)log.records, (unsigned long)log.maxRecords,
+                         (unsigned long)log.fileBytes, (unsigned long)log.tornRecords,
+                         (unsigned long)log.appendFailures);
+        }
+#ifdef ARDUINO
+        Serial.printf("Heap: free %lu, min free %lu, largest block %lu\n",
+                     (unsigned long)ESP.getFreeHeap(), (unsigned long)ESP.getMinFreeHeap(),
+                     (unsigned long)ESP.getMaxAllocHeap());
+#endif
     }
     
     bool shouldTriggerCollection() {
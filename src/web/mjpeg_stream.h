@@ -0,0 +1,242 @@
+#ifndef MJPEG_STREAM_H
+#define MJPEG_STREAM_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <memory>
+#include "../runtime/rt_platform.h"
+#include "../runtime/metrics.h"
+
+// Live camera view as a multipart/x-mixed-replace stream. The capture side
+// (loop() in data collection mode) asks wantsFrame() at its own pace and
+// publish()es JPEGs; the hub only keeps the newest one. Every connected
+// client has an MjpegClient that the web server pulls from whenever its TCP
+// window has room. A client that is still sending an older frame when newer
+// ones arrive simply skips to the latest, so a slow client loses frames
+// instead of building a queue, and nothing is captured while nobody watches.
+//
+// Delivery is pulled, not pushed: ESPAsyncWebServer only calls a filler
+// again on the next ACK or on AsyncTCP's poll (about every 500 ms), and it
+// has no way to wake a response from publish(). Once a client has sent its
+// frame and found nothing newer, the next one goes out at the poll, so the
+// delivered rate is about 2 fps whatever the target. A higher target only
+// helps when a new frame is published while the previous one is still being
+// ACKed; /api/camera/stats reports the achieved sendFps.
+
+#define MJPEG_BOUNDARY "fingertimerframe"
+#define MJPEG_DEFAULT_FPS 5
+#define MJPEG_MAX_FPS 15
+
+// ESPAsyncWebServer: "no data yet, call again" from a response filler
+#ifndef RESPONSE_TRY_AGAIN
+#define RESPONSE_TRY_AGAIN 0xFFFFFFFF
+#endif
+
+struct MjpegFrame {
+    uint8_t* data;             // malloc'd JPEG, owned by the frame
+    size_t length;
+    uint32_t seq;
+    uint32_t capturedMs;
+
+    MjpegFrame(uint8_t* jpeg, size_t len, uint32_t sequence, uint32_t nowMs)
+        : data(jpeg), length(len), seq(sequence), capturedMs(nowMs) {}
+    ~MjpegFrame() { free(data); }
+};
+
+struct MjpegStats {
+    int clients;
+    int targetFps;
+    uint32_t published;
+    uint32_t sent;             // Frames delivered, summed over clients
+    uint32_t dropped;          // Frames clients skipped for being slow
+    float captureFps;          // Achieved rates over the last window
+    float sendFps;
+};
+
+class MjpegStreamHub {
+private:
+    std::shared_ptr<MjpegFrame> latest;
+    uint32_t nextSeq;
+    RtMutex lock;
+
+    std::atomic<int> clients;
+    std::atomic<int> targetFps;
+    uint32_t lastCaptureMs;
+
+    std::atomic<uint32_t> published;
+    std::atomic<uint32_t> sent;
+    std::atomic<uint32_t> dropped;
+
+    // Rate window
+    uint32_t windowStartMs;
+    uint32_t windowPublished;
+    uint32_t windowSent;
+    float captureFps;
+    float sendFps;
+
+    static const uint32_t WINDOW_MS = 2000;
+
+public:
+    MjpegStreamHub() : nextSeq(1), clients(0), targetFps(MJPEG_DEFAULT_FPS), lastCaptureMs(0),
+                       published(0), sent(0), dropped(0) {
+        windowStartMs = 0;
+        windowPublished = 0;
+        windowSent = 0;
+        captureFps = 0;
+        sendFps = 0;
+    }
+
+    void setTargetFps(int fps) {
+        if (fps < 1) fps = 1;
+        if (fps > MJPEG_MAX_FPS) fps = MJPEG_MAX_FPS;
+        targetFps = fps;
+    }
+
+    int getTargetFps() const { return targetFps.load(); }
+    int getClients() const { return clients.load(); }
+
+    // Capture pacing: only when someone is watching, at most targetFps
+    bool wantsFrame(uint32_t nowMs) const {
+        if (clients.load() == 0) return false;
+        return nowMs - lastCaptureMs >= 1000UL / targetFps.load();
+    }
+
+    // Takes ownership of a malloc'd JPEG
+    void publish(uint8_t* jpeg, size_t length, uint32_t nowMs) {
+        lastCaptureMs = nowMs;
+        lock.lock();
+        latest = std::make_shared<MjpegFrame>(jpeg, length, nextSeq++, nowMs);
+        lock.unlock();
+        published++;
+        updateRates(nowMs);
+    }
+
+    // Newest frame if it is newer than afterSeq, otherwise nullptr
+    std::shared_ptr<MjpegFrame> frameAfter(uint32_t afterSeq) {
+        lock.lock();
+        std::shared_ptr<MjpegFrame> frame = latest;
+        lock.unlock();
+        if (!frame || (int32_t)(frame->seq - afterSeq) <= 0) return nullptr;
+        return frame;
+    }
+
+    void clientConnected() { clients++; }
+
+    void clientDisconnected() {
+        if (--clients == 0) {
+            // Don't hold the last JPEG while nobody is watching
+            lock.lock();
+            latest.reset();
+            lock.unlock();
+        }
+    }
+
+    void noteSent(uint32_t skipped) {
+        sent++;
+        dropped += skipped;
+    }
+
+    // Called from the capture side; the web task only bumps the counters
+    void updateRates(uint32_t nowMs) {
+        uint32_t elapsed = nowMs - windowStartMs;
+        if (elapsed < WINDOW_MS) return;
+        uint32_t p = published.load();
+        uint32_t s = sent.load();
+        captureFps = (p - windowPublished) * 1000.0f / elapsed;
+        sendFps = (s - windowSent) * 1000.0f / elapsed;
+        windowPublished = p;
+        windowSent = s;
+        windowStartMs = nowMs;
+    }
+
+    MjpegStats getStats() const {
+        MjpegStats stats;
+        stats.clients = clients.load();
+        stats.targetFps = targetFps.load();
+        stats.published = published.load();
+        stats.sent = sent.load();
+        stats.dropped = dropped.load();
+        stats.captureFps = stats.clients > 0 ? captureFps : 0.0f;
+        stats.sendFps = stats.clients > 0 ? sendFps : 0.0f;
+        return stats;
+    }
+
+    void printStats() {
+        MjpegStats stats = getStats();
+        RT_LOG("MJPEG: %d clients @ %d fps target, capture %.1f fps, send %.1f fps, %lu sent, %lu dropped\n",
+               stats.clients, stats.targetFps, stats.captureFps, stats.sendFps,
+               (unsigned long)stats.sent, (unsigned long)stats.dropped);
+    }
+};
+
+// One connected viewer. fill() is an ESPAsyncWebServer response filler:
+// it writes the part header, then the JPEG, then the trailing CRLF, and
+// returns RESPONSE_TRY_AGAIN while there is no newer frame to send (which
+// defers the next call to the TCP poll; see above).
+class MjpegClient {
+private:
+    MjpegStreamHub* hub;
+    std::shared_ptr<MjpegFrame> frame;  // Frame being sent
+    uint32_t lastSeq;
+    uint32_t skipped;          // Frames passed over to get to this one
+    char header[96];
+    size_t headerLen;
+    size_t offset;             // Bytes of header + JPEG + CRLF already written
+
+    size_t partLength() const { return headerLen + frame->length + 2; }
+
+public:
+    MjpegClient(MjpegStreamHub* source) : hub(source), lastSeq(0), skipped(0), headerLen(0), offset(0) {
+        hub->clientConnected();
+    }
+
+    ~MjpegClient() {
+        hub->clientDisconnected();
+    }
+
+    size_t fill(uint8_t* buffer, size_t maxLen) {
+        if (!frame) {
+            frame = hub->frameAfter(lastSeq);
+            if (!frame) return RESPONSE_TRY_AGAIN;
+            // Everything published since our last frame was skipped
+            skipped = lastSeq > 0 ? frame->seq - lastSeq - 1 : 0;
+            lastSeq = frame->seq;
+            headerLen = snprintf(header, sizeof(header),
+                                 "--" MJPEG_BOUNDARY "\r\nContent-Type: image/jpeg\r\nContent-Length: %u\r\n\r\n",
+                                 (unsigned)frame->length);
+            offset = 0;
+        }
+
+        size_t written = 0;
+        while (written < maxLen && offset < partLength()) {
+            const uint8_t* src;
+            size_t avail;
+            if (offset < headerLen) {
+                src = (const uint8_t*)header + offset;
+                avail = headerLen - offset;
+            } else if (offset < headerLen + frame->length) {
+                src = frame->data + (offset - headerLen);
+                avail = headerLen + frame->length - offset;
+            } else {
+                src = (const uint8_t*)"\r\n" + (offset - headerLen - frame->length);
+                avail = partLength() - offset;
+            }
+            if (avail > maxLen - written) avail = maxLen - written;
+            memcpy(buffer + written, src, avail);
+            written += avail;
+            offset += avail;
+        }
+
+        PipelineMetrics::instance().addWifiSentBytes(written);
+        if (offset == partLength()) {
+            hub->noteSent(skipped);
+            frame.reset();
+        }
+        return written;
+    }
+};
+
+#endif
@@ -0,0 +1,344 @@
+#ifndef SAMPLE_LOG_H
+#define SAMPLE_LOG_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "../runtime/rt_platform.h"
+#include "sample_record.h"
+
+#ifdef ARDUINO
+#include <LittleFS.h>
+#endif
+
+// Append-only file of SampleRecords, so a data collection session survives
+// resets and power cycles. Layout: an 8-byte header (magic, record size,
+// version) followed by back-to-back 36-byte records. Records are only ever
+// appended and flushed one at a time; a record torn by a reset is padded out
+// with zeros on the next begin() so later appends stay aligned, and fails its
+// checksum on export. On the device the file lives on LittleFS (the default
+// "spiffs" partition); off-target it is a plain file in the working
+// directory. A log written in another record format is started afresh.
+//
+// Exposes the same range()/read() interface as SampleStore so CsvStreamer can
+// export it directly, without loading the session into RAM.
+
+#ifdef ARDUINO
+#define SAMPLE_LOG_PATH "/samples.bin"
+#else
+#define SAMPLE_LOG_PATH "samples.bin"
+#endif
+#define SAMPLE_LOG_MAGIC 0x31535446UL   // "FTS1"
+#define SAMPLE_LOG_VERSION 2            // 2: edge features in hundredths
+
+struct SampleLogStats {
+    bool open;
+    uint32_t records;
+    uint32_t maxRecords;
+    uint32_t fileBytes;
+    uint32_t tornRecords;      // Padded at begin() after an interrupted write
+    uint32_t appendFailures;
+    uint8_t session;
+};
+
+class SampleLog {
+private:
+    struct Header {
+        uint32_t magic;
+        uint16_t recordSize;
+        uint16_t version;
+    };
+
+    static const uint32_t HEADER_BYTES = sizeof(Header);
+    static const uint32_t RECORD_BYTES = sizeof(SampleRecord);
+
+#ifdef ARDUINO
+    fs::File writer;
+    fs::File reader;
+#else
+    FILE* writer;
+    FILE* reader;
+#endif
+    char path[64];
+    bool opened;
+    uint32_t records;
+    uint32_t readerRecords;    // Records visible to the reader handle
+    uint32_t maxRecords;
+    uint32_t tornRecords;
+    uint32_t appendFailures;
+    uint8_t session;
+    mutable RtMutex lock;
+
+    // --- File access; the only platform-specific part ---
+
+#ifdef ARDUINO
+    bool fileExists() { return LittleFS.exists(path); }
+    void removeFile() { LittleFS.remove(path); }
+
+    bool openWriter() {
+        writer = LittleFS.open(path, FILE_APPEND);
+        return (bool)writer;
+    }
+
+    bool openReader() {
+        reader = LittleFS.open(path, FILE_READ);
+        return (bool)reader;
+    }
+
+    void closeFiles() {
+        if (writer) writer.close();
+        if (reader) reader.close();
+    }
+
+    uint32_t fileSize() {
+        fs::File f = LittleFS.open(path, FILE_READ);
+        if (!f) return 0;
+        uint32_t size = f.size();
+        f.close();
+        return size;
+    }
+
+    bool writeBytes(const void* data, size_t len) {
+        if (writer.write((const uint8_t*)data, len) != len) return false;
+        writer.flush();
+        return true;
+    }
+
+    bool readAt(uint32_t offset, void* data, size_t len) {
+        return reader.seek(offset) && reader.read((uint8_t*)data, len) == len;
+    }
+
+    bool mountFilesystem() {
+        // Format on first use so a fresh board works without uploading an image
+        return LittleFS.begin(true);
+    }
+
+    uint32_t filesystemBytes() { return LittleFS.totalBytes(); }
+#else
+    bool fileExists() {
+        FILE* f = fopen(path, "rb");
+        if (f) fclose(f);
+        return f != nullptr;
+    }
+
+    void removeFile() { remove(path); }
+
+    bool openWriter() {
+        writer = fopen(path, "ab");
+        return writer != nullptr;
+    }
+
+    bool openReader() {
+        reader = fopen(path, "rb");
+        return reader != nullptr;
+    }
+
+    void closeFiles() {
+        if (writer) fclose(writer);
+        if (reader) fclose(reader);
+        writer = nullptr;
+        reader = nullptr;
+    }
+
+    uint32_t fileSize() {
+        FILE* f = fopen(path, "rb");
+        if (!f) return 0;
+        fseek(f, 0, SEEK_END);
+        uint32_t size = (uint32_t)ftell(f);
+        fclose(f);
+        return size;
+    }
+
+    bool writeBytes(const void* data, size_t len) {
+        if (fwrite(data, 1, len, writer) != len) return false;
+        fflush(writer);
+        return true;
+    }
+
+    bool readAt(uint32_t offset, void* data, size_t len) {
+        return fseek(reader, offset, SEEK_SET) == 0 && fread(data, 1, len, reader) == len;
+    }
+
+    bool mountFilesystem() { return true; }
+    uint32_t filesystemBytes() { return 1536UL * 1024; }
+#endif
+
+    bool createFile() {
+        closeFiles();
+        removeFile();
+        if (!openWriter()) return false;
+        Header header = { SAMPLE_LOG_MAGIC, (uint16_t)RECORD_BYTES, SAMPLE_LOG_VERSION };
+        return writeBytes(&header, sizeof(header));
+    }
+
+    bool headerMatches() {
+        Header header;
+        if (!openReader()) return false;
+        bool ok = readAt(0, &header, sizeof(header)) &&
+                  header.magic == SAMPLE_LOG_MAGIC &&
+                  header.recordSize == RECORD_BYTES &&
+                  header.version == SAMPLE_LOG_VERSION;
+        closeFiles();
+        return ok;
+    }
+
+    // Reopen the reader once it is behind the writer; file systems only
+    // guarantee a handle sees data flushed before it was opened
+    bool ensureReader(uint32_t seq) {
+        if (reader && seq < readerRecords) return true;
+#ifdef ARDUINO
+        if (reader) reader.close();
+#else
+        if (reader) fclose(reader);
+        reader = nullptr;
+#endif
+        readerRecords = records;
+        return openReader();
+    }
+
+    uint8_t lastSession() {
+        SampleRecord record;
+        for (uint32_t seq = records; seq > 0; seq--) {
+            if (readAt(HEADER_BYTES + (seq - 1) * RECORD_BYTES, &record, RECORD_BYTES) &&
+                sampleRecordValid(record)) {
+                return record.session;
+            }
+        }
+        return 0;
+    }
+
+public:
+    SampleLog() {
+#ifndef ARDUINO
+        writer = nullptr;
+        reader = nullptr;
+#endif
+        path[0] = '\0';
+        opened = false;
+        records = 0;
+        readerRecords = 0;
+        maxRecords = 0;
+        tornRecords = 0;
+        appendFailures = 0;
+        session = 0;
+    }
+
+    ~SampleLog() {
+        closeFiles();
+    }
+
+    // Mount the file system and pick up the log left by previous boots
+    bool begin(const char* filePath = SAMPLE_LOG_PATH) {
+        lock.lock();
+        closeFiles();
+        strncpy(path, filePath, sizeof(path) - 1);
+        path[sizeof(path) - 1] = '\0';
+        opened = false;
+
+        if (!mountFilesystem()) {
+            lock.unlock();
+            return false;
+        }
+        // Leave a quarter of the partition for the file system itself
+        maxRecords = (filesystemBytes() / 4 * 3 - HEADER_BYTES) / RECORD_BYTES;
+
+        if (!fileExists() || !headerMatches()) {
+            opened = createFile();
+            records = 0;
+            session = 0;
+            lock.unlock();
+            return opened;
+        }
+
+        uint32_t size = fileSize();
+        records = (size - HEADER_BYTES) / RECORD_BYTES;
+        uint32_t tail = (size - HEADER_BYTES) % RECORD_BYTES;
+
+        if (!openWriter()) {
+            lock.unlock();
+            return false;
+        }
+        if (tail > 0) {
+            uint8_t zeros[RECORD_BYTES];
+            memset(zeros, 0, sizeof(zeros));
+            writeBytes(zeros, RECORD_BYTES - tail);
+            records++;
+            tornRecords++;
+        }
+
+        readerRecords = records;
+        opened = openReader();
+        session = opened ? lastSession() + 1 : 0;
+        lock.unlock();
+        return opened;
+    }
+
+    bool isOpen() const { return opened; }
+
+    // Session number stamped into records collected during this boot
+    uint8_t getSession() const { return session; }
+
+    bool append(const SampleRecord& record) {
+        lock.lock();
+        bool ok = opened && records < maxRecords && writeBytes(&record, RECORD_BYTES);
+        if (ok) {
+            records++;
+        } else {
+            appendFailures++;
+        }
+        lock.unlock();
+        return ok;
+    }
+
+    // Drop every record and start a fresh file
+    bool clear() {
+        lock.lock();
+        opened = createFile();
+        records = 0;
+        readerRecords = 0;
+        tornRecords = 0;
+        lock.unlock();
+        return opened;
+    }
+
+    uint32_t size() const {
+        lock.lock();
+        uint32_t n = records;
+        lock.unlock();
+        return n;
+    }
+
+    void range(uint32_t& first, uint32_t& end) const {
+        lock.lock();
+        first = 0;
+        end = records;
+        lock.unlock();
+    }
+
+    // Records are never overwritten, so this only fails past the end, after
+    // clear(), or on a read error
+    bool read(uint32_t seq, SampleRecord& out) const {
+        SampleLog* self = const_cast<SampleLog*>(this);
+        lock.lock();
+        bool ok = opened && seq < records && self->ensureReader(seq) &&
+                  self->readAt(HEADER_BYTES + seq * RECORD_BYTES, &out, RECORD_BYTES);
+        lock.unlock();
+        return ok;
+    }
+
+    SampleLogStats getStats() const {
+        SampleLogStats stats;
+        lock.lock();
+        stats.open = opened;
+        stats.records = records;
+        stats.maxRecords = maxRecords;
+        stats.fileBytes = opened ? HEADER_BYTES + records * RECORD_BYTES : 0;
+        stats.tornRecords = tornRecords;
+        stats.appendFailures = appendFailures;
+        stats.session = session;
+        lock.unlock();
+        return stats;
+    }
+};
+
+#endif
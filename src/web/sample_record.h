@@ -0,0 +1,98 @@
+#ifndef SAMPLE_RECORD_H
+#define SAMPLE_RECORD_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stddef.h>
+
+// Fixed-size binary form of one training sample, used both in RAM and in the
+// flash log. The brightness and contrast features (0-13) are whole numbers
+// 0-255 and take one byte each. The edge density features (14-19) are
+// fractions such as 77.78 and are kept in hundredths in 16 bits, the same
+// two decimals the serial TRAINING_DATA line prints, so both exports agree.
+// 36 bytes per sample instead of 84 (label + floats) or ~120 as CSV text.
+
+#define SAMPLE_FEATURES 20
+#define SAMPLE_EDGE_FEATURES_START 14   // Matches extractImageFeatures()
+#define SAMPLE_EDGE_FEATURES (SAMPLE_FEATURES - SAMPLE_EDGE_FEATURES_START)
+#define SAMPLE_EDGE_SCALE 100.0f
+
+struct SampleRecord {
+    uint32_t timestampMs;      // millis() at capture
+    int8_t label;              // Finger count
+    uint8_t session;           // Boot the sample was collected in
+    uint8_t levels[SAMPLE_EDGE_FEATURES_START];   // Features 0-13
+    uint16_t edges[SAMPLE_EDGE_FEATURES];         // Features 14-19, hundredths
+    uint16_t check;            // Fletcher-16 of the bytes above
+    uint16_t reserved;         // Zero; keeps the size explicit
+};
+
+static_assert(sizeof(SampleRecord) == 36, "SampleRecord layout is the on-flash format");
+
+inline uint32_t quantizeFeature(float value, float scale, uint32_t maxValue) {
+    float scaled = value * scale + 0.5f;
+    if (scaled <= 0.0f) return 0;
+    if (scaled >= (float)maxValue) return maxValue;
+    return (uint32_t)scaled;
+}
+
+inline void setSampleFeature(SampleRecord& record, int index, float value) {
+    if (index < SAMPLE_EDGE_FEATURES_START) {
+        record.levels[index] = (uint8_t)quantizeFeature(value, 1.0f, 255);
+    } else {
+        record.edges[index - SAMPLE_EDGE_FEATURES_START] =
+            (uint16_t)quantizeFeature(value, SAMPLE_EDGE_SCALE, 255 * 100);
+    }
+}
+
+inline float sampleFeature(const SampleRecord& record, int index) {
+    if (index < SAMPLE_EDGE_FEATURES_START) return record.levels[index];
+    return record.edges[index - SAMPLE_EDGE_FEATURES_START] / SAMPLE_EDGE_SCALE;
+}
+
+inline uint16_t sampleChecksum(const SampleRecord& record) {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&record);
+    uint16_t sum1 = 0xFF;
+    uint16_t sum2 = 0xFF;
+    for (size_t i = 0; i < offsetof(SampleRecord, check); i++) {
+        sum1 = (sum1 + bytes[i]) % 255;
+        sum2 = (sum2 + sum1) % 255;
+    }
+    // Salted so an all-zero record (torn-write padding) never checks out
+    return ((sum2 << 8) | sum1) ^ 0xA55A;
+}
+
+// False for zero padding and half-written records
+inline bool sampleRecordValid(const SampleRecord& record) {
+    return record.check == sampleChecksum(record);
+}
+
+inline void encodeSample(SampleRecord& record, int label, const float* features, int count,
+                         uint32_t timestampMs, uint8_t session) {
+    record.timestampMs = timestampMs;
+    record.label = (int8_t)label;
+    record.session = session;
+    for (int i = 0; i < SAMPLE_FEATURES; i++) {
+        setSampleFeature(record, i, i < count ? features[i] : 0.0f);
+    }
+    record.reserved = 0;
+    record.check = sampleChecksum(record);
+}
+
+// Same CSV format the serial TRAINING_DATA lines use. Returns the number of
+// characters in line, never more than size - 1: a line that does not fit is
+// cut short (and loses its newline) rather than reported at full length.
+inline int formatSampleCsv(const SampleRecord& record, char* line, size_t size) {
+    if (size == 0) return 0;
+    int limit = (int)size - 1;
+    int len = snprintf(line, size, "%d", record.label);
+    for (int i = 0; i < SAMPLE_FEATURES && len < limit; i++) {
+        len += snprintf(line + len, size - len, ",%.2f", sampleFeature(record, i));
+    }
+    if (len >= limit) return limit;
+    line[len++] = '\n';
+    line[len] = '\0';
+    return len;
+}
+
+#endif
@@ -0,0 +1,188 @@
+#ifndef SAMPLE_STORE_H
+#define SAMPLE_STORE_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../runtime/rt_platform.h"
+#include "sample_record.h"
+
+// Bounded storage for collected training samples. Samples are kept as
+// fixed-size SampleRecords in equal-sized segments that are allocated on demand
+// and reused forever, so the heap sees at most MAX_SEGMENTS identical blocks
+// instead of one ever-growing String. Once full the store behaves as a ring
+// and overwrites the oldest segment. Every sample gets a sequence number so a
+// reader (e.g. a chunked HTTP response) can tell when data it has not sent
+// yet was overwritten under it.
+
+struct SampleStoreStats {
+    uint32_t stored;           // Samples currently held
+    uint32_t capacity;
+    uint32_t overwritten;      // Samples lost to the ring wrapping
+    uint32_t segments;         // Segments allocated
+    uint32_t peakSegments;
+    uint32_t bytesAllocated;
+    uint32_t peakBytes;        // High-water mark of segment memory
+};
+
+template <int SEGMENT_SAMPLES, int MAX_SEGMENTS>
+class SampleStore {
+public:
+    static constexpr uint32_t CAPACITY = SEGMENT_SAMPLES * MAX_SEGMENTS;
+    static constexpr size_t SEGMENT_BYTES = sizeof(SampleRecord) * SEGMENT_SAMPLES;
+
+private:
+    SampleRecord* segments[MAX_SEGMENTS];
+    int allocated;
+    int peakAllocated;
+    uint32_t firstSeq;         // Oldest sample still stored
+    uint32_t nextSeq;          // Sequence number of the next sample
+    uint32_t overwritten;
+    bool allocationFailed;
+    mutable RtMutex lock;
+
+    SampleRecord* slotFor(uint32_t seq) const {
+        uint32_t index = seq % CAPACITY;
+        return &segments[index / SEGMENT_SAMPLES][index % SEGMENT_SAMPLES];
+    }
+
+    // Make sure the segment for nextSeq exists; false if the heap refused
+    bool reserveNext() {
+        int segment = (nextSeq % CAPACITY) / SEGMENT_SAMPLES;
+        if (segments[segment]) return true;
+        segments[segment] = (SampleRecord*)malloc(SEGMENT_BYTES);
+        if (!segments[segment]) return false;
+        allocated++;
+        if (allocated > peakAllocated) peakAllocated = allocated;
+        return true;
+    }
+
+public:
+    SampleStore() {
+        for (int i = 0; i < MAX_SEGMENTS; i++) segments[i] = nullptr;
+        allocated = 0;
+        peakAllocated = 0;
+        firstSeq = 0;
+        nextSeq = 0;
+        overwritten = 0;
+        allocationFailed = false;
+    }
+
+    ~SampleStore() {
+        for (int i = 0; i < MAX_SEGMENTS; i++) free(segments[i]);
+    }
+
+    bool add(const SampleRecord& record) {
+        lock.lock();
+        if (!reserveNext()) {
+            allocationFailed = true;
+            lock.unlock();
+            return false;
+        }
+        *slotFor(nextSeq) = record;
+        nextSeq++;
+        if (nextSeq - firstSeq > CAPACITY) {
+            firstSeq++;
+            overwritten++;
+        }
+        lock.unlock();
+        return true;
+    }
+
+    // Forget all samples; segments stay allocated for reuse
+    void clear() {
+        lock.lock();
+        firstSeq = nextSeq;
+        lock.unlock();
+    }
+
+    uint32_t size() const {
+        lock.lock();
+        uint32_t n = nextSeq - firstSeq;
+        lock.unlock();
+        return n;
+    }
+
+    // Sequence range [first, end) currently readable
+    void range(uint32_t& first, uint32_t& end) const {
+        lock.lock();
+        first = firstSeq;
+        end = nextSeq;
+        lock.unlock();
+    }
+
+    // Copy one sample out; false if it was overwritten or never existed
+    bool read(uint32_t seq, SampleRecord& out) const {
+        lock.lock();
+        bool ok = (int32_t)(seq - firstSeq) >= 0 && (int32_t)(nextSeq - seq) > 0;
+        if (ok) out = *slotFor(seq);
+        lock.unlock();
+        return ok;
+    }
+
+    SampleStoreStats getStats() const {
+        SampleStoreStats stats;
+        lock.lock();
+        stats.stored = nextSeq - firstSeq;
+        stats.capacity = CAPACITY;
+        stats.overwritten = overwritten;
+        stats.segments = allocated;
+        stats.peakSegments = peakAllocated;
+        stats.bytesAllocated = allocated * SEGMENT_BYTES;
+        stats.peakBytes = peakAllocated * SEGMENT_BYTES;
+        lock.unlock();
+        return stats;
+    }
+
+    bool hadAllocationFailure() const { return allocationFailed; }
+};
+
+// Serializes a store (or the flash SampleLog, which has the same range()/read()
+// interface) to CSV a buffer at a time, for chunked responses. The sample range
+// is fixed when the streamer is created; samples overwritten while the
+// download is in progress, and torn records, are skipped (and counted).
+template <typename Store>
+class CsvStreamer {
+private:
+    const Store* store;
+    uint32_t seq;
+    uint32_t endSeq;
+    char line[SAMPLE_FEATURES * 12 + 16];
+    int lineLen;
+    int linePos;
+    uint32_t skipped;
+
+public:
+    CsvStreamer(const Store* source) : store(source), lineLen(0), linePos(0), skipped(0) {
+        store->range(seq, endSeq);
+    }
+
+    // Fill up to maxLen bytes; returns 0 once everything has been sent
+    size_t fill(uint8_t* buffer, size_t maxLen) {
+        size_t written = 0;
+        while (written < maxLen) {
+            if (linePos == lineLen) {
+                SampleRecord sample;
+                bool found = false;
+                while (seq != endSeq && !found) {
+                    found = store->read(seq++, sample) && sampleRecordValid(sample);
+                    if (!found) skipped++;
+                }
+                if (!found) break;
+                lineLen = formatSampleCsv(sample, line, sizeof(line));
+                linePos = 0;
+            }
+            size_t n = lineLen - linePos;
+            if (n > maxLen - written) n = maxLen - written;
+            memcpy(buffer + written, line + linePos, n);
+            linePos += n;
+            written += n;
+        }
+        return written;
+    }
+
+    uint32_t getSkipped() const { return skipped; }
+};
+
+#endif
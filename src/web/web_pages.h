@@ -49,6 +49,10 @@ const char* getDataCollectionHTML() {
                 <label>
                     <input type="checkbox" id="autoRefresh" checked> Auto-refresh (2s)
                 </label>
+                <label>
+                    <input type="checkbox" id="liveStream" onchange="toggleStream()"> Live stream
+                </label>
+                <div id="streamStats"></div>
             </div>
         </div>
         
@@ -187,10 +191,32 @@ const char* getDataCollectionHTML() {
             img.src = '/api/camera/capture?' + new Date().getTime();
         }
         
+        function toggleStream() {
+            const img = document.getElementById('cameraView');
+            if (document.getElementById('liveStream').checked) {
+                img.src = '/api/camera/stream?fps=5';
+            } else {
+                refreshCamera();
+                document.getElementById('streamStats').textContent = '';
+            }
+        }
+        
+        function updateStreamStats() {
+            if (!document.getElementById('liveStream').checked) return;
+            fetch('/api/camera/stats')
+                .then(response => response.json())
+                .then(data => {
+                    document.getElementById('streamStats').textContent =
+                        `${data.sendFps.toFixed(1)} fps (target ${data.targetFps}), ${data.framesDropped} dropped`;
+                });
+        }
+        
         function startCameraAutoRefresh() {
+            setInterval(updateStreamStats, 2000);
             setInterval(() => {
                 const autoRefresh = document.getElementById('autoRefresh');
-                if (autoRefresh && autoRefresh.checked) {
+                const liveStream = document.getElementById('liveStream');
+                if (autoRefresh && autoRefresh.checked && !liveStream.checked) {
                     refreshCamera();
                 }
             }, 2000);
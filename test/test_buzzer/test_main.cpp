@@ -0,0 +1,149 @@
+// BuzzerControl's tone sequencer against a fake clock: step timing, chaining
+// from the previous step's end after a late tick, busy state, the tick
+// starting and stopping with the queue, and stop() flushing.
+//
+//   pio test -e native -f test_buzzer
+
+#include <unity.h>
+#include "ui/buzzer.h"
+
+static BuzzerControl* buzzer;
+
+void setUp(void) {
+    buzzer = new BuzzerControl();
+    buzzer->init();
+}
+
+void tearDown(void) {
+    delete buzzer;
+}
+
+static bool sounding() {
+    return digitalRead(BUZZER_PIN) == HIGH;
+}
+
+// Ticks every BUZZER_TICK_MS from fromMs to toMs and records when the output
+// switches on and off
+static int sampleEdges(unsigned long fromMs, unsigned long toMs, unsigned long* edges, int maxEdges) {
+    int count = 0;
+    bool level = sounding();
+    for (unsigned long now = fromMs; now <= toMs; now += BUZZER_TICK_MS) {
+        buzzer->update(now);
+        if (sounding() != level && count < maxEdges) {
+            level = sounding();
+            edges[count++] = now;
+        }
+    }
+    return count;
+}
+
+void test_idle_buzzer_is_quiet(void) {
+    TEST_ASSERT_FALSE(buzzer->isBusy());
+    TEST_ASSERT_FALSE(buzzer->isTicking());
+    buzzer->update(0);
+    TEST_ASSERT_FALSE(sounding());
+    TEST_ASSERT_FALSE(buzzer->isTicking());
+}
+
+void test_beep_plays_for_its_duration(void) {
+    buzzer->beep(100);
+    TEST_ASSERT_TRUE(buzzer->isBusy());
+    TEST_ASSERT_TRUE(buzzer->isTicking());
+
+    buzzer->update(1000);
+    TEST_ASSERT_TRUE(sounding());
+    buzzer->update(1099);
+    TEST_ASSERT_TRUE(sounding());
+    TEST_ASSERT_TRUE(buzzer->isBusy());
+
+    buzzer->update(1100);
+    TEST_ASSERT_FALSE(sounding());
+    TEST_ASSERT_FALSE(buzzer->isBusy());
+    TEST_ASSERT_FALSE(buzzer->isTicking());
+}
+
+void test_pattern_edges(void) {
+    buzzer->beepPattern(3, 100, 150);
+    unsigned long edges[8];
+    int count = sampleEdges(0, 1000, edges, 8);
+    TEST_ASSERT_EQUAL_INT(6, count);
+    const unsigned long expected[] = { 0, 100, 250, 350, 500, 600 };
+    for (int i = 0; i < 6; i++) {
+        TEST_ASSERT_EQUAL_UINT32(expected[i], edges[i]);
+    }
+    TEST_ASSERT_FALSE(buzzer->isBusy());
+    TEST_ASSERT_FALSE(buzzer->isTicking());
+}
+
+void test_late_tick_does_not_stretch_pattern(void) {
+    buzzer->beepPattern(2, 100, 100);
+    buzzer->update(0);
+    TEST_ASSERT_TRUE(sounding());
+    // One tick 250 ms late: the first tone and the rest are over, the second
+    // tone started at 200 and is half done
+    buzzer->update(250);
+    TEST_ASSERT_TRUE(sounding());
+    buzzer->update(299);
+    TEST_ASSERT_TRUE(sounding());
+    buzzer->update(300);
+    TEST_ASSERT_FALSE(sounding());
+    TEST_ASSERT_FALSE(buzzer->isBusy());
+}
+
+void test_tick_restarts_for_new_steps(void) {
+    buzzer->beep(50);
+    buzzer->update(0);
+    buzzer->update(50);
+    TEST_ASSERT_FALSE(buzzer->isTicking());
+
+    buzzer->rest(20);
+    buzzer->beep(30);
+    TEST_ASSERT_TRUE(buzzer->isTicking());
+    buzzer->update(100);
+    TEST_ASSERT_FALSE(sounding());
+    TEST_ASSERT_TRUE(buzzer->isBusy());
+    buzzer->update(120);
+    TEST_ASSERT_TRUE(sounding());
+    buzzer->update(150);
+    TEST_ASSERT_FALSE(sounding());
+    TEST_ASSERT_FALSE(buzzer->isTicking());
+}
+
+void test_stop_flushes_queue(void) {
+    buzzer->alarmPattern();
+    buzzer->update(0);
+    TEST_ASSERT_TRUE(sounding());
+    buzzer->stop();
+    TEST_ASSERT_FALSE(sounding());
+    TEST_ASSERT_FALSE(buzzer->isBusy());
+    TEST_ASSERT_FALSE(buzzer->isTicking());
+
+    // The flush does not swallow steps queued afterwards
+    buzzer->beep(10);
+    buzzer->update(2000);
+    TEST_ASSERT_TRUE(sounding());
+}
+
+void test_full_queue_drops_steps(void) {
+    for (size_t i = 0; i < BuzzerControl::QUEUE_DEPTH + 8; i++) {
+        buzzer->beep(10);
+    }
+    TEST_ASSERT_EQUAL_UINT32(8, buzzer->getDroppedSteps());
+    unsigned long edges[2 * BuzzerControl::QUEUE_DEPTH + 2];
+    // Back-to-back tones of one frequency: on at the start, off at the end
+    int count = sampleEdges(0, 1000, edges, 2 * BuzzerControl::QUEUE_DEPTH + 2);
+    TEST_ASSERT_EQUAL_INT(2, count);
+    TEST_ASSERT_EQUAL_UINT32(10 * BuzzerControl::QUEUE_DEPTH, edges[1]);
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_idle_buzzer_is_quiet);
+    RUN_TEST(test_beep_plays_for_its_duration);
+    RUN_TEST(test_pattern_edges);
+    RUN_TEST(test_late_tick_does_not_stretch_pattern);
+    RUN_TEST(test_tick_restarts_for_new_steps);
+    RUN_TEST(test_stop_flushes_queue);
+    RUN_TEST(test_full_queue_drops_steps);
+    return UNITY_END();
+}
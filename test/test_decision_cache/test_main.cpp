@@ -0,0 +1,125 @@
+// DecisionCache: an unchanged scene hits, a changed one misses, the signature
+// only rejects and never accepts on its own (features nearly a bucket apart
+// and same-signature features past the tolerance both miss), entries expire
+// after the maximum age, and the hit and saved-time counters add up.
+//
+//   pio test -e native -f test_decision_cache
+
+#include <unity.h>
+#include <Arduino.h>
+#include "ai/decision_cache.h"
+
+static const int N = 4;
+
+static DecisionCache<N>* cache;
+
+void setUp(void) {
+    cache = new DecisionCache<N>();
+    // 8-unit buckets, 4-unit tolerance, 3 s maximum age
+    cache->setTolerance(8.0f, 4.0f);
+    cache->setMaxAge(3000);
+}
+
+void tearDown(void) {
+    delete cache;
+}
+
+void test_unchanged_scene_hits(void) {
+    const float features[N] = { 10.0f, 20.0f, 30.0f, 40.0f };
+    int result = -1;
+    TEST_ASSERT_FALSE(cache->lookup(features, 0, result));
+    cache->store(features, 3, 0, 1500);
+    TEST_ASSERT_TRUE(cache->lookup(features, 100, result));
+    TEST_ASSERT_EQUAL_INT(3, result);
+
+    const float nudged[N] = { 11.0f, 19.0f, 30.5f, 41.0f };
+    result = -1;
+    TEST_ASSERT_TRUE(cache->lookup(nudged, 200, result));
+    TEST_ASSERT_EQUAL_INT(3, result);
+}
+
+void test_changed_scene_misses(void) {
+    const float features[N] = { 10.0f, 20.0f, 30.0f, 40.0f };
+    const float changed[N] = { 10.0f, 20.0f, 30.0f, 90.0f };
+    cache->store(features, 3, 0, 1500);
+    int result = -1;
+    TEST_ASSERT_FALSE(cache->lookup(changed, 100, result));
+    TEST_ASSERT_EQUAL_INT(-1, result);
+}
+
+void test_same_signature_past_tolerance_misses(void) {
+    // Both ends of the [8, 16) bucket: the signatures match, the features
+    // are 7.9 apart
+    const float low[N] = { 8.0f, 8.0f, 8.0f, 8.0f };
+    const float high[N] = { 8.0f, 8.0f, 8.0f, 15.9f };
+    cache->store(low, 2, 0, 1500);
+    int result = -1;
+    TEST_ASSERT_FALSE(cache->lookup(high, 100, result));
+    TEST_ASSERT_EQUAL_INT(-1, result);
+}
+
+void test_tolerance_edge(void) {
+    const float features[N] = { 9.0f, 9.0f, 9.0f, 9.0f };
+    cache->store(features, 1, 0, 1500);
+    int result = -1;
+    // Exactly the tolerance away, same bucket: a hit
+    const float atEdge[N] = { 9.0f, 9.0f, 9.0f, 13.0f };
+    TEST_ASSERT_TRUE(cache->lookup(atEdge, 100, result));
+    TEST_ASSERT_EQUAL_INT(1, result);
+    // Just past it: a miss
+    const float pastEdge[N] = { 9.0f, 9.0f, 9.0f, 13.01f };
+    TEST_ASSERT_FALSE(cache->lookup(pastEdge, 100, result));
+    // Within tolerance but across a bucket boundary: rejected by signature
+    const float acrossBucket[N] = { 9.0f, 9.0f, 9.0f, 7.5f };
+    TEST_ASSERT_FALSE(cache->lookup(acrossBucket, 100, result));
+}
+
+void test_entry_expires_after_max_age(void) {
+    const float features[N] = { 10.0f, 20.0f, 30.0f, 40.0f };
+    cache->store(features, 4, 1000, 1500);
+    int result = -1;
+    TEST_ASSERT_TRUE(cache->lookup(features, 4000, result));
+    TEST_ASSERT_FALSE(cache->lookup(features, 4001, result));
+
+    // A zero maximum age disables the cache without counting lookups
+    cache->store(features, 4, 5000, 1500);
+    cache->setMaxAge(0);
+    unsigned long lookups = cache->getLookups();
+    TEST_ASSERT_FALSE(cache->lookup(features, 5000, result));
+    TEST_ASSERT_EQUAL_UINT32(lookups, cache->getLookups());
+}
+
+void test_stats_counters(void) {
+    const float features[N] = { 10.0f, 20.0f, 30.0f, 40.0f };
+    const float changed[N] = { 50.0f, 20.0f, 30.0f, 40.0f };
+    int result;
+    TEST_ASSERT_FALSE(cache->lookup(features, 0, result));      // Empty
+    cache->store(features, 3, 0, 1500);
+    TEST_ASSERT_TRUE(cache->lookup(features, 100, result));
+    TEST_ASSERT_TRUE(cache->lookup(features, 200, result));
+    TEST_ASSERT_FALSE(cache->lookup(changed, 300, result));
+    cache->store(changed, 5, 300, 2500);
+    TEST_ASSERT_TRUE(cache->lookup(changed, 400, result));
+
+    TEST_ASSERT_EQUAL_UINT32(5, cache->getLookups());
+    TEST_ASSERT_EQUAL_UINT32(3, cache->getHits());
+    TEST_ASSERT_TRUE(cache->getHitRate() > 0.599f && cache->getHitRate() < 0.601f);
+    // Each hit saves the cost of the inference that filled the entry
+    TEST_ASSERT_TRUE(cache->getSavedUs() == 1500ULL + 1500ULL + 2500ULL);
+
+    cache->resetStats();
+    TEST_ASSERT_EQUAL_UINT32(0, cache->getLookups());
+    TEST_ASSERT_EQUAL_UINT32(0, cache->getHits());
+    TEST_ASSERT_TRUE(cache->getSavedUs() == 0ULL);
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_unchanged_scene_hits);
+    RUN_TEST(test_changed_scene_misses);
+    RUN_TEST(test_same_signature_past_tolerance_misses);
+    RUN_TEST(test_tolerance_edge);
+    RUN_TEST(test_entry_expires_after_max_age);
+    RUN_TEST(test_stats_counters);
+    return UNITY_END();
+}
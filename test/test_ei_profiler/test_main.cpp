@@ -0,0 +1,169 @@
+// The scoped-zone profiler (edge-impulse-sdk/dsp/ei_profiler.h): a zone
+// entered under two parents keeps separate figures under each, self time
+// excludes nested zones, MicroProfilerInterface tags nest under the open
+// zone, reset keeps the tree, and a full registry drops entries instead of
+// misfiling them.
+//
+//   pio test -e native -f test_ei_profiler
+
+#include <unity.h>
+#include <stdarg.h>
+#include <string>
+#include <thread>
+#include "edge-impulse-sdk/dsp/ei_profiler.h"
+
+// The SDK's print hook, captured for the report test
+static std::string printed;
+
+void ei_printf(const char *format, ...) {
+    char line[256];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    printed += line;
+}
+
+void setUp(void) {
+    ei_profiler_reset();
+    printed.clear();
+}
+
+void tearDown(void) {
+}
+
+static void spinUs(uint32_t us) {
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+static void leaf(uint32_t us) {
+    EI_PROFILE_ZONE("leaf");
+    spinUs(us);
+}
+
+static void pathA() {
+    EI_PROFILE_ZONE("path_a");
+    leaf(200);
+}
+
+static void pathB() {
+    EI_PROFILE_ZONE("path_b");
+    leaf(2000);
+    leaf(2000);
+}
+
+void test_zone_keyed_by_parent(void) {
+    // B first: a node fixed at first entry would file A's calls under B
+    pathB();
+    for (int i = 0; i < 3; i++) pathA();
+
+    const ei_profile_node_t* a = ei_profiler_find("path_a", nullptr);
+    const ei_profile_node_t* b = ei_profiler_find("path_b", nullptr);
+    TEST_ASSERT_NOT_NULL(a);
+    TEST_ASSERT_NOT_NULL(b);
+    const ei_profile_node_t* leafA = ei_profiler_find("leaf", a);
+    const ei_profile_node_t* leafB = ei_profiler_find("leaf", b);
+    TEST_ASSERT_NOT_NULL(leafA);
+    TEST_ASSERT_NOT_NULL(leafB);
+    TEST_ASSERT_TRUE(leafA != leafB);
+    TEST_ASSERT_EQUAL_UINT32(3, leafA->count);
+    TEST_ASSERT_EQUAL_UINT32(2, leafB->count);
+    TEST_ASSERT_EQUAL_INT(1, leafA->depth);
+    // Each leaf keeps its own path's timing
+    TEST_ASSERT_TRUE(leafA->max_ticks < leafB->min_ticks);
+    TEST_ASSERT_NULL(ei_profiler_find("leaf", nullptr));
+}
+
+void test_self_time_excludes_children(void) {
+    pathB();
+    const ei_profile_node_t* b = ei_profiler_find("path_b", nullptr);
+    const ei_profile_node_t* leafB = ei_profiler_find("leaf", b);
+    TEST_ASSERT_TRUE(leafB->total_ticks == b->child_ticks);
+    TEST_ASSERT_TRUE(b->total_ticks >= b->child_ticks);
+    TEST_ASSERT_TRUE(leafB->total_ticks >= 4000ULL * EI_PROFILER_TICKS_PER_US);
+}
+
+void test_tags_nest_under_open_zone(void) {
+    ei::profiler::tag_profiler tags;
+    {
+        EI_PROFILE_ZONE("invoke_a");
+        uint32_t op = tags.BeginEvent("FULLY_CONNECTED");
+        tags.EndEvent(op);
+    }
+    {
+        EI_PROFILE_ZONE("invoke_b");
+        uint32_t op = tags.BeginEvent("FULLY_CONNECTED");
+        uint32_t inner = tags.BeginEvent("SOFTMAX");
+        // Ending the outer event closes the inner one too
+        tags.EndEvent(op);
+        (void)inner;
+    }
+    const ei_profile_node_t* a = ei_profiler_find("invoke_a", nullptr);
+    const ei_profile_node_t* b = ei_profiler_find("invoke_b", nullptr);
+    const ei_profile_node_t* fcA = ei_profiler_find("FULLY_CONNECTED", a);
+    const ei_profile_node_t* fcB = ei_profiler_find("FULLY_CONNECTED", b);
+    TEST_ASSERT_NOT_NULL(fcA);
+    TEST_ASSERT_NOT_NULL(fcB);
+    TEST_ASSERT_EQUAL_UINT32(1, fcA->count);
+    TEST_ASSERT_EQUAL_UINT32(1, fcB->count);
+    const ei_profile_node_t* softmax = ei_profiler_find("SOFTMAX", fcB);
+    TEST_ASSERT_NOT_NULL(softmax);
+    TEST_ASSERT_EQUAL_UINT32(1, softmax->count);
+    TEST_ASSERT_NULL(ei_profiler_find("SOFTMAX", fcA));
+}
+
+void test_reset_keeps_tree(void) {
+    pathA();
+    int nodes = ei_profiler_node_count();
+    ei_profiler_reset();
+    TEST_ASSERT_EQUAL_INT(nodes, ei_profiler_node_count());
+    const ei_profile_node_t* a = ei_profiler_find("path_a", nullptr);
+    TEST_ASSERT_EQUAL_UINT32(0, a->count);
+    TEST_ASSERT_EQUAL_UINT32(0, ei_profiler_percentile_ticks(a, 99.0f));
+    pathA();
+    TEST_ASSERT_EQUAL_UINT32(1, a->count);
+    TEST_ASSERT_EQUAL_INT(nodes, ei_profiler_node_count());
+}
+
+void test_report_lists_zone_under_each_parent(void) {
+    pathA();
+    pathB();
+    ei_profiler_report();
+    // Each parent's line is followed by its own, indented leaf line
+    const char* parents[] = { "path_a", "path_b" };
+    for (int i = 0; i < 2; i++) {
+        size_t line = printed.find(parents[i]);
+        TEST_ASSERT_TRUE(line != std::string::npos);
+        size_t next = printed.find('\n', line) + 1;
+        TEST_ASSERT_EQUAL_INT(0, printed.compare(next, 6, "  leaf"));
+    }
+}
+
+static void nest(int levels) {
+    EI_PROFILE_ZONE("nest");
+    if (levels > 1) nest(levels - 1);
+}
+
+void test_full_registry_drops_entries(void) {
+    // Every level is a new (parent, zone) pair
+    nest(EI_PROFILER_MAX_ZONES + 8);
+    TEST_ASSERT_EQUAL_INT(EI_PROFILER_MAX_ZONES, ei_profiler_node_count());
+    TEST_ASSERT_GREATER_THAN(0, ei::profiler::registry().dropped);
+    // Zones seen before still record
+    int before = ei_profiler_find("path_a", nullptr)->count;
+    pathA();
+    TEST_ASSERT_EQUAL_INT(before + 1, ei_profiler_find("path_a", nullptr)->count);
+    ei_profiler_report();
+    TEST_ASSERT_TRUE(printed.find("not recorded") != std::string::npos);
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_zone_keyed_by_parent);
+    RUN_TEST(test_self_time_excludes_children);
+    RUN_TEST(test_tags_nest_under_open_zone);
+    RUN_TEST(test_reset_keeps_tree);
+    RUN_TEST(test_report_lists_zone_under_each_parent);
+    RUN_TEST(test_full_registry_drops_entries);
+    return UNITY_END();
+}
@@ -0,0 +1,143 @@
+// HeapTelemetry's bookkeeping: blocks are accounted until released, a
+// pointer it never handed out is freed as is instead of being read as a
+// header, calloc-style sizes that overflow fail, a full live-block table
+// falls back to untracked blocks, and the table stays exact through churn.
+//
+//   pio test -e native -f test_heap_telemetry
+
+#include <unity.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <vector>
+#include "runtime/heap_telemetry.h"
+
+static const size_t LIVE_LIMIT = HEAP_TELEMETRY_MAX_BLOCKS / 4 * 3;
+
+static HeapTelemetry* telemetry;
+
+void setUp(void) {
+    telemetry = new HeapTelemetry();
+}
+
+void tearDown(void) {
+    delete telemetry;
+}
+
+static void* allocate(size_t size) {
+    return telemetry->allocate(size, HEAP_SOURCE_EI, 0x1000, false);
+}
+
+void test_blocks_accounted_until_released(void) {
+    void* a = allocate(10);
+    void* b = telemetry->allocate(300, HEAP_SOURCE_NEW, 0x2000, false);
+    void* c = allocate(5000);
+    HeapTotals totals = telemetry->getTotals();
+    TEST_ASSERT_EQUAL_UINT32(5310, totals.liveBytes);
+    TEST_ASSERT_EQUAL_UINT32(2, totals.sources[HEAP_SOURCE_EI].liveBlocks);
+    TEST_ASSERT_EQUAL_UINT32(1, totals.sources[HEAP_SOURCE_NEW].liveBlocks);
+    TEST_ASSERT_EQUAL_UINT32(3, telemetry->getTrackedBlocks());
+
+    telemetry->release(b);
+    telemetry->release(a);
+    telemetry->release(c);
+    totals = telemetry->getTotals();
+    TEST_ASSERT_EQUAL_UINT32(0, totals.liveBytes);
+    TEST_ASSERT_EQUAL_UINT32(5310, totals.peakBytes);
+    TEST_ASSERT_EQUAL_UINT32(0, totals.foreignFrees);
+    TEST_ASSERT_EQUAL_UINT32(0, telemetry->getTrackedBlocks());
+    telemetry->release(nullptr);
+}
+
+void test_foreign_block_freed_as_is(void) {
+    void* ours = allocate(64);
+    // A plain malloc block whose preceding bytes look like nothing we wrote
+    void* foreign = malloc(64);
+    telemetry->release(foreign);
+    HeapTotals totals = telemetry->getTotals();
+    TEST_ASSERT_EQUAL_UINT32(1, totals.foreignFrees);
+    TEST_ASSERT_EQUAL_UINT32(64, totals.liveBytes);
+    TEST_ASSERT_EQUAL_UINT32(0, totals.sources[HEAP_SOURCE_EI].frees);
+    TEST_ASSERT_EQUAL_UINT32(1, telemetry->getTrackedBlocks());
+
+    telemetry->release(ours);
+    totals = telemetry->getTotals();
+    TEST_ASSERT_EQUAL_UINT32(0, totals.liveBytes);
+    TEST_ASSERT_EQUAL_UINT32(1, totals.foreignFrees);
+}
+
+void test_array_size_overflow_fails(void) {
+    TEST_ASSERT_NULL(telemetry->allocateArray(SIZE_MAX / 2 + 1, 2, HEAP_SOURCE_EI, 0x1000));
+    TEST_ASSERT_NULL(telemetry->allocateArray(3, SIZE_MAX / 2, HEAP_SOURCE_EI, 0x1000));
+    HeapTotals totals = telemetry->getTotals();
+    TEST_ASSERT_EQUAL_UINT32(2, totals.sources[HEAP_SOURCE_EI].failures);
+    TEST_ASSERT_EQUAL_UINT32(0, totals.sources[HEAP_SOURCE_EI].allocations);
+
+    uint32_t* zeroed = (uint32_t*)telemetry->allocateArray(16, sizeof(uint32_t), HEAP_SOURCE_EI, 0x1000);
+    TEST_ASSERT_NOT_NULL(zeroed);
+    for (int i = 0; i < 16; i++) TEST_ASSERT_EQUAL_UINT32(0, zeroed[i]);
+    TEST_ASSERT_EQUAL_UINT32(64, telemetry->getTotals().liveBytes);
+    telemetry->release(zeroed);
+}
+
+void test_full_table_falls_back_to_untracked(void) {
+    std::vector<void*> blocks;
+    for (size_t i = 0; i < LIVE_LIMIT + 10; i++) {
+        void* ptr = allocate(8);
+        TEST_ASSERT_NOT_NULL(ptr);
+        blocks.push_back(ptr);
+    }
+    HeapTotals totals = telemetry->getTotals();
+    TEST_ASSERT_EQUAL_UINT32(10, totals.untrackedBlocks);
+    TEST_ASSERT_EQUAL_UINT32(LIVE_LIMIT * 8, totals.liveBytes);
+    TEST_ASSERT_EQUAL_UINT32(LIVE_LIMIT, telemetry->getTrackedBlocks());
+
+    // Untracked blocks come back as foreign frees; tracked ones balance out
+    for (size_t i = 0; i < blocks.size(); i++) telemetry->release(blocks[blocks.size() - 1 - i]);
+    totals = telemetry->getTotals();
+    TEST_ASSERT_EQUAL_UINT32(10, totals.foreignFrees);
+    TEST_ASSERT_EQUAL_UINT32(0, totals.liveBytes);
+    TEST_ASSERT_EQUAL_UINT32(0, telemetry->getTrackedBlocks());
+}
+
+void test_table_exact_through_churn(void) {
+    // Random frees reorder the probe runs; a lost entry would show up as a
+    // foreign free and a live-byte mismatch
+    std::vector<std::pair<void*, size_t> > live;
+    uint32_t seed = 12345;
+    uint64_t expectedBytes = 0;
+    for (int op = 0; op < 50000; op++) {
+        seed = seed * 1103515245u + 12345u;
+        bool grow = live.size() < 16 || (live.size() < LIVE_LIMIT - 1 && (seed >> 16) % 3 != 0);
+        if (grow) {
+            size_t size = 1 + (seed >> 8) % 200;
+            void* ptr = allocate(size);
+            TEST_ASSERT_NOT_NULL(ptr);
+            live.push_back(std::make_pair(ptr, size));
+            expectedBytes += size;
+        } else {
+            size_t index = (seed >> 12) % live.size();
+            telemetry->release(live[index].first);
+            expectedBytes -= live[index].second;
+            live[index] = live.back();
+            live.pop_back();
+        }
+    }
+    HeapTotals totals = telemetry->getTotals();
+    TEST_ASSERT_EQUAL_UINT32(0, totals.foreignFrees);
+    TEST_ASSERT_EQUAL_UINT32(0, totals.untrackedBlocks);
+    TEST_ASSERT_EQUAL_UINT32(live.size(), telemetry->getTrackedBlocks());
+    TEST_ASSERT_EQUAL_UINT32((uint32_t)expectedBytes, totals.liveBytes);
+    for (size_t i = 0; i < live.size(); i++) telemetry->release(live[i].first);
+    TEST_ASSERT_EQUAL_UINT32(0, telemetry->getTotals().liveBytes);
+    TEST_ASSERT_EQUAL_UINT32(0, telemetry->getTotals().foreignFrees);
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_blocks_accounted_until_released);
+    RUN_TEST(test_foreign_block_freed_as_is);
+    RUN_TEST(test_array_size_overflow_fails);
+    RUN_TEST(test_full_table_falls_back_to_untracked);
+    RUN_TEST(test_table_exact_through_churn);
+    return UNITY_END();
+}
@@ -0,0 +1,107 @@
+// LatencyHistogram and the exposition writer: observations land in the
+// right bucket, the 64-bit sum carries across the low word's wrap, a
+// scrape racing writers that keep carrying never sees the sum go back,
+// and histogram series come out cumulative with their sum and count.
+//
+//   pio test -e native -f test_metrics
+
+#include <unity.h>
+#include <string.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "runtime/metrics.h"
+
+static LatencyHistogram* histogram;
+
+void setUp(void) {
+    histogram = new LatencyHistogram();
+}
+
+void tearDown(void) {
+    delete histogram;
+}
+
+void test_observations_bucketed_by_upper_bound(void) {
+    histogram->observe(0);
+    histogram->observe(500);
+    histogram->observe(501);
+    histogram->observe(1000000);
+    histogram->observe(1000001);
+    TEST_ASSERT_EQUAL_UINT32(2, histogram->getBucket(0));
+    TEST_ASSERT_EQUAL_UINT32(1, histogram->getBucket(1));
+    TEST_ASSERT_EQUAL_UINT32(1, histogram->getBucket(METRICS_LATENCY_BUCKETS - 2));
+    TEST_ASSERT_EQUAL_UINT32(1, histogram->getBucket(METRICS_LATENCY_BUCKETS - 1));
+    TEST_ASSERT_EQUAL_UINT32(5, histogram->getCount());
+    TEST_ASSERT_TRUE(histogram->getSumUs() == 2001002ULL);
+}
+
+void test_sum_carries_across_low_word(void) {
+    for (int i = 0; i < 5; i++) histogram->observe(0xFFFFFFF0u);
+    TEST_ASSERT_TRUE(histogram->getSumUs() == 5ULL * 0xFFFFFFF0u);
+    histogram->observe(0x50);
+    TEST_ASSERT_TRUE(histogram->getSumUs() == 5ULL * 0xFFFFFFF0u + 0x50);
+}
+
+void test_racing_scrape_never_sees_sum_go_back(void) {
+    // Every observation wraps the low word, so a reader that caught one
+    // between its low add and its carry would see the sum drop by 2^32
+    const int writers = 4;
+    const int perWriter = 200000;
+    std::atomic<bool> done(false);
+    std::atomic<int> regressions(0);
+    std::thread reader([&]() {
+        uint64_t last = 0;
+        while (!done.load()) {
+            uint64_t sum = histogram->getSumUs();
+            if (sum < last) regressions++;
+            last = sum;
+        }
+    });
+    std::vector<std::thread> threads;
+    for (int w = 0; w < writers; w++) {
+        threads.push_back(std::thread([&]() {
+            for (int i = 0; i < perWriter; i++) histogram->observe(0xFFFFFFF0u);
+        }));
+    }
+    for (size_t t = 0; t < threads.size(); t++) threads[t].join();
+    done = true;
+    reader.join();
+    TEST_ASSERT_EQUAL_INT(0, regressions.load());
+    TEST_ASSERT_EQUAL_UINT32(writers * perWriter, histogram->getCount());
+    TEST_ASSERT_TRUE(histogram->getSumUs() == (uint64_t)writers * perWriter * 0xFFFFFFF0u);
+}
+
+void test_histogram_series_cumulative(void) {
+    histogram->observe(400);
+    histogram->observe(2000);
+    histogram->observe(2000000);
+    char buffer[2048];
+    MetricsWriter writer(buffer, sizeof(buffer));
+    writer.histogram("stage_latency_seconds", "stage", "dsp", *histogram);
+    TEST_ASSERT_FALSE(writer.overflowed());
+    TEST_ASSERT_NOT_NULL(strstr(buffer, METRICS_PREFIX "stage_latency_seconds_bucket{stage=\"dsp\",le=\"0.0005\"} 1\n"));
+    TEST_ASSERT_NOT_NULL(strstr(buffer, METRICS_PREFIX "stage_latency_seconds_bucket{stage=\"dsp\",le=\"0.0025\"} 2\n"));
+    TEST_ASSERT_NOT_NULL(strstr(buffer, METRICS_PREFIX "stage_latency_seconds_bucket{stage=\"dsp\",le=\"1\"} 2\n"));
+    TEST_ASSERT_NOT_NULL(strstr(buffer, METRICS_PREFIX "stage_latency_seconds_bucket{stage=\"dsp\",le=\"+Inf\"} 3\n"));
+    TEST_ASSERT_NOT_NULL(strstr(buffer, METRICS_PREFIX "stage_latency_seconds_sum{stage=\"dsp\"} 2.002400\n"));
+    TEST_ASSERT_NOT_NULL(strstr(buffer, METRICS_PREFIX "stage_latency_seconds_count{stage=\"dsp\"} 3\n"));
+}
+
+void test_writer_reports_overflow(void) {
+    char buffer[64];
+    MetricsWriter writer(buffer, sizeof(buffer));
+    writer.histogram("stage_latency_seconds", "stage", "dsp", *histogram);
+    TEST_ASSERT_TRUE(writer.overflowed());
+    TEST_ASSERT_EQUAL_UINT32(sizeof(buffer) - 1, strlen(buffer));
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_observations_bucketed_by_upper_bound);
+    RUN_TEST(test_sum_carries_across_low_word);
+    RUN_TEST(test_racing_scrape_never_sees_sum_go_back);
+    RUN_TEST(test_histogram_series_cumulative);
+    RUN_TEST(test_writer_reports_overflow);
+    return UNITY_END();
+}
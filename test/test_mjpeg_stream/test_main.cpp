@@ -0,0 +1,152 @@
+// MjpegStreamHub and MjpegClient: capture is paced by the target rate and
+// only runs while someone watches, a part comes out as header, JPEG and CRLF
+// through any buffer size, a client that falls behind skips to the newest
+// frame and the skipped ones are counted as dropped, the frame being sent is
+// kept while newer ones replace it, and the last disconnect releases it.
+//
+//   pio test -e native -f test_mjpeg_stream
+
+#include <unity.h>
+#include <string.h>
+#include <string>
+#include "web/mjpeg_stream.h"
+
+static MjpegStreamHub* hub;
+
+void setUp(void) {
+    hub = new MjpegStreamHub();
+}
+
+void tearDown(void) {
+    delete hub;
+}
+
+// A malloc'd stand-in JPEG of length bytes, all set to fill
+static void publishFrame(uint8_t fill, size_t length, uint32_t nowMs) {
+    uint8_t* jpeg = (uint8_t*)malloc(length);
+    memset(jpeg, fill, length);
+    hub->publish(jpeg, length, nowMs);
+}
+
+// Drain one part through a chunkBytes buffer; "" if there was nothing to send
+static std::string drainPart(MjpegClient& client, size_t chunkBytes) {
+    std::string part;
+    uint8_t buffer[64];
+    uint32_t sentBefore = hub->getStats().sent;
+    while (hub->getStats().sent == sentBefore) {
+        size_t n = client.fill(buffer, chunkBytes);
+        if (n == RESPONSE_TRY_AGAIN) break;
+        part.append((const char*)buffer, n);
+    }
+    return part;
+}
+
+static std::string expectedPart(uint8_t fill, size_t length) {
+    char header[96];
+    snprintf(header, sizeof(header),
+             "--" MJPEG_BOUNDARY "\r\nContent-Type: image/jpeg\r\nContent-Length: %u\r\n\r\n",
+             (unsigned)length);
+    return std::string(header) + std::string(length, (char)fill) + "\r\n";
+}
+
+void test_capture_paced_while_watched(void) {
+    TEST_ASSERT_FALSE(hub->wantsFrame(1000));
+    MjpegClient* client = new MjpegClient(hub);
+    hub->setTargetFps(5);
+    TEST_ASSERT_TRUE(hub->wantsFrame(1000));
+    publishFrame(1, 10, 1000);
+    TEST_ASSERT_FALSE(hub->wantsFrame(1199));
+    TEST_ASSERT_TRUE(hub->wantsFrame(1200));
+
+    // The target is clamped to the supported range
+    hub->setTargetFps(100);
+    TEST_ASSERT_EQUAL_INT(MJPEG_MAX_FPS, hub->getTargetFps());
+    hub->setTargetFps(0);
+    TEST_ASSERT_EQUAL_INT(1, hub->getTargetFps());
+
+    delete client;
+    TEST_ASSERT_FALSE(hub->wantsFrame(5000));
+}
+
+void test_part_framing_at_any_buffer_size(void) {
+    MjpegClient client(hub);
+    uint8_t buffer[64];
+    TEST_ASSERT_TRUE(client.fill(buffer, sizeof(buffer)) == RESPONSE_TRY_AGAIN);
+
+    const size_t sizes[] = { 1, 3, 17, 64 };
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        publishFrame((uint8_t)('a' + i), 150, 1000 + i * 200);
+        TEST_ASSERT_TRUE(drainPart(client, sizes[i]) == expectedPart('a' + i, 150));
+        // Nothing newer: ask to be called again
+        TEST_ASSERT_TRUE(client.fill(buffer, sizeof(buffer)) == RESPONSE_TRY_AGAIN);
+    }
+    MjpegStats stats = hub->getStats();
+    TEST_ASSERT_EQUAL_UINT32(4, stats.published);
+    TEST_ASSERT_EQUAL_UINT32(4, stats.sent);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.dropped);
+}
+
+void test_slow_client_skips_to_newest(void) {
+    MjpegClient client(hub);
+    uint8_t buffer[64];
+    publishFrame('a', 100, 1000);
+    // Part-way through the first frame, three more are published
+    TEST_ASSERT_EQUAL_UINT32(16, client.fill(buffer, 16));
+    publishFrame('b', 100, 1200);
+    publishFrame('c', 100, 1400);
+    publishFrame('d', 100, 1600);
+
+    // The frame in flight is finished intact, then only the newest follows
+    std::string rest = drainPart(client, 64);
+    TEST_ASSERT_TRUE(std::string((const char*)buffer, 16) + rest == expectedPart('a', 100));
+    TEST_ASSERT_EQUAL_UINT32(0, hub->getStats().dropped);
+    TEST_ASSERT_TRUE(drainPart(client, 64) == expectedPart('d', 100));
+    TEST_ASSERT_EQUAL_UINT32(2, hub->getStats().dropped);
+    TEST_ASSERT_EQUAL_UINT32(2, hub->getStats().sent);
+}
+
+void test_drops_counted_per_client(void) {
+    MjpegClient fast(hub);
+    MjpegClient* slow = new MjpegClient(hub);
+    TEST_ASSERT_EQUAL_INT(2, hub->getClients());
+
+    publishFrame('a', 40, 1000);
+    TEST_ASSERT_TRUE(drainPart(fast, 64) == expectedPart('a', 40));
+    TEST_ASSERT_TRUE(drainPart(*slow, 64) == expectedPart('a', 40));
+    for (int i = 0; i < 4; i++) {
+        publishFrame((uint8_t)('b' + i), 40, 1200 + i * 200);
+        TEST_ASSERT_TRUE(drainPart(fast, 64) == expectedPart('b' + i, 40));
+    }
+    TEST_ASSERT_TRUE(drainPart(*slow, 64) == expectedPart('e', 40));
+    MjpegStats stats = hub->getStats();
+    TEST_ASSERT_EQUAL_UINT32(7, stats.sent);
+    TEST_ASSERT_EQUAL_UINT32(3, stats.dropped);
+
+    // The first client to leave keeps the newest frame for the other
+    delete slow;
+    TEST_ASSERT_TRUE(hub->frameAfter(0) != nullptr);
+}
+
+void test_last_disconnect_releases_frame(void) {
+    MjpegClient* client = new MjpegClient(hub);
+    publishFrame('a', 40, 1000);
+    TEST_ASSERT_TRUE(hub->frameAfter(0) != nullptr);
+    delete client;
+    TEST_ASSERT_EQUAL_INT(0, hub->getClients());
+    TEST_ASSERT_TRUE(hub->frameAfter(0) == nullptr);
+
+    // A new viewer waits for a fresh frame instead of a stale one
+    MjpegClient again(hub);
+    uint8_t buffer[64];
+    TEST_ASSERT_TRUE(again.fill(buffer, sizeof(buffer)) == RESPONSE_TRY_AGAIN);
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_capture_paced_while_watched);
+    RUN_TEST(test_part_framing_at_any_buffer_size);
+    RUN_TEST(test_slow_client_skips_to_newest);
+    RUN_TEST(test_drops_counted_per_client);
+    RUN_TEST(test_last_disconnect_releases_frame);
+    return UNITY_END();
+}
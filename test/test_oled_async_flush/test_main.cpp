@@ -0,0 +1,146 @@
+// AsyncOledFlusher against a panel whose transfers take their 400 kHz bus
+// time: the panel ends on the last submitted frame, bursts coalesce, and a
+// 20 ms UI loop redrawing a countdown keeps its period when the flush runs
+// on the background task, where the same loop flushing inline stalls for
+// every transfer. The loop jitter of both variants is printed.
+//
+//   pio test -e native -f test_oled_async_flush
+
+#include <unity.h>
+#include <stdio.h>
+#include <thread>
+#include "ui/oled_async_flush.h"
+#include "runtime/loop_jitter.h"
+
+static const uint32_t BYTE_NS = 22500;     // 9 bit times at 400 kHz
+static const int UI_TICK_MS = 20;
+
+// Framebuffer panel that blocks the flushing task for the bytes' bus time
+class BusTimedBackend : public FramebufferOledBackend {
+public:
+    size_t writeRegion(int page, int colStart, int colEnd, const uint8_t* data) override {
+        size_t bytes = FramebufferOledBackend::writeRegion(page, colStart, colEnd, data);
+        std::this_thread::sleep_for(std::chrono::nanoseconds((uint64_t)BYTE_NS * bytes));
+        return bytes;
+    }
+};
+
+static BusTimedBackend* panel;
+static OledRenderer* renderer;
+static AsyncOledFlusher* flusher;
+static uint8_t framebuffer[OLED_FRAME_BYTES];
+
+void setUp(void) {
+    panel = new BusTimedBackend();
+    renderer = new OledRenderer(panel);
+    flusher = new AsyncOledFlusher(renderer);
+    memset(framebuffer, 0, sizeof(framebuffer));
+}
+
+void tearDown(void) {
+    flusher->stop();
+    delete flusher;
+    delete renderer;
+    delete panel;
+}
+
+// A countdown's digits: three pages by 60 columns change every frame, and
+// every tenth frame the whole screen changes (a new message)
+static void drawFrame(int frame) {
+    if (frame % 10 == 0) {
+        memset(framebuffer, frame & 0xFF, sizeof(framebuffer));
+    }
+    for (int page = 2; page < 5; page++) {
+        memset(framebuffer + page * OLED_WIDTH + 10, (frame * 37 + page) & 0xFF, 60);
+    }
+}
+
+static void waitIdle() {
+    for (int i = 0; i < 500 && flusher->isBusy(); i++) rtSleepMs(2);
+}
+
+// The UI task's shape: tick work, then sleep for the tick
+static void runUiLoop(LoopJitterMeter& meter, bool async, int frames) {
+    for (int frame = 0; frame < frames; frame++) {
+        meter.tick();
+        drawFrame(frame);
+        if (async) {
+            flusher->submit(framebuffer);
+        } else {
+            renderer->flush(framebuffer, rtMillis());
+        }
+        rtSleepMs(UI_TICK_MS);
+    }
+}
+
+void test_panel_ends_on_last_frame(void) {
+    TEST_ASSERT_TRUE(flusher->start());
+    for (int frame = 0; frame < 20; frame++) {
+        drawFrame(frame);
+        flusher->submit(framebuffer);
+        rtSleepMs(5);
+    }
+    waitIdle();
+    TEST_ASSERT_FALSE(flusher->isBusy());
+    TEST_ASSERT_EQUAL_MEMORY(framebuffer, panel->getFrame(), OLED_FRAME_BYTES);
+    TEST_ASSERT_EQUAL_UINT32(20, flusher->getSubmitted());
+    TEST_ASSERT_EQUAL_UINT32(20, flusher->getFlushed() + flusher->getCoalesced());
+}
+
+void test_burst_coalesces(void) {
+    TEST_ASSERT_TRUE(flusher->start());
+    // Ten frames while the first full-screen transfer is still on the bus
+    for (int frame = 0; frame < 10; frame++) {
+        drawFrame(frame * 10);
+        flusher->submit(framebuffer);
+    }
+    waitIdle();
+    TEST_ASSERT_GREATER_THAN(0, flusher->getCoalesced());
+    TEST_ASSERT_LESS_THAN(10, flusher->getFlushed());
+    TEST_ASSERT_EQUAL_MEMORY(framebuffer, panel->getFrame(), OLED_FRAME_BYTES);
+}
+
+void test_stop_joins_flush_task(void) {
+    TEST_ASSERT_TRUE(flusher->start());
+    drawFrame(0);
+    flusher->submit(framebuffer);
+    flusher->stop();
+    TEST_ASSERT_FALSE(flusher->isRunning());
+    // Restartable, and the restarted task picks up new frames
+    TEST_ASSERT_TRUE(flusher->start());
+    drawFrame(10);
+    flusher->submit(framebuffer);
+    waitIdle();
+    TEST_ASSERT_EQUAL_MEMORY(framebuffer, panel->getFrame(), OLED_FRAME_BYTES);
+}
+
+void test_async_flush_keeps_ui_period(void) {
+    const int FRAMES = 60;
+    LoopJitterMeter inlineMeter("inline flush");
+    runUiLoop(inlineMeter, false, FRAMES);
+
+    renderer->invalidate();
+    TEST_ASSERT_TRUE(flusher->start());
+    LoopJitterMeter asyncMeter("async flush");
+    runUiLoop(asyncMeter, true, FRAMES);
+    waitIdle();
+
+    printf("[jitter] %s: period avg %.0f us, stddev %.0f us, max %lu us\n", "inline flush",
+           inlineMeter.getMeanUs(), inlineMeter.getStdDevUs(), (unsigned long)inlineMeter.getMaxUs());
+    printf("[jitter] %s: period avg %.0f us, stddev %.0f us, max %lu us\n", "async flush",
+           asyncMeter.getMeanUs(), asyncMeter.getStdDevUs(), (unsigned long)asyncMeter.getMaxUs());
+
+    // Inline, every full-screen frame adds its ~25 ms transfer to the period
+    TEST_ASSERT_GREATER_THAN(UI_TICK_MS * 1000 + 20000, inlineMeter.getMaxUs());
+    TEST_ASSERT_LESS_THAN(UI_TICK_MS * 1000 + 5000, asyncMeter.getMaxUs());
+    TEST_ASSERT_TRUE(asyncMeter.getStdDevUs() < inlineMeter.getStdDevUs());
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_panel_ends_on_last_frame);
+    RUN_TEST(test_burst_coalesces);
+    RUN_TEST(test_stop_joins_flush_task);
+    RUN_TEST(test_async_flush_keeps_ui_period);
+    return UNITY_END();
+}
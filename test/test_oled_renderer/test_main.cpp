@@ -0,0 +1,175 @@
+// OledRenderer dirty-region flushing into FramebufferOledBackend: after every
+// flush the backend's copy of the panel must equal the framebuffer, and only
+// the changed column span of changed pages may be sent. The I2C backend
+// holds the shared bus for the whole flush.
+//
+//   pio test -e native -f test_oled_renderer
+
+#include <unity.h>
+#include <thread>
+#include "ui/oled_renderer.h"
+
+static FramebufferOledBackend* panel;
+static OledRenderer* renderer;
+static uint8_t framebuffer[OLED_FRAME_BYTES];
+static uint32_t randomState;
+
+void setUp(void) {
+    panel = new FramebufferOledBackend();
+    renderer = new OledRenderer(panel);
+    memset(framebuffer, 0, sizeof(framebuffer));
+    randomState = 4242;
+}
+
+void tearDown(void) {
+    delete renderer;
+    delete panel;
+}
+
+static uint32_t nextRandom() {
+    randomState = randomState * 1664525u + 1013904223u;
+    return randomState >> 8;
+}
+
+static void setPixel(int x, int y, bool on) {
+    uint8_t bit = 1 << (y & 7);
+    uint8_t& cell = framebuffer[(y / 8) * OLED_WIDTH + x];
+    cell = on ? (cell | bit) : (cell & ~bit);
+}
+
+// Bytes the I2C backend puts on the bus for one region of count columns
+static size_t regionBytes(int count) {
+    int chunks = (count + SSD1306I2CBackend::CHUNK - 1) / SSD1306I2CBackend::CHUNK;
+    return 8 + count + chunks * 2;
+}
+
+static void assertPanelMatches() {
+    TEST_ASSERT_EQUAL_MEMORY(framebuffer, panel->getFrame(), OLED_FRAME_BYTES);
+}
+
+void test_first_flush_sends_every_page(void) {
+    framebuffer[5] = 0x81;
+    size_t bytes = renderer->flush(framebuffer, 0);
+    assertPanelMatches();
+    TEST_ASSERT_EQUAL_UINT32(OLED_PAGES, panel->getRegionsWritten());
+    TEST_ASSERT_EQUAL_UINT32(OLED_PAGES * regionBytes(OLED_WIDTH), bytes);
+}
+
+void test_unchanged_frame_sends_nothing(void) {
+    renderer->flush(framebuffer, 0);
+    unsigned long regions = panel->getRegionsWritten();
+    TEST_ASSERT_EQUAL_UINT32(0, renderer->flush(framebuffer, 10));
+    TEST_ASSERT_EQUAL_UINT32(regions, panel->getRegionsWritten());
+    TEST_ASSERT_EQUAL_UINT32(1, renderer->getSkippedFlushes());
+    TEST_ASSERT_EQUAL_UINT32(2, renderer->getFlushes());
+}
+
+void test_single_pixel_sends_one_column(void) {
+    renderer->flush(framebuffer, 0);
+    unsigned long regions = panel->getRegionsWritten();
+    setPixel(77, 21, true);
+    size_t bytes = renderer->flush(framebuffer, 10);
+    assertPanelMatches();
+    TEST_ASSERT_TRUE(panel->getPixel(77, 21));
+    TEST_ASSERT_EQUAL_UINT32(regions + 1, panel->getRegionsWritten());
+    TEST_ASSERT_EQUAL_UINT32(regionBytes(1), bytes);
+}
+
+void test_region_spans_first_to_last_change(void) {
+    renderer->flush(framebuffer, 0);
+    // Two changes on page 3, one on page 6: spans 10..90 and 127..127
+    setPixel(10, 24, true);
+    setPixel(90, 31, true);
+    setPixel(127, 55, true);
+    size_t bytes = renderer->flush(framebuffer, 10);
+    assertPanelMatches();
+    TEST_ASSERT_EQUAL_UINT32(regionBytes(81) + regionBytes(1), bytes);
+
+    // Clearing a pixel is a change too
+    setPixel(10, 24, false);
+    TEST_ASSERT_EQUAL_UINT32(regionBytes(1), renderer->flush(framebuffer, 20));
+    assertPanelMatches();
+}
+
+void test_invalidate_resends_everything(void) {
+    renderer->flush(framebuffer, 0);
+    renderer->invalidate();
+    TEST_ASSERT_EQUAL_UINT32(OLED_PAGES * regionBytes(OLED_WIDTH), renderer->flush(framebuffer, 10));
+    assertPanelMatches();
+}
+
+void test_random_edits_keep_panel_in_sync(void) {
+    renderer->flush(framebuffer, 0);
+    size_t full = OLED_PAGES * regionBytes(OLED_WIDTH);
+    for (int frame = 1; frame <= 200; frame++) {
+        int edits = 1 + nextRandom() % 12;
+        for (int i = 0; i < edits; i++) {
+            setPixel(nextRandom() % OLED_WIDTH, nextRandom() % OLED_HEIGHT, nextRandom() & 1);
+        }
+        size_t bytes = renderer->flush(framebuffer, frame * 50);
+        assertPanelMatches();
+        TEST_ASSERT_LESS_OR_EQUAL(full, bytes);
+    }
+}
+
+void test_sparse_edits_cost_less_than_full_frames(void) {
+    renderer->flush(framebuffer, 0);
+    size_t total = 0;
+    for (int frame = 1; frame <= 50; frame++) {
+        // A small moving glyph: an 8x8 block walking right on page 2
+        int x = frame % (OLED_WIDTH - 8);
+        memset(framebuffer + 2 * OLED_WIDTH, 0, OLED_WIDTH);
+        memset(framebuffer + 2 * OLED_WIDTH + x, 0xFF, 8);
+        total += renderer->flush(framebuffer, frame * 50);
+        assertPanelMatches();
+    }
+    TEST_ASSERT_LESS_THAN(50 * OLED_PAGES * regionBytes(OLED_WIDTH) / 10, total);
+}
+
+void test_byte_count_matches_i2c_backend(void) {
+    // The host backend must charge exactly what the I2C backend sends
+    SSD1306I2CBackend i2c;
+    uint8_t data[OLED_WIDTH];
+    memset(data, 0x55, sizeof(data));
+    for (int count = 1; count <= OLED_WIDTH; count++) {
+        TEST_ASSERT_EQUAL_UINT32(i2c.writeRegion(0, 0, count - 1, data),
+                                 panel->writeRegion(0, 0, count - 1, data));
+    }
+}
+
+void test_i2c_flush_waits_for_bus(void) {
+    // The camera side holds the shared bus; a flush must not start until it
+    // is released
+    SSD1306I2CBackend i2c;
+    OledRenderer busRenderer(&i2c);
+    std::atomic<bool> held(false);
+    std::thread camera([&] {
+        I2cBusLock bus;
+        held = true;
+        rtSleepMs(20);
+    });
+    while (!held.load()) rtSleepMs(1);
+    I2cBus::resetStats();
+    uint32_t start = rtMicros();
+    busRenderer.flush(framebuffer, 0);
+    uint32_t elapsed = rtMicros() - start;
+    camera.join();
+    TEST_ASSERT_GREATER_OR_EQUAL(15000, elapsed);
+
+    // endFlush() released the bus again (this would block forever otherwise)
+    I2cBusLock bus;
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_first_flush_sends_every_page);
+    RUN_TEST(test_unchanged_frame_sends_nothing);
+    RUN_TEST(test_single_pixel_sends_one_column);
+    RUN_TEST(test_region_spans_first_to_last_change);
+    RUN_TEST(test_invalidate_resends_everything);
+    RUN_TEST(test_random_edits_keep_panel_in_sync);
+    RUN_TEST(test_sparse_edits_cost_less_than_full_frames);
+    RUN_TEST(test_byte_count_matches_i2c_backend);
+    RUN_TEST(test_i2c_flush_waits_for_bus);
+    return UNITY_END();
+}
@@ -0,0 +1,162 @@
+// PowerManager on SimulatedPowerBackend: the sleep/delay policy, wake-up
+// lateness and camera accounting, and the real state machine running a
+// 1-minute countdown with the policy in charge of every idle gap, and a
+// countdown that keeps accepting timers in short camera-on windows.
+//
+//   pio test -e native -f test_power_manager
+
+#include <unity.h>
+#include "ui/oled.h"
+#include "ui/buzzer.h"
+#include "logic/state_machine.h"
+#include "runtime/power_manager.h"
+
+static SimulatedPowerBackend* backend;
+static PowerManager* power;
+
+void setUp(void) {
+    backend = new SimulatedPowerBackend(0, 1);
+    power = new PowerManager(backend);
+}
+
+void tearDown(void) {
+    delete power;
+    delete backend;
+}
+
+void test_short_gap_is_a_delay(void) {
+    TEST_ASSERT_EQUAL_UINT32(10, power->idle(10, true));
+    TEST_ASSERT_EQUAL_UINT32(0, power->getSleepCount());
+    TEST_ASSERT_EQUAL_UINT32(1, power->getSkippedSleeps());
+    TEST_ASSERT_EQUAL_UINT32(10, power->getIdleAwakeMs());
+}
+
+void test_disallowed_sleep_is_a_delay(void) {
+    power->idle(500, false);
+    TEST_ASSERT_EQUAL_UINT32(0, power->getSleepCount());
+    TEST_ASSERT_EQUAL_UINT32(0, power->getSkippedSleeps());
+    TEST_ASSERT_EQUAL_UINT32(500, power->getAwakeMs());
+    TEST_ASSERT_EQUAL_UINT32(0, power->getAsleepMs());
+}
+
+void test_long_gap_sleeps_ahead_of_deadline(void) {
+    // Sleeps budget - sleepWakeMs (2) and wakes 1 ms later: on time
+    power->idle(500, true);
+    TEST_ASSERT_EQUAL_UINT32(1, power->getSleepCount());
+    TEST_ASSERT_EQUAL_UINT32(499, power->getAsleepMs());
+    TEST_ASSERT_EQUAL_UINT32(499, backend->nowMs());
+    TEST_ASSERT_EQUAL_UINT32(0, power->getMaxWakeLateMs());
+}
+
+void test_slow_wake_is_counted_late(void) {
+    SimulatedPowerBackend slow(0, 5);
+    PowerManager slowPower(&slow);
+    slowPower.idle(500, true);
+    TEST_ASSERT_EQUAL_UINT32(503, slow.nowMs());
+    TEST_ASSERT_EQUAL_UINT32(3, slowPower.getMaxWakeLateMs());
+}
+
+void test_sleep_disabled(void) {
+    power->setSleepEnabled(false);
+    power->idle(500, true);
+    TEST_ASSERT_EQUAL_UINT32(0, power->getSleepCount());
+    TEST_ASSERT_EQUAL_UINT32(500, power->getAwakeMs());
+}
+
+void test_camera_standby_lowers_current(void) {
+    backend->advance(1000);
+    float cameraOn = power->getAverageCurrentMa();
+    power->noteCameraStandby(true);
+    backend->advance(9000);
+    TEST_ASSERT_TRUE(power->isCameraStandby());
+    float mostlyStandby = power->getAverageCurrentMa();
+    TEST_ASSERT_TRUE(mostlyStandby < cameraOn);
+    // 1 s at 45 + 70 mA, 9 s at 45 + 1.5 mA
+    TEST_ASSERT_FLOAT_WITHIN(0.1f, (115.0f + 9 * 46.5f) / 10, mostlyStandby);
+}
+
+static SimulatedPowerBackend* clockSource;
+static uint32_t simulatedClock() { return clockSource->nowMs(); }
+
+// Work per wake-up: state machine update plus a countdown redraw over I2C
+static const uint32_t WORK_MS = 5;
+
+void test_countdown_mostly_asleep(void) {
+    clockSource = backend;
+    TimerStateMachine machine;
+    machine.setClock(simulatedClock);
+    machine.setAcceptWhileRunning(false);
+    machine.init(nullptr, nullptr, nullptr);
+    power->noteCameraStandby(true);
+
+    machine.addTimer(1, 0);
+    power->reset();
+    int iterations = 0;
+    while (machine.getState() == STATE_RUNNING) {
+        machine.update();
+        backend->advance(WORK_MS);
+        power->idle(machine.msUntilNextEvent(), true);
+        iterations++;
+    }
+
+    uint64_t total = power->getAwakeMs() + power->getAsleepMs();
+    float asleep = (float)power->getAsleepMs() / total;
+    printf("[power] 1-minute countdown: %.2f%% asleep, %lu sleeps, %d loop iterations, avg %.2f mA\n",
+           asleep * 100.0f, power->getSleepCount(), iterations, power->getAverageCurrentMa());
+    TEST_ASSERT_GREATER_OR_EQUAL(60000, total);
+    // One sleep per displayed second (the "Timer Set!" hold replaces two).
+    // Each wake-up lands just ahead of its deadline and waits it out awake.
+    TEST_ASSERT_GREATER_OR_EQUAL(58, power->getSleepCount());
+    TEST_ASSERT_LESS_OR_EQUAL(61, power->getSleepCount());
+    TEST_ASSERT_LESS_OR_EQUAL(2 * 61, iterations);
+    TEST_ASSERT_TRUE(asleep > 0.99f);
+    TEST_ASSERT_EQUAL_UINT32(0, power->getMaxWakeLateMs());
+}
+
+void test_detect_windows_power_camera_down(void) {
+    // Accepting timers while running: the camera is powered only for the
+    // detection windows, and the chip stays awake through them (capture and
+    // inference are in flight) but sleeps in between
+    clockSource = backend;
+    TimerStateMachine machine;
+    machine.setClock(simulatedClock);
+    machine.setAcceptWhileRunning(true);
+    machine.init(nullptr, nullptr, nullptr);
+
+    machine.addTimer(5, 0);
+    power->reset();
+    uint64_t cameraOnMs = 0;
+    while (machine.getState() == STATE_RUNNING) {
+        machine.update();
+        bool detecting = machine.acceptsNewTimers();
+        power->noteCameraStandby(!detecting);
+        uint32_t start = backend->nowMs();
+        backend->advance(WORK_MS);
+        uint32_t budget = machine.msUntilNextEvent();
+        if (budget > (detecting ? 100u : 1000u)) budget = detecting ? 100 : 1000;
+        power->idle(budget, !detecting);
+        if (detecting) cameraOnMs += backend->nowMs() - start;
+    }
+
+    uint64_t total = power->getAwakeMs() + power->getAsleepMs();
+    float cameraOn = (float)cameraOnMs / total;
+    printf("[power] 5-minute countdown with detection windows: camera on %.1f%%, %.2f%% asleep, avg %.2f mA\n",
+           cameraOn * 100.0f, 100.0f * power->getAsleepMs() / total, power->getAverageCurrentMa());
+    float windowShare = (float)TimerStateMachine::DETECT_WINDOW / TimerStateMachine::DETECT_PERIOD;
+    TEST_ASSERT_FLOAT_WITHIN(0.02f, windowShare, cameraOn);
+    // The camera left on for the whole countdown would draw 115 mA
+    TEST_ASSERT_TRUE(power->getAverageCurrentMa() < 20.0f);
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_short_gap_is_a_delay);
+    RUN_TEST(test_disallowed_sleep_is_a_delay);
+    RUN_TEST(test_long_gap_sleeps_ahead_of_deadline);
+    RUN_TEST(test_slow_wake_is_counted_late);
+    RUN_TEST(test_sleep_disabled);
+    RUN_TEST(test_camera_standby_lowers_current);
+    RUN_TEST(test_countdown_mostly_asleep);
+    RUN_TEST(test_detect_windows_power_camera_down);
+    return UNITY_END();
+}
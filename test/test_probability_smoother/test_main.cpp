@@ -0,0 +1,240 @@
+// ProbabilitySmoother: priming, dwell and hysteresis, convergence time
+// under noisy input, and the default floor and margin moving the label on
+// the deployed model's real output.
+//
+//   pio test -e native -f test_probability_smoother
+
+#include <unity.h>
+#include "ai/probability_smoother.h"
+
+static const int LABELS = ProbabilitySmoother::LABEL_COUNT;
+static const unsigned long FRAME_MS = 100;
+
+static ProbabilitySmoother smoother;
+static uint32_t noiseState;
+
+void setUp(void) {
+    smoother.configure(0.4f, 0.10f, 0.6f, 300);
+    smoother.reset();
+    noiseState = 12345;
+}
+
+void tearDown(void) {}
+
+// Deterministic noise in [0, 1)
+static float noise() {
+    noiseState = noiseState * 1664525u + 1013904223u;
+    return (noiseState >> 8) / 16777216.0f;
+}
+
+// `confidence` on label, the rest spread evenly
+static void peaked(float* probabilities, int label, float confidence) {
+    for (int i = 0; i < LABELS; i++) {
+        probabilities[i] = i == label ? confidence : (1.0f - confidence) / (LABELS - 1);
+    }
+}
+
+// The true label gets `confidence` plus up to +-jitter; every other class
+// random mass; normalised to sum to one
+static void noisy(float* probabilities, int label, float confidence, float jitter) {
+    float sum = 0.0f;
+    for (int i = 0; i < LABELS; i++) {
+        probabilities[i] = i == label ? confidence + (noise() * 2.0f - 1.0f) * jitter
+                                      : noise() * (1.0f - confidence) * 2.0f / (LABELS - 1);
+        if (probabilities[i] < 0.0f) probabilities[i] = 0.0f;
+        sum += probabilities[i];
+    }
+    for (int i = 0; i < LABELS; i++) probabilities[i] /= sum;
+}
+
+void test_first_update_primes_scores(void) {
+    float p[LABELS];
+    peaked(p, 2, 0.7f);
+    smoother.update(p, 0);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 0.7f, smoother.getSmoothedProbability(2));
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 0.06f, smoother.getSmoothedProbability(0));
+    TEST_ASSERT_EQUAL_UINT32(1, smoother.getState().updates);
+}
+
+void test_switches_after_min_dwell(void) {
+    float p[LABELS];
+    peaked(p, 3, 0.9f);
+    unsigned long now = 0;
+    const SmoothingState* state = &smoother.update(p, now);
+    TEST_ASSERT_EQUAL_INT(0, state->stableLabel);
+    TEST_ASSERT_EQUAL_INT(3, state->candidateLabel);
+
+    int changes = 0;
+    unsigned long switchedAt = 0;
+    for (int frame = 1; frame <= 10; frame++) {
+        now += FRAME_MS;
+        state = &smoother.update(p, now);
+        if (state->changed) {
+            changes++;
+            switchedAt = now;
+        }
+    }
+    TEST_ASSERT_EQUAL_INT(3, state->stableLabel);
+    TEST_ASSERT_EQUAL_INT(1, changes);
+    TEST_ASSERT_EQUAL_UINT32(300, switchedAt);
+    TEST_ASSERT_EQUAL_INT(-1, state->candidateLabel);
+}
+
+void test_single_spike_does_not_switch(void) {
+    float background[LABELS];
+    float spike[LABELS];
+    peaked(background, 0, 0.9f);
+    peaked(spike, 4, 1.0f);
+    unsigned long now = 0;
+    for (int frame = 0; frame < 5; frame++, now += FRAME_MS) smoother.update(background, now);
+    smoother.update(spike, now);
+    for (int frame = 0; frame < 10; frame++) {
+        now += FRAME_MS;
+        TEST_ASSERT_FALSE(smoother.update(background, now).changed);
+    }
+    TEST_ASSERT_EQUAL_INT(0, smoother.getStableLabel());
+}
+
+void test_hysteresis_holds_against_near_tie(void) {
+    float a[LABELS];
+    float b[LABELS];
+    peaked(a, 1, 0.9f);
+    unsigned long now = 0;
+    for (int frame = 0; frame < 10; frame++, now += FRAME_MS) smoother.update(a, now);
+    TEST_ASSERT_EQUAL_INT(1, smoother.getStableLabel());
+
+    // Classes 1 and 2 alternate a few points apart: never a clear lead
+    for (int i = 0; i < LABELS; i++) a[i] = b[i] = 0.05f;
+    a[1] = 0.42f; a[2] = 0.38f;
+    b[1] = 0.38f; b[2] = 0.42f;
+    for (int frame = 0; frame < 100; frame++, now += FRAME_MS) {
+        TEST_ASSERT_FALSE(smoother.update(frame % 2 ? a : b, now).changed);
+    }
+    TEST_ASSERT_EQUAL_INT(1, smoother.getStableLabel());
+}
+
+void test_below_confidence_floor_never_switches(void) {
+    float p[LABELS];
+    peaked(p, 5, 0.5f);
+    unsigned long now = 0;
+    for (int frame = 0; frame < 50; frame++, now += FRAME_MS) smoother.update(p, now);
+    TEST_ASSERT_EQUAL_INT(0, smoother.getStableLabel());
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 0.5f, smoother.getSmoothedProbability(5));
+}
+
+// Frames until the stable label first reaches `label` (-1 if it never does
+// within maxFrames) and how often it changes afterwards
+static int convergenceFrames(int label, float confidence, float jitter, int maxFrames, int& laterChanges) {
+    float p[LABELS];
+    int converged = -1;
+    laterChanges = 0;
+    for (int frame = 0; frame < maxFrames; frame++) {
+        noisy(p, label, confidence, jitter);
+        const SmoothingState& state = smoother.update(p, frame * FRAME_MS);
+        if (converged < 0 && state.stableLabel == label) {
+            converged = frame;
+        } else if (converged >= 0 && state.changed) {
+            laterChanges++;
+        }
+    }
+    return converged;
+}
+
+void test_converges_quickly_on_clean_input(void) {
+    int laterChanges;
+    int frames = convergenceFrames(2, 0.9f, 0.0f, 50, laterChanges);
+    // Leads from the first frame; the 300 ms dwell is 3 more frames
+    TEST_ASSERT_EQUAL_INT(3, frames);
+    TEST_ASSERT_EQUAL_INT(0, laterChanges);
+}
+
+void test_converges_under_noise_without_chatter(void) {
+    int laterChanges;
+    int frames = convergenceFrames(4, 0.7f, 0.2f, 200, laterChanges);
+    TEST_ASSERT_GREATER_OR_EQUAL(3, frames);
+    TEST_ASSERT_LESS_OR_EQUAL(8, frames);
+    TEST_ASSERT_EQUAL_INT(0, laterChanges);
+}
+
+void test_heavier_noise_takes_longer(void) {
+    int laterChanges;
+    int clean = convergenceFrames(3, 0.8f, 0.05f, 200, laterChanges);
+    setUp();
+    noiseState = 999;
+    int heavy = convergenceFrames(3, 0.65f, 0.3f, 200, laterChanges);
+    TEST_ASSERT_GREATER_OR_EQUAL(0, clean);
+    TEST_ASSERT_GREATER_OR_EQUAL(clean, heavy);
+    TEST_ASSERT_LESS_OR_EQUAL(20, heavy);
+}
+
+// The deployed model's probability vectors for the first eight "no fingers"
+// rows of data/finger_detection_data.csv, and the vector it gives every
+// "one finger" row from row 53 to row 72 (replay env, run_classifier())
+static const float replayNoFingers[8][LABELS] = {
+    { 0.37500f, 0.01172f, 0.02344f, 0.23828f, 0.15625f, 0.19531f },
+    { 0.16016f, 0.17578f, 0.16797f, 0.17188f, 0.16406f, 0.16406f },
+    { 0.29688f, 0.04297f, 0.05469f, 0.23047f, 0.17578f, 0.19922f },
+    { 0.42969f, 0.00391f, 0.01172f, 0.23047f, 0.14062f, 0.18359f },
+    { 0.37109f, 0.01172f, 0.02344f, 0.23828f, 0.16016f, 0.19531f },
+    { 0.42969f, 0.00391f, 0.01172f, 0.23047f, 0.14062f, 0.18359f },
+    { 0.26953f, 0.05469f, 0.07031f, 0.22266f, 0.17969f, 0.19922f },
+    { 0.42969f, 0.00391f, 0.01172f, 0.23047f, 0.14062f, 0.18359f },
+};
+static const float replayOneFinger[LABELS] = { 0.16016f, 0.17578f, 0.16797f, 0.17188f, 0.16406f, 0.16406f };
+
+// Stable labels after each phase of no fingers, one finger, no fingers
+static void replayScene(ProbabilitySmoother& replaySmoother, int labels[3]) {
+    const unsigned long captureMs = 1000;
+    unsigned long now = 0;
+    for (int f = 0; f < 8; f++, now += captureMs) replaySmoother.update(replayNoFingers[f], now);
+    labels[0] = replaySmoother.getStableLabel();
+    for (int f = 0; f < 12; f++, now += captureMs) replaySmoother.update(replayOneFinger, now);
+    labels[1] = replaySmoother.getStableLabel();
+    for (int f = 0; f < 8; f++, now += captureMs) replaySmoother.update(replayNoFingers[f], now);
+    labels[2] = replaySmoother.getStableLabel();
+}
+
+void test_default_floor_follows_replay_output(void) {
+    ProbabilitySmoother defaults;
+    int labels[3];
+    replayScene(defaults, labels);
+    TEST_ASSERT_EQUAL_INT(0, labels[0]);
+    TEST_ASSERT_EQUAL_INT(1, labels[1]);
+    TEST_ASSERT_EQUAL_INT(0, labels[2]);
+
+    // The old EI_CLASSIFIER_THRESHOLD floor pins the label on the same input
+    ProbabilitySmoother thresholded;
+    thresholded.configure(0.4f, 0.10f, 0.6f, 300);
+    replayScene(thresholded, labels);
+    TEST_ASSERT_EQUAL_INT(0, labels[0]);
+    TEST_ASSERT_EQUAL_INT(0, labels[1]);
+    TEST_ASSERT_EQUAL_INT(0, labels[2]);
+}
+
+void test_reset_restores_initial_state(void) {
+    float p[LABELS];
+    peaked(p, 3, 0.9f);
+    for (int frame = 0; frame < 10; frame++) smoother.update(p, frame * FRAME_MS);
+    smoother.reset(1, 5000);
+    const SmoothingState& state = smoother.getState();
+    TEST_ASSERT_EQUAL_INT(1, state.stableLabel);
+    TEST_ASSERT_EQUAL_INT(-1, state.candidateLabel);
+    TEST_ASSERT_EQUAL_UINT32(5000, state.stableSinceMs);
+    TEST_ASSERT_EQUAL_UINT32(0, state.updates);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, 0.0f, smoother.getSmoothedProbability(3));
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_first_update_primes_scores);
+    RUN_TEST(test_switches_after_min_dwell);
+    RUN_TEST(test_single_spike_does_not_switch);
+    RUN_TEST(test_hysteresis_holds_against_near_tie);
+    RUN_TEST(test_below_confidence_floor_never_switches);
+    RUN_TEST(test_converges_quickly_on_clean_input);
+    RUN_TEST(test_converges_under_noise_without_chatter);
+    RUN_TEST(test_heavier_noise_takes_longer);
+    RUN_TEST(test_default_floor_follows_replay_output);
+    RUN_TEST(test_reset_restores_initial_state);
+    return UNITY_END();
+}
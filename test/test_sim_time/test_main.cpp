@@ -0,0 +1,239 @@
+// Simulated time (lib/native_hal) with tasks on its one simulated core:
+// sleeps, delays and charged costs move the clock exactly, tasks run in
+// wake-time order, RtSignal and RtMutex hand over at the simulated instant
+// they would on the device, and the task runtime runs to the same counts
+// every time, slow inference included.
+//
+//   pio test -e native -f test_sim_time
+
+#include <unity.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <Arduino.h>
+#include "native_hal.h"
+#include "runtime/task_runtime.h"
+
+struct Event {
+    std::string name;
+    uint32_t atMs;
+    bool flag;
+};
+
+// Only the current simulated task runs, so tasks append without a lock
+static std::vector<Event> events;
+static uint32_t startUs;
+
+static uint32_t elapsedMs() {
+    return (rtMicros() - startUs) / 1000;
+}
+
+static void record(const char* name, bool flag = false) {
+    Event event = { name, elapsedMs(), flag };
+    events.push_back(event);
+}
+
+static void expectEvent(size_t index, const char* name, uint32_t atMs) {
+    TEST_ASSERT_TRUE(index < events.size());
+    TEST_ASSERT_EQUAL_STRING(name, events[index].name.c_str());
+    TEST_ASSERT_EQUAL_UINT32(atMs, events[index].atMs);
+}
+
+void setUp(void) {
+    events.clear();
+    nativeSetCostModel(nativeDefaultCostModel());
+    nativeSetSimulatedTime(true);
+    startUs = rtMicros();
+}
+
+void tearDown(void) {
+    nativeSetSimulatedTime(false);
+}
+
+void test_clock_moves_only_by_sleeps_and_costs(void) {
+    TEST_ASSERT_EQUAL_UINT32(0, rtMicros() - startUs);
+    rtSleepMs(250);
+    TEST_ASSERT_EQUAL_UINT32(250000, rtMicros() - startUs);
+    delay(5);
+    TEST_ASSERT_EQUAL_UINT32(255000, rtMicros() - startUs);
+
+    NativeCostModel model = nativeDefaultCostModel();
+    model.stageUs[RT_COST_INFERENCE] = 2500;
+    nativeSetCostModel(model);
+    // An ensemble charges one inference per model
+    rtChargeCost(RT_COST_INFERENCE, 2);
+    TEST_ASSERT_EQUAL_UINT32(260000, rtMicros() - startUs);
+    TEST_ASSERT_EQUAL_UINT32(rtMicros(), (uint32_t)micros());
+}
+
+struct PeriodicTask {
+    const char* name;
+    uint32_t periodMs;
+    int runs;
+};
+
+static void periodicEntry(void* arg) {
+    PeriodicTask* task = static_cast<PeriodicTask*>(arg);
+    for (int i = 0; i < task->runs; i++) {
+        record(task->name);
+        rtSleepMs(task->periodMs);
+    }
+}
+
+void test_tasks_run_in_wake_time_order(void) {
+    PeriodicTask fast = { "fast", 30, 4 };
+    PeriodicTask slow = { "slow", 50, 4 };
+    RtTaskHandle fastHandle, slowHandle;
+    TEST_ASSERT_TRUE(rtStartTask(periodicEntry, &fast, "fast", 2048, 1, 0, &fastHandle));
+    TEST_ASSERT_TRUE(rtStartTask(periodicEntry, &slow, "slow", 2048, 1, 0, &slowHandle));
+    // Started tasks only run once the caller blocks
+    TEST_ASSERT_EQUAL_UINT32(0, events.size());
+
+    rtJoinTask(fastHandle);
+    TEST_ASSERT_EQUAL_UINT32(120, elapsedMs());
+    rtJoinTask(slowHandle);
+    TEST_ASSERT_EQUAL_UINT32(200, elapsedMs());
+
+    TEST_ASSERT_EQUAL_UINT32(8, events.size());
+    expectEvent(0, "fast", 0);
+    expectEvent(1, "slow", 0);
+    expectEvent(2, "fast", 30);
+    expectEvent(3, "slow", 50);
+    expectEvent(4, "fast", 60);
+    expectEvent(5, "fast", 90);
+    expectEvent(6, "slow", 100);
+    expectEvent(7, "slow", 150);
+}
+
+static RtSignal* signal;
+
+static void waiterEntry(void*) {
+    bool notified = signal->wait(1000);
+    record("notified", notified);
+    bool again = signal->wait(100);
+    record("timed out", again);
+}
+
+void test_signal_wakes_waiter_at_notify_time(void) {
+    RtSignal ready;
+    signal = &ready;
+    RtTaskHandle waiter;
+    TEST_ASSERT_TRUE(rtStartTask(waiterEntry, nullptr, "waiter", 2048, 1, 0, &waiter));
+    rtSleepMs(40);
+    ready.notify();
+    rtJoinTask(waiter);
+
+    TEST_ASSERT_EQUAL_UINT32(2, events.size());
+    expectEvent(0, "notified", 40);
+    TEST_ASSERT_TRUE(events[0].flag);
+    expectEvent(1, "timed out", 140);
+    TEST_ASSERT_FALSE(events[1].flag);
+}
+
+static RtMutex* mutex;
+
+static void holderEntry(void*) {
+    mutex->lock();
+    record("holder locked");
+    rtSleepMs(20);
+    mutex->unlock();
+}
+
+static void contenderEntry(void*) {
+    rtSleepMs(5);
+    mutex->lock();
+    record("contender locked");
+    mutex->unlock();
+}
+
+void test_mutex_held_across_a_sleep(void) {
+    RtMutex lock;
+    mutex = &lock;
+    RtTaskHandle holder, contender;
+    TEST_ASSERT_TRUE(rtStartTask(holderEntry, nullptr, "holder", 2048, 1, 0, &holder));
+    TEST_ASSERT_TRUE(rtStartTask(contenderEntry, nullptr, "contender", 2048, 1, 0, &contender));
+    rtJoinTask(holder);
+    rtJoinTask(contender);
+
+    TEST_ASSERT_EQUAL_UINT32(2, events.size());
+    expectEvent(0, "holder locked", 0);
+    expectEvent(1, "contender locked", 20);
+}
+
+static bool chargedCapture(void*, RuntimeFrame& frame) {
+    rtChargeCost(RT_COST_FEATURES);
+    frame.featureCount = RUNTIME_FRAME_FEATURES;
+    return true;
+}
+
+static int chargedClassify(void*, const RuntimeFrame& frame) {
+    rtChargeCost(RT_COST_INFERENCE);
+    return (int)(frame.seq % 6);
+}
+
+static void ignoreDetection(void*, const RuntimeDetection&) {}
+
+struct RunCounts {
+    unsigned long captured;
+    unsigned long inferred;
+    unsigned long handled;
+    unsigned long dropped;
+};
+
+static RunCounts runPipeline(uint32_t inferenceUs, uint32_t runMs) {
+    NativeCostModel model = nativeDefaultCostModel();
+    model.stageUs[RT_COST_FEATURES] = 1000;
+    model.stageUs[RT_COST_INFERENCE] = inferenceUs;
+    nativeSetCostModel(model);
+
+    TaskRuntime* runtime = new TaskRuntime();
+    runtime->getConfig().captureIntervalMs = 100;
+    RuntimeHooks hooks;
+    memset(&hooks, 0, sizeof(hooks));
+    hooks.capture = chargedCapture;
+    hooks.classify = chargedClassify;
+    hooks.onDetection = ignoreDetection;
+    TEST_ASSERT_TRUE(runtime->start(hooks));
+    rtSleepMs(runMs);
+    runtime->stop();
+
+    RunCounts counts = { runtime->getFramesCaptured(), runtime->getFramesInferred(),
+                         runtime->getDetectionsHandled(), runtime->getDroppedFrames() };
+    delete runtime;
+    return counts;
+}
+
+void test_task_runtime_on_simulated_clock(void) {
+    // Captures at 0, 100, ... 900 ms, each classified well within the interval
+    RunCounts counts = runPipeline(30000, 1000);
+    TEST_ASSERT_EQUAL_UINT32(10, counts.captured);
+    TEST_ASSERT_EQUAL_UINT32(10, counts.inferred);
+    TEST_ASSERT_EQUAL_UINT32(10, counts.handled);
+    TEST_ASSERT_EQUAL_UINT32(0, counts.dropped);
+}
+
+void test_slow_inference_holds_the_core(void) {
+    // Inference at 2.5x the capture interval. All tasks share the one
+    // simulated core, so capture waits out each inference and runs at its
+    // rate instead of overfilling the queue - the same counts every run.
+    RunCounts first = runPipeline(250000, 3000);
+    RunCounts second = runPipeline(250000, 3000);
+    TEST_ASSERT_EQUAL_UINT32(13, first.captured);
+    TEST_ASSERT_EQUAL_UINT32(12, first.inferred);
+    TEST_ASSERT_EQUAL_UINT32(0, first.dropped);
+    TEST_ASSERT_EQUAL_UINT32(first.captured, second.captured);
+    TEST_ASSERT_EQUAL_UINT32(first.inferred, second.inferred);
+    TEST_ASSERT_EQUAL_UINT32(first.handled, second.handled);
+    TEST_ASSERT_EQUAL_UINT32(first.dropped, second.dropped);
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_clock_moves_only_by_sleeps_and_costs);
+    RUN_TEST(test_tasks_run_in_wake_time_order);
+    RUN_TEST(test_signal_wakes_waiter_at_notify_time);
+    RUN_TEST(test_mutex_held_across_a_sleep);
+    RUN_TEST(test_task_runtime_on_simulated_clock);
+    RUN_TEST(test_slow_inference_holds_the_core);
+    return UNITY_END();
+}
@@ -0,0 +1,261 @@
+// TimerStateMachine stepped through an injected clock: every state
+// transition and timeout, concurrent countdowns with new timers accepted in
+// detection windows (or refused) while running, windows that fit the
+// confirming readings and restart the caller's debounce when they close,
+// cancellation, and a countdown across the 32-bit millisecond wraparound.
+//
+//   pio test -e native -f test_state_machine
+
+#include <unity.h>
+#include "ui/oled.h"
+#include "ui/buzzer.h"
+#include "logic/state_machine.h"
+
+static uint32_t fakeNow;
+static TimerStateMachine* machine;
+static BuzzerControl* buzzer;
+
+static uint32_t fakeClock() { return fakeNow; }
+
+void setUp(void) {
+    fakeNow = 1000;
+    buzzer = new BuzzerControl();
+    machine = new TimerStateMachine();
+    machine->setClock(fakeClock);
+    machine->init(nullptr, buzzer, nullptr);
+}
+
+void tearDown(void) {
+    delete machine;
+    delete buzzer;
+}
+
+// Advance the clock 1 ms at a time, dispatching as the device loop would
+static void step(uint32_t ms) {
+    for (uint32_t i = 0; i < ms; i++) {
+        fakeNow++;
+        machine->update();
+        buzzer->update(fakeNow);
+    }
+}
+
+void test_starts_waiting_with_ready_prompt(void) {
+    TEST_ASSERT_EQUAL_INT(STATE_WAITING, machine->getState());
+    TEST_ASSERT_TRUE(machine->acceptsNewTimers());
+    TEST_ASSERT_EQUAL_UINT32(TimerStateMachine::READY_MESSAGE_INTERVAL, machine->msUntilNextEvent());
+    step(TimerStateMachine::READY_MESSAGE_INTERVAL);
+    // The prompt re-arms itself and the state does not change
+    TEST_ASSERT_EQUAL_INT(STATE_WAITING, machine->getState());
+    TEST_ASSERT_EQUAL_UINT32(TimerStateMachine::READY_MESSAGE_INTERVAL, machine->msUntilNextEvent());
+}
+
+void test_detecting_falls_back_to_waiting(void) {
+    machine->setState(STATE_DETECTING);
+    TEST_ASSERT_EQUAL_INT(STATE_DETECTING, machine->getState());
+    TEST_ASSERT_EQUAL_UINT32(0, machine->msUntilNextEvent());
+    machine->update();
+    TEST_ASSERT_EQUAL_INT(STATE_WAITING, machine->getState());
+}
+
+void test_setting_times_out_into_running(void) {
+    machine->processFingerCount(2);
+    machine->setState(STATE_SETTING);
+    step(TimerStateMachine::SETTING_TIMEOUT - 1);
+    TEST_ASSERT_EQUAL_INT(STATE_SETTING, machine->getState());
+    step(1);
+    TEST_ASSERT_EQUAL_INT(STATE_RUNNING, machine->getState());
+    TEST_ASSERT_EQUAL_INT(1, machine->getActiveTimers());
+    TEST_ASSERT_EQUAL_UINT32(120, machine->getRemainingTime());
+    TEST_ASSERT_TRUE(buzzer->isBusy());     // Start beeps
+}
+
+void test_countdown_expires_then_finished_times_out(void) {
+    TEST_ASSERT_TRUE(machine->addTimer(0, 3));
+    TEST_ASSERT_EQUAL_INT(STATE_RUNNING, machine->getState());
+    TEST_ASSERT_EQUAL_UINT32(3, machine->getRemainingTime());
+
+    step(2999);
+    TEST_ASSERT_EQUAL_INT(STATE_RUNNING, machine->getState());
+    TEST_ASSERT_FALSE(machine->isTimerExpired());
+    step(1);
+    TEST_ASSERT_EQUAL_INT(STATE_FINISHED, machine->getState());
+    TEST_ASSERT_TRUE(buzzer->isBusy());     // Alarm
+    TEST_ASSERT_FALSE(machine->acceptsNewTimers());
+
+    step(TimerStateMachine::FINISHED_TIMEOUT - 1);
+    TEST_ASSERT_EQUAL_INT(STATE_FINISHED, machine->getState());
+    step(1);
+    TEST_ASSERT_EQUAL_INT(STATE_WAITING, machine->getState());
+    TEST_ASSERT_EQUAL_INT(0, machine->getActiveTimers());
+}
+
+void test_alarm_repeats_once_pattern_played_out(void) {
+    machine->addTimer(0, 1);
+    step(1000);
+    TEST_ASSERT_EQUAL_INT(STATE_FINISHED, machine->getState());
+    // The 2.1 s alarm pattern is still playing at the first 2 s repeat, so
+    // only the second repeat re-sounds it
+    step(2100);
+    TEST_ASSERT_FALSE(buzzer->isBusy());
+    step(TimerStateMachine::ALARM_INTERVAL * 2 - 2100);
+    TEST_ASSERT_TRUE(buzzer->isBusy());
+}
+
+void test_redraw_follows_displayed_seconds(void) {
+    machine->addTimer(0, 10);
+    // "Timer Set!" hold, then one redraw per displayed second
+    TEST_ASSERT_EQUAL_UINT32(TimerStateMachine::TIMER_SET_HOLD, machine->msUntilNextEvent());
+    step(TimerStateMachine::TIMER_SET_HOLD);
+    for (int i = 0; i < 5; i++) {
+        uint32_t wait = machine->msUntilNextEvent();
+        TEST_ASSERT_GREATER_THAN(0, wait);
+        TEST_ASSERT_LESS_OR_EQUAL(1000, wait);
+        step(wait);
+    }
+    TEST_ASSERT_EQUAL_INT(STATE_RUNNING, machine->getState());
+}
+
+void test_timer_added_while_running(void) {
+    machine->setAcceptWhileRunning(true);
+    machine->addTimer(1, 0);
+    step(TimerStateMachine::DETECT_PERIOD - TimerStateMachine::DETECT_WINDOW);
+    TEST_ASSERT_TRUE(machine->acceptsNewTimers());
+    TEST_ASSERT_TRUE(machine->addTimer(0, 2));
+    TEST_ASSERT_EQUAL_INT(2, machine->getActiveTimers());
+    // The display follows the soonest countdown
+    TEST_ASSERT_EQUAL_UINT32(2, machine->getRemainingTime());
+
+    step(2000);
+    TEST_ASSERT_EQUAL_INT(STATE_RUNNING, machine->getState());
+    TEST_ASSERT_EQUAL_INT(1, machine->getActiveTimers());
+    TEST_ASSERT_TRUE(buzzer->isBusy());     // Short "timer done" alert
+    // 60 s less the gap before the window and the 2 s just stepped
+    const uint32_t GAP = TimerStateMachine::DETECT_PERIOD - TimerStateMachine::DETECT_WINDOW;
+    TEST_ASSERT_EQUAL_UINT32(60 - GAP / 1000 - 2, machine->getRemainingTime());
+
+    step(60000 - GAP - 2000);
+    TEST_ASSERT_EQUAL_INT(STATE_FINISHED, machine->getState());
+}
+
+void test_detect_windows_while_running(void) {
+    const uint32_t GAP = TimerStateMachine::DETECT_PERIOD - TimerStateMachine::DETECT_WINDOW;
+    machine->setAcceptWhileRunning(true);
+    machine->addTimer(2, 0);
+    // The camera may power down right after the gesture that set the timer
+    TEST_ASSERT_FALSE(machine->acceptsNewTimers());
+    int openMs = 0;
+    for (uint32_t ms = 0; ms < 3 * TimerStateMachine::DETECT_PERIOD; ms++) {
+        step(1);
+        if (machine->acceptsNewTimers()) openMs++;
+    }
+    TEST_ASSERT_EQUAL_INT(3 * TimerStateMachine::DETECT_WINDOW, openMs);
+
+    // The machine wakes the caller for the window edges
+    TEST_ASSERT_FALSE(machine->acceptsNewTimers());
+    TEST_ASSERT_LESS_OR_EQUAL(GAP, machine->msUntilNextEvent());
+
+    // A timer added in a window closes it for a full gap
+    step(GAP);
+    TEST_ASSERT_TRUE(machine->acceptsNewTimers());
+    TEST_ASSERT_TRUE(machine->addTimer(0, 50));
+    TEST_ASSERT_FALSE(machine->acceptsNewTimers());
+    step(GAP - 1);
+    TEST_ASSERT_FALSE(machine->acceptsNewTimers());
+    step(1);
+    TEST_ASSERT_TRUE(machine->acceptsNewTimers());
+}
+
+void test_detect_window_fits_confirmation_and_resets_debounce(void) {
+    const uint32_t GAP = TimerStateMachine::DETECT_PERIOD - TimerStateMachine::DETECT_WINDOW;
+    machine->setAcceptWhileRunning(true);
+    machine->addTimer(5, 0);
+    uint32_t closedSeq = machine->getDetectWindowSeq();
+    step(GAP);
+    TEST_ASSERT_TRUE(machine->acceptsNewTimers());
+    // Opening does not restart a caller's debounce; the window is still
+    // open after the confirming readings at the reading interval
+    TEST_ASSERT_EQUAL_UINT32(closedSeq, machine->getDetectWindowSeq());
+    step((TimerStateMachine::CONFIRMATION_REQUIRED - 1) * TimerStateMachine::DETECT_READING_INTERVAL);
+    TEST_ASSERT_TRUE(machine->acceptsNewTimers());
+
+    // Closing without a gesture bumps the sequence, so partial counts are dropped
+    step(TimerStateMachine::DETECT_WINDOW -
+         (TimerStateMachine::CONFIRMATION_REQUIRED - 1) * TimerStateMachine::DETECT_READING_INTERVAL);
+    TEST_ASSERT_FALSE(machine->acceptsNewTimers());
+    TEST_ASSERT_EQUAL_UINT32(closedSeq + 1, machine->getDetectWindowSeq());
+
+    // So does a timer added inside the next window
+    step(GAP);
+    TEST_ASSERT_TRUE(machine->addTimer(1, 0));
+    TEST_ASSERT_EQUAL_UINT32(closedSeq + 2, machine->getDetectWindowSeq());
+}
+
+void test_running_refuses_new_timers_when_configured(void) {
+    machine->setAcceptWhileRunning(false);
+    TEST_ASSERT_TRUE(machine->acceptsNewTimers());
+    machine->addTimer(0, 5);
+    TEST_ASSERT_FALSE(machine->acceptsNewTimers());
+    step(5000);
+    TEST_ASSERT_EQUAL_INT(STATE_FINISHED, machine->getState());
+    step(TimerStateMachine::FINISHED_TIMEOUT);
+    TEST_ASSERT_TRUE(machine->acceptsNewTimers());
+}
+
+void test_full_timer_slots_refuse(void) {
+    for (int i = 0; i < MAX_CONCURRENT_TIMERS; i++) {
+        TEST_ASSERT_TRUE(machine->acceptsNewTimers());
+        TEST_ASSERT_TRUE(machine->addTimer(5, i));
+        step(TimerStateMachine::DETECT_PERIOD - TimerStateMachine::DETECT_WINDOW);
+    }
+    // Full: the detection window opens without accepting
+    TEST_ASSERT_FALSE(machine->acceptsNewTimers());
+    TEST_ASSERT_FALSE(machine->addTimer(1, 0));
+    TEST_ASSERT_EQUAL_INT(MAX_CONCURRENT_TIMERS, machine->getActiveTimers());
+}
+
+void test_cancel_paths(void) {
+    machine->addTimer(0, 5);
+    machine->addTimer(0, 8);
+    // Ids are 1-based; cancelling the soonest moves the display to the next
+    TEST_ASSERT_TRUE(machine->cancelTimer(1));
+    TEST_ASSERT_EQUAL_INT(STATE_RUNNING, machine->getState());
+    TEST_ASSERT_EQUAL_UINT32(8, machine->getRemainingTime());
+    TEST_ASSERT_FALSE(machine->cancelTimer(1));
+
+    step(5000);
+    TEST_ASSERT_EQUAL_INT(STATE_RUNNING, machine->getState());
+    TEST_ASSERT_TRUE(machine->cancelTimer(2));
+    TEST_ASSERT_EQUAL_INT(STATE_WAITING, machine->getState());
+    step(10000);
+    TEST_ASSERT_EQUAL_INT(STATE_WAITING, machine->getState());
+}
+
+void test_countdown_across_clock_wraparound(void) {
+    fakeNow = 0xFFFFFFFFu - 4000;
+    machine->setClock(fakeClock);
+    machine->setState(STATE_WAITING);
+    machine->addTimer(0, 10);
+    step(9999);
+    TEST_ASSERT_EQUAL_INT(STATE_RUNNING, machine->getState());
+    TEST_ASSERT_LESS_THAN(10000, fakeNow);    // The clock has wrapped
+    step(1);
+    TEST_ASSERT_EQUAL_INT(STATE_FINISHED, machine->getState());
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_starts_waiting_with_ready_prompt);
+    RUN_TEST(test_detecting_falls_back_to_waiting);
+    RUN_TEST(test_setting_times_out_into_running);
+    RUN_TEST(test_countdown_expires_then_finished_times_out);
+    RUN_TEST(test_alarm_repeats_once_pattern_played_out);
+    RUN_TEST(test_redraw_follows_displayed_seconds);
+    RUN_TEST(test_timer_added_while_running);
+    RUN_TEST(test_detect_windows_while_running);
+    RUN_TEST(test_detect_window_fits_confirmation_and_resets_debounce);
+    RUN_TEST(test_running_refuses_new_timers_when_configured);
+    RUN_TEST(test_full_timer_slots_refuse);
+    RUN_TEST(test_cancel_paths);
+    RUN_TEST(test_countdown_across_clock_wraparound);
+    return UNITY_END();
+}
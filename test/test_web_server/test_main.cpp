@@ -0,0 +1,253 @@
+// DataCollectionServer served through the host web server stand-in: form
+// settings and collection control, the chunked CSV export from the RAM store
+// and the flash log at any send-buffer size, CSV lines clamped to their
+// buffer, edge features exported to the serial line's precision, the
+// metrics and camera routes, and timer mode's monitoring-only route set.
+//
+//   pio test -e native -f test_web_server
+
+#include <unity.h>
+#include <string.h>
+#include <algorithm>
+#include "camera/camera_arducam.h"
+#include "model-parameters/model_metadata.h"
+
+#ifdef swap
+#undef swap
+#endif
+#ifdef min
+#undef min
+#endif
+#ifdef max
+#undef max
+#endif
+#ifdef round
+#undef round
+#endif
+
+#include "web/data_collection_server.h"
+
+typedef std::vector<std::pair<String, String> > Params;
+
+static const char* LOG_PATH = "test_web_server_samples.bin";
+static const char* NO_LOG_PATH = "no-such-dir/samples.bin";   // RAM store only
+
+static DataCollectionServer* server;
+
+void setUp(void) {
+    remove(LOG_PATH);
+    server = new DataCollectionServer();
+}
+
+void tearDown(void) {
+    delete server;
+    remove(LOG_PATH);
+}
+
+static NativeWebResponse get(const char* url, size_t chunkBytes = 1436) {
+    return nativeWebRequest(80, HTTP_GET, url, Params(), chunkBytes);
+}
+
+static NativeWebResponse post(const char* url, const Params& params = Params()) {
+    return nativeWebRequest(80, HTTP_POST, url, params);
+}
+
+// Every third sample has the longest line the format produces: the lowest
+// label and every feature at 255
+static void addSamples(int count) {
+    float features[SAMPLE_FEATURES];
+    for (int i = 0; i < count; i++) {
+        for (int f = 0; f < SAMPLE_FEATURES; f++) {
+            features[f] = (i % 3 == 0) ? 1000.0f : (float)((i * 7 + f * 13) % 100);
+        }
+        TEST_ASSERT_TRUE(server->addSample(i % 3 == 0 ? -128 : i % 6, features, SAMPLE_FEATURES));
+    }
+}
+
+// CSV the export must produce: every stored sample, in order
+template <typename Store>
+static std::string expectedCsv(const Store& store) {
+    std::string csv;
+    uint32_t first, end;
+    store.range(first, end);
+    for (uint32_t seq = first; seq != end; seq++) {
+        SampleRecord record;
+        TEST_ASSERT_TRUE(store.read(seq, record));
+        char line[256];
+        formatSampleCsv(record, line, sizeof(line));
+        csv += line;
+    }
+    return csv;
+}
+
+void test_not_listening_before_init(void) {
+    TEST_ASSERT_EQUAL_INT(0, get("/api/status").status);
+    TEST_ASSERT_TRUE(server->init(nullptr, NO_LOG_PATH));
+    TEST_ASSERT_TRUE(server->isServerStarted());
+    TEST_ASSERT_EQUAL_INT(200, get("/api/status").status);
+    TEST_ASSERT_EQUAL_INT(404, get("/api/nothing").status);
+    // Routes are registered per method
+    TEST_ASSERT_EQUAL_INT(404, get("/api/start").status);
+}
+
+void test_settings_and_collection_control(void) {
+    server->init(nullptr, NO_LOG_PATH);
+    Params settings;
+    settings.push_back(std::make_pair(String("fingers"), String("3")));
+    settings.push_back(std::make_pair(String("samplesPerCount"), String("7")));
+    settings.push_back(std::make_pair(String("delay"), String("500")));
+    settings.push_back(std::make_pair(String("autoMode"), String("true")));
+    TEST_ASSERT_EQUAL_INT(200, post("/api/settings", settings).status);
+    TEST_ASSERT_EQUAL_INT(3, server->currentFingers);
+    TEST_ASSERT_EQUAL_INT(7, server->samplesPerFingerCount);
+    TEST_ASSERT_EQUAL_INT(500, server->collectionDelay);
+    TEST_ASSERT_TRUE(server->autoMode);
+
+    // Form fields only: the same names in the query string are ignored
+    Params query;
+    query.push_back(std::make_pair(String("fingers"), String("5")));
+    nativeWebRequest(80, HTTP_GET, "/api/settings", query);
+    TEST_ASSERT_EQUAL_INT(3, server->currentFingers);
+
+    post("/api/start");
+    TEST_ASSERT_TRUE(server->isCollecting);
+    TEST_ASSERT_TRUE(server->shouldCollect);
+    server->onSampleCollected();
+    TEST_ASSERT_FALSE(server->shouldCollect);
+    post("/api/collect");
+    TEST_ASSERT_TRUE(server->shouldCollect);
+    post("/api/stop");
+    TEST_ASSERT_FALSE(server->isCollecting);
+    TEST_ASSERT_FALSE(server->shouldTriggerCollection());
+}
+
+void test_csv_export_from_ram_store(void) {
+    server->init(nullptr, NO_LOG_PATH);
+    TEST_ASSERT_FALSE(server->sampleLog.isOpen());
+    addSamples(100);
+    std::string expected = expectedCsv(server->samples);
+    TEST_ASSERT_EQUAL_UINT32(100, server->storedSamples());
+
+    // Send buffers smaller than a line, around a line, and a full segment
+    const size_t sizes[] = { 1, 7, 64, 150, 1436 };
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        NativeWebResponse response = get("/api/data", sizes[i]);
+        TEST_ASSERT_EQUAL_INT(200, response.status);
+        TEST_ASSERT_EQUAL_INT(0, response.overruns);
+        TEST_ASSERT_EQUAL_UINT32(expected.size(), response.body.size());
+        TEST_ASSERT_TRUE(response.body == expected);
+    }
+}
+
+void test_csv_export_from_flash_log(void) {
+    TEST_ASSERT_TRUE(server->init(nullptr, LOG_PATH));
+    TEST_ASSERT_TRUE(server->sampleLog.isOpen());
+    addSamples(40);
+    std::string expected = expectedCsv(server->sampleLog);
+    NativeWebResponse response = get("/api/data", 33);
+    TEST_ASSERT_EQUAL_INT(0, response.overruns);
+    TEST_ASSERT_TRUE(response.body == expected);
+    TEST_ASSERT_EQUAL_INT(40, (int)std::count(response.body.begin(), response.body.end(), '\n'));
+
+    // The log survives a restart; clearing it empties the export
+    delete server;
+    server = new DataCollectionServer();
+    TEST_ASSERT_TRUE(server->init(nullptr, LOG_PATH));
+    TEST_ASSERT_EQUAL_INT(40, server->totalSamples);
+    TEST_ASSERT_TRUE(get("/api/data").body == expected);
+    post("/api/cleardata");
+    TEST_ASSERT_EQUAL_UINT32(0, get("/api/data").body.size());
+}
+
+void test_csv_line_clamped_to_buffer(void) {
+    SampleRecord record;
+    float features[SAMPLE_FEATURES];
+    for (int f = 0; f < SAMPLE_FEATURES; f++) features[f] = 1000.0f;
+    encodeSample(record, -128, features, SAMPLE_FEATURES, 0, 0);
+
+    char full[256];
+    int fullLen = formatSampleCsv(record, full, sizeof(full));
+    TEST_ASSERT_EQUAL_INT('\n', full[fullLen - 1]);
+    for (size_t size = 1; size <= (size_t)fullLen + 2; size++) {
+        char line[256];
+        memset(line, 'x', sizeof(line));
+        int len = formatSampleCsv(record, line, size);
+        TEST_ASSERT_LESS_OR_EQUAL((int)size - 1, len);
+        TEST_ASSERT_EQUAL_INT(len, (int)strlen(line));
+        TEST_ASSERT_EQUAL_INT('x', line[size]);      // Nothing past the buffer
+        TEST_ASSERT_EQUAL_MEMORY(full, line, len);
+    }
+    TEST_ASSERT_EQUAL_INT(0, formatSampleCsv(record, full, 0));
+}
+
+void test_csv_matches_serial_precision(void) {
+    // Whole-number levels, and edge densities as extractImageFeatures()
+    // produces them: edge count over region size, times 100
+    float features[SAMPLE_FEATURES];
+    for (int f = 0; f < SAMPLE_EDGE_FEATURES_START; f++) features[f] = (float)(f * 18);
+    const int edgeCounts[SAMPLE_EDGE_FEATURES] = { 7, 0, 1, 9, 4, 5 };
+    for (int f = 0; f < SAMPLE_EDGE_FEATURES; f++) {
+        features[SAMPLE_EDGE_FEATURES_START + f] = (float)edgeCounts[f] / 9 * 100;
+    }
+    SampleRecord record;
+    encodeSample(record, 3, features, SAMPLE_FEATURES, 0, 0);
+    TEST_ASSERT_TRUE(sampleRecordValid(record));
+
+    // What the serial TRAINING_DATA line prints for the same features
+    char expected[256];
+    int len = snprintf(expected, sizeof(expected), "%d", 3);
+    for (int f = 0; f < SAMPLE_FEATURES; f++) {
+        len += snprintf(expected + len, sizeof(expected) - len, ",%.2f", features[f]);
+    }
+    snprintf(expected + len, sizeof(expected) - len, "\n");
+
+    char line[256];
+    formatSampleCsv(record, line, sizeof(line));
+    TEST_ASSERT_EQUAL_STRING(expected, line);
+    TEST_ASSERT_TRUE(strstr(line, ",77.78,") != nullptr);
+}
+
+void test_metrics_and_memory_routes(void) {
+    server->init(nullptr, NO_LOG_PATH);
+    addSamples(5);
+    NativeWebResponse metrics = get("/api/metrics");
+    TEST_ASSERT_EQUAL_INT(200, metrics.status);
+    TEST_ASSERT_TRUE(metrics.body.find("stored_samples 5") != std::string::npos);
+    TEST_ASSERT_EQUAL_INT(200, get("/api/memory").status);
+    TEST_ASSERT_EQUAL_INT(200, get("/api/heap").status);
+}
+
+void test_monitoring_only_routes(void) {
+    TEST_ASSERT_TRUE(server->initMonitoring());
+    TEST_ASSERT_TRUE(server->isWifiActive());
+    NativeWebResponse metrics = get("/api/metrics");
+    TEST_ASSERT_EQUAL_INT(200, metrics.status);
+    TEST_ASSERT_TRUE(metrics.body.find("stage_latency_seconds_count{stage=\"dsp\"}") != std::string::npos);
+    TEST_ASSERT_EQUAL_INT(200, get("/api/heap").status);
+    TEST_ASSERT_EQUAL_INT(200, get("/api/memory").status);
+    // Nothing that drives collection or the camera
+    TEST_ASSERT_EQUAL_INT(404, get("/api/status").status);
+    TEST_ASSERT_EQUAL_INT(404, post("/api/start").status);
+    TEST_ASSERT_EQUAL_INT(404, get("/api/camera/capture").status);
+}
+
+void test_camera_routes_without_camera(void) {
+    server->init(nullptr, NO_LOG_PATH);
+    TEST_ASSERT_EQUAL_INT(500, get("/api/camera/capture").status);
+    TEST_ASSERT_EQUAL_INT(500, get("/api/camera/stream").status);
+    TEST_ASSERT_EQUAL_INT(200, get("/api/camera/stats").status);
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_not_listening_before_init);
+    RUN_TEST(test_settings_and_collection_control);
+    RUN_TEST(test_csv_export_from_ram_store);
+    RUN_TEST(test_csv_export_from_flash_log);
+    RUN_TEST(test_csv_line_clamped_to_buffer);
+    RUN_TEST(test_csv_matches_serial_precision);
+    RUN_TEST(test_metrics_and_memory_routes);
+    RUN_TEST(test_monitoring_only_routes);
+    RUN_TEST(test_camera_routes_without_camera);
+    return UNITY_END();
+}
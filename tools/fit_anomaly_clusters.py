@@ -0,0 +1,228 @@
+#!/usr/bin/env python3
+"""Fit K-means anomaly clusters on the finger feature CSV.
+
+Reads data/finger_detection_data.csv (label followed by 20 features), holds
+out every --holdout-th row of each label, standard-scales the rest, runs
+K-means and writes src/ai/finger_anomaly_clusters.h in the same layout Edge
+Impulse uses for its K-means anomaly block (per-axis mean/scale, centroids
+and the max distance of any training sample to its centroid).
+
+Clusters with fewer than --min-members samples are dropped together with
+their samples, which are the outliers of the training set: a one-sample
+cluster has a radius of 0 and would accept that outlier, and nothing near it,
+as in distribution, and merging it into a neighbour would stretch that
+cluster's radius over the outlier instead.
+
+The score threshold is not fitted: it is the lowest score that passes
+--pass-fraction of the held-out rows, which the clusters never saw. The
+fraction of held-out and training rows it passes is written to the header.
+
+Only the Python standard library is used so the script runs anywhere:
+
+    python3 tools/fit_anomaly_clusters.py [--clusters 12] [--seed 7] [--min-members 5]
+                                          [--holdout 5] [--pass-fraction 0.95]
+"""
+
+import argparse
+import csv
+import math
+import os
+import random
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+DEFAULT_CSV = os.path.join(ROOT, "data", "finger_detection_data.csv")
+DEFAULT_OUT = os.path.join(ROOT, "src", "ai", "finger_anomaly_clusters.h")
+
+
+def load_features(path):
+    rows = []
+    with open(path, newline="") as f:
+        for record in csv.reader(f):
+            if not record or not record[0].strip().lstrip("-").isdigit():
+                continue
+            rows.append((int(record[0]), [float(v) for v in record[1:]]))
+    return rows
+
+
+def split_holdout(rows, every):
+    """Every `every`-th row of each label is held out; the rest is fitted."""
+    seen = {}
+    train, held = [], []
+    for label, features in rows:
+        index = seen.get(label, 0)
+        seen[label] = index + 1
+        (held if every > 0 and index % every == every - 1 else train).append(features)
+    return train, held
+
+
+def standard_scale(rows):
+    n = len(rows)
+    dims = len(rows[0])
+    mean = [sum(r[d] for r in rows) / n for d in range(dims)]
+    scale = []
+    for d in range(dims):
+        var = sum((r[d] - mean[d]) ** 2 for r in rows) / n
+        scale.append(math.sqrt(var) if var > 0 else 1.0)
+    return mean, scale
+
+
+def apply_scale(rows, mean, scale):
+    return [[(r[d] - mean[d]) / scale[d] for d in range(len(mean))] for r in rows]
+
+
+def dist2(a, b):
+    return sum((x - y) ** 2 for x, y in zip(a, b))
+
+
+def lloyd(points, centroids, iterations=100):
+    k = len(centroids)
+    assignment = [-1] * len(points)
+    for _ in range(iterations):
+        changed = False
+        for i, p in enumerate(points):
+            best = min(range(k), key=lambda c: dist2(p, centroids[c]))
+            if best != assignment[i]:
+                assignment[i] = best
+                changed = True
+        for c in range(k):
+            members = [p for p, a in zip(points, assignment) if a == c]
+            if members:
+                centroids[c] = [sum(m[d] for m in members) / len(members)
+                                for d in range(len(points[0]))]
+        if not changed:
+            break
+    return assignment
+
+
+def kmeans(points, k, seed, min_members):
+    rng = random.Random(seed)
+    # k-means++ initialisation
+    centroids = [list(rng.choice(points))]
+    while len(centroids) < k:
+        weights = [min(dist2(p, c) for c in centroids) for p in points]
+        total = sum(weights)
+        pick = rng.uniform(0, total)
+        acc = 0.0
+        for p, w in zip(points, weights):
+            acc += w
+            if acc >= pick:
+                centroids.append(list(p))
+                break
+
+    # Drop the smallest under-populated cluster and its samples, and refine
+    # the rest, until none is left
+    assignment = lloyd(points, centroids)
+    dropped = 0
+    while len(centroids) > 1:
+        counts = [assignment.count(c) for c in range(len(centroids))]
+        smallest = min(range(len(centroids)), key=lambda c: counts[c])
+        if counts[smallest] >= min_members:
+            break
+        points = [p for p, a in zip(points, assignment) if a != smallest]
+        del centroids[smallest]
+        dropped += counts[smallest]
+        assignment = lloyd(points, centroids)
+
+    max_error = [0.0] * len(centroids)
+    members = [0] * len(centroids)
+    for p, a in zip(points, assignment):
+        max_error[a] = max(max_error[a], math.sqrt(dist2(p, centroids[a])))
+        members[a] += 1
+    return centroids, max_error, members, dropped
+
+
+def score(point, centroids, max_error):
+    """get_min_distance_to_cluster: nearest centroid distance minus its radius."""
+    return min(math.sqrt(dist2(point, c)) - r for c, r in zip(centroids, max_error))
+
+
+def pass_threshold(scores, fraction):
+    """Lowest threshold that passes `fraction` of the scores (score <= threshold)."""
+    ordered = sorted(scores)
+    index = max(0, min(len(ordered) - 1, int(math.ceil(fraction * len(ordered))) - 1))
+    return ordered[index]
+
+
+def passed(scores, threshold):
+    return sum(1 for s in scores if s <= threshold) / float(len(scores))
+
+
+def fmt(values):
+    return ", ".join("%.6ff" % v for v in values)
+
+
+def write_header(path, mean, scale, centroids, max_error, members, threshold, stats, source):
+    k = len(centroids)
+    dims = len(mean)
+    lines = [
+        "#ifndef FINGER_ANOMALY_CLUSTERS_H",
+        "#define FINGER_ANOMALY_CLUSTERS_H",
+        "",
+        "// Generated by tools/fit_anomaly_clusters.py from %s - do not edit." % source,
+        "// K-means clusters over the standard-scaled 20-feature vector, fitted on",
+        "// %d rows, less %d outliers dropped with the clusters they formed." % (
+            stats["train"], stats["dropped"]),
+        "// Members per cluster: %s." % ", ".join(str(m) for m in members),
+        "// The threshold passes %.1f%% of the %d held-out rows and %.1f%% of the" % (
+            100.0 * stats["held_pass"], stats["held"], 100.0 * stats["train_pass"]),
+        "// fitted ones.",
+        "",
+        "#define FINGER_ANOMALY_CLUSTER_COUNT %d" % k,
+        "#define FINGER_ANOMALY_AXES %d" % dims,
+        "#define FINGER_ANOMALY_THRESHOLD %.6ff" % threshold,
+        "",
+        "static const float finger_anomaly_mean[FINGER_ANOMALY_AXES] = { %s };" % fmt(mean),
+        "static const float finger_anomaly_scale[FINGER_ANOMALY_AXES] = { %s };" % fmt(scale),
+        "",
+        "static const float finger_anomaly_centroids[FINGER_ANOMALY_CLUSTER_COUNT][FINGER_ANOMALY_AXES] = {",
+    ]
+    for c in centroids:
+        lines.append("    { %s }," % fmt(c))
+    lines += [
+        "};",
+        "",
+        "static const float finger_anomaly_max_error[FINGER_ANOMALY_CLUSTER_COUNT] = { %s };" % fmt(max_error),
+        "",
+        "#endif",
+        "",
+    ]
+    with open(path, "w") as f:
+        f.write("\n".join(lines))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--csv", default=DEFAULT_CSV)
+    parser.add_argument("--out", default=DEFAULT_OUT)
+    parser.add_argument("--clusters", type=int, default=12)
+    parser.add_argument("--seed", type=int, default=7)
+    parser.add_argument("--min-members", type=int, default=5)
+    parser.add_argument("--holdout", type=int, default=5)
+    parser.add_argument("--pass-fraction", type=float, default=0.95)
+    args = parser.parse_args()
+
+    rows = load_features(args.csv)
+    train, held = split_holdout(rows, args.holdout)
+    if not held:
+        parser.error("--holdout leaves no rows to set the threshold on")
+    mean, scale = standard_scale(train)
+    scaled = apply_scale(train, mean, scale)
+    centroids, max_error, members, dropped = kmeans(scaled, args.clusters, args.seed, args.min_members)
+
+    held_scores = [score(p, centroids, max_error) for p in apply_scale(held, mean, scale)]
+    train_scores = [score(p, centroids, max_error) for p in scaled]
+    threshold = pass_threshold(held_scores, args.pass_fraction)
+    stats = {
+        "train": len(train), "dropped": dropped, "held": len(held),
+        "held_pass": passed(held_scores, threshold), "train_pass": passed(train_scores, threshold),
+    }
+    write_header(args.out, mean, scale, centroids, max_error, members, threshold, stats,
+                 os.path.relpath(args.csv, ROOT).replace(os.sep, "/"))
+    print("Fitted %d clusters on %d samples, %d outliers dropped with clusters under %d members -> %s" % (
+        len(centroids), len(train), dropped, args.min_members, args.out))
+    print("Threshold %.3f passes %.1f%% of %d held-out and %.1f%% of %d fitted samples" % (
+        threshold, 100.0 * stats["held_pass"], len(held), 100.0 * stats["train_pass"], len(train)))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,168 @@
+#!/usr/bin/env python3
+"""Convert TRACE dumps from the serial log into Chrome trace JSON.
+
+With ENABLE_TRACE set, the firmware prints its stage trace (src/runtime/
+trace.h) once a minute as
+
+    TRACE_DUMP,<count>,<overwritten>
+    TRACE_STAGE,<id>,<name>
+    TRACE_TASK,<id>,<name>
+    TRACE,<timestamp us>,<B|E|I>,<stage>,<task>,<arg>
+    TRACE_DUMP_END
+
+This script collects every dump in a captured log (monitor prefixes and
+interleaved output are ignored), drops the events a dump shares with the
+previous one, unwraps the 32-bit microsecond clock and writes a file that
+chrome://tracing or https://ui.perfetto.dev opens directly. --summary also
+prints per-stage durations.
+
+    pio device monitor | tee run.log
+    python3 tools/trace_to_chrome.py run.log -o trace.json --summary
+"""
+
+import argparse
+import json
+import sys
+
+WRAP = 1 << 32
+
+
+def parse_dumps(lines):
+    """Yield (stages, tasks, events) per complete dump."""
+    dump = None
+    for line in lines:
+        start = line.find("TRACE")
+        if start < 0:
+            continue
+        fields = line[start:].strip().split(",")
+        tag = fields[0]
+        if tag == "TRACE_DUMP":
+            dump = ({}, {}, [])
+        elif dump is None:
+            continue
+        elif tag == "TRACE_STAGE" and len(fields) >= 3:
+            dump[0][int(fields[1])] = fields[2]
+        elif tag == "TRACE_TASK" and len(fields) >= 3:
+            dump[1][int(fields[1])] = fields[2]
+        elif tag == "TRACE" and len(fields) >= 6:
+            try:
+                ts, phase, stage, task, arg = (int(fields[1]), fields[2],
+                                               int(fields[3]), int(fields[4]),
+                                               int(fields[5]))
+            except ValueError:
+                continue    # Line mangled by interleaved output
+            dump[2].append((ts, phase, stage, task, arg))
+        elif tag == "TRACE_DUMP_END":
+            yield dump
+            dump = None
+
+
+def collect(lines):
+    stages, tasks, events = {}, {}, []
+    previous = set()
+    for dump_stages, dump_tasks, dump_events in parse_dumps(lines):
+        stages.update(dump_stages)
+        tasks.update(dump_tasks)
+        # Consecutive dumps overlap when fewer than TRACE_CAPACITY events
+        # were recorded in between
+        events.extend(e for e in dump_events if e not in previous)
+        previous = set(dump_events)
+    return stages, tasks, events
+
+
+def unwrap(events):
+    """Replace raw 32-bit timestamps with a monotonic 64-bit timeline."""
+    result = []
+    offset = 0
+    last = None
+    for ts, phase, stage, task, arg in events:
+        if last is not None and ts + offset < last - WRAP // 2:
+            offset += WRAP
+        full = ts + offset
+        last = max(full, last) if last is not None else full
+        result.append((full, phase, stage, task, arg))
+    return result
+
+
+def to_chrome(stages, tasks, events):
+    trace = []
+    base = events[0][0] if events else 0
+    open_spans = {}
+    for ts, phase, stage, task, arg in events:
+        name = stages.get(stage, "stage%d" % stage)
+        entry = {"name": name, "pid": 1, "tid": task, "ts": ts - base}
+        key = (task, stage)
+        if phase == "B":
+            open_spans[key] = open_spans.get(key, 0) + 1
+            entry["ph"] = "B"
+            if arg:
+                entry["args"] = {"arg": arg}
+        elif phase == "E":
+            if not open_spans.get(key):
+                continue    # Its begin fell out of the ring
+            open_spans[key] -= 1
+            entry["ph"] = "E"
+            if arg:
+                entry["args"] = {"arg": arg}
+        else:
+            entry["ph"] = "i"
+            entry["s"] = "t"
+            entry["args"] = {"arg": arg}
+        trace.append(entry)
+
+    for task in sorted(set(e[3] for e in events) | set(tasks)):
+        trace.append({"name": "thread_name", "ph": "M", "pid": 1, "tid": task,
+                      "args": {"name": tasks.get(task, "task %d" % task)}})
+    return {"traceEvents": trace, "displayTimeUnit": "ms"}
+
+
+def summarize(stages, events, out):
+    open_spans = {}
+    durations = {}
+    instants = {}
+    for ts, phase, stage, task, arg in events:
+        key = (task, stage)
+        if phase == "B":
+            open_spans.setdefault(key, []).append(ts)
+        elif phase == "E" and open_spans.get(key):
+            durations.setdefault(stage, []).append(ts - open_spans[key].pop())
+        elif phase == "I":
+            instants.setdefault(stage, []).append(arg)
+
+    out.write("%-16s %7s %10s %10s %10s\n" % ("stage", "count", "avg us", "p99 us", "max us"))
+    for stage in sorted(set(durations) | set(instants)):
+        values = sorted(durations.get(stage) or instants[stage])
+        p99 = values[min(len(values) - 1, int(0.99 * (len(values) - 1)))]
+        out.write("%-16s %7d %10d %10d %10d%s\n" % (
+            stages.get(stage, "stage%d" % stage), len(values),
+            sum(values) // len(values), p99, values[-1],
+            "" if stage in durations else "  (instant arg)"))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("log", nargs="?", help="serial log (default: stdin)")
+    parser.add_argument("-o", "--output", default="trace.json", help="Chrome trace JSON to write")
+    parser.add_argument("--summary", action="store_true", help="print per-stage durations")
+    args = parser.parse_args()
+
+    if args.log:
+        with open(args.log, errors="replace") as f:
+            stages, tasks, raw = collect(f)
+    else:
+        stages, tasks, raw = collect(sys.stdin)
+
+    if not raw:
+        sys.exit("no TRACE dumps found (is ENABLE_TRACE set?)")
+
+    events = unwrap(raw)
+    with open(args.output, "w") as f:
+        json.dump(to_chrome(stages, tasks, events), f)
+    print("%d events, %d tasks -> %s" % (len(events), len(set(e[3] for e in events)), args.output))
+
+    if args.summary:
+        summarize(stages, events, sys.stdout)
+
+
+if __name__ == "__main__":
+    main()